@@ -0,0 +1,50 @@
+#version 430
+
+// Reflective Shadow Maps based on "Reflective Shadow Maps" by Carsten Dachsbacher and Marc Stamminger
+
+in Vertex
+{
+    vec3 normalW;
+    vec2 uv;
+} In;
+
+uniform sampler2D u_diffuseTexture0;
+uniform sampler2D u_emissionMap0;
+uniform sampler2D u_opacityMap0;
+uniform float u_hasEmissionMap;
+uniform float u_hasOpacityMap;
+uniform float u_hasDiffuseTexture;
+uniform vec4 u_color;
+uniform vec3 u_emissionColor;
+
+uniform vec3 u_lightColor; // Color * intensity
+
+layout(location = 0) out vec4 out_flux;
+layout(location = 1) out vec4 out_normal; // xyz: normal mapped to [0, 1], w: 1 if the flux is emitted light
+
+void main() 
+{
+	if (u_hasOpacityMap > 0.0 && texture(u_opacityMap0, In.uv).r < 0.1)
+        discard;
+
+    // Same radiance as injectLightByConservativeVoxelization without the nDotL and visibility terms
+    if (any(greaterThan(u_emissionColor, vec3(0.0))))
+    {
+        vec3 emission = u_emissionColor;
+
+        if (u_hasEmissionMap > 0.0)
+            emission += texture(u_emissionMap0, In.uv).rgb;
+
+        out_flux = vec4(emission, 1.0);
+        out_normal = vec4(normalize(In.normalW) * 0.5 + 0.5, 1.0);
+        return;
+    }
+
+    vec4 color = u_color;
+
+    if (u_hasDiffuseTexture > 0.0)
+        color = texture(u_diffuseTexture0, In.uv);
+
+    out_flux = vec4(u_lightColor * color.rgb * color.a, 1.0);
+    out_normal = vec4(normalize(In.normalW) * 0.5 + 0.5, 0.0);
+}
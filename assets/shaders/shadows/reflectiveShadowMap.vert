@@ -14,17 +14,12 @@ uniform mat4 u_modelIT;
 out Vertex
 {
     vec3 normalW;
-    vec3 tangentW;
-    vec3 bitangentW;
     vec2 uv;
 };
 
 void main()
 {
     gl_Position = u_proj * u_view * u_model * vec4(in_pos, 1.0);
-    
     normalW = (u_modelIT * vec4(in_normal, 0.0)).xyz;
-    tangentW = (u_modelIT * vec4(in_tangent, 0.0)).xyz;
-    bitangentW = (u_modelIT * vec4(in_bitangent, 0.0)).xyz;
     uv = in_uv;
 }
@@ -29,4 +29,19 @@ void imageAtomicRGBA8Avg(layout(r32ui) volatile uimage3D image, ivec3 coords, ve
     }
 }
 
+// Radiance in [0, 1] is accumulated with 16 fractional bits - 65535 samples of full intensity fit into an accumulator.
+// Has to match CPURadianceAccumulation::FIXED_POINT_SCALE
+const float RADIANCE_FIXED_POINT_SCALE = 65536.0;
+
+// Contention-free alternative to imageAtomicRGBA8Avg: The channels are summed up in separate R32UI accumulators
+// that are channelOffset texels apart. The fourth accumulator counts the samples (alpha as in imageAtomicRGBA8Avg).
+void imageAtomicFixedPointAdd(layout(r32ui) volatile uimage3D image, ivec3 coords, ivec3 channelOffset, vec4 value)
+{
+    uvec3 fixedPointValue = uvec3(round(clamp(value.rgb, 0.0, 1.0) * RADIANCE_FIXED_POINT_SCALE));
+    imageAtomicAdd(image, coords, fixedPointValue.r);
+    imageAtomicAdd(image, coords + channelOffset, fixedPointValue.g);
+    imageAtomicAdd(image, coords + 2 * channelOffset, fixedPointValue.b);
+    imageAtomicAdd(image, coords + 3 * channelOffset, uint(value.a));
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 430
+#extension GL_ARB_shading_language_include : enable
+#extension GL_ARB_shader_image_load_store : require
+
+#define CONSERVATIVE_VOXELIZATION
+#define MULTI_REGION_VOXELIZATION
+
+#include "/voxelConeTracing/injectLightByConservativeVoxelizationFrag.glsl"
@@ -53,7 +53,7 @@ void main()
         }
         
         emission.rgb = clamp(emission.rgb, 0.0, 1.0);
-        storeVoxelColorAtomicRGBA8Avg6Faces(u_voxelRadiance, posW, emission);
+        storeVoxelRadiance6Faces(u_voxelRadiance, posW, emission);
     }
 	else
 	{
@@ -89,6 +89,6 @@ void main()
         radiance = clamp(radiance, 0.0, 1.0);
 		
 		ivec3 faceIndices = computeVoxelFaceIndices(-normal);
-        storeVoxelColorAtomicRGBA8Avg(u_voxelRadiance, posW, vec4(radiance, 1.0), faceIndices, abs(normal));
+        storeVoxelRadiance(u_voxelRadiance, posW, vec4(radiance, 1.0), faceIndices, abs(normal));
 	}
 }
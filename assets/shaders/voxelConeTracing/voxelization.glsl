@@ -9,10 +9,44 @@
 #include "/voxelConeTracing/atomicOperations.glsl"
 #include "/voxelConeTracing/settings.glsl"
 
-uniform int u_clipmapLevel;
 uniform int u_clipmapResolution;
 uniform int u_clipmapResolutionWithBorder;
 
+// Radiance is summed up in the fixed-point accumulators of a single clipmap level instead of averaged in the clipmap
+uniform bool u_fixedPointRadianceAccumulation;
+
+#ifdef MULTI_REGION_VOXELIZATION
+// Multiple regions (of possibly different clipmap levels) are voxelized with one draw call.
+// Layout has to match VoxelizationRegionData in voxelization.cpp
+struct VoxelizationRegion
+{
+	mat4 viewProj[3];
+	mat4 viewProjInv[3];
+	vec4 regionMin; // w: clipmap level
+	vec4 regionMax; // w: voxel size
+	vec4 prevRegionMin; // w: max extent
+	vec4 prevRegionMax; // w: downsample transition region size
+};
+
+layout(std430, binding = 0) readonly buffer VoxelizationRegions
+{
+	VoxelizationRegion u_voxelizationRegions[];
+};
+
+// Index of the region in u_voxelizationRegions - defined by the geometry and fragment shader stages
+int getVoxelizationRegionIdx();
+
+#define u_clipmapLevel (int(u_voxelizationRegions[getVoxelizationRegionIdx()].regionMin.w))
+#define u_regionMin (u_voxelizationRegions[getVoxelizationRegionIdx()].regionMin.xyz)
+#define u_regionMax (u_voxelizationRegions[getVoxelizationRegionIdx()].regionMax.xyz)
+#define u_prevRegionMin (u_voxelizationRegions[getVoxelizationRegionIdx()].prevRegionMin.xyz)
+#define u_prevRegionMax (u_voxelizationRegions[getVoxelizationRegionIdx()].prevRegionMax.xyz)
+#define u_downsampleTransitionRegionSize (u_voxelizationRegions[getVoxelizationRegionIdx()].prevRegionMax.w)
+#define u_maxExtent (u_voxelizationRegions[getVoxelizationRegionIdx()].prevRegionMin.w)
+#define u_voxelSize (u_voxelizationRegions[getVoxelizationRegionIdx()].regionMax.w)
+#else
+uniform int u_clipmapLevel;
+
 uniform vec3 u_regionMin;
 uniform vec3 u_regionMax;
 uniform vec3 u_prevRegionMin;
@@ -20,6 +54,7 @@ uniform vec3 u_prevRegionMax;
 uniform float u_downsampleTransitionRegionSize;
 uniform float u_maxExtent;
 uniform float u_voxelSize;
+#endif
 
 //layout(r32ui) uniform volatile coherent uimage3D u_voxelAlbedo;
 
@@ -124,6 +159,51 @@ void storeVoxelColorAtomicRGBA8Avg(layout(r32ui) volatile uimage3D image, vec3 p
 	imageAtomicRGBA8Avg(image, imageCoords + ivec3(faceIndices.z * u_clipmapResolutionWithBorder, 0, 0), vec4(color.rgb * weight.z, 1.0));
 }
 
+// The accumulators of the fixed-point radiance accumulation cover the 6 faces of a single clipmap level without border.
+// The 4 channels are stacked along y (see resolveRadianceAccumulation.comp)
+ivec3 computeAccumulatorCoords(vec3 posW)
+{
+	ivec3 imageCoords = computeImageCoords(posW);
+	imageCoords.y -= u_clipmapResolutionWithBorder * u_clipmapLevel;
+
+#ifdef VOXEL_TEXTURE_WITH_BORDER
+	imageCoords -= ivec3(BORDER_WIDTH);
+#endif
+
+	return imageCoords;
+}
+
+void storeVoxelRadiance6Faces(layout(r32ui) volatile uimage3D image, vec3 posW, vec4 color)
+{
+	if (!u_fixedPointRadianceAccumulation)
+	{
+		storeVoxelColorAtomicRGBA8Avg6Faces(image, posW, color);
+		return;
+	}
+
+	ivec3 imageCoords = computeAccumulatorCoords(posW);
+	ivec3 channelOffset = ivec3(0, u_clipmapResolution, 0);
+
+	for (int i = 0; i < 6; ++i)
+		imageAtomicFixedPointAdd(image, imageCoords + ivec3(u_clipmapResolution * i, 0, 0), channelOffset, color);
+}
+
+void storeVoxelRadiance(layout(r32ui) volatile uimage3D image, vec3 posW, vec4 color, ivec3 faceIndices, vec3 weight)
+{
+	if (!u_fixedPointRadianceAccumulation)
+	{
+		storeVoxelColorAtomicRGBA8Avg(image, posW, color, faceIndices, weight);
+		return;
+	}
+
+	ivec3 imageCoords = computeAccumulatorCoords(posW);
+	ivec3 channelOffset = ivec3(0, u_clipmapResolution, 0);
+
+	imageAtomicFixedPointAdd(image, imageCoords + ivec3(faceIndices.x * u_clipmapResolution, 0, 0), channelOffset, vec4(color.rgb * weight.x, 1.0));
+	imageAtomicFixedPointAdd(image, imageCoords + ivec3(faceIndices.y * u_clipmapResolution, 0, 0), channelOffset, vec4(color.rgb * weight.y, 1.0));
+	imageAtomicFixedPointAdd(image, imageCoords + ivec3(faceIndices.z * u_clipmapResolution, 0, 0), channelOffset, vec4(color.rgb * weight.z, 1.0));
+}
+
 //void storeVoxelColorRGBA8(uimage3D image, vec3 posW, vec4 color) // layout(rgba8ui) volatile coherent 
 //{
 //	ivec3 imageCoords = computeImageCoords(posW);
@@ -29,8 +29,18 @@ in ConservativeVoxelizationFragmentInput
     flat vec4 triangleAABB;
 	flat vec3[3] trianglePosW;
 	flat int faceIdx;
+#ifdef MULTI_REGION_VOXELIZATION
+	flat int regionIdx;
+#endif
 } in_cvFrag;
 
+#ifdef MULTI_REGION_VOXELIZATION
+int getVoxelizationRegionIdx()
+{
+	return in_cvFrag.regionIdx;
+}
+#endif
+
 bool cvIntersectsTriangle(vec3 posW)
 {
     AABBox3D b;
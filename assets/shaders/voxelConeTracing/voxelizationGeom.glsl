@@ -5,9 +5,24 @@
 
 #include "/voxelConeTracing/voxelization.glsl"
 
+#ifdef MULTI_REGION_VOXELIZATION
+// Every invocation voxelizes the triangle into one region of the batch [u_regionOffset, u_regionOffset + u_regionCount)
+uniform int u_regionOffset;
+uniform int u_regionCount;
+
+int getVoxelizationRegionIdx()
+{
+	return u_regionOffset + gl_InvocationID;
+}
+
+// The matrices of a region map it to its viewport - all viewports cover the whole framebuffer
+#define u_viewProj (u_voxelizationRegions[getVoxelizationRegionIdx()].viewProj)
+#define u_viewProjInv (u_voxelizationRegions[getVoxelizationRegionIdx()].viewProjInv)
+#else
 uniform mat4 u_viewProj[3];
 uniform mat4 u_viewProjInv[3];
 uniform vec2 u_viewportSizes[3];
+#endif
 
 #ifdef CONSERVATIVE_VOXELIZATION
 out ConservativeVoxelizationFragmentInput
@@ -17,8 +32,27 @@ out ConservativeVoxelizationFragmentInput
     flat vec4 triangleAABB;
 	flat vec3[3] trianglePosW;
 	flat int faceIdx;
+#ifdef MULTI_REGION_VOXELIZATION
+	flat int regionIdx;
+#endif
 } out_cvFrag;
 
+#ifdef MULTI_REGION_VOXELIZATION
+bool cvIsRegionInvocation()
+{
+	return gl_InvocationID < u_regionCount;
+}
+
+// The triangle can only create fragments in the region if it overlaps the region extended by one voxel
+bool cvOverlapsRegion()
+{
+	vec3 triangleMin = min(gl_in[0].gl_Position.xyz, min(gl_in[1].gl_Position.xyz, gl_in[2].gl_Position.xyz));
+	vec3 triangleMax = max(gl_in[0].gl_Position.xyz, max(gl_in[1].gl_Position.xyz, gl_in[2].gl_Position.xyz));
+	
+	return all(lessThanEqual(triangleMin, u_regionMax + u_voxelSize)) && all(greaterThanEqual(triangleMax, u_regionMin - u_voxelSize));
+}
+#endif
+
 // Coservative Voxelization based on "Conservative Rasterization", GPU Gems 2 Chapter 42 by Jon Hasselgren, Tomas Akenine-Möller and Lennart Ohlsson:
 // http://http.developer.nvidia.com/GPUGems2/gpugems2_chapter42.html
 void cvGeometryPass(out vec4 positionsClip[3])
@@ -32,7 +66,11 @@ void cvGeometryPass(out vec4 positionsClip[3])
         u_viewProj[idx] * gl_in[2].gl_Position
     );
 
+#ifdef MULTI_REGION_VOXELIZATION
+    vec2 hPixel = vec2(1.0 / u_clipmapResolutionWithBorder);
+#else
     vec2 hPixel = 1.0 / u_viewportSizes[idx];
+#endif
 	
 	vec3 triangleNormalClip = normalize(cross(positionsClip[1].xyz - positionsClip[0].xyz, positionsClip[2].xyz - positionsClip[0].xyz));
 	computeExtendedTriangle(hPixel, triangleNormalClip, positionsClip, out_cvFrag.triangleAABB);
@@ -57,6 +95,9 @@ void cvEmitVertex(vec4 posClip)
 	gl_Position = posClip;
 	out_cvFrag.posW = (u_viewProjInv[gl_ViewportIndex] * posClip).xyz;
 	out_cvFrag.posClip = posClip.xyz;
+#ifdef MULTI_REGION_VOXELIZATION
+	out_cvFrag.regionIdx = getVoxelizationRegionIdx();
+#endif
 	
 	EmitVertex();
 }
@@ -10,10 +10,16 @@
 #include "rendering/util/Mipmapper.h"
 #include "rendering/renderer/MeshRenderers.h"
 #include "util/QueryManager.h"
+#include "resource/ResourceManager.h"
 #include "util/file.h"
 #include "rendering/voxelConeTracing/VoxelConeTracing.h"
 #include "util/colors.h"
 #include <SOIL2.h>
+#include "rendering/RenderingBenchmark.h"
+#include "memory/FrameArena.h"
+#include "memory/HeapAllocationCounter.h"
+#include "util/Profiler.h"
+#include "util/GLProfilerGPUBackend.h"
 
 Engine::Engine()
     : m_running(true), m_initialized(false) 
@@ -28,6 +34,14 @@ void Engine::init(Game* game)
     Screen::init(1100, 600, false);
     m_initialized = true;
     Input::subscribe(this);
+
+    Profiler::setThreadName("Main Thread");
+    Profiler::setGPUBackend(std::make_unique<GLProfilerGPUBackend>());
+
+    m_threadPool = std::make_unique<ThreadPool>();
+    ECS::setThreadPool(m_threadPool.get());
+    ResourceManager::setThreadPool(m_threadPool.get());
+
     MeshRenderers::init();
     Mipmapper::init();
     VoxelConeTracing::init();
@@ -35,6 +49,10 @@ void Engine::init(Game* game)
     ImGui_ImplSdlGL3_Init(Screen::getSDLWindow());
 
     EditableMaterialProperties::init();
+
+#ifdef RUN_RENDERING_BENCHMARKS
+    RenderingBenchmark::runBenchmarks();
+#endif
 }
 
 void Engine::update()
@@ -44,11 +62,14 @@ void Engine::update()
         LOG_EXIT("Engine is not initialized. Shutting down...");
     }
 
-    if (!m_paused)
-    {
-        QueryManager::beginElapsedTime(QueryTarget::CPU, "Total Time");
-        QueryManager::beginElapsedTime(QueryTarget::GPU, "Total Time");
-    }
+    // Collects the profile zones of the last frame before the zones of this frame begin
+    Profiler::update();
+    PROFILE_GPU_ZONE("Frame");
+
+    // Everything allocated in the frame arena during the last frame is released
+    FrameArena::reset();
+    std::size_t heapAllocationCount = HeapAllocationCounter::getAllocationCount();
+    std::size_t arenaHeapAllocationCount = FrameArena::getHeapAllocationCount();
 
     Time::update();
     Input::update(Screen::getHeight(), true);
@@ -64,17 +85,26 @@ void Engine::update()
     {
         ImGui_ImplSdlGL3_NewFrame(Screen::getSDLWindow());
 
-        QueryManager::beginElapsedTime(QueryTarget::CPU, "ECS Update");
-        ECS::update();
-        QueryManager::endElapsedTime(QueryTarget::CPU, "ECS Update");
+        ResourceManager::update();
+
+        {
+            PROFILE_ZONE("ECS Update");
+            ECS::update();
+        }
 
-        m_game->update();
+        // Events posted by worker threads and components are delivered on the main thread before the game update
+        {
+            PROFILE_ZONE("Event Dispatch");
+            Event::dispatchQueued();
+        }
 
-        QueryManager::beginElapsedTime(QueryTarget::CPU, "GUI");
-        QueryManager::beginElapsedTime(QueryTarget::GPU, "GUI");
+        {
+            PROFILE_ZONE("Game Update");
+            m_game->update();
+        }
+
+        PROFILE_GPU_ZONE("GUI");
         ImGui::Render();
-        QueryManager::endElapsedTime(QueryTarget::CPU, "GUI");
-        QueryManager::endElapsedTime(QueryTarget::GPU, "GUI");
     }
 
     Screen::update();
@@ -85,8 +115,14 @@ void Engine::update()
         takeScreenshot();
     }
 
-    QueryManager::endElapsedTime(QueryTarget::CPU, "Total Time");
-    QueryManager::endElapsedTime(QueryTarget::GPU, "Total Time");
+    QueryManager::setCounter("Frame Arena: Allocations", FrameArena::getAllocationCount());
+    QueryManager::setCounter("Frame Arena: Bytes", FrameArena::getSize());
+    QueryManager::setCounter("Frame Arena: Heap Allocations", FrameArena::getHeapAllocationCount() - arenaHeapAllocationCount);
+
+    QueryManager::setCounter("Profiler: Dropped Zones", Profiler::getDroppedZoneCount());
+
+    if (HeapAllocationCounter::isEnabled())
+        QueryManager::setCounter("Heap Allocations", HeapAllocationCounter::getAllocationCount() - heapAllocationCount);
 
     QueryManager::update();
 }
@@ -94,6 +130,10 @@ void Engine::update()
 void Engine::shutdown()
 {
     m_game->quit();
+    ECS::setThreadPool(nullptr);
+    ResourceManager::setThreadPool(nullptr);
+    m_threadPool.reset();
+    Profiler::setGPUBackend(nullptr);
     VoxelConeTracing::terminate();
     ImGui_ImplSdlGL3_Shutdown();
     SDL_Quit();
@@ -166,6 +206,15 @@ void Engine::resize(int width, int height)
     }
 }
 
+void Engine::exportTrace()
+{
+    std::string path = "Trace" + std::to_string(m_traceCounter++) + ".json";
+    if (Profiler::exportChromeTrace(path))
+        LOG("Exported the profile trace to " << path);
+    else
+        LOG_ERROR("Failed to write the trace: " << path);
+}
+
 void Engine::takeScreenshot()
 {
     RGBA8* pixels = new RGBA8[Screen::getWidth() * Screen::getHeight()];
@@ -3,6 +3,8 @@
 #include "event/QuitEvent.h"
 #include "input/Input.h"
 #include "ecs/ECS.h"
+#include "util/ThreadPool.h"
+#include <memory>
 
 class CameraComponent;
 class Game;
@@ -31,6 +33,11 @@ public:
 
     void requestScreenshot() { m_screenshotRequest = true; }
 
+    /**
+    * Writes the profile zones of the last frames to a Chrome trace file (chrome://tracing, ui.perfetto.dev).
+    */
+    void exportTrace();
+
 protected:
     void onQuit() override;
     void onWindowEvent(const SDL_WindowEvent& windowEvent) override;
@@ -46,8 +53,10 @@ private:
     bool m_initialized;
 
     Game* m_game{nullptr};
+    std::unique_ptr<ThreadPool> m_threadPool;
     std::vector<ComponentPtr<CameraComponent>> m_cameras;
 
     bool m_screenshotRequest{ false };
     int m_screenshotCounter{ 0 };
+    int m_traceCounter{ 0 };
 };
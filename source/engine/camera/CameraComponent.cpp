@@ -21,6 +21,34 @@ BBox Frustum::getBBox() const
     return bbox;
 }
 
+void Frustum::getPlanes(glm::vec4 planes[6]) const
+{
+    const glm::vec3 planePoints[6][3]{
+        { data.nearBottomLeft, data.nearBottomRight, data.nearTopLeft },
+        { data.farBottomLeft, data.farTopLeft, data.farBottomRight },
+        { data.nearBottomLeft, data.nearTopLeft, data.farBottomLeft },
+        { data.nearBottomRight, data.farBottomRight, data.nearTopRight },
+        { data.nearBottomLeft, data.farBottomLeft, data.nearBottomRight },
+        { data.nearTopLeft, data.nearTopRight, data.farTopLeft }
+    };
+
+    glm::vec3 center(0.0f);
+    for (auto& p : points)
+        center += p / 8.0f;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        const glm::vec3* p = planePoints[i];
+        glm::vec3 n = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[0]));
+
+        // The orientation depends on the handedness - make sure the normal points inside
+        if (glm::dot(n, center - p[0]) < 0.0f)
+            n = -n;
+
+        planes[i] = glm::vec4(n, -glm::dot(n, p[0]));
+    }
+}
+
 CameraComponent::CameraComponent() {}
 
 void CameraComponent::update() { updateViewMatrix(); }
@@ -31,6 +31,12 @@ struct Frustum
 
     void transform(const glm::mat4& matrix);
     BBox getBBox() const;
+
+    /**
+    * Computes the 6 planes (near, far, left, right, bottom, top) as (n.x, n.y, n.z, d)
+    * with normals pointing inside: dot(n, p) + d >= 0 for all points p inside of the frustum.
+    */
+    void getPlanes(glm::vec4 planes[6]) const;
 };
 
 /**
@@ -41,6 +47,8 @@ class CameraComponent : public Component
 {
     friend class CameraSystem;
 public:
+    static constexpr ComponentUsage USAGE_HINT = ComponentUsage::MostlyStatic;
+
     CameraComponent();
 
     void update() override;
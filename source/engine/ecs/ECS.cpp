@@ -1,6 +1,7 @@
 #include "ECS.h"
 
 EntityManager ECS::m_entityManager;
+ThreadPool* ECS::m_threadPool = nullptr;
 std::unordered_map<std::type_index, System*> ECS::m_systems;
 std::unordered_map<std::string, Entity> ECS::m_entityMap;
 
@@ -9,7 +10,7 @@ void ECS::update()
     for (auto& sp : m_systems)
         sp.second->update(m_entityManager);
 
-    m_entityManager.update();
+    m_entityManager.update(m_threadPool);
 }
 
 void ECS::lateUpdate()
@@ -17,7 +18,7 @@ void ECS::lateUpdate()
     for (auto& sp : m_systems)
         sp.second->lateUpdate(m_entityManager);
 
-    m_entityManager.lateUpdate();
+    m_entityManager.lateUpdate(m_threadPool);
 }
 
 Entity ECS::createEntity(const std::string& name)
@@ -20,6 +20,14 @@ public:
     static void update();
     static void lateUpdate();
 
+    /**
+    * Sets the thread pool which is used for parallel component updates.
+    * Components are updated on the calling thread only if the thread pool is null (default).
+    */
+    static void setThreadPool(ThreadPool* threadPool) { m_threadPool = threadPool; }
+
+    static ThreadPool* getThreadPool() { return m_threadPool; }
+
     static Entity createEntity(const std::string& name);
     static Entity createEntity();
 
@@ -46,6 +54,7 @@ public:
     static std::size_t getEntityCountWithComponentsIncludeInactive();
 private:
     static EntityManager m_entityManager;
+    static ThreadPool* m_threadPool;
     static std::unordered_map<std::type_index, System*> m_systems;
     static std::unordered_map<std::string, Entity> m_entityMap; // Maps entities by names
 };
@@ -70,25 +79,11 @@ void ECS::removeSystem()
 template <class ... Components>
 std::size_t ECS::getEntityCountWithComponents()
 {
-    std::size_t count = 0;
-
-    for (auto e : m_entityManager.getEntitiesWithComponents<Components...>())
-    {
-        ++count;
-    }
-
-    return count;
+    return m_entityManager.numberOfEntitiesWithComponents<Components...>(false);
 }
 
 template <class ... Components>
 std::size_t ECS::getEntityCountWithComponentsIncludeInactive()
 {
-    std::size_t count = 0;
-
-    for (auto e : m_entityManager.getEntitiesWithComponentsIncludeInactive<Components...>())
-    {
-        ++count;
-    }
-
-    return count;
+    return m_entityManager.numberOfEntitiesWithComponents<Components...>(true);
 }
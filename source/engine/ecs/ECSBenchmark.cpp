@@ -0,0 +1,162 @@
+#include "ECSBenchmark.h"
+#include "EntityManager.h"
+#include <engine/util/Timer.h>
+#include <engine/util/Logger.h>
+#include <engine/util/ThreadPool.h>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+namespace ecs_benchmark
+{
+    struct PositionComponent : public Component
+    {
+        PositionComponent(int x, int y)
+            : x(x), y(y) { }
+
+        int x, y;
+    };
+
+    struct RenderComponent : public Component
+    {
+        int value = 1;
+    };
+
+    struct ParticleComponent : public Component
+    {
+        static constexpr bool PARALLEL_UPDATE = true;
+
+        void update() override
+        {
+            // Some work that is comparable to a transform update
+            for (int i = 0; i < 8; ++i)
+            {
+                velocity = velocity * 0.99f + glm::vec3(0.0f, -0.01f, 0.0f);
+                position += velocity * 0.016f;
+                rotation = glm::normalize(rotation * glm::angleAxis(0.01f, glm::normalize(velocity + glm::vec3(0.1f))));
+            }
+        }
+
+        glm::vec3 position;
+        glm::vec3 velocity{1.0f, 2.0f, 3.0f};
+        glm::quat rotation;
+    };
+
+    /**
+    * Sums up a value of all entities in the range to make sure that the iteration is not optimized away.
+    */
+    template <class TRange>
+    int64_t iterate(TRange range)
+    {
+        int64_t sum = 0;
+        for (Entity e : range)
+            sum += e.getComponent<RenderComponent>()->value;
+
+        return sum;
+    }
+
+#ifdef RUN_ECS_BENCHMARKS
+    struct ECSBenchmarkRunner
+    {
+        ECSBenchmarkRunner()
+        {
+            ECSBenchmark::runBenchmarks();
+        }
+    };
+
+    ECSBenchmarkRunner ecsBenchmarkRunner;
+#endif
+}
+
+using namespace ecs_benchmark;
+
+void ECSBenchmark::runBenchmarks()
+{
+    benchmarkGetEntitiesWithComponents();
+    benchmarkParallelUpdate();
+}
+
+void ECSBenchmark::benchmarkGetEntitiesWithComponents()
+{
+    LOG("ECS Benchmark: getEntitiesWithComponents<Position, Render> with 1% matching entities");
+
+    for (int entityCount : {10000, 100000, 1000000})
+    {
+        EntityManager entityManager;
+
+        for (int i = 0; i < entityCount; ++i)
+        {
+            Entity entity = entityManager.create();
+            entity.addComponent<PositionComponent>(i, 0);
+
+            if (i % 100 == 0)
+                entity.addComponent<RenderComponent>();
+        }
+
+        int repetitions = std::max(10000000 / entityCount, 10);
+        int64_t scanSum = 0;
+        int64_t querySum = 0;
+
+        // The first query creates the match list
+        Timer timer;
+        entityManager.getEntitiesWithComponents<PositionComponent, RenderComponent>();
+        timer.tick();
+        uint64_t listCreationTime = timer.deltaTimeInMicroseconds();
+
+        timer.start();
+        for (int i = 0; i < repetitions; ++i)
+            scanSum += iterate(entityManager.scanEntitiesWithComponents<PositionComponent, RenderComponent>());
+        timer.tick();
+        double scanTime = double(timer.deltaTimeInMicroseconds()) / repetitions;
+
+        timer.start();
+        for (int i = 0; i < repetitions; ++i)
+            querySum += iterate(entityManager.getEntitiesWithComponents<PositionComponent, RenderComponent>());
+        timer.tick();
+        double queryTime = double(timer.deltaTimeInMicroseconds()) / repetitions;
+
+        assert(scanSum == querySum);
+        LOG(entityCount << " entities: scan " << scanTime << " us, match list " << queryTime << " us, speedup " << scanTime / std::max(queryTime, 0.001)
+            << "x (match list creation: " << listCreationTime << " us)");
+    }
+}
+
+void ECSBenchmark::benchmarkParallelUpdate()
+{
+    std::size_t maxThreadCount = ThreadPool::defaultWorkerCount() + 1;
+    LOG("ECS Benchmark: EntityManager::update with parallel updates (" << maxThreadCount << " hardware threads)");
+
+    for (int entityCount : {10000, 100000, 1000000})
+    {
+        EntityManager entityManager;
+
+        for (int i = 0; i < entityCount; ++i)
+            entityManager.create().addComponent<ParticleComponent>();
+
+        int repetitions = std::max(1000000 / entityCount, 3);
+        double serialTime = 0.0;
+
+        // Powers of 2 and the maximum thread count
+        std::vector<std::size_t> threadCounts;
+        for (std::size_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+            threadCounts.push_back(threadCount);
+        threadCounts.push_back(maxThreadCount);
+
+        for (std::size_t threadCount : threadCounts)
+        {
+            ThreadPool threadPool(threadCount - 1);
+            ThreadPool* pool = threadCount > 1 ? &threadPool : nullptr;
+            entityManager.update(pool);
+
+            Timer timer;
+            for (int i = 0; i < repetitions; ++i)
+                entityManager.update(pool);
+            timer.tick();
+
+            double time = double(timer.deltaTimeInMicroseconds()) / repetitions;
+            if (threadCount == 1)
+                serialTime = time;
+
+            LOG(entityCount << " entities, " << threadCount << " threads: " << time / 1000.0 << " ms, speedup " << serialTime / std::max(time, 0.001) << "x");
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+class ECSBenchmark
+{
+public:
+    static void runBenchmarks();
+
+private:
+    static void benchmarkGetEntitiesWithComponents();
+    static void benchmarkParallelUpdate();
+};
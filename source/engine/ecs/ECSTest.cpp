@@ -3,6 +3,7 @@
 #include <cassert>
 #include "EntityManager.h"
 #include "ECS.h"
+#include <engine/util/ThreadPool.h>
 
 namespace ecs_test
 {
@@ -33,6 +34,31 @@ namespace ecs_test
         float time = 0.f;
     };
 
+    struct LightComponent : public Component
+    {
+        static constexpr ComponentUsage USAGE_HINT = ComponentUsage::MostlyStatic;
+
+        explicit LightComponent(int intensity)
+            : intensity(intensity) { }
+
+        void update() override { ++updateCount; }
+
+        int intensity;
+        int updateCount{0};
+    };
+
+    struct ParticleComponent : public Component
+    {
+        static constexpr bool PARALLEL_UPDATE = true;
+
+        void update() override { ++updateCount; }
+
+        void lateUpdate() override { lateUpdateCount += updateCount; }
+
+        int updateCount{0};
+        int lateUpdateCount{0};
+    };
+
     class PhysicsSystem : public System
     {
     public:
@@ -70,6 +96,16 @@ namespace ecs_test
     template <class T1, class T2, class... Args>
     bool allDifferent(const T1& v1, const T2& v2, const Args& ... args) { return allNotEqual(v1, v2, args...); }
 
+    template <class TRange>
+    std::vector<Entity> collect(TRange range)
+    {
+        std::vector<Entity> entities;
+        for (Entity e : range)
+            entities.push_back(e);
+
+        return entities;
+    }
+
 #ifdef RUN_ECS_TESTS
     struct ECSTestRunner
     {
@@ -92,6 +128,9 @@ void ECSTest::runTests()
     testHasGetAddRemoveComponent();
     testGetEntitiesWithComponents();
     testSystem();
+    testSparseComponents();
+    testMatchLists();
+    testParallelUpdate();
 }
 
 void ECSTest::testComponentTypeID()
@@ -220,3 +259,172 @@ void ECSTest::testSystem()
         assert(entity.getComponent<PositionComponent>()->x == 0.f);
     }
 }
+
+void ECSTest::testSparseComponents()
+{
+    // Setup a test environment
+    EntityManager entityManager;
+
+    int entitySize = 1000;
+    std::vector<Entity> lights;
+
+    for (int i = 0; i < entitySize; ++i)
+    {
+        Entity entity = entityManager.create();
+        entity.addComponent<PositionComponent>(i, 0);
+
+        if (i % 100 == 0)
+        {
+            entity.addComponent<LightComponent>(i);
+            lights.push_back(entity);
+        }
+    }
+
+    // Space is only reserved for the existing components
+    auto lightPool = entityManager.getPool<LightComponent>();
+    assert(lightPool->size() == lights.size());
+    assert(lightPool->capacity() < std::size_t(entitySize));
+    assertNumberOfEntitiesWithComponents<LightComponent>(entityManager, int(lights.size()));
+    assertNumberOfEntitiesWithComponents<PositionComponent, LightComponent>(entityManager, int(lights.size()));
+
+    // Removing components from the middle of the packed storage must not affect the others
+    lights[3].removeComponent<LightComponent>();
+    lights[5].destroy();
+    assert(!lights[3].hasComponent<LightComponent>());
+    assert(lightPool->size() == lights.size() - 2);
+
+    for (std::size_t i = 0; i < lights.size(); ++i)
+    {
+        if (i == 3 || i == 5)
+            continue;
+
+        auto light = lights[i].getComponent<LightComponent>();
+        assert(light && light->intensity == int(i) * 100);
+        assert(light->getOwner() == lights[i]);
+    }
+
+    // Only active components of the packed storage are updated
+    lights[0].setActive(false);
+    entityManager.update();
+    assert(lights[0].getComponent<LightComponent>()->updateCount == 0);
+    assert(lights[1].getComponent<LightComponent>()->updateCount == 1);
+
+    // Recycled entity ids must not see the old component
+    Entity entity = entityManager.create();
+    assert(!entity.hasComponent<LightComponent>());
+    entity.addComponent<LightComponent>(7);
+    assert(entity.getComponent<LightComponent>()->intensity == 7);
+    assert(lightPool->size() == lights.size() - 1);
+}
+
+void ECSTest::testMatchLists()
+{
+    // Setup a test environment
+    EntityManager entityManager;
+
+    int entitySize = 200;
+    std::vector<Entity> entities;
+
+    // Query before any entity exists to make sure the lists are kept up to date
+    assertNumberOfEntitiesWithComponents<PositionComponent, VelocityComponent>(entityManager, 0);
+    assert(collect(entityManager.getEntitiesWithComponentsIncludeInactive<RenderComponent>()).empty());
+
+    for (int i = 0; i < entitySize; ++i)
+    {
+        Entity entity = entityManager.create();
+        entity.addComponent<PositionComponent>(i, 0);
+
+        if (i % 3 == 0)
+            entity.addComponent<VelocityComponent>(0, 1);
+
+        if (i % 5 == 0)
+            entity.addComponent<RenderComponent>();
+
+        entities.push_back(entity);
+    }
+
+    auto assertListsMatchScan = [&entityManager]()
+    {
+        assert(collect(entityManager.getEntitiesWithComponents<PositionComponent, VelocityComponent>()) ==
+               collect(entityManager.scanEntitiesWithComponents<PositionComponent, VelocityComponent>()));
+        assert(collect(entityManager.getEntitiesWithComponentsIncludeInactive<RenderComponent>()) ==
+               collect(entityManager.scanEntitiesWithComponentsIncludeInactive<RenderComponent>()));
+        assert(collect(entityManager.getEntitiesWithComponents<RenderComponent>()) ==
+               collect(entityManager.scanEntitiesWithComponents<RenderComponent>()));
+    };
+
+    assertListsMatchScan();
+
+    for (int i = 0; i < entitySize; i += 7)
+    {
+        if (entities[i].hasComponent<VelocityComponent>())
+            entities[i].removeComponent<VelocityComponent>();
+        else
+            entities[i].addComponent<VelocityComponent>(0, 1);
+
+        entities[i + 1].setActive(false);
+    }
+
+    entities[10].destroy();
+    entities[10] = entityManager.create();
+    entities[10].addComponent<RenderComponent>();
+    assertListsMatchScan();
+
+    // Modifications while iterating: Every entity must still be visited exactly once
+    std::vector<Entity> expected = collect(entityManager.scanEntitiesWithComponents<PositionComponent>());
+    std::vector<Entity> visited;
+    for (Entity e : entityManager.getEntitiesWithComponents<PositionComponent>())
+    {
+        visited.push_back(e);
+        if (e.getComponent<PositionComponent>()->x % 2 == 0)
+            e.removeComponent<PositionComponent>();
+    }
+
+    assert(visited == expected);
+    assertListsMatchScan();
+}
+
+void ECSTest::testParallelUpdate()
+{
+    // Setup a test environment
+    EntityManager entityManager;
+    ThreadPool threadPool(3);
+
+    int entitySize = 10 * PARALLEL_UPDATE_CHUNK_SIZE + 7;
+    int numIterations = 10;
+    std::vector<Entity> entities;
+
+    for (int i = 0; i < entitySize; ++i)
+    {
+        Entity entity = entityManager.create();
+        entity.addComponent<ParticleComponent>();
+        entities.push_back(entity);
+
+        if (i % 11 == 0)
+            entity.setActive(false);
+    }
+
+    for (int i = 0; i < numIterations; ++i)
+    {
+        entityManager.update(&threadPool);
+        entityManager.lateUpdate(&threadPool);
+    }
+
+    for (int i = 0; i < entitySize; ++i)
+    {
+        auto particle = entities[i].getComponent<ParticleComponent>();
+        int expectedUpdates = i % 11 == 0 ? 0 : numIterations;
+        assert(particle->updateCount == expectedUpdates);
+        assert(particle->lateUpdateCount == expectedUpdates * (expectedUpdates + 1) / 2);
+    }
+
+    // Chunks of arbitrary sizes must cover the whole range exactly once
+    std::vector<int> visits(12345, 0);
+    threadPool.parallelFor(visits.size(), 100, [&visits](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            ++visits[i];
+    });
+
+    assert(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+}
@@ -11,4 +11,7 @@ private:
     static void testEntityCreateDestroyValid();
     static void testHasGetAddRemoveComponent();
     static void testSystem();
+    static void testSparseComponents();
+    static void testMatchLists();
+    static void testParallelUpdate();
 };
@@ -16,7 +16,7 @@ void EntityManager::destroy(const Entity& entity)
     for (std::size_t i = 0; i < m_componentPools.size(); ++i)
     {
         auto pool = m_componentPools[i];
-        if (pool && m_componentMasks[i].test(i))
+        if (pool && m_componentMasks[entity.m_id].test(i))
             pool->destroy(entity.m_id);
     }
 
@@ -25,6 +25,7 @@ void EntityManager::destroy(const Entity& entity)
     m_alive[entity.m_id] = false;
     m_active[entity.m_id] = false;
     m_idManager.release(entity.m_id);
+    updateMatchLists(entity.m_id);
 }
 
 std::vector<ComponentPtr<Component>> EntityManager::getAllComponents(const Entity& entity)
@@ -48,6 +49,7 @@ void EntityManager::removeComponent(const Entity& entity, std::size_t componentT
     assert(valid(entity) && hasComponent(entity, componentTypeID));
     m_componentMasks[entity.m_id].reset(componentTypeID);
     getPool(componentTypeID)->destroy(entity.m_id);
+    updateMatchLists(entity.m_id);
 }
 
 const std::string& EntityManager::getName(const Entity& entity) const
@@ -62,6 +64,9 @@ void EntityManager::setActive(const Entity& entity, bool active)
     bool wasActive = m_active[entity.m_id];
     m_active[entity.m_id] = active;
 
+    if (wasActive != active)
+        updateMatchLists(entity.m_id);
+
     if (wasActive && !active)
         Event::transmit<EntityDeactivatedEvent>(entity);
     else if (!wasActive && active)
@@ -83,27 +88,37 @@ bool EntityManager::hasComponent(const Entity& entity, std::size_t componentType
 const Component* EntityManager::getComponentPtr(const Entity& entity, std::size_t componentTypeID) const
 {
     assert(valid(entity) && hasComponent(entity, componentTypeID));
-    return getPool(componentTypeID)->getPtr(entity.m_id);
+    auto pool = getPool(componentTypeID);
+
+    if (isSparse(componentTypeID))
+        return static_cast<const Component*>(static_cast<const BaseSparsePool*>(pool)->getByKey(entity.m_id));
+
+    return static_cast<const Component*>(pool->get(entity.m_id));
 }
 
 Component* EntityManager::getComponentPtr(const Entity& entity, std::size_t componentTypeID)
 {
     assert(valid(entity) && hasComponent(entity, componentTypeID));
-    return getPool(componentTypeID)->getPtr(entity.m_id);
+    auto pool = getPool(componentTypeID);
+
+    if (isSparse(componentTypeID))
+        return static_cast<Component*>(static_cast<BaseSparsePool*>(pool)->getByKey(entity.m_id));
+
+    return static_cast<Component*>(pool->get(entity.m_id));
 }
 
-Pool<Component>* EntityManager::getPool(std::size_t componentTypeID)
+BasePool* EntityManager::getPool(std::size_t componentTypeID)
 {
     assert(componentTypeID < m_componentPools.size());
     assert(m_componentPools[componentTypeID]);
-    return static_cast<Pool<Component>*>(m_componentPools[componentTypeID]);
+    return m_componentPools[componentTypeID];
 }
 
-const Pool<const Component>* EntityManager::getPool(std::size_t componentTypeID) const
+const BasePool* EntityManager::getPool(std::size_t componentTypeID) const
 {
     assert(componentTypeID < m_componentPools.size());
     assert(m_componentPools[componentTypeID]);
-    return static_cast<const Pool<const Component>*>(m_componentPools[componentTypeID]);
+    return m_componentPools[componentTypeID];
 }
 
 EntityManager::~EntityManager()
@@ -113,50 +128,14 @@ EntityManager::~EntityManager()
             delete pool;
 }
 
-void EntityManager::update()
+void EntityManager::update(ThreadPool* threadPool)
 {
-    for (std::size_t componentTypeID = 0; componentTypeID < m_componentPools.size(); ++componentTypeID)
-    {
-        auto componentPool = m_componentPools[componentTypeID];
-        ComponentMask mask;
-        mask.set(componentTypeID);
-
-        if (componentPool)
-        {
-            for (std::size_t i = 0; i < componentPool->size(); ++i)
-            {
-                Component* c = reinterpret_cast<Component*>(componentPool->get(i));
-
-                if ((m_componentMasks[i] & mask) == mask && m_alive[i] && m_active[i])
-                {
-                    c->update();
-                }
-            }
-        }
-    }
+    forEachActiveComponent([](Component* c) { c->update(); }, threadPool);
 }
 
-void EntityManager::lateUpdate()
+void EntityManager::lateUpdate(ThreadPool* threadPool)
 {
-    for (std::size_t componentTypeID = 0; componentTypeID < m_componentPools.size(); ++componentTypeID)
-    {
-        auto componentPool = m_componentPools[componentTypeID];
-        ComponentMask mask;
-        mask.set(componentTypeID);
-
-        if (componentPool)
-        {
-            for (std::size_t i = 0; i < componentPool->size(); ++i)
-            {
-                Component* c = reinterpret_cast<Component*>(componentPool->get(i));
-
-                if ((m_componentMasks[i] & mask) == mask && m_alive[i] && m_active[i])
-                {
-                    c->lateUpdate();
-                }
-            }
-        }
-    }
+    forEachActiveComponent([](Component* c) { c->lateUpdate(); }, threadPool);
 }
 
 Entity EntityManager::create() { return create("Entity" + std::to_string(m_totalEntityCounter)); }
@@ -176,19 +155,58 @@ Entity EntityManager::create(const std::string& name)
         m_active.resize(id + 1);
         m_componentMasks.resize(id + 1);
 
-        // Reserve space for each component type
-        for (auto pool : m_componentPools)
-            if (pool)
-                pool->resize(id + 1);
+        // Reserve space for each component type that is not stored in a sparse set
+        for (std::size_t componentTypeID = 0; componentTypeID < m_componentPools.size(); ++componentTypeID)
+            if (m_componentPools[componentTypeID] && !isSparse(componentTypeID))
+                m_componentPools[componentTypeID]->resize(id + 1);
     }
 
     m_alive[id] = true;
     m_active[id] = true;
     m_names[id] = name;
+    updateMatchLists(id);
 
     return Entity(id, m_versions[id], this);
 }
 
+EntityManager::EntityMatchList* EntityManager::getMatchList(const ComponentMask& mask, bool includeInactive)
+{
+    for (auto& list : m_matchLists)
+        if (list->includeInactive == includeInactive && list->mask == mask)
+            return list.get();
+
+    // First query with this mask: Collect the matching entities once
+    m_matchLists.push_back(std::make_unique<EntityMatchList>(mask, includeInactive));
+    auto list = m_matchLists.back().get();
+
+    for (EntityID id = 0; id < capacity(); ++id)
+        if (matches(id, *list))
+            list->ids.push_back(id);
+
+    return list;
+}
+
+bool EntityManager::matches(EntityID id, const EntityMatchList& list) const
+{
+    return m_alive[id] && (list.includeInactive || m_active[id]) && (m_componentMasks[id] & list.mask) == list.mask;
+}
+
+void EntityManager::updateMatchLists(EntityID id)
+{
+    for (auto& list : m_matchLists)
+    {
+        auto& ids = list->ids;
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        bool contained = it != ids.end() && *it == id;
+        bool match = matches(id, *list);
+
+        if (match && !contained)
+            ids.insert(it, id);
+        else if (!match && contained)
+            ids.erase(it);
+    }
+}
+
 // ******************** EntityIDManager Implementations ********************
 EntityID EntityIDManager::next()
 {
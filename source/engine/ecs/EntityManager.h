@@ -5,34 +5,33 @@
 #include <assert.h>
 #include "ecs_settings.h"
 #include <engine/memory/Pool.h>
+#include <engine/memory/SparsePool.h>
+#include <engine/util/ThreadPool.h>
 #include <unordered_map>
 #include <cstddef>
+#include <memory>
+#include <algorithm>
 
 /*
 ~~~~~ Features ~~~~~
 - Good cache utilization.
 - Fast Add, Remove, Get operations on entities and components.
 - Fast entity traversal.
+- Usage hints for component types (see ComponentUsage):
+- "Highly Dynamic" (default): High usage of Add, Remove operations.
+-> fast Add, Remove but higher space consumption (O(n) where n is the number of entities)
+- "Mostly Static": No or very low Add, Remove usage.
+-> lower space consumption (O(n) where n is the number of components) but slower Add, Remove
+Components of "Mostly Static" types are stored in a sparse set and kept densely packed.
 
 ~~~~~ Limitations ~~~~~
 - No multithreading considerations.
-- High space reservation. Example:
+- High space reservation for "Highly Dynamic" component types. Example:
 100 entities are in the game - only 1 entity has Component of type X - space for 100 components of types X is reserved.
 
 ~~~~~ Future considerations ~~~~~
-- Make it hybrid:
-There is often no need for fast Add, Remove operations but a higher need for lower space consumption.
-Give the user the ability to specify usage hints for component types:
-- "Mostly Static": No or very low Add, Remove usage.
--> lower space consumption (O(n) where n is the number of components) but slower Add, Remove
-- "Highly Dynamic": High usage of Add, Remove operations.
--> faster Add, Remove but higher space consumption (O(n) where n is the number of entities)
-- "Default": One of the following ideas: (TBD)
-1. Compromise between the 2 above: Reserve "a bit" (TBD) more space to prepare for Add, Remove
-or
-2. Adapt to usage (intelligent/learning system) - Implementation time cost probably outweighs the (potentially low) benefits.
-or
-3. Default to Static or Dynamic
+- Adapt the storage to the usage of component types (intelligent/learning system)
+- Implementation time cost probably outweighs the (potentially low) benefits.
 */
 
 class Component;
@@ -195,10 +194,29 @@ private:
 #endif
 };
 
+/**
+* Usage hints for component types which determine how the components are stored.
+*/
+enum class ComponentUsage
+{
+    // Components are stored in a pool with one slot per entity
+    HighlyDynamic,
+    // Components are stored densely packed in a sparse set
+    MostlyStatic
+};
+
 class Component
 {
     friend class EntityManager;
 public:
+    // Component types can hide this member to choose another storage policy
+    static constexpr ComponentUsage USAGE_HINT = ComponentUsage::HighlyDynamic;
+
+    // Component types can hide this member to allow update() and lateUpdate() calls of
+    // different components of this type on multiple threads at the same time.
+    // This is only safe if the functions don't modify anything but the component itself.
+    static constexpr bool PARALLEL_UPDATE = false;
+
     virtual ~Component() { }
 
     virtual void update() { }
@@ -243,6 +261,10 @@ private:
 // Each Pool manages components of a unique component type
 using ComponentPools = std::vector<BasePool*>;
 
+// The pool type of a component type depends on its usage hint
+template <class C>
+using ComponentPool = typename std::conditional<std::remove_const<C>::type::USAGE_HINT == ComponentUsage::MostlyStatic, SparsePool<C>, Pool<C>>::type;
+
 // The component mask is used to identify which components are assigned to an entity
 // All component types have one unique bit which corresponds to the ComponentPools index
 using ComponentMask = std::bitset<MAX_COMPONENTS>;
@@ -252,10 +274,23 @@ using EntityVersions = std::vector<EntityVersion>;
 
 using ComponentTypeID = uint32_t;
 
+// Properties of a component type which are declared by the type itself
+struct ComponentTypeInfo
+{
+    ComponentTypeInfo() { }
+
+    ComponentTypeInfo(ComponentUsage usage, bool parallelUpdate)
+        : usage(usage), parallelUpdate(parallelUpdate) { }
+
+    ComponentUsage usage{ComponentUsage::HighlyDynamic};
+    bool parallelUpdate{false};
+};
+
 class EntityManager
 {
     friend class Entity;
     friend class ECSTest;
+    friend class ECSBenchmark;
     friend class ECS;
     friend class ComponentPtr<Component>;
 
@@ -264,6 +299,80 @@ class EntityManager
     // Default ValidType: inactive entities will be skipped
     class ValidTypeDefault;
 
+    // Sorted ids of all entities that match the component mask of a query.
+    // A list is created on the first query with its mask and kept up to date
+    // when components are added/removed and entities are created/destroyed/(de)activated.
+    struct EntityMatchList
+    {
+        EntityMatchList(const ComponentMask& mask, bool includeInactive)
+            : mask(mask), includeInactive(includeInactive) { }
+
+        ComponentMask mask;
+        bool includeInactive;
+        std::vector<EntityID> ids;
+    };
+
+    /**
+    * Iterates over the entities of a match list in O(number of matches).
+    * The list is allowed to change during iteration: If the current entity was removed
+    * or entities were inserted before it then the iteration continues with the next higher entity id.
+    */
+    class EntityQueryIterator : public std::iterator<std::input_iterator_tag, Entity>
+    {
+        friend class EntityManager;
+
+    public:
+        bool operator ==(const EntityQueryIterator& other) const { return atEnd() ? other.atEnd() : !other.atEnd() && m_idx == other.m_idx; }
+
+        bool operator !=(const EntityQueryIterator& other) const { return !(*this == other); }
+
+        Entity operator *() const { return Entity(m_id, m_manager->m_versions[m_id], m_manager); }
+
+        EntityQueryIterator& operator ++()
+        {
+            auto& ids = m_list->ids;
+
+            if (m_idx < ids.size() && ids[m_idx] == m_id)
+                ++m_idx;
+            else
+                m_idx = std::size_t(std::upper_bound(ids.begin(), ids.end(), m_id) - ids.begin());
+
+            updateID();
+            return *this;
+        }
+
+        EntityQueryIterator begin() const
+        {
+            auto it = EntityQueryIterator(m_manager, m_list, 0);
+            it.updateID();
+            return it;
+        }
+
+        EntityQueryIterator end() const { return EntityQueryIterator(m_manager, m_list, std::numeric_limits<std::size_t>::max()); }
+
+    private:
+        EntityQueryIterator(EntityManager* manager, const EntityMatchList* list, std::size_t idx = 0)
+            : m_manager(manager), m_list(list), m_idx(idx) { }
+
+        bool atEnd() const { return m_idx >= m_list->ids.size(); }
+
+        void updateID()
+        {
+            if (!atEnd())
+                m_id = m_list->ids[m_idx];
+        }
+
+    private:
+        EntityManager* m_manager;
+        const EntityMatchList* m_list;
+        std::size_t m_idx;
+        EntityID m_id{0};
+    };
+
+    /**
+    * Iterates over all entity ids and skips those that don't match - O(number of entities).
+    * Used as a reference for the match lists.
+    */
     template <class TValid>
     class EntityIteratorBase : public std::iterator<std::input_iterator_tag, Entity>
     {
@@ -316,14 +425,21 @@ class EntityManager
         EntityID m_i;
     };
 
-    using EntityIterator = EntityIteratorBase<ValidTypeDefault>;
-    using EntityIteratorIncludeInactive = EntityIteratorBase<ValidTypeIncludeInactive>;
+    using EntityScanIterator = EntityIteratorBase<ValidTypeDefault>;
+    using EntityScanIteratorIncludeInactive = EntityIteratorBase<ValidTypeIncludeInactive>;
+
+    using EntityIterator = EntityQueryIterator;
+    using EntityIteratorIncludeInactive = EntityQueryIterator;
 
 public:
     ~EntityManager();
 
-    void update();
-    void lateUpdate();
+    /**
+    * Updates all components of active entities. Components of types with PARALLEL_UPDATE
+    * are updated in parallel if a threadPool is given.
+    */
+    void update(ThreadPool* threadPool = nullptr);
+    void lateUpdate(ThreadPool* threadPool = nullptr);
 
     bool valid(const Entity& entity) const { return entity.m_id < m_versions.size() && m_versions[entity.m_id] == entity.m_version; }
 
@@ -377,15 +493,39 @@ private:
     template <class C>
     const C* getComponentPtr(const Entity& entity) const;
 
+    template <class... Components>
+    EntityScanIterator scanEntitiesWithComponents() { return EntityScanIterator(this, makeComponentMask<Components...>()); }
+
+    template <class... Components>
+    EntityScanIteratorIncludeInactive scanEntitiesWithComponentsIncludeInactive() { return EntityScanIteratorIncludeInactive(this, makeComponentMask<Components...>()); }
+
+    EntityMatchList* getMatchList(const ComponentMask& mask, bool includeInactive);
+
+    bool matches(EntityID id, const EntityMatchList& list) const;
+
+    /**
+    * Inserts/removes the entity into/from the match lists according to its current state.
+    */
+    void updateMatchLists(EntityID id);
+
     template <class C>
-    Pool<C>* getPool();
+    ComponentPool<C>* getPool();
 
-    Pool<Component>* getPool(std::size_t componentTypeID);
+    BasePool* getPool(std::size_t componentTypeID);
 
     template <class C>
-    const Pool<const C>* getPool() const;
+    const ComponentPool<const C>* getPool() const;
+
+    const BasePool* getPool(std::size_t componentTypeID) const;
+
+    bool isSparse(std::size_t componentTypeID) const { return m_componentTypeInfos[componentTypeID].usage == ComponentUsage::MostlyStatic; }
 
-    const Pool<const Component>* getPool(std::size_t componentTypeID) const;
+    /**
+    * Calls func for every component of active entities. Pools of component types with parallel updates
+    * are split into chunks which are processed by the threadPool if it is not null.
+    */
+    template <class TFunc>
+    void forEachActiveComponent(TFunc func, ThreadPool* threadPool);
 
     // Used to assign an id to each component type local to the EntityManager.
     // Starting at 0 and increasing by 1. It's used as an index into a container.
@@ -402,10 +542,12 @@ private:
     std::vector<bool> m_alive;
     std::vector<bool> m_active;
     ComponentPools m_componentPools;
+    std::vector<ComponentTypeInfo> m_componentTypeInfos;
     ComponentMasks m_componentMasks;
     std::vector<std::string> m_names;
     EntityVersions m_versions;
     EntityIDManager m_idManager;
+    std::vector<std::unique_ptr<EntityMatchList>> m_matchLists;
     std::size_t m_totalEntityCounter{0}; // Increases when a new entity is added but never decreases
 };
 
@@ -417,12 +559,20 @@ void EntityManager::addComponent(const Entity& entity, Args&&... args)
     ComponentTypeID compTypeID = getComponentTypeID<C>();
 
     // Make sure a component pool for this component type exists
-    if (m_componentPools.size() <= compTypeID) { m_componentPools.resize(compTypeID + 1); }
+    if (m_componentPools.size() <= compTypeID)
+    {
+        m_componentPools.resize(compTypeID + 1);
+        m_componentTypeInfos.resize(compTypeID + 1);
+    }
 
     if (!m_componentPools[compTypeID])
     {
-        m_componentPools[compTypeID] = new Pool<C>();
-        m_componentPools[compTypeID]->resize(m_versions.size());
+        m_componentPools[compTypeID] = new ComponentPool<C>();
+        m_componentTypeInfos[compTypeID] = ComponentTypeInfo(C::USAGE_HINT, C::PARALLEL_UPDATE);
+
+        // Sparse pools grow with the number of components
+        if (!isSparse(compTypeID))
+            m_componentPools[compTypeID]->resize(m_versions.size());
     }
 
     // Set the component mask bit
@@ -431,6 +581,8 @@ void EntityManager::addComponent(const Entity& entity, Args&&... args)
     // Create the component with the given arguments
     C* component = getPool<C>()->create(entity.m_id, std::forward<Args>(args)...);
     component->m_owner = entity;
+
+    updateMatchLists(entity.m_id);
 }
 
 template <class C>
@@ -439,6 +591,7 @@ void EntityManager::removeComponent(const Entity& entity)
     assert(valid(entity) && hasComponent<C>(entity));
     m_componentMasks[entity.m_id].reset(getComponentTypeID<C>());
     getPool<C>()->destroy(entity.m_id);
+    updateMatchLists(entity.m_id);
 }
 
 template <class C>
@@ -465,35 +618,19 @@ ComponentPtr<C> EntityManager::getComponent(const Entity& entity) const
 template <class ... Components>
 EntityManager::EntityIterator EntityManager::getEntitiesWithComponents()
 {
-    return EntityIterator(this, makeComponentMask<Components...>());
+    return EntityIterator(this, getMatchList(makeComponentMask<Components...>(), false));
 }
 
 template <class ... Components>
 EntityManager::EntityIteratorIncludeInactive EntityManager::getEntitiesWithComponentsIncludeInactive()
 {
-    return EntityIteratorIncludeInactive(this, makeComponentMask<Components...>());
+    return EntityIteratorIncludeInactive(this, getMatchList(makeComponentMask<Components...>(), true));
 }
 
 template <class ... Components>
 EntityID EntityManager::numberOfEntitiesWithComponents(bool includeInactive)
 {
-    ComponentMask mask = makeComponentMask<Components...>();
-
-    EntityID size = 0;
-    if (includeInactive)
-    {
-        for (EntityID i = 0; i < m_versions.size(); ++i)
-            if (m_alive[i] && (m_componentMasks[i] & mask) == mask)
-                ++size;
-    }
-    else
-    {
-        for (EntityID i = 0; i < m_versions.size(); ++i)
-            if (m_alive[i] && m_active[i] && (m_componentMasks[i] & mask) == mask)
-                ++size;
-    }
-
-    return size;
+    return EntityID(getMatchList(makeComponentMask<Components...>(), includeInactive)->ids.size());
 }
 
 template <class C>
@@ -511,19 +648,64 @@ const C* EntityManager::getComponentPtr(const Entity& entity) const
 }
 
 template <class C>
-Pool<C>* EntityManager::getPool()
+ComponentPool<C>* EntityManager::getPool()
 {
     assert(getComponentTypeID<C>() < m_componentPools.size());
     assert(m_componentPools[getComponentTypeID<C>()]);
-    return static_cast<Pool<C>*>(m_componentPools[getComponentTypeID<C>()]);
+    return static_cast<ComponentPool<C>*>(m_componentPools[getComponentTypeID<C>()]);
 }
 
 template <class C>
-const Pool<const C>* EntityManager::getPool() const
+const ComponentPool<const C>* EntityManager::getPool() const
 {
     assert(getComponentTypeID<C>() < m_componentPools.size());
     assert(m_componentPools[getComponentTypeID<C>()]);
-    return static_cast<const Pool<const C>*>(m_componentPools[getComponentTypeID<C>()]);
+    return static_cast<const ComponentPool<const C>*>(m_componentPools[getComponentTypeID<C>()]);
+}
+
+template <class TFunc>
+void EntityManager::forEachActiveComponent(TFunc func, ThreadPool* threadPool)
+{
+    for (std::size_t componentTypeID = 0; componentTypeID < m_componentPools.size(); ++componentTypeID)
+    {
+        auto componentPool = m_componentPools[componentTypeID];
+
+        if (!componentPool)
+            continue;
+
+        bool sparse = isSparse(componentTypeID);
+        ComponentMask mask;
+        mask.set(componentTypeID);
+
+        auto processRange = [&](std::size_t begin, std::size_t end)
+        {
+            if (sparse)
+            {
+                // Iterate over the packed components
+                auto sparsePool = static_cast<BaseSparsePool*>(componentPool);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    EntityID id = EntityID(sparsePool->keyAt(i));
+
+                    if (m_alive[id] && m_active[id])
+                        func(reinterpret_cast<Component*>(sparsePool->get(i)));
+                }
+            }
+            else
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    if ((m_componentMasks[i] & mask) == mask && m_alive[i] && m_active[i])
+                        func(reinterpret_cast<Component*>(componentPool->get(i)));
+                }
+            }
+        };
+
+        if (threadPool && m_componentTypeInfos[componentTypeID].parallelUpdate)
+            threadPool->parallelFor(componentPool->size(), PARALLEL_UPDATE_CHUNK_SIZE, processRange);
+        else
+            processRange(0, componentPool->size());
+    }
 }
 
 template <class C>
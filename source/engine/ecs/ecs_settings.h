@@ -5,3 +5,9 @@
 #endif
 
 #define MAX_COMPONENTS 64
+
+// Number of components per job if a component type is updated in parallel
+#define PARALLEL_UPDATE_CHUNK_SIZE 1024
+
+// Runs the ECS benchmarks on startup and logs the results
+//#define RUN_ECS_BENCHMARKS
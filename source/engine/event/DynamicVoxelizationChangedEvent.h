@@ -0,0 +1,13 @@
+#pragma once
+#include "engine/ecs/EntityManager.h"
+
+/**
+* Transmitted when the DynamicVoxelization component was added to or removed from the entity.
+*/
+struct DynamicVoxelizationChangedEvent
+{
+    DynamicVoxelizationChangedEvent(const Entity& entity)
+        :entity(entity) {}
+
+    Entity entity;
+};
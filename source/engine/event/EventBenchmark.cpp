@@ -0,0 +1,98 @@
+#include "EventBenchmark.h"
+#include "event.h"
+#include <engine/util/Timer.h>
+#include <engine/util/Logger.h>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+namespace event_benchmark
+{
+    const int EVENT_COUNT = 1000000;
+
+    struct BenchmarkEvent
+    {
+        int value;
+    };
+
+    class BenchmarkReceiver : public Receiver<BenchmarkEvent>
+    {
+    public:
+        void receive(const BenchmarkEvent& event) override { sum += event.value; }
+
+        int64_t sum{0};
+    };
+
+    uint64_t eventsPerSecond(uint64_t eventCount, const Timer& timer)
+    {
+        return eventCount * 1000000 / std::max<uint64_t>(timer.deltaTimeInMicroseconds(), 1);
+    }
+
+#ifdef RUN_EVENT_BENCHMARKS
+    struct EventBenchmarkRunner
+    {
+        EventBenchmarkRunner()
+        {
+            EventBenchmark::runBenchmarks();
+        }
+    };
+
+    EventBenchmarkRunner eventBenchmarkRunner;
+#endif
+}
+
+using namespace event_benchmark;
+
+void EventBenchmark::runBenchmarks()
+{
+    benchmarkTransmit();
+
+    for (int producerCount : {1, 2, 4, 8})
+        benchmarkPost(producerCount);
+}
+
+void EventBenchmark::benchmarkTransmit()
+{
+    BenchmarkReceiver receiver;
+    Timer timer;
+
+    timer.start();
+    for (int i = 0; i < EVENT_COUNT; ++i)
+        Event::transmit<BenchmarkEvent>(i);
+    timer.tick();
+
+    LOG("Event Benchmark: transmit " << eventsPerSecond(EVENT_COUNT, timer) << " events/s (sum " << receiver.sum << ")");
+}
+
+void EventBenchmark::benchmarkPost(int producerCount)
+{
+    BenchmarkReceiver receiver;
+    std::atomic<int> finishedCount{0};
+    Timer timer;
+
+    timer.start();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p)
+    {
+        producers.emplace_back([&finishedCount, producerCount]()
+        {
+            for (int i = 0; i < EVENT_COUNT / producerCount; ++i)
+                Event::post<BenchmarkEvent>(i);
+
+            ++finishedCount;
+        });
+    }
+
+    uint64_t deliveredCount = 0;
+    while (finishedCount.load() < producerCount)
+        deliveredCount += Event::dispatchQueued();
+
+    for (auto& producer : producers)
+        producer.join();
+
+    deliveredCount += Event::dispatchQueued();
+    timer.tick();
+
+    LOG("Event Benchmark: post from " << producerCount << " threads " << eventsPerSecond(deliveredCount, timer) << " events/s (sum " << receiver.sum << ")");
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Runs the event benchmarks on startup and logs the results
+//#define RUN_EVENT_BENCHMARKS
+
+class EventBenchmark
+{
+public:
+    static void runBenchmarks();
+
+private:
+    static void benchmarkTransmit();
+
+    /**
+    * Events posted from producerCount threads while the main thread dispatches them.
+    */
+    static void benchmarkPost(int producerCount);
+};
@@ -0,0 +1,142 @@
+#include "EventTest.h"
+#include "event.h"
+#include <thread>
+#include <vector>
+#include <cassert>
+
+namespace event_test
+{
+    struct TestEvent
+    {
+        int producer;
+        int value;
+    };
+
+    struct OtherTestEvent
+    {
+        int value;
+    };
+
+    /**
+    * Checks that the events of each producer arrive in the order they were posted.
+    */
+    class TestReceiver : public Receiver<TestEvent>, public Receiver<OtherTestEvent>
+    {
+    public:
+        void receive(const TestEvent& event) override
+        {
+            if (std::size_t(event.producer) >= lastValues.size())
+                lastValues.resize(event.producer + 1, -1);
+
+            if (event.value <= lastValues[event.producer])
+                ordered = false;
+
+            lastValues[event.producer] = event.value;
+            ++count;
+        }
+
+        void receive(const OtherTestEvent& event) override { otherSum += event.value; }
+
+        std::vector<int> lastValues;
+        bool ordered{true};
+        std::size_t count{0};
+        int otherSum{0};
+    };
+
+#ifdef RUN_EVENT_TESTS
+    struct EventTestRunner
+    {
+        EventTestRunner()
+        {
+            EventTest::runTests();
+        }
+    };
+
+    EventTestRunner eventTestRunner;
+#endif
+}
+
+using namespace event_test;
+
+void EventTest::runTests()
+{
+    testTransmit();
+    testPost();
+    testMultipleProducers();
+    testOverflow();
+}
+
+void EventTest::testTransmit()
+{
+    TestReceiver receiver;
+
+    Event::transmit<TestEvent>(0, 1);
+    Event::transmit<OtherTestEvent>(5);
+    assert(receiver.count == 1);
+    assert(receiver.otherSum == 5);
+}
+
+void EventTest::testPost()
+{
+    TestReceiver receiver;
+
+    Event::post<TestEvent>(0, 1);
+    Event::post<TestEvent>(0, 2);
+    Event::post<OtherTestEvent>(5);
+    assert(receiver.count == 0);
+    assert(receiver.otherSum == 0);
+
+    assert(Event::dispatchQueued() == 3);
+    assert(receiver.count == 2);
+    assert(receiver.otherSum == 5);
+    assert(receiver.ordered);
+
+    assert(Event::dispatchQueued() == 0);
+}
+
+void EventTest::testMultipleProducers()
+{
+    const int producerCount = 4;
+    const int eventsPerProducer = 20000;
+    TestReceiver receiver;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p)
+    {
+        producers.emplace_back([p]()
+        {
+            for (int i = 0; i < eventsPerProducer; ++i)
+                Event::post<TestEvent>(p, i);
+        });
+    }
+
+    // The main thread dispatches while the producers are still posting
+    for (int i = 0; i < 100; ++i)
+        Event::dispatchQueued();
+
+    for (auto& producer : producers)
+        producer.join();
+
+    Event::dispatchQueued();
+    assert(receiver.count == std::size_t(producerCount * eventsPerProducer));
+    assert(receiver.ordered);
+}
+
+void EventTest::testOverflow()
+{
+    const int eventCount = EVENT_QUEUE_CAPACITY * 2 + 10;
+    TestReceiver receiver;
+
+    for (int i = 0; i < eventCount; ++i)
+        Event::post<TestEvent>(0, i);
+
+    assert(receiver.count == 0);
+    assert(Event::dispatchQueued() == std::size_t(eventCount));
+    assert(receiver.count == std::size_t(eventCount));
+    assert(receiver.ordered);
+
+    // The queue is used again after the overflow was delivered
+    Event::post<TestEvent>(0, eventCount);
+    assert(Event::dispatchQueued() == 1);
+    assert(receiver.ordered);
+}
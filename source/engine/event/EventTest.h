@@ -0,0 +1,17 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_EVENT_TESTS
+#endif
+
+class EventTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testTransmit();
+    static void testPost();
+    static void testMultipleProducers();
+    static void testOverflow();
+};
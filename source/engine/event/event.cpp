@@ -1 +1,31 @@
 #include "event.h"
+
+std::size_t EventTransmitter::dispatchQueued()
+{
+    // Channels can be created by other threads during the dispatch
+    std::size_t channelCount;
+    {
+        std::lock_guard<std::mutex> lock(m_channelsMutex);
+        channelCount = m_channels.size();
+    }
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < channelCount; ++i)
+    {
+        BaseEventChannel* channel;
+        {
+            std::lock_guard<std::mutex> lock(m_channelsMutex);
+            channel = m_channels[i];
+        }
+
+        count += channel->dispatchQueued();
+    }
+
+    return count;
+}
+
+void EventTransmitter::registerChannel(BaseEventChannel* channel)
+{
+    std::lock_guard<std::mutex> lock(m_channelsMutex);
+    m_channels.push_back(channel);
+}
@@ -1,11 +1,15 @@
 #pragma once
-#include <unordered_map>
-#include <typeindex>
 #include <vector>
-#include <functional>
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include <assert.h>
+#include <cstddef>
+#include <engine/util/MPSCQueue.h>
+
+// Number of queued events per event type that fit into the lock-free queue. Further events go to a locked overflow list.
+#define EVENT_QUEUE_CAPACITY 4096
 
 class BaseReceiver
 {
@@ -23,16 +27,74 @@ public:
     virtual void receive(const TEvent& event) = 0;
 };
 
+class BaseEventChannel
+{
+public:
+    virtual ~BaseEventChannel() { }
+
+    /**
+    * Delivers the queued events to the receivers.
+    * @return The number of delivered events.
+    */
+    virtual std::size_t dispatchQueued() = 0;
+};
+
+/**
+* Receivers and queued events of a single event type. There is one channel per type - the channel is found
+* through the template instantiation at compile time instead of a lookup by type.
+*/
+template <class TEvent>
+class EventChannel : public BaseEventChannel
+{
+    friend class EventTransmitter;
+public:
+    EventChannel()
+        : m_queue(EVENT_QUEUE_CAPACITY) { }
+
+    std::size_t dispatchQueued() override;
+
+private:
+    void deliver(const TEvent& event)
+    {
+        for (auto receiver : m_receivers)
+            receiver->receive(event);
+    }
+
+private:
+    std::vector<Receiver<TEvent>*> m_receivers;
+    MPSCQueue<TEvent> m_queue;
+
+    std::mutex m_overflowMutex;
+    std::vector<TEvent> m_overflow;
+    std::atomic<bool> m_hasOverflow{false};
+};
+
+/**
+* Events are either transmitted synchronously - the receivers are called immediately on the calling thread -
+* or posted to a queue from any thread and delivered on the main thread with dispatchQueued().
+* Subscriptions and synchronous transmissions are only allowed on the main thread.
+*/
 class EventTransmitter
 {
     friend class Event;
-
-    typedef std::function<void(const void* event)> BaseReceiveFunc;
-    typedef std::vector<BaseReceiver*> ReceiverContainer;
 public:
     template <class TEvent, class... Args>
     void transmit(Args&&... args);
 
+    /**
+    * Thread-safe. The event is delivered with the next dispatchQueued().
+    */
+    template <class TEvent, class... Args>
+    void post(Args&&... args);
+
+    /**
+    * Delivers the posted events of all types. Events of the same type are delivered in the order they were posted
+    * by a thread unless the queue overflows during the dispatch. Events posted by the receivers during the dispatch
+    * may already be delivered in the same call.
+    * @return The number of delivered events.
+    */
+    std::size_t dispatchQueued();
+
     template <class TEvent>
     void subscribe(Receiver<TEvent>* receiver) noexcept;
 
@@ -48,8 +110,14 @@ public:
 private:
     EventTransmitter() { }
 
+    template <class TEvent>
+    EventChannel<TEvent>& getChannel();
+
+    void registerChannel(BaseEventChannel* channel);
+
 private:
-    std::unordered_map<std::type_index, ReceiverContainer> m_receiverMap;
+    std::mutex m_channelsMutex;
+    std::vector<BaseEventChannel*> m_channels;
 };
 
 class Event
@@ -58,6 +126,11 @@ public:
     template <class TEvent, class... Args>
     static void transmit(Args&&... args);
 
+    template <class TEvent, class... Args>
+    static void post(Args&&... args);
+
+    static std::size_t dispatchQueued() { return transmitter().dispatchQueued(); }
+
     static EventTransmitter& transmitter()
     {
         static EventTransmitter* m_transmitter = new EventTransmitter();
@@ -68,30 +141,81 @@ public:
 template <class TEvent, class... Args>
 void Event::transmit(Args&&... args) { transmitter().transmit<TEvent>(std::forward<Args>(args)...); }
 
+template <class TEvent, class... Args>
+void Event::post(Args&&... args) { transmitter().post<TEvent>(std::forward<Args>(args)...); }
+
 template <class TEvent>
 Receiver<TEvent>::Receiver() { Event::transmitter().subscribe(this); }
 
 template <class TEvent>
 Receiver<TEvent>::~Receiver() { Event::transmitter().unsubscribe(this); }
 
+template <class TEvent>
+std::size_t EventChannel<TEvent>::dispatchQueued()
+{
+    std::size_t count = 0;
+    while (m_queue.tryConsume([this](const TEvent& event) { deliver(event); }))
+        ++count;
+
+    if (m_hasOverflow.load(std::memory_order_acquire))
+    {
+        std::vector<TEvent> overflow;
+        {
+            std::lock_guard<std::mutex> lock(m_overflowMutex);
+            overflow.swap(m_overflow);
+            m_hasOverflow.store(false, std::memory_order_relaxed);
+        }
+
+        for (auto& event : overflow)
+            deliver(event);
+
+        count += overflow.size();
+    }
+
+    return count;
+}
+
+template <class TEvent>
+EventChannel<TEvent>& EventTransmitter::getChannel()
+{
+    // Created on first use of the event type
+    static EventChannel<TEvent>* channel = [this]()
+    {
+        auto newChannel = new EventChannel<TEvent>();
+        registerChannel(newChannel);
+        return newChannel;
+    }();
+
+    return *channel;
+}
+
 template <class TEvent, class... Args>
 void EventTransmitter::transmit(Args&&... args)
 {
     TEvent event{std::forward<Args>(args)...};
-    auto eventId = std::type_index(typeid(TEvent));
-    auto& receivers = m_receiverMap[eventId];
-    for (auto r : receivers)
-    {
-        Receiver<TEvent>* receiver = static_cast<Receiver<TEvent>*>(r);
-        receiver->receive(event);
-    }
+    getChannel<TEvent>().deliver(event);
+}
+
+template <class TEvent, class... Args>
+void EventTransmitter::post(Args&&... args)
+{
+    auto& channel = getChannel<TEvent>();
+    TEvent event{std::forward<Args>(args)...};
+
+    // The event is only moved if the queue has space. Once events overflowed the following events
+    // are appended to the overflow list as well to keep their order.
+    if (!channel.m_hasOverflow.load(std::memory_order_acquire) && channel.m_queue.tryPush(std::move(event)))
+        return;
+
+    std::lock_guard<std::mutex> lock(channel.m_overflowMutex);
+    channel.m_overflow.push_back(std::move(event));
+    channel.m_hasOverflow.store(true, std::memory_order_release);
 }
 
 template <class TEvent>
 void EventTransmitter::unsubscribe(Receiver<TEvent>* receiver) noexcept
 {
-    auto eventId = std::type_index(typeid(TEvent));
-    auto& receivers = m_receiverMap[eventId];
+    auto& receivers = getChannel<TEvent>().m_receivers;
     auto it = std::remove(receivers.begin(), receivers.end(), receiver);
     if (it != receivers.end())
         receivers.erase(it);
@@ -100,8 +224,7 @@ void EventTransmitter::unsubscribe(Receiver<TEvent>* receiver) noexcept
 template <class TEvent>
 void EventTransmitter::subscribe(Receiver<TEvent>* receiver) noexcept
 {
-    auto eventId = std::type_index(typeid(TEvent));
-    auto& receivers = m_receiverMap[eventId];
+    auto& receivers = getChannel<TEvent>().m_receivers;
     assert(std::find(receivers.begin(), receivers.end(), receiver) == receivers.end());
     receivers.push_back(receiver);
 }
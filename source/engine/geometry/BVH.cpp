@@ -0,0 +1,177 @@
+#include "BVH.h"
+#include <algorithm>
+
+const uint32_t BVH::MAX_DEPTH;
+const uint32_t BVH::MAX_LEAF_COUNT;
+
+namespace
+{
+    const uint32_t BIN_COUNT = 16;
+
+    // Cost of traversing a node relative to the cost of testing a primitive
+    const float TRAVERSAL_COST = 1.0f;
+
+    struct Bin
+    {
+        BBox bbox;
+        uint32_t count{0};
+    };
+}
+
+void BVH::build(const std::vector<BBox>& primitiveBBoxes, uint32_t maxLeafSize)
+{
+    assert(maxLeafSize > 0);
+    m_nodes.clear();
+    m_primitiveBBoxes = primitiveBBoxes;
+    m_primitiveIndices.resize(primitiveBBoxes.size());
+
+    if (primitiveBBoxes.empty())
+        return;
+
+    std::vector<glm::vec3> centroids(primitiveBBoxes.size());
+    for (uint32_t i = 0; i < primitiveBBoxes.size(); ++i)
+    {
+        m_primitiveIndices[i] = i;
+        centroids[i] = primitiveBBoxes[i].center();
+    }
+
+    m_nodes.reserve(2 * primitiveBBoxes.size());
+    buildRecursive(0, uint32_t(primitiveBBoxes.size()), 0, centroids, maxLeafSize);
+}
+
+void BVH::refit(const std::vector<BBox>& primitiveBBoxes)
+{
+    assert(primitiveBBoxes.size() == m_primitiveBBoxes.size());
+    m_primitiveBBoxes = primitiveBBoxes;
+
+    // Children always have higher indices than their parents
+    for (std::size_t i = m_nodes.size(); i-- > 0;)
+    {
+        Node& node = m_nodes[i];
+        BBox bbox;
+
+        if (node.isLeaf())
+        {
+            for (uint32_t j = node.offset; j < node.offset + node.count; ++j)
+                bbox.unite(m_primitiveBBoxes[m_primitiveIndices[j]]);
+        }
+        else
+        {
+            bbox = m_nodes[i + 1].bbox;
+            bbox.unite(m_nodes[node.offset].bbox);
+        }
+
+        node.bbox = bbox;
+    }
+}
+
+uint32_t BVH::buildRecursive(uint32_t begin, uint32_t end, uint32_t depth, const std::vector<glm::vec3>& centroids, uint32_t maxLeafSize)
+{
+    uint32_t nodeIdx = uint32_t(m_nodes.size());
+    m_nodes.emplace_back();
+
+    BBox bbox;
+    BBox centroidBBox;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        bbox.unite(m_primitiveBBoxes[m_primitiveIndices[i]]);
+        centroidBBox.unite(centroids[m_primitiveIndices[i]]);
+    }
+
+    uint32_t count = end - begin;
+    uint8_t axis = centroidBBox.maxExtentIdx();
+    float centroidMin = centroidBBox.min()[axis];
+    float centroidExtent = centroidBBox.scale()[axis];
+
+    auto makeInterior = [&](uint32_t mid)
+    {
+        buildRecursive(begin, mid, depth + 1, centroids, maxLeafSize);
+        uint32_t rightChild = buildRecursive(mid, end, depth + 1, centroids, maxLeafSize);
+
+        Node& node = m_nodes[nodeIdx];
+        node.bbox = bbox;
+        node.offset = rightChild;
+        node.count = 0;
+        node.axis = axis;
+        return nodeIdx;
+    };
+
+    auto makeLeaf = [&]()
+    {
+        // Split too large leaves in the middle, e.g. if all centroids are equal
+        if (count > MAX_LEAF_COUNT)
+        {
+            assert(depth + 1 < MAX_DEPTH);
+            return makeInterior(begin + count / 2);
+        }
+
+        Node& node = m_nodes[nodeIdx];
+        node.bbox = bbox;
+        node.offset = begin;
+        node.count = uint16_t(count);
+        return nodeIdx;
+    };
+
+    // The depth limit guarantees that the traversal stack can't overflow
+    if (count <= maxLeafSize || centroidExtent <= 0.0f || depth + 2 >= MAX_DEPTH)
+        return makeLeaf();
+
+    // Bin the primitives along the axis with the largest centroid extent
+    Bin bins[BIN_COUNT];
+    auto binIdx = [&](uint32_t primitiveIdx)
+    {
+        uint32_t b = uint32_t(BIN_COUNT * (centroids[primitiveIdx][axis] - centroidMin) / centroidExtent);
+        return std::min(b, BIN_COUNT - 1);
+    };
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        Bin& bin = bins[binIdx(m_primitiveIndices[i])];
+        bin.bbox.unite(m_primitiveBBoxes[m_primitiveIndices[i]]);
+        ++bin.count;
+    }
+
+    // Sweep from the right to get the costs of all right sides
+    float rightCosts[BIN_COUNT];
+    BBox rightBBox;
+    uint32_t rightCount = 0;
+    for (uint32_t i = BIN_COUNT - 1; i > 0; --i)
+    {
+        rightBBox.unite(bins[i].bbox);
+        rightCount += bins[i].count;
+        rightCosts[i] = rightCount > 0 ? rightCount * rightBBox.surfaceArea() : 0.0f;
+    }
+
+    // Sweep from the left and find the split with the lowest SAH cost
+    BBox leftBBox;
+    uint32_t leftCount = 0;
+    float bestCost = FLT_MAX;
+    uint32_t bestSplit = 0;
+    for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+    {
+        leftBBox.unite(bins[i].bbox);
+        leftCount += bins[i].count;
+
+        if (leftCount == 0 || leftCount == count)
+            continue;
+
+        float cost = leftCount * leftBBox.surfaceArea() + rightCosts[i + 1];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = i + 1;
+        }
+    }
+
+    float area = bbox.surfaceArea();
+    float splitCost = TRAVERSAL_COST + (area > 0.0f ? bestCost / area : float(count));
+
+    if (bestCost == FLT_MAX || (splitCost >= float(count) && count <= 4 * maxLeafSize))
+        return makeLeaf();
+
+    auto first = m_primitiveIndices.begin() + begin;
+    auto last = m_primitiveIndices.begin() + end;
+    uint32_t mid = uint32_t(std::partition(first, last, [&](uint32_t primitiveIdx) { return binIdx(primitiveIdx) < bestSplit; }) - m_primitiveIndices.begin());
+
+    return makeInterior(mid);
+}
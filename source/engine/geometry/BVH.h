@@ -0,0 +1,276 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include "BBox.h"
+#include "Ray.h"
+#include "intersection.h"
+
+/**
+* Bounding volume hierarchy over primitives which are given by their bounding boxes.
+* The tree is built top-down with a binned surface area heuristic (SAH).
+* Nodes are stored in depth-first order: The left child of an interior node directly follows its parent.
+*
+* The BVH only knows the bounding boxes of the primitives. Exact tests (e.g. ray/triangle)
+* are performed by user provided functions which receive the index of the primitive.
+*/
+class BVH
+{
+public:
+    static const uint32_t MAX_DEPTH = 64;
+    static const uint32_t MAX_LEAF_COUNT = 0xFFFF;
+
+    /**
+    * Result of a batched query: Every reported primitive is stored once in primitives and
+    * the primitives of bbox i are primitives[bboxPrimitives[j]] for j in [bboxOffsets[i], bboxOffsets[i + 1]).
+    * Keep the result between queries to avoid reallocations.
+    */
+    class BatchQueryResult
+    {
+        friend class BVH;
+
+    public:
+        std::vector<uint32_t> primitives;
+        std::vector<uint32_t> bboxOffsets;
+        std::vector<uint32_t> bboxPrimitives;
+
+    private:
+        // Index into primitives per primitive of the BVH - reset after every query
+        std::vector<uint32_t> slots;
+        std::vector<uint32_t> rejectedPrimitives;
+    };
+
+    // 32 bytes: two nodes share a cache line
+    struct Node
+    {
+        bool isLeaf() const { return count > 0; }
+
+        BBox bbox;
+        uint32_t offset{0}; // Leaf: index of the first primitive in the primitive index list, Interior: index of the right child
+        uint16_t count{0}; // Number of primitives - 0 for interior nodes
+        uint16_t axis{0}; // Split axis of interior nodes
+    };
+
+    void build(const std::vector<BBox>& primitiveBBoxes, uint32_t maxLeafSize = 4);
+
+    /**
+    * Recomputes the node bounds bottom-up after primitives moved. The tree topology is kept,
+    * thus the quality of the tree decreases if primitives move a lot relative to each other - build() again in that case.
+    * The number of primitives must not change.
+    */
+    void refit(const std::vector<BBox>& primitiveBBoxes);
+
+    /**
+    * Finds the closest primitive hit by the ray in [0, tMax].
+    * intersectFunc(uint32_t primitiveIdx, float tMax, float& tHit) must return true and set tHit
+    * if the primitive is hit in [0, tMax].
+    * Returns true if a primitive was hit. primitiveIdx and t are set to the closest hit in that case.
+    */
+    template <class TIntersectFunc>
+    bool raycast(const Ray& ray, float tMax, TIntersectFunc intersectFunc, uint32_t& primitiveIdx, float& t) const;
+
+    /**
+    * Calls func(uint32_t primitiveIdx) for every primitive whose bounding box overlaps the given bbox.
+    */
+    template <class TFunc>
+    void query(const BBox& bbox, TFunc func) const;
+
+    /**
+    * Calls func(uint32_t primitiveIdx) for every primitive whose bounding box is not outside of one of the planes.
+    * See intersection::bboxPlanes for the plane convention.
+    */
+    template <class TFunc>
+    void query(const glm::vec4* planes, std::size_t planeCount, TFunc func) const;
+
+    /**
+    * Queries all bboxes at once (e.g. the revoxelization regions of a clipmap level) and reports every primitive
+    * that overlaps at least one of the bboxes and passes filter(uint32_t primitiveIdx) once.
+    * The filter is called once per primitive.
+    */
+    template <class TFilter>
+    void query(const std::vector<BBox>& bboxes, TFilter filter, BatchQueryResult& result) const;
+
+    bool empty() const { return m_nodes.empty(); }
+
+    std::size_t getPrimitiveCount() const { return m_primitiveBBoxes.size(); }
+
+    const std::vector<Node>& getNodes() const { return m_nodes; }
+
+    const BBox& getBBox() const { assert(!empty()); return m_nodes[0].bbox; }
+
+private:
+    uint32_t buildRecursive(uint32_t begin, uint32_t end, uint32_t depth, const std::vector<glm::vec3>& centroids, uint32_t maxLeafSize);
+
+    template <class TNodeTest, class TPrimitiveTest, class TFunc>
+    void traverse(TNodeTest nodeTest, TPrimitiveTest primitiveTest, TFunc func) const;
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_primitiveIndices;
+    std::vector<BBox> m_primitiveBBoxes;
+};
+
+template <class TIntersectFunc>
+bool BVH::raycast(const Ray& ray, float tMax, TIntersectFunc intersectFunc, uint32_t& primitiveIdx, float& t) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    glm::vec3 invDirection = 1.0f / ray.direction;
+    uint32_t stack[MAX_DEPTH];
+    uint32_t stackSize = 0;
+    uint32_t nodeIdx = 0;
+    float closestT = tMax;
+    bool hit = false;
+
+    while (true)
+    {
+        const Node& node = m_nodes[nodeIdx];
+        float tEntry;
+
+        if (intersection::rayBBox(ray.origin, invDirection, node.bbox, closestT, tEntry))
+        {
+            if (node.isLeaf())
+            {
+                for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+                {
+                    float tHit;
+                    if (intersectFunc(m_primitiveIndices[i], closestT, tHit))
+                    {
+                        closestT = tHit;
+                        primitiveIdx = m_primitiveIndices[i];
+                        hit = true;
+                    }
+                }
+            }
+            else
+            {
+                // Visit the near child first to shrink closestT as early as possible
+                uint32_t nearChild = nodeIdx + 1;
+                uint32_t farChild = node.offset;
+
+                if (ray.direction[node.axis] < 0.0f)
+                    std::swap(nearChild, farChild);
+
+                assert(stackSize < MAX_DEPTH);
+                stack[stackSize++] = farChild;
+                nodeIdx = nearChild;
+                continue;
+            }
+        }
+
+        if (stackSize == 0)
+            break;
+
+        nodeIdx = stack[--stackSize];
+    }
+
+    t = closestT;
+    return hit;
+}
+
+template <class TFunc>
+void BVH::query(const BBox& bbox, TFunc func) const
+{
+    auto test = [&bbox](const BBox& b) { return bbox.overlaps(b); };
+    traverse(test, test, func);
+}
+
+template <class TFunc>
+void BVH::query(const glm::vec4* planes, std::size_t planeCount, TFunc func) const
+{
+    auto test = [planes, planeCount](const BBox& b) { return intersection::bboxPlanes(b, planes, planeCount); };
+    traverse(test, test, func);
+}
+
+template <class TFilter>
+void BVH::query(const std::vector<BBox>& bboxes, TFilter filter, BatchQueryResult& result) const
+{
+    const uint32_t UNVISITED = 0xFFFFFFFF;
+    const uint32_t REJECTED = 0xFFFFFFFE;
+
+    result.primitives.clear();
+    result.bboxPrimitives.clear();
+    result.bboxOffsets.assign(1, 0);
+    result.slots.resize(m_primitiveBBoxes.size(), UNVISITED);
+
+    // Separate traversals per bbox are faster than one shared traversal: Both test the same nodes against the same bboxes
+    // but the shared traversal has to track which bboxes overlap a node. Only the results are shared.
+    for (const BBox& bbox : bboxes)
+    {
+        query(bbox, [&result, &filter, UNVISITED, REJECTED](uint32_t primitiveIdx)
+        {
+            uint32_t& slot = result.slots[primitiveIdx];
+
+            if (slot == UNVISITED)
+            {
+                if (filter(primitiveIdx))
+                {
+                    slot = uint32_t(result.primitives.size());
+                    result.primitives.push_back(primitiveIdx);
+                }
+                else
+                {
+                    slot = REJECTED;
+                    result.rejectedPrimitives.push_back(primitiveIdx);
+                }
+            }
+
+            if (slot != REJECTED)
+                result.bboxPrimitives.push_back(slot);
+        });
+
+        result.bboxOffsets.push_back(uint32_t(result.bboxPrimitives.size()));
+    }
+
+    for (uint32_t primitiveIdx : result.primitives)
+        result.slots[primitiveIdx] = UNVISITED;
+
+    for (uint32_t primitiveIdx : result.rejectedPrimitives)
+        result.slots[primitiveIdx] = UNVISITED;
+
+    result.rejectedPrimitives.clear();
+}
+
+template <class TNodeTest, class TPrimitiveTest, class TFunc>
+void BVH::traverse(TNodeTest nodeTest, TPrimitiveTest primitiveTest, TFunc func) const
+{
+    if (m_nodes.empty())
+        return;
+
+    uint32_t stack[MAX_DEPTH];
+    uint32_t stackSize = 0;
+    uint32_t nodeIdx = 0;
+
+    while (true)
+    {
+        const Node& node = m_nodes[nodeIdx];
+
+        if (nodeTest(node.bbox))
+        {
+            if (node.isLeaf())
+            {
+                for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+                {
+                    uint32_t primitiveIdx = m_primitiveIndices[i];
+                    if (primitiveTest(m_primitiveBBoxes[primitiveIdx]))
+                        func(primitiveIdx);
+                }
+            }
+            else
+            {
+                assert(stackSize < MAX_DEPTH);
+                stack[stackSize++] = node.offset;
+                nodeIdx = nodeIdx + 1;
+                continue;
+            }
+        }
+
+        if (stackSize == 0)
+            break;
+
+        nodeIdx = stack[--stackSize];
+    }
+}
@@ -0,0 +1,278 @@
+#include "GeometryBenchmark.h"
+#include "Transform.h"
+#include "TriangleBVH.h"
+#include <engine/util/Timer.h>
+#include <engine/util/ThreadPool.h>
+#include <engine/util/Logger.h>
+#include <engine/util/math.h>
+#include <random>
+#include <atomic>
+
+namespace geometry_benchmark
+{
+    /**
+    * Sponza-like scene graph: A root with groups of nodes that contain the meshes.
+    */
+    const int GROUP_COUNT = 32;
+    const int NODES_PER_GROUP = 16;
+    const int MESHES_PER_NODE = 8;
+
+    glm::vec3 position(int i) { return glm::vec3(float(i % 7) - 3.0f, float(i % 5) * 0.5f, float(i % 3) - 1.0f); }
+
+    glm::quat rotation(int i) { return glm::angleAxis(float(i) * 0.1f, glm::normalize(glm::vec3(1.0f, float(i % 4), 0.5f))); }
+
+    glm::vec3 scale(int i) { return glm::vec3(1.0f + float(i % 3) * 0.1f); }
+
+    /**
+    * Sponza-like triangle soup: Clusters of small triangles in a 38 x 16 x 24 box with roughly as many triangles as Sponza.
+    */
+    const int CLUSTER_COUNT = 512;
+    const int TRIANGLES_PER_CLUSTER = 512;
+    const glm::vec3 SCENE_EXTENT(38.0f, 16.0f, 24.0f);
+
+    const std::size_t RAY_COUNT = 1000000;
+    const std::size_t VALIDATION_RAY_COUNT = 1000;
+
+    bool nearEq(const glm::mat4& m0, const glm::mat4& m1)
+    {
+        for (int c = 0; c < 4; ++c)
+            if (!math::nearEq(m0[c], m1[c], 0.001f))
+                return false;
+
+        return true;
+    }
+
+#ifdef RUN_GEOMETRY_BENCHMARKS
+    struct GeometryBenchmarkRunner
+    {
+        GeometryBenchmarkRunner()
+        {
+            GeometryBenchmark::runBenchmarks();
+        }
+    };
+
+    GeometryBenchmarkRunner geometryBenchmarkRunner;
+#endif
+}
+
+using namespace geometry_benchmark;
+
+void GeometryBenchmark::runBenchmarks()
+{
+    benchmarkTransformHierarchy();
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+
+    for (int c = 0; c < CLUSTER_COUNT; ++c)
+    {
+        glm::vec3 center = glm::vec3(unit(rng), unit(rng), unit(rng)) * SCENE_EXTENT;
+
+        for (int t = 0; t < TRIANGLES_PER_CLUSTER; ++t)
+        {
+            glm::vec3 p = center + (glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f) * 2.0f;
+
+            for (int v = 0; v < 3; ++v)
+            {
+                indices.push_back(uint32_t(vertices.size()));
+                vertices.push_back(p + (glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f) * 0.2f);
+            }
+        }
+    }
+
+    benchmarkRaycast("Triangle clusters", vertices, indices);
+}
+
+void GeometryBenchmark::benchmarkRaycast(const std::string& sceneName, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices)
+{
+    Timer timer;
+    TriangleBVH bvh(vertices, indices);
+    timer.tick();
+
+    LOG("Geometry Benchmark: Ray casts against " << sceneName << " with " << bvh.getTriangleCount() << " triangles");
+    LOG("TriangleBVH build: " << timer.deltaTimeInMilliseconds() << " ms, " << bvh.getBVH().getNodes().size() << " nodes");
+
+    // Rays start inside of the scene and go into random directions like picking and GI rays
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const BBox& sceneBBox = bvh.getBVH().getBBox();
+    std::vector<Ray> rays(RAY_COUNT);
+
+    for (auto& ray : rays)
+    {
+        ray.origin = sceneBBox.min() + glm::vec3(unit(rng), unit(rng), unit(rng)) * sceneBBox.scale();
+        float z = 2.0f * unit(rng) - 1.0f;
+        float phi = 2.0f * math::PI * unit(rng);
+        float r = std::sqrt(1.0f - z * z);
+        ray.direction = glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    std::atomic<std::size_t> hitCount{0};
+    auto castRays = [&](std::size_t begin, std::size_t end)
+    {
+        std::size_t hits = 0;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            uint32_t triangleIdx;
+            float t;
+            glm::vec2 uv;
+            if (bvh.raycast(rays[i], FLT_MAX, triangleIdx, t, uv))
+                ++hits;
+        }
+
+        hitCount += hits;
+    };
+
+    timer.start();
+    castRays(0, rays.size());
+    timer.tick();
+    double singleThreadedTime = double(std::max(timer.deltaTimeInMicroseconds(), uint64_t(1)));
+    std::size_t singleThreadedHitCount = hitCount;
+    hitCount = 0;
+
+    {
+        ThreadPool threadPool;
+        timer.start();
+        threadPool.parallelFor(rays.size(), 4096, castRays);
+        timer.tick();
+    }
+    double parallelTime = double(std::max(timer.deltaTimeInMicroseconds(), uint64_t(1)));
+
+    LOG("Ray casts: " << rays.size() / singleThreadedTime << " Mrays/s single threaded, " << rays.size() / parallelTime << " Mrays/s on "
+        << ThreadPool::defaultWorkerCount() + 1 << " threads, " << singleThreadedHitCount << " hits");
+
+    if (hitCount != singleThreadedHitCount)
+        LOG_ERROR("Parallel ray casts found " << hitCount << " hits instead of " << singleThreadedHitCount);
+
+    // Compare with brute force
+    std::size_t mismatchCount = 0;
+    for (std::size_t i = 0; i < std::min(VALIDATION_RAY_COUNT, rays.size()); ++i)
+    {
+        float closestT = FLT_MAX;
+        for (std::size_t j = 0; j < indices.size(); j += 3)
+        {
+            float t;
+            glm::vec2 uv;
+            if (rays[i].intersectsTriangle(vertices[indices[j]], vertices[indices[j + 1]], vertices[indices[j + 2]], uv, t) && t >= 0.0f && t < closestT)
+                closestT = t;
+        }
+
+        uint32_t triangleIdx;
+        float t;
+        glm::vec2 uv;
+        bool hit = bvh.raycast(rays[i], FLT_MAX, triangleIdx, t, uv);
+
+        if (hit != (closestT != FLT_MAX) || (hit && std::abs(t - closestT) > 0.0001f * std::max(1.0f, closestT)))
+            ++mismatchCount;
+    }
+
+    if (mismatchCount > 0)
+        LOG_ERROR("TriangleBVH ray casts differ from brute force for " << mismatchCount << " rays");
+}
+
+void GeometryBenchmark::benchmarkTransformHierarchy()
+{
+    EntityManager entityManager;
+    std::vector<Entity> entities;
+    std::vector<ComponentPtr<Transform>> transforms;
+    std::vector<int> parents;
+    BBox meshBBox(glm::vec3(-1.0f), glm::vec3(1.0f));
+
+    auto addNode = [&](int parentIdx)
+    {
+        int i = int(transforms.size());
+        Entity entity = entityManager.create();
+        entity.addComponent<Transform>(meshBBox);
+        auto transform = entity.getComponent<Transform>();
+        transform->setLocalPosition(position(i));
+        transform->setLocalRotation(rotation(i));
+        transform->setLocalScale(scale(i));
+
+        if (parentIdx >= 0)
+            transform->setParent(transforms[parentIdx]);
+
+        entities.push_back(entity);
+        transforms.push_back(transform);
+        parents.push_back(parentIdx);
+        return i;
+    };
+
+    int root = addNode(-1);
+    std::vector<int> groups;
+    for (int g = 0; g < GROUP_COUNT; ++g)
+    {
+        int group = addNode(root);
+        groups.push_back(group);
+        for (int n = 0; n < NODES_PER_GROUP; ++n)
+        {
+            int node = addNode(group);
+            for (int m = 0; m < MESHES_PER_NODE; ++m)
+                addNode(node);
+        }
+    }
+
+    int lastNode = int(transforms.size()) - 1;
+    int repetitions = 100;
+    LOG("Geometry Benchmark: Transform hierarchy with " << transforms.size() << " nodes");
+
+    // Move the whole scene - every move is read
+    Timer timer;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        transforms[root]->setLocalPosition(glm::vec3(float(i), 0.0f, 0.0f));
+        transforms[lastNode]->getBBox();
+    }
+    timer.tick();
+    LOG("Move root: " << double(timer.deltaTimeInMicroseconds()) / repetitions << " us");
+
+    // Move one group - most of the hierarchy is unchanged
+    timer.start();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        transforms[groups[0]]->setLocalRotation(rotation(i));
+        transforms[groups[0]]->getBBox();
+    }
+    timer.tick();
+    LOG("Move one group: " << double(timer.deltaTimeInMicroseconds()) / repetitions << " us");
+
+    // Move all groups and read once - the changes are propagated in one pass
+    timer.start();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        for (int group : groups)
+            transforms[group]->setLocalRotation(rotation(i + group));
+
+        transforms[lastNode]->getBBox();
+    }
+    timer.tick();
+    LOG("Move all groups: " << double(timer.deltaTimeInMicroseconds()) / repetitions << " us");
+
+    // Compare with the world matrices computed along the parent chain
+    for (std::size_t i = 0; i < transforms.size(); ++i)
+    {
+        glm::mat4 expected;
+        for (int n = int(i); n >= 0; n = parents[n])
+        {
+            auto& t = transforms[n];
+            expected = glm::translate(t->getLocalPosition()) * glm::toMat4(t->getLocalRotation()) * glm::scale(t->getLocalScale()) * expected;
+        }
+
+        BBox expectedBBox = meshBBox.toWorld(expected);
+        glm::vec3 point(1.0f, 2.0f, 3.0f);
+
+        if (!nearEq(transforms[i]->getLocalToWorldMatrix(), expected) ||
+            !math::nearEq(transforms[i]->transformPointToLocal(glm::vec3(expected * glm::vec4(point, 1.0f))), point, 0.001f) ||
+            !math::nearEq(transforms[i]->getBBox().min(), expectedBBox.min(), 0.001f) ||
+            !math::nearEq(transforms[i]->getBBox().max(), expectedBBox.max(), 0.001f))
+        {
+            LOG_ERROR("Transform result differs from the parent chain at node " << i);
+            break;
+        }
+    }
+
+    // The entity manager doesn't destroy the components - their nodes would stay in the shared hierarchy
+    for (auto it = entities.rbegin(); it != entities.rend(); ++it)
+        it->destroy();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Runs the geometry benchmarks on startup and logs the results
+//#define RUN_GEOMETRY_BENCHMARKS
+
+class GeometryBenchmark
+{
+public:
+    static void runBenchmarks();
+
+    /**
+    * Measures the ray cast throughput of a TriangleBVH over the given triangles.
+    */
+    static void benchmarkRaycast(const std::string& sceneName, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+private:
+    static void benchmarkTransformHierarchy();
+};
@@ -1,34 +1,138 @@
 #include "Transform.h"
 #include <engine/util/math.h>
 #include <imgui/imgui.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+    struct SharedHierarchy
+    {
+        TransformHierarchy hierarchy;
+        std::atomic<bool> dirty{false};
+        std::mutex updateMutex;
+    };
+
+    // Function local because transforms are also created in static initializers (e.g. by GeometryBenchmark)
+    SharedHierarchy& sharedHierarchy()
+    {
+        static SharedHierarchy shared;
+        return shared;
+    }
+}
+
+Transform::Transform()
+    : m_node(getHierarchy().add())
+{
+    markHierarchyDirty();
+}
 
 Transform::Transform(const BBox& bbox)
+    : Transform()
 {
     setBBox(bbox);
-    m_lastFrameWorldBBox = m_worldBBox;
+}
+
+Transform::Transform(Transform&& other)
+    : Component(other),
+    m_root(other.m_root),
+    m_parent(other.m_parent),
+    m_children(std::move(other.m_children)),
+    m_node(other.m_node),
+    m_eulerAnglesWorld(other.m_eulerAnglesWorld),
+    m_eulerAnglesWorldValid(other.m_eulerAnglesWorldValid),
+    m_lastFrameWorldBBox(other.m_lastFrameWorldBBox)
+{
+    other.m_node = TransformHierarchy::INVALID_NODE;
+}
+
+Transform::~Transform()
+{
+    if (m_node == TransformHierarchy::INVALID_NODE)
+        return;
+
+    // The children become roots - the hierarchy would remove them together with this node otherwise
+    for (auto& child : m_children)
+    {
+        if (!child)
+            continue;
+
+        getHierarchy().setParent(child->m_node, TransformHierarchy::INVALID_NODE);
+        child->m_parent = ComponentPtr<Transform>();
+        child->setRoot(ComponentPtr<Transform>());
+    }
+
+    if (m_parent)
+    {
+        auto& siblings = m_parent->m_children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), ComponentPtr<Transform>(getOwner())), siblings.end());
+    }
+
+    getHierarchy().remove(m_node);
+    markHierarchyDirty();
 }
 
 void Transform::onShowInEditor()
 {
+    glm::vec3 position = getLocalPosition();
+    glm::vec3 scale = getLocalScale();
+
+    if (!m_eulerAnglesWorldValid)
+    {
+        m_eulerAnglesWorld = getEulerAngles();
+        m_eulerAnglesWorldValid = true;
+    }
+
     m_eulerAnglesWorld = math::toDegrees(m_eulerAnglesWorld);
 
-    bool positionChanged = ImGui::DragFloat3("Position", &m_position[0], 0.05f);
-    bool scaleChanged = ImGui::DragFloat3("Scale", &m_scale[0], 0.05f);
+    bool positionChanged = ImGui::DragFloat3("Position", &position[0], 0.05f);
+    bool scaleChanged = ImGui::DragFloat3("Scale", &scale[0], 0.05f);
     bool rotationChanged = ImGui::DragFloat3("Rotation", &m_eulerAnglesWorld[0], 0.5f, -360.0f, 360.0f);
 
     m_eulerAnglesWorld = math::toRadians(m_eulerAnglesWorld);
 
     if (positionChanged || scaleChanged || rotationChanged)
     {
-        // This will also update the cache for position and scale
+        setLocalPosition(position);
+        setLocalScale(scale);
         setEulerAngles(m_eulerAnglesWorld);
     }
 }
 
 void Transform::lateUpdate()
 {
-    m_changedSinceLastFrame = false;
-    m_lastFrameWorldBBox = m_worldBBox;
+    // Updates the hierarchy on the first call - the other threads of a parallel update wait for it
+    m_lastFrameWorldBBox = getUpdatedHierarchy().getBBox(m_node);
+    getHierarchy().clearChanged(m_node);
+}
+
+TransformHierarchy& Transform::getHierarchy()
+{
+    return sharedHierarchy().hierarchy;
+}
+
+const TransformHierarchy& Transform::getUpdatedHierarchy()
+{
+    SharedHierarchy& shared = sharedHierarchy();
+
+    if (shared.dirty.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(shared.updateMutex);
+
+        if (shared.dirty.load(std::memory_order_relaxed))
+        {
+            shared.hierarchy.update();
+            shared.dirty.store(false, std::memory_order_release);
+        }
+    }
+
+    return shared.hierarchy;
+}
+
+void Transform::markHierarchyDirty()
+{
+    sharedHierarchy().dirty.store(true, std::memory_order_relaxed);
 }
 
 glm::mat3 Transform::getLocalToWorldRotationMatrix() const
@@ -38,28 +142,27 @@ glm::mat3 Transform::getLocalToWorldRotationMatrix() const
 
 void Transform::setLocalPosition(const glm::vec3& position)
 {
-    m_position = position;
-    updateCache();
+    getHierarchy().setLocalPosition(m_node, position);
+    markHierarchyDirty();
 }
 
 void Transform::setLocalRotation(const glm::quat& rotation)
 {
-    m_rotation = rotation;
-    updateCache();
-    m_eulerAnglesWorld = getEulerAngles();
+    getHierarchy().setLocalRotation(m_node, rotation);
+    markHierarchyDirty();
+
+    // Recomputed by the editor - computing it here would update the hierarchy on every rotation
+    m_eulerAnglesWorldValid = false;
 }
 
 void Transform::setPosition(const glm::vec3& position)
 {
-    m_position = m_parent ? m_parent->transformPointToLocal(position) : position;
-    updateCache();
+    setLocalPosition(m_parent ? m_parent->transformPointToLocal(position) : position);
 }
 
 void Transform::setRotation(const glm::quat& rotation)
 {
-    m_rotation = m_parent ? m_parent->getWorldToLocalRotation() * rotation : rotation;
-    updateCache();
-    m_eulerAnglesWorld = getEulerAngles();
+    setLocalRotation(m_parent ? m_parent->getWorldToLocalRotation() * rotation : rotation);
 }
 
 glm::vec3 Transform::getApproximateScale() const
@@ -71,8 +174,8 @@ glm::vec3 Transform::getApproximateScale() const
 
 void Transform::setLocalScale(const glm::vec3& scale)
 {
-    m_scale = scale;
-    updateCache();
+    getHierarchy().setLocalScale(m_node, scale);
+    markHierarchyDirty();
 }
 
 void Transform::lookAt(const glm::vec3& target, const glm::vec3& worldUp)
@@ -88,19 +191,18 @@ void Transform::lookAt(const glm::vec3& target, const glm::vec3& worldUp)
 
 void Transform::setLocalEulerAngles(const glm::vec3& eulerAngles)
 {
-    m_rotation = math::eulerYXZQuat(eulerAngles);
-    updateCache();
-    m_eulerAnglesWorld = getEulerAngles();
+    setLocalRotation(math::eulerYXZQuat(eulerAngles));
 }
 
-glm::vec3 Transform::getLocalEulerAngles() const { return math::eulerAngles(m_rotation); }
+glm::vec3 Transform::getLocalEulerAngles() const { return math::eulerAngles(getLocalRotation()); }
 
 void Transform::setEulerAngles(const glm::vec3& eulerAngles)
 {
     glm::quat rotation = math::eulerYXZQuat(eulerAngles);
-    m_rotation = m_parent ? m_parent->getWorldToLocalRotation() * rotation : rotation;
-    updateCache();
+    getHierarchy().setLocalRotation(m_node, m_parent ? m_parent->getWorldToLocalRotation() * rotation : rotation);
+    markHierarchyDirty();
     m_eulerAnglesWorld = eulerAngles;
+    m_eulerAnglesWorldValid = true;
 }
 
 glm::vec3 Transform::getEulerAngles() const
@@ -114,13 +216,25 @@ void Transform::setParent(ComponentPtr<Transform> parent)
         return;
 
     if (m_parent)
-        m_parent->m_children.erase(std::remove(m_children.begin(), m_children.end(), ComponentPtr<Transform>(getOwner())));
+    {
+        auto& siblings = m_parent->m_children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), ComponentPtr<Transform>(getOwner())), siblings.end());
+    }
 
     m_parent = parent;
-    m_root = parent->getRoot();
+    setRoot(parent->getRoot());
     m_parent->m_children.push_back(ComponentPtr<Transform>(getOwner()));
 
-    updateCacheHierarchy();
+    getHierarchy().setParent(m_node, parent->m_node);
+    markHierarchyDirty();
+}
+
+void Transform::setRoot(const ComponentPtr<Transform>& root)
+{
+    m_root = root;
+
+    for (auto& child : m_children)
+        child->setRoot(root ? root : ComponentPtr<Transform>(getOwner()));
 }
 
 glm::vec3 Transform::transformPointToWorld(const glm::vec3& point) const
@@ -145,53 +259,9 @@ glm::vec3 Transform::transformVectorToLocal(const glm::vec3& vector) const
 
 void Transform::setBBox(const BBox& bbox) noexcept
 {
-    m_originalBBox = bbox;
-    m_worldBBox = bbox.toWorld(m_localToWorldMatrix);
-    m_changedSinceLastFrame = true;
-    m_lastFrameWorldBBox = m_worldBBox;
-}
-
-void Transform::updateCache()
-{
-    m_localMatrix = glm::translate(m_position) * glm::toMat4(m_rotation) * glm::scale(m_scale);
-    m_localMatrixInv = glm::inverse(m_localMatrix);
-
-    updateCacheHierarchy();
-}
-
-void Transform::updateCacheHierarchy()
-{
-    if (m_parent)
-    {
-        m_localToWorldMatrix = m_parent->getLocalToWorldMatrix() * m_localMatrix;
-        m_worldToLocalMatrix = m_localMatrixInv * m_parent->getWorldToLocalMatrix();
-        m_localToWorldRotation = m_parent->getLocalToWorldRotation() * m_rotation;
-        m_worldToLocalRotation = glm::inverse(m_localToWorldRotation);
-    }
-    else
-    {
-        m_localToWorldMatrix = m_localMatrix;
-        m_worldToLocalMatrix = m_localMatrixInv;
-        m_localToWorldRotation = m_rotation;
-        m_worldToLocalRotation = glm::inverse(m_localToWorldRotation);
-    }
-
-    m_changedSinceLastFrame = true;
-    m_worldBBox = m_originalBBox.toWorld(m_localToWorldMatrix);
-
-    // Update all children
-    for (auto& child : m_children)
-        child->updateCacheHierarchy();
-}
-
-glm::mat4 Transform::getLocalMatrix() const
-{
-    return m_localMatrix;
-}
-
-glm::mat4 Transform::getLocalInverseMatrix() const
-{
-    return m_localMatrixInv;
+    getHierarchy().setLocalBBox(m_node, bbox);
+    markHierarchyDirty();
+    m_lastFrameWorldBBox = getBBox();
 }
 
 void Transform::pitch(float angle) noexcept
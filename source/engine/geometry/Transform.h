@@ -4,14 +4,31 @@
 #include <glm/ext.hpp>
 #include <engine/ecs/EntityManager.h>
 #include "BBox.h"
+#include "TransformHierarchy.h"
 
+/**
+* The local transformations, world matrices and world bounding boxes of all transforms are stored in one shared
+* TransformHierarchy. Setters only mark the hierarchy as dirty, the first read of a world matrix or bounding box
+* updates all changed subtrees in one pass - reads thus always see the effect of previous setter calls.
+*/
 class Transform : public Component
 {
 public:
-    Transform() { }
+    // lateUpdate() only modifies the transform itself
+    static constexpr bool PARALLEL_UPDATE = true;
+
+    Transform();
 
     explicit Transform(const BBox& bbox);
 
+    // Sparse component pools move their components
+    Transform(Transform&& other);
+
+    Transform(const Transform&) = delete;
+    Transform& operator=(const Transform&) = delete;
+
+    ~Transform();
+
     void onShowInEditor() override;
 
     std::string getName() const override { return "Transform"; }
@@ -21,12 +38,12 @@ public:
     /**
     * Returns the transformation matrix from the local coordinate system of this transform to the world coordinate system.
     */
-    const glm::mat4& getLocalToWorldMatrix() const { return m_localToWorldMatrix; }
+    const glm::mat4& getLocalToWorldMatrix() const { return getUpdatedHierarchy().getLocalToWorldMatrix(m_node); }
 
     /**
     * Returns the transformation matrix from the world coordinate system to the local coordinate system of this transform.
     */
-    const glm::mat4& getWorldToLocalMatrix() const { return m_worldToLocalMatrix; }
+    const glm::mat4& getWorldToLocalMatrix() const { return getUpdatedHierarchy().getWorldToLocalMatrix(m_node); }
 
     glm::vec3 getRight() const { return getLocalToWorldRotationMatrix()[0]; }
 
@@ -52,7 +69,7 @@ public:
     /**
     * Returns the rotation quaternion in world space.
     */
-    const glm::quat& getRotation() const { return m_localToWorldRotation; }
+    const glm::quat& getRotation() const { return getUpdatedHierarchy().getRotation(m_node); }
 
     /**
     * Returns the scale in world space. Due to skewing the 3 component scale
@@ -64,11 +81,11 @@ public:
     void setLocalRotation(const glm::quat& rotation);
     void setLocalScale(const glm::vec3& scale);
 
-    const glm::vec3& getLocalScale() const { return m_scale; }
+    const glm::vec3& getLocalScale() const { return getHierarchy().getLocalScale(m_node); }
 
-    const glm::vec3& getLocalPosition() const { return m_position; }
+    const glm::vec3& getLocalPosition() const { return getHierarchy().getLocalPosition(m_node); }
 
-    const glm::quat& getLocalRotation() const { return m_rotation; }
+    const glm::quat& getLocalRotation() const { return getHierarchy().getLocalRotation(m_node); }
 
     void lookAt(const glm::vec3& target, const glm::vec3& worldUp = glm::vec3(0.0f, 1.0f, 0.0f));
 
@@ -130,51 +147,50 @@ public:
 
     void move(const glm::vec3& posDelta) { setPosition(getPosition() + posDelta); }
 
-    bool hasChangedSinceLastFrame() const { return (m_changedSinceLastFrame & 1) > 0; }
+    bool hasChangedSinceLastFrame() const { return getUpdatedHierarchy().hasChanged(m_node); }
 
     void setBBox(const BBox& bbox) noexcept;
 
-    const BBox& getBBox() const noexcept { return m_worldBBox; }
+    const BBox& getBBox() const noexcept { return getUpdatedHierarchy().getBBox(m_node); }
 
     const BBox& getLastFrameBBox() const noexcept { return m_lastFrameWorldBBox; }
 
 private:
-    void updateCache();
-    void updateCacheHierarchy();
+    /**
+    * Shared by all transforms. Doesn't update it - only for local attributes and setters.
+    */
+    static TransformHierarchy& getHierarchy();
+
+    /**
+    * Returns the shared hierarchy after updating it if necessary. Can be called on multiple threads at the same time
+    * as long as no setter is called concurrently - e.g. by lateUpdate() on all threads of a parallel update.
+    */
+    static const TransformHierarchy& getUpdatedHierarchy();
 
-    glm::mat4 getLocalMatrix() const;
-    glm::mat4 getLocalInverseMatrix() const;
+    /**
+    * Has to be called after every change of the shared hierarchy.
+    */
+    static void markHierarchyDirty();
+
+    void setRoot(const ComponentPtr<Transform>& root);
 
     glm::mat3 getLocalToWorldRotationMatrix() const;
 
-    const glm::quat& getLocalToWorldRotation() const { return m_localToWorldRotation; }
+    const glm::quat& getLocalToWorldRotation() const { return getRotation(); }
 
-    const glm::quat& getWorldToLocalRotation() const { return m_worldToLocalRotation; }
+    glm::quat getWorldToLocalRotation() const { return glm::inverse(getRotation()); }
 
 private:
     ComponentPtr<Transform> m_root;
     ComponentPtr<Transform> m_parent;
     std::vector<ComponentPtr<Transform>> m_children;
 
-    // Local coordinate attributes
-    glm::vec3 m_position;
-    glm::vec3 m_scale{1.0f,1.0f,1.0f};
-    glm::quat m_rotation;
-
-    // Cache for performance
-    glm::mat4 m_localMatrix;
-    glm::mat4 m_localMatrixInv;
-    glm::mat4 m_localToWorldMatrix;
-    glm::mat4 m_worldToLocalMatrix;
-    glm::quat m_localToWorldRotation;
-    glm::quat m_worldToLocalRotation;
+    // Node in the shared hierarchy - INVALID_NODE if moved from
+    TransformNodeID m_node{TransformHierarchy::INVALID_NODE};
 
     // Editor specific members
     glm::vec3 m_eulerAnglesWorld; // Euler angles in world space
+    bool m_eulerAnglesWorldValid{true};
 
-    bool m_changedSinceLastFrame{false};
-
-    BBox m_originalBBox;
-    BBox m_worldBBox;
     BBox m_lastFrameWorldBBox;
 };
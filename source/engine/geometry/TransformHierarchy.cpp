@@ -0,0 +1,341 @@
+#include "TransformHierarchy.h"
+#include <cassert>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_HIERARCHY_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+const TransformNodeID TransformHierarchy::INVALID_NODE;
+
+namespace
+{
+    template <class T>
+    void reorderArray(std::vector<T>& v, const std::vector<uint32_t>& order)
+    {
+        std::vector<T> result;
+        result.reserve(order.size());
+
+        for (uint32_t idx : order)
+            result.push_back(v[idx]);
+
+        v.swap(result);
+    }
+}
+
+TransformNodeID TransformHierarchy::add(TransformNodeID parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, const BBox& localBBox)
+{
+    assert(parent == INVALID_NODE || valid(parent));
+
+    TransformNodeID node;
+    if (m_freeNodes.size() > 0)
+    {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    else
+    {
+        node = TransformNodeID(m_nodeToIdx.size());
+        m_nodeToIdx.push_back(INVALID_NODE);
+    }
+
+    uint32_t parentIdx = parent == INVALID_NODE ? INVALID_NODE : index(parent);
+    uint32_t idx;
+    if (m_freeIndices.size() > 0)
+    {
+        // Filling a hole only breaks the parent before child order if the parent comes after it
+        idx = m_freeIndices.back();
+        m_freeIndices.pop_back();
+
+        if (parentIdx != INVALID_NODE && parentIdx > idx)
+            m_orderDirty = true;
+    }
+    else
+    {
+        // Appending keeps the parent before child order because the parent already exists
+        idx = uint32_t(m_parents.size());
+        resize(idx + 1);
+    }
+
+    m_nodeToIdx[node] = idx;
+    m_idxToNode[idx] = node;
+    m_parents[idx] = parentIdx;
+    m_positions[idx] = position;
+    m_rotations[idx] = rotation;
+    m_scales[idx] = scale;
+    m_localBBoxes[idx] = localBBox;
+    m_worldBBoxes[idx] = localBBox;
+    m_changed[idx] = 0;
+    markDirty(idx);
+
+    return node;
+}
+
+void TransformHierarchy::remove(TransformNodeID node)
+{
+    if (m_orderDirty)
+        sort();
+
+    uint32_t removedIdx = index(node);
+    removeIndex(removedIdx);
+
+    // Descendants come after their parents - a node is a descendant if its parent was just removed
+    for (uint32_t i = removedIdx + 1; i < m_parents.size(); ++i)
+    {
+        if (m_parents[i] != INVALID_NODE && m_idxToNode[m_parents[i]] == INVALID_NODE)
+            removeIndex(i);
+    }
+
+    // Compact the arrays if most of them are holes
+    if (m_freeIndices.size() * 2 > m_parents.size())
+        sort();
+}
+
+void TransformHierarchy::setParent(TransformNodeID node, TransformNodeID parent)
+{
+    uint32_t idx = index(node);
+
+    if (parent == INVALID_NODE)
+    {
+        m_parents[idx] = INVALID_NODE;
+    }
+    else
+    {
+        uint32_t parentIdx = index(parent);
+        assert(parentIdx != idx && !isAncestor(idx, parentIdx) && "A node can't be the parent of its ancestor.");
+        m_parents[idx] = parentIdx;
+
+        if (parentIdx > idx)
+            m_orderDirty = true;
+    }
+
+    markDirty(idx);
+}
+
+TransformNodeID TransformHierarchy::getParent(TransformNodeID node) const
+{
+    uint32_t parentIdx = m_parents[index(node)];
+    return parentIdx == INVALID_NODE ? INVALID_NODE : m_idxToNode[parentIdx];
+}
+
+void TransformHierarchy::setLocalPosition(TransformNodeID node, const glm::vec3& position)
+{
+    uint32_t idx = index(node);
+    m_positions[idx] = position;
+    markDirty(idx);
+}
+
+void TransformHierarchy::setLocalRotation(TransformNodeID node, const glm::quat& rotation)
+{
+    uint32_t idx = index(node);
+    m_rotations[idx] = rotation;
+    markDirty(idx);
+}
+
+void TransformHierarchy::setLocalScale(TransformNodeID node, const glm::vec3& scale)
+{
+    uint32_t idx = index(node);
+    m_scales[idx] = scale;
+    markDirty(idx);
+}
+
+void TransformHierarchy::setLocalBBox(TransformNodeID node, const BBox& bbox)
+{
+    uint32_t idx = index(node);
+    m_localBBoxes[idx] = bbox;
+    markDirty(idx);
+}
+
+void TransformHierarchy::update()
+{
+    if (m_orderDirty)
+        sort();
+
+    uint32_t count = uint32_t(m_parents.size());
+    for (uint32_t i = m_firstDirtyIdx; i < count; ++i)
+    {
+        uint32_t parentIdx = m_parents[i];
+        if (!m_localDirty[i] && (parentIdx == INVALID_NODE || !m_updated[parentIdx]))
+            continue;
+
+        if (m_localDirty[i])
+        {
+            m_localMatrices[i] = glm::translate(m_positions[i]) * glm::toMat4(m_rotations[i]) * glm::scale(m_scales[i]);
+            m_localInvMatrices[i] = glm::inverse(m_localMatrices[i]);
+            m_localDirty[i] = 0;
+        }
+
+        if (parentIdx == INVALID_NODE)
+        {
+            m_worldMatrices[i] = m_localMatrices[i];
+            m_worldInvMatrices[i] = m_localInvMatrices[i];
+            m_worldRotations[i] = m_rotations[i];
+        }
+        else
+        {
+            multiply(m_worldMatrices[parentIdx], m_localMatrices[i], m_worldMatrices[i]);
+            multiply(m_localInvMatrices[i], m_worldInvMatrices[parentIdx], m_worldInvMatrices[i]);
+            m_worldRotations[i] = m_worldRotations[parentIdx] * m_rotations[i];
+        }
+
+        m_worldBBoxes[i] = m_localBBoxes[i].toWorld(m_worldMatrices[i]);
+        m_updated[i] = 1;
+        m_changed[i] = 1;
+    }
+
+    // Nodes before the first dirty node were not touched
+    if (m_firstDirtyIdx < count)
+        std::fill(m_updated.begin() + m_firstDirtyIdx, m_updated.end(), uint8_t(0));
+
+    m_firstDirtyIdx = count;
+}
+
+void TransformHierarchy::multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#ifdef TRANSFORM_HIERARCHY_USE_SSE
+    // Column major: out[c] = a[0] * b[c].x + a[1] * b[c].y + a[2] * b[c].z + a[3] * b[c].w
+    __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[c][0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[c][1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[c][2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[c][3])));
+        _mm_storeu_ps(&out[c][0], r);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+uint32_t TransformHierarchy::index(TransformNodeID node) const
+{
+    assert(valid(node));
+    return m_nodeToIdx[node];
+}
+
+void TransformHierarchy::markDirty(uint32_t idx)
+{
+    m_localDirty[idx] = 1;
+    m_firstDirtyIdx = std::min(m_firstDirtyIdx, idx);
+}
+
+void TransformHierarchy::removeIndex(uint32_t idx)
+{
+    m_nodeToIdx[m_idxToNode[idx]] = INVALID_NODE;
+    m_freeNodes.push_back(m_idxToNode[idx]);
+    m_freeIndices.push_back(idx);
+
+    // A hole is never dirty and has no parent: update() skips it
+    m_idxToNode[idx] = INVALID_NODE;
+    m_parents[idx] = INVALID_NODE;
+    m_localDirty[idx] = 0;
+    m_changed[idx] = 0;
+}
+
+bool TransformHierarchy::isAncestor(uint32_t ancestorIdx, uint32_t idx) const
+{
+    for (uint32_t p = m_parents[idx]; p != INVALID_NODE; p = m_parents[p])
+        if (p == ancestorIdx)
+            return true;
+
+    return false;
+}
+
+void TransformHierarchy::sort()
+{
+    // Sorting by depth guarantees that parents come before their children
+    std::vector<uint32_t> depths(m_parents.size(), INVALID_NODE);
+
+    for (uint32_t i = 0; i < m_parents.size(); ++i)
+    {
+        // Walk up until a node with known depth is found
+        uint32_t depth = 0;
+        uint32_t p = i;
+        while (p != INVALID_NODE && depths[p] == INVALID_NODE)
+        {
+            p = m_parents[p];
+            ++depth;
+        }
+
+        uint32_t baseDepth = p == INVALID_NODE ? 0 : depths[p] + 1;
+
+        // Assign the depths on the walked path
+        p = i;
+        while (p != INVALID_NODE && depths[p] == INVALID_NODE)
+        {
+            --depth;
+            depths[p] = baseDepth + depth;
+            p = m_parents[p];
+        }
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(size());
+    for (uint32_t i = 0; i < m_parents.size(); ++i)
+    {
+        if (m_idxToNode[i] != INVALID_NODE)
+            order.push_back(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&depths](uint32_t i0, uint32_t i1) { return depths[i0] < depths[i1]; });
+    reorder(order);
+    m_freeIndices.clear();
+    m_orderDirty = false;
+    m_firstDirtyIdx = 0;
+}
+
+void TransformHierarchy::resize(std::size_t size)
+{
+    m_idxToNode.resize(size, INVALID_NODE);
+    m_parents.resize(size, INVALID_NODE);
+    m_positions.resize(size);
+    m_rotations.resize(size);
+    m_scales.resize(size);
+    m_localMatrices.resize(size);
+    m_localInvMatrices.resize(size);
+    m_worldMatrices.resize(size);
+    m_worldInvMatrices.resize(size);
+    m_worldRotations.resize(size);
+    m_localBBoxes.resize(size);
+    m_worldBBoxes.resize(size);
+    m_localDirty.resize(size, 0);
+    m_updated.resize(size, 0);
+    m_changed.resize(size, 0);
+}
+
+void TransformHierarchy::reorder(const std::vector<uint32_t>& order)
+{
+    std::vector<uint32_t> newIndices(m_parents.size(), INVALID_NODE);
+    for (uint32_t i = 0; i < order.size(); ++i)
+        newIndices[order[i]] = i;
+
+    reorderArray(m_idxToNode, order);
+    reorderArray(m_parents, order);
+    reorderArray(m_positions, order);
+    reorderArray(m_rotations, order);
+    reorderArray(m_scales, order);
+    reorderArray(m_localMatrices, order);
+    reorderArray(m_localInvMatrices, order);
+    reorderArray(m_worldMatrices, order);
+    reorderArray(m_worldInvMatrices, order);
+    reorderArray(m_worldRotations, order);
+    reorderArray(m_localBBoxes, order);
+    reorderArray(m_worldBBoxes, order);
+    reorderArray(m_localDirty, order);
+    reorderArray(m_updated, order);
+    reorderArray(m_changed, order);
+
+    for (uint32_t i = 0; i < m_parents.size(); ++i)
+    {
+        if (m_parents[i] != INVALID_NODE)
+            m_parents[i] = newIndices[m_parents[i]];
+
+        m_nodeToIdx[m_idxToNode[i]] = i;
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include "BBox.h"
+
+// Stable identifier of a node in a TransformHierarchy
+using TransformNodeID = uint32_t;
+
+/**
+* Transform hierarchy in structure-of-arrays layout.
+* Local TRS, matrices and bounding boxes of all nodes are stored in separate arrays which are sorted
+* such that parents always come before their children. update() thus computes the world matrices and
+* world bounding boxes of all changed subtrees in a single linear pass without recursion.
+*
+* Changes are deferred: world matrices and bounding boxes are only valid after update(). The pass starts at the
+* first changed node - nodes before it can't be affected because they are no descendants of it.
+* Removed nodes leave a hole that is filled by the next added node, sort() compacts the arrays.
+*
+* Backs the Transform component which calls update() lazily when a world matrix or bounding box is read.
+*/
+class TransformHierarchy
+{
+public:
+    static const TransformNodeID INVALID_NODE = std::numeric_limits<TransformNodeID>::max();
+
+    /**
+    * Adds a node with the given local transformation and local bounding box.
+    * The node is added as a root if parent is INVALID_NODE.
+    */
+    TransformNodeID add(TransformNodeID parent = INVALID_NODE,
+                        const glm::vec3& position = glm::vec3(0.0f),
+                        const glm::quat& rotation = glm::quat(),
+                        const glm::vec3& scale = glm::vec3(1.0f),
+                        const BBox& localBBox = BBox(glm::vec3(0.0f), glm::vec3(0.0f)));
+
+    /**
+    * Removes the node and all of its descendants.
+    */
+    void remove(TransformNodeID node);
+
+    /**
+    * The local transformation is kept. Pass INVALID_NODE to make the node a root.
+    */
+    void setParent(TransformNodeID node, TransformNodeID parent);
+
+    TransformNodeID getParent(TransformNodeID node) const;
+
+    void setLocalPosition(TransformNodeID node, const glm::vec3& position);
+    void setLocalRotation(TransformNodeID node, const glm::quat& rotation);
+    void setLocalScale(TransformNodeID node, const glm::vec3& scale);
+    void setLocalBBox(TransformNodeID node, const BBox& bbox);
+
+    const glm::vec3& getLocalPosition(TransformNodeID node) const { return m_positions[index(node)]; }
+
+    const glm::quat& getLocalRotation(TransformNodeID node) const { return m_rotations[index(node)]; }
+
+    const glm::vec3& getLocalScale(TransformNodeID node) const { return m_scales[index(node)]; }
+
+    const BBox& getLocalBBox(TransformNodeID node) const { return m_localBBoxes[index(node)]; }
+
+    const glm::mat4& getLocalToWorldMatrix(TransformNodeID node) const { return m_worldMatrices[index(node)]; }
+
+    const glm::mat4& getWorldToLocalMatrix(TransformNodeID node) const { return m_worldInvMatrices[index(node)]; }
+
+    const glm::quat& getRotation(TransformNodeID node) const { return m_worldRotations[index(node)]; }
+
+    const BBox& getBBox(TransformNodeID node) const { return m_worldBBoxes[index(node)]; }
+
+    /**
+    * Returns true if the world matrix of the node was recomputed by an update() since the last clearChanged().
+    */
+    bool hasChanged(TransformNodeID node) const { return m_changed[index(node)] != 0; }
+
+    /**
+    * Only writes the flag of the node: Can be called for different nodes on multiple threads at the same time.
+    */
+    void clearChanged(TransformNodeID node) { m_changed[index(node)] = 0; }
+
+    bool valid(TransformNodeID node) const { return node < m_nodeToIdx.size() && m_nodeToIdx[node] != INVALID_NODE; }
+
+    std::size_t size() const { return m_parents.size() - m_freeIndices.size(); }
+
+    /**
+    * Returns true if update() has to be called before world matrices and bounding boxes are read.
+    */
+    bool needsUpdate() const { return m_firstDirtyIdx < m_parents.size(); }
+
+    /**
+    * Recomputes the world matrices, their inverses, the world rotations and the world bounding boxes
+    * of all nodes whose local transformation or whose ancestors changed since the last update.
+    */
+    void update();
+
+    /**
+    * Computes out = a * b. Uses SSE if available.
+    */
+    static void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+private:
+    uint32_t index(TransformNodeID node) const;
+
+    bool isAncestor(uint32_t ancestorIdx, uint32_t idx) const;
+
+    void markDirty(uint32_t idx);
+
+    /**
+    * Turns the element at idx into a hole.
+    */
+    void removeIndex(uint32_t idx);
+
+    /**
+    * Restores the parent before child order and removes the holes of removed nodes.
+    */
+    void sort();
+
+    /**
+    * Keeps only the elements at the given indices in the given order.
+    */
+    void reorder(const std::vector<uint32_t>& order);
+
+    void resize(std::size_t size);
+
+private:
+    // Stable node ids -> indices into the arrays below and vice versa
+    std::vector<uint32_t> m_nodeToIdx;
+    std::vector<TransformNodeID> m_idxToNode;
+    std::vector<TransformNodeID> m_freeNodes;
+    std::vector<uint32_t> m_freeIndices; // Holes of removed nodes
+
+    // Sorted parent before child
+    std::vector<uint32_t> m_parents; // Index of the parent or INVALID_NODE for roots and holes
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
+    std::vector<glm::mat4> m_localMatrices;
+    std::vector<glm::mat4> m_localInvMatrices;
+    std::vector<glm::mat4> m_worldMatrices;
+    std::vector<glm::mat4> m_worldInvMatrices;
+    std::vector<glm::quat> m_worldRotations;
+    std::vector<BBox> m_localBBoxes;
+    std::vector<BBox> m_worldBBoxes;
+    std::vector<uint8_t> m_localDirty;
+    std::vector<uint8_t> m_updated; // Recomputed in the running update() - all zero otherwise
+    std::vector<uint8_t> m_changed;
+
+    uint32_t m_firstDirtyIdx{0};
+    bool m_orderDirty{false};
+};
@@ -0,0 +1,69 @@
+#include "TriangleBVH.h"
+
+TriangleBVH::TriangleBVH(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices)
+{
+    build(vertices, indices);
+}
+
+void TriangleBVH::build(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices)
+{
+    std::vector<BBox> bboxes;
+    copyTriangles(vertices, indices, bboxes);
+    m_bvh.build(bboxes);
+}
+
+void TriangleBVH::refit(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices)
+{
+    assert(indices.size() / 3 == m_bvh.getPrimitiveCount());
+    std::vector<BBox> bboxes;
+    copyTriangles(vertices, indices, bboxes);
+    m_bvh.refit(bboxes);
+}
+
+bool TriangleBVH::raycast(const Ray& ray, float tMax, uint32_t& triangleIdx, float& t, glm::vec2& uv) const
+{
+    glm::vec2 closestUV;
+    auto intersectTriangle = [this, &ray, &closestUV](uint32_t idx, float maxT, float& tHit)
+    {
+        glm::vec2 triangleUV;
+        if (ray.intersectsTriangle(m_vertices[3 * idx], m_vertices[3 * idx + 1], m_vertices[3 * idx + 2], triangleUV, tHit) && tHit >= 0.0f && tHit <= maxT)
+        {
+            closestUV = triangleUV;
+            return true;
+        }
+
+        return false;
+    };
+
+    if (!m_bvh.raycast(ray, tMax, intersectTriangle, triangleIdx, t))
+        return false;
+
+    uv = closestUV;
+    return true;
+}
+
+glm::vec3 TriangleBVH::computeNormal(uint32_t triangleIdx) const
+{
+    const glm::vec3& p0 = m_vertices[3 * triangleIdx];
+    return glm::cross(m_vertices[3 * triangleIdx + 1] - p0, m_vertices[3 * triangleIdx + 2] - p0);
+}
+
+void TriangleBVH::copyTriangles(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices, std::vector<BBox>& bboxes)
+{
+    assert(indices.size() % 3 == 0);
+    std::size_t triangleCount = indices.size() / 3;
+    m_vertices.resize(indices.size());
+    bboxes.resize(triangleCount);
+
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        BBox bbox;
+        for (std::size_t j = 3 * i; j < 3 * i + 3; ++j)
+        {
+            m_vertices[j] = vertices[indices[j]];
+            bbox.unite(m_vertices[j]);
+        }
+
+        bboxes[i] = bbox;
+    }
+}
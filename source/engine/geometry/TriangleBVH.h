@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "BVH.h"
+#include "Ray.h"
+
+/**
+* BVH over the triangles of an indexed triangle list. The triangles are stored in the
+* space of the given vertices (usually object space), thus the BVH stays valid if only the
+* transformation of the mesh changes. Rays have to be transformed into that space.
+*/
+class TriangleBVH
+{
+public:
+    TriangleBVH() { }
+
+    TriangleBVH(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+    void build(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+    * Updates the BVH after vertices were moved. The indices must be the same as the ones used in build().
+    */
+    void refit(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+    * Finds the closest triangle hit by the ray in [0, tMax].
+    * Returns true if a triangle was hit. triangleIdx, t and the barycentric coordinates uv are set in that case.
+    */
+    bool raycast(const Ray& ray, float tMax, uint32_t& triangleIdx, float& t, glm::vec2& uv) const;
+
+    /**
+    * Returns the unnormalized geometric normal of the given triangle.
+    */
+    glm::vec3 computeNormal(uint32_t triangleIdx) const;
+
+    std::size_t getTriangleCount() const { return m_vertices.size() / 3; }
+
+    const BVH& getBVH() const { return m_bvh; }
+
+private:
+    void copyTriangles(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices, std::vector<BBox>& bboxes);
+
+private:
+    BVH m_bvh;
+
+    // The 3 vertices of each triangle
+    std::vector<glm::vec3> m_vertices;
+};
@@ -214,3 +214,35 @@ bool intersection::TriangleBBox::test(const BBox& b)
 
     return true;
 }
+
+bool intersection::rayBBox(const glm::vec3& origin, const glm::vec3& invDirection, const BBox& b, float tMax, float& tEntry)
+{
+    glm::vec3 t0 = (b.min() - origin) * invDirection;
+    glm::vec3 t1 = (b.max() - origin) * invDirection;
+
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+
+    tEntry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+
+    return tEntry <= tExit;
+}
+
+bool intersection::bboxPlanes(const BBox& b, const glm::vec4* planes, std::size_t planeCount)
+{
+    for (std::size_t i = 0; i < planeCount; ++i)
+    {
+        const glm::vec4& plane = planes[i];
+
+        // The corner of the bbox which is furthest in the direction of the plane normal
+        glm::vec3 p(plane.x >= 0.0f ? b.max().x : b.min().x,
+                    plane.y >= 0.0f ? b.max().y : b.min().y,
+                    plane.z >= 0.0f ? b.max().z : b.min().z);
+
+        if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include "BBox.h"
+#include <cstddef>
 
 class BBox;
 
@@ -12,6 +13,18 @@ namespace intersection
 
     bool bboxTriangle(const BBox& b, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
 
+    /**
+    * Slab test between the ray (origin, 1 / direction) and the bbox. Only hits in [0, tMax] are considered.
+    * tEntry is set to the distance at which the ray enters the bbox (0 if the origin is inside).
+    */
+    bool rayBBox(const glm::vec3& origin, const glm::vec3& invDirection, const BBox& b, float tMax, float& tEntry);
+
+    /**
+    * Returns false if the bbox is completely outside of one of the planes.
+    * A plane is given as (n.x, n.y, n.z, d) where dot(n, p) + d >= 0 holds for all points p inside.
+    */
+    bool bboxPlanes(const BBox& b, const glm::vec4* planes, std::size_t planeCount);
+
     class TriangleBBox
     {
     public:
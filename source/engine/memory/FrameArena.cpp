@@ -0,0 +1,9 @@
+#include "FrameArena.h"
+
+std::size_t FrameArena::m_allocationCount = 0;
+
+void FrameArena::reset()
+{
+    getAllocator().reset();
+    m_allocationCount = 0;
+}
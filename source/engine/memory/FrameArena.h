@@ -0,0 +1,86 @@
+#pragma once
+#include "LinearAllocator.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Replaces the global operator new to count all heap allocations of a frame (see HeapAllocationCounter)
+//#define COUNT_HEAP_ALLOCATIONS
+
+/**
+* Memory for data that is only needed during the current frame. Engine::update releases everything at the start of
+* each frame. Once the arena has grown to the working size of a frame no heap allocations are made.
+* Not thread-safe: Only allocate on the main thread.
+*/
+class FrameArena
+{
+public:
+    static void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+        ++m_allocationCount;
+        return getAllocator().allocate(size, alignment);
+    }
+
+    /**
+    * Invalidates all allocations of the last frame.
+    */
+    static void reset();
+
+    /**
+    * Number of allocations from the arena in the current frame.
+    */
+    static std::size_t getAllocationCount() { return m_allocationCount; }
+
+    /**
+    * Bytes allocated from the arena in the current frame.
+    */
+    static std::size_t getSize() { return getAllocator().size(); }
+
+    /**
+    * Number of heap allocations the arena itself made to grow since the start of the program.
+    */
+    static std::size_t getHeapAllocationCount() { return getAllocator().getHeapAllocationCount(); }
+
+private:
+    // Constructed on first use - the arena can already be used during static initialization
+    static LinearAllocator& getAllocator()
+    {
+        // Grows to the working size of a frame in the first frames
+        static LinearAllocator allocator(64 * 1024);
+        return allocator;
+    }
+
+private:
+    static std::size_t m_allocationCount;
+};
+
+/**
+* STL allocator that allocates from the FrameArena. Containers using it must not outlive the frame.
+* Deallocation is a no-op - the memory is released with FrameArena::reset().
+*/
+template <class T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    FrameAllocator() noexcept { }
+
+    template <class U>
+    FrameAllocator(const FrameAllocator<U>&) noexcept { }
+
+    T* allocate(std::size_t n) { return static_cast<T*>(FrameArena::allocate(n * sizeof(T), alignof(T))); }
+
+    void deallocate(T*, std::size_t) noexcept { }
+
+    template <class U>
+    bool operator==(const FrameAllocator<U>&) const noexcept { return true; }
+
+    template <class U>
+    bool operator!=(const FrameAllocator<U>&) const noexcept { return false; }
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
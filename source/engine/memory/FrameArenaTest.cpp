@@ -0,0 +1,101 @@
+#include "FrameArenaTest.h"
+#include "FrameArena.h"
+#include <glm/glm.hpp>
+#include <cassert>
+
+namespace frame_arena_test
+{
+#ifdef RUN_FRAME_ARENA_TESTS
+    struct FrameArenaTestRunner
+    {
+        FrameArenaTestRunner()
+        {
+            FrameArenaTest::runTests();
+        }
+    };
+
+    FrameArenaTestRunner frameArenaTestRunner;
+#endif
+}
+
+using namespace frame_arena_test;
+
+void FrameArenaTest::runTests()
+{
+    testLinearAllocator();
+    testContainers();
+    testNoSteadyStateHeapAllocations();
+}
+
+void FrameArenaTest::testLinearAllocator()
+{
+    LinearAllocator allocator(128);
+
+    char* c = static_cast<char*>(allocator.allocate(1, 1));
+    glm::mat4* m = allocator.create<glm::mat4>(1.0f);
+    assert(reinterpret_cast<std::uintptr_t>(m) % alignof(glm::mat4) == 0);
+    assert(reinterpret_cast<char*>(m) > c);
+    assert(*m == glm::mat4(1.0f));
+    assert(allocator.getHeapAllocationCount() == 1);
+
+    // Doesn't fit into the block anymore
+    allocator.create<glm::mat4>(2.0f);
+    assert(allocator.getHeapAllocationCount() == 2);
+
+    // The block grows to the usage of the last frame
+    allocator.reset();
+    assert(allocator.size() == 0);
+    assert(allocator.capacity() >= 1 + 2 * sizeof(glm::mat4));
+    assert(allocator.getHeapAllocationCount() == 3);
+
+    allocator.allocate(1, 1);
+    allocator.create<glm::mat4>(1.0f);
+    allocator.create<glm::mat4>(2.0f);
+    assert(allocator.getHeapAllocationCount() == 3);
+}
+
+void FrameArenaTest::testContainers()
+{
+    FrameArena::reset();
+
+    FrameVector<int> values;
+    for (int i = 0; i < 100; ++i)
+        values.push_back(i);
+
+    FrameString name("u_directionalLights");
+    name += "[0].direction";
+
+    assert(values[99] == 99);
+    assert(name == "u_directionalLights[0].direction");
+    assert(FrameArena::getAllocationCount() > 0);
+    assert(FrameArena::getSize() >= 100 * sizeof(int));
+
+    FrameArena::reset();
+    assert(FrameArena::getAllocationCount() == 0);
+    assert(FrameArena::getSize() == 0);
+}
+
+void FrameArenaTest::testNoSteadyStateHeapAllocations()
+{
+    auto runFrame = []()
+    {
+        FrameArena::reset();
+
+        FrameVector<glm::vec4> positions;
+        for (int i = 0; i < 50000; ++i)
+            positions.push_back(glm::vec4(float(i)));
+
+        FrameVector<bool> markedPortions(1000, false);
+        markedPortions[10] = true;
+    };
+
+    runFrame();
+    runFrame();
+    std::size_t heapAllocationCount = FrameArena::getHeapAllocationCount();
+
+    for (int frame = 0; frame < 5; ++frame)
+        runFrame();
+
+    assert(FrameArena::getHeapAllocationCount() == heapAllocationCount);
+    FrameArena::reset();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_FRAME_ARENA_TESTS
+#endif
+
+class FrameArenaTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testLinearAllocator();
+    static void testContainers();
+    static void testNoSteadyStateHeapAllocations();
+};
@@ -0,0 +1,47 @@
+#include "HeapAllocationCounter.h"
+#include "FrameArena.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::size_t> heapAllocationCount{0};
+}
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+void* operator new(std::size_t size)
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete[](void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+#endif
+
+bool HeapAllocationCounter::isEnabled()
+{
+#ifdef COUNT_HEAP_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t HeapAllocationCounter::getAllocationCount()
+{
+    return heapAllocationCount.load(std::memory_order_relaxed);
+}
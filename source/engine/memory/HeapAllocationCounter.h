@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+/**
+* Counts the calls of the global operator new if COUNT_HEAP_ALLOCATIONS is defined in FrameArena.h.
+*/
+class HeapAllocationCounter
+{
+public:
+    static bool isEnabled();
+
+    /**
+    * Number of heap allocations of all threads since the start of the program. Always 0 if the counting is disabled.
+    */
+    static std::size_t getAllocationCount();
+};
@@ -0,0 +1,53 @@
+#include "LinearAllocator.h"
+#include <algorithm>
+#include <new>
+#include <cassert>
+
+LinearAllocator::LinearAllocator(std::size_t capacity)
+    : m_capacity(capacity)
+{
+    m_block = allocateBlock(capacity);
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    reset();
+    delete[] m_block;
+}
+
+void* LinearAllocator::allocateOverflow(std::size_t size, std::size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    // new[] only guarantees the fundamental alignment - over-allocate for stricter alignments
+    char* overflowBlock = allocateBlock(size + alignment);
+    m_overflowBlocks.push_back(overflowBlock);
+
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(overflowBlock);
+    return overflowBlock + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+}
+
+void LinearAllocator::reset()
+{
+    m_highWaterMark = std::max(m_highWaterMark, m_size);
+
+    for (char* overflowBlock : m_overflowBlocks)
+        delete[] overflowBlock;
+
+    if (!m_overflowBlocks.empty())
+    {
+        m_overflowBlocks.clear();
+        delete[] m_block;
+        m_capacity = m_highWaterMark;
+        m_block = allocateBlock(m_capacity);
+    }
+
+    m_offset = 0;
+    m_size = 0;
+}
+
+char* LinearAllocator::allocateBlock(std::size_t size)
+{
+    ++m_heapAllocationCount;
+    return new char[std::max(size, std::size_t(1))];
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+* Hands out memory by bumping an offset in a single block. All allocations are released at once with reset().
+*
+* Allocations that don't fit into the block are served from overflow blocks until the next reset(). reset() then grows
+* the block to the highest usage so far - after a warm-up the allocator doesn't touch the heap anymore.
+*/
+class LinearAllocator
+{
+public:
+    explicit LinearAllocator(std::size_t capacity);
+    ~LinearAllocator();
+
+    LinearAllocator(const LinearAllocator&) = delete;
+    LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_block) + m_offset;
+        std::size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+        // The padding is counted as well to make sure the grown block fits the same allocations
+        m_size += size + padding;
+
+        if (m_offset + padding + size > m_capacity)
+            return allocateOverflow(size, alignment);
+
+        void* memory = m_block + m_offset + padding;
+        m_offset += padding + size;
+        return memory;
+    }
+
+    /**
+    * Destructors are never called - only types without destructors are allowed.
+    */
+    template <class T, class ... Args>
+    T* create(Args&& ... args);
+
+    /**
+    * Invalidates all allocations.
+    */
+    void reset();
+
+    /**
+    * Bytes handed out since the last reset.
+    */
+    std::size_t size() const { return m_size; }
+
+    std::size_t capacity() const { return m_capacity; }
+
+    /**
+    * Number of heap allocations that were made since the construction including the block itself.
+    */
+    std::size_t getHeapAllocationCount() const { return m_heapAllocationCount; }
+
+private:
+    void* allocateOverflow(std::size_t size, std::size_t alignment);
+
+    char* allocateBlock(std::size_t size);
+
+private:
+    char* m_block{nullptr};
+    std::size_t m_capacity{0};
+    std::size_t m_offset{0};
+    std::size_t m_size{0};
+    std::size_t m_highWaterMark{0};
+    std::vector<char*> m_overflowBlocks;
+    std::size_t m_heapAllocationCount{0};
+};
+
+template <class T, class ... Args>
+T* LinearAllocator::create(Args&& ... args)
+{
+    static_assert(std::is_trivially_destructible<T>::value, "LinearAllocator never calls destructors.");
+
+    return new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args) ...);
+}
@@ -0,0 +1,4 @@
+#include "SparsePool.h"
+
+const std::size_t BaseSparsePool::PAGE_SIZE;
+const uint32_t BaseSparsePool::INVALID_INDEX;
@@ -0,0 +1,142 @@
+#pragma once
+#include "Pool.h"
+#include <limits>
+#include <cstdint>
+#include <utility>
+
+/**
+* Pool of densely packed elements which are addressed by sparse keys (e.g. entity ids).
+* A paged sparse array maps keys to indices into the packed element storage. Pages are only
+* allocated when a key in their range is used, thus the memory consumption scales with the
+* number of elements and not with the largest key.
+* Elements are kept contiguous (per block) by swapping the last element into the gap on removal.
+*/
+class BaseSparsePool : public BasePool
+{
+public:
+    static const std::size_t PAGE_SIZE = 4096;
+    static const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    BaseSparsePool(std::size_t elemSize, std::size_t blockCapacity, std::size_t initialPoolCapacity)
+        : BasePool(elemSize, blockCapacity, initialPoolCapacity) { }
+
+    bool contains(std::size_t key) const
+    {
+        std::size_t page = key / PAGE_SIZE;
+        return page < m_sparsePages.size() && !m_sparsePages[page].empty() && m_sparsePages[page][key % PAGE_SIZE] != INVALID_INDEX;
+    }
+
+    /**
+    * Returns the index of the element with the given key in the packed storage.
+    */
+    std::size_t indexOf(std::size_t key) const
+    {
+        assert(contains(key));
+        return m_sparsePages[key / PAGE_SIZE][key % PAGE_SIZE];
+    }
+
+    /**
+    * Returns the key of the element at the given index in the packed storage.
+    */
+    std::size_t keyAt(std::size_t idx) const
+    {
+        assert(idx < m_size);
+        return m_keys[idx];
+    }
+
+    void* getByKey(std::size_t key) { return get(indexOf(key)); }
+
+    const void* getByKey(std::size_t key) const { return get(indexOf(key)); }
+
+protected:
+    /**
+    * Appends the key to the packed storage and returns the index of the new element.
+    */
+    std::size_t insertKey(std::size_t key)
+    {
+        assert(!contains(key));
+        std::size_t page = key / PAGE_SIZE;
+
+        if (m_sparsePages.size() <= page)
+            m_sparsePages.resize(page + 1);
+
+        if (m_sparsePages[page].empty())
+            m_sparsePages[page].resize(PAGE_SIZE, INVALID_INDEX);
+
+        std::size_t idx = m_size;
+        resize(m_size + 1);
+        m_keys.push_back(uint32_t(key));
+        m_sparsePages[page][key % PAGE_SIZE] = uint32_t(idx);
+        return idx;
+    }
+
+    /**
+    * Removes the key from the mapping. The element which was last in the packed storage
+    * is expected to be moved to the index of the removed key by the caller.
+    */
+    void eraseKey(std::size_t key)
+    {
+        std::size_t idx = indexOf(key);
+        std::size_t lastKey = m_keys.back();
+
+        m_keys[idx] = uint32_t(lastKey);
+        m_sparsePages[lastKey / PAGE_SIZE][lastKey % PAGE_SIZE] = uint32_t(idx);
+        m_sparsePages[key / PAGE_SIZE][key % PAGE_SIZE] = INVALID_INDEX;
+        m_keys.pop_back();
+        --m_size;
+    }
+
+protected:
+    std::vector<std::vector<uint32_t>> m_sparsePages; // Key -> index into the packed storage
+    std::vector<uint32_t> m_keys; // Index into the packed storage -> key
+};
+
+/**
+* The default block capacity is much lower than the one of Pool because sparse pools
+* are meant for element types with few instances.
+*/
+template <class T, std::size_t BlockCapacity = 64, std::size_t InitialCapacity = 0>
+class SparsePool : public BaseSparsePool
+{
+public:
+    SparsePool() : BaseSparsePool(sizeof(T), BlockCapacity, InitialCapacity) { }
+
+    /**
+    * Calls the destructor of the element with the given key and fills the gap with the last element.
+    */
+    void destroy(std::size_t key) override
+    {
+        std::size_t idx = indexOf(key);
+        std::size_t lastIdx = m_size - 1;
+        T* elem = static_cast<T*>(get(idx));
+        elem->~T();
+
+        if (idx != lastIdx)
+        {
+            T* last = static_cast<T*>(get(lastIdx));
+            new(elem) T(std::move(*last));
+            last->~T();
+        }
+
+        eraseKey(key);
+    }
+
+    /**
+    * Constructs a new element with the given key at the end of the packed storage.
+    * args are the constructor parameters for the class of the pool
+    */
+    template <class ... Args>
+    T* create(std::size_t key, Args&& ... args)
+    {
+        std::size_t idx = insertKey(key);
+        return new(get(idx)) T(std::forward<Args>(args) ...);
+    }
+
+    T& getRef(std::size_t key) { return *static_cast<T*>(getByKey(key)); }
+
+    const T& getRef(std::size_t key) const { return *static_cast<const T*>(getByKey(key)); }
+
+    T* getPtr(std::size_t key) { return static_cast<T*>(getByKey(key)); }
+
+    const T* getPtr(std::size_t key) const { return static_cast<const T*>(getByKey(key)); }
+};
@@ -1,6 +1,8 @@
 #include "Material.h"
 
 std::unordered_map<UniformName, EditableMaterialDesc> EditableMaterialProperties::m_materialDescs;
+uint32_t Material::m_idCounter = 0;
+const MaterialParameterIndex Material::INVALID_PARAMETER;
 
 void EditableMaterialProperties::init()
 {
@@ -11,23 +13,13 @@ void EditableMaterialProperties::init()
 }
 
 Material::Material(std::shared_ptr<Shader> shader)
-    : m_shader(shader) {}
+    : m_id(m_idCounter++), m_shader(shader) {}
 
 void Material::setShader(std::shared_ptr<Shader> shader)
 {
     m_shader = shader;
 }
 
-void Material::setTexture2D(const TextureName& textureName, TextureID textureID)
-{
-    m_textures2D[textureName] = textureID;
-}
-
-void Material::setTexture3D(const TextureName& textureName, TextureID textureID)
-{
-    m_textures3D[textureName] = textureID;
-}
-
 void Material::use()
 {
     use(m_shader.get(), true);
@@ -40,31 +32,139 @@ void Material::use(Shader* shader, bool bind)
     if (bind)
         shader->bind();
 
-    for (auto& p : m_floatMap)
-        shader->setFloat(p.first, p.second);
-
-    for (auto& p : m_vec2Map)
-        shader->setVector(p.first, p.second);
-
-    for (auto& p : m_vec3Map)
-        shader->setVector(p.first, p.second);
-
-    for (auto& p : m_vec4Map)
-        shader->setVector(p.first, p.second);
+    const ShaderLocations& shaderLocations = getShaderLocations(shader);
+    GLint textureUnit = 0;
 
-    for (auto& p : m_mat2Map)
-        shader->setMatrix(p.first, p.second);
+    for (std::size_t i = 0; i < m_parameters.size(); ++i)
+    {
+        const MaterialParameter& parameter = m_parameters[i];
+        GLint location = shaderLocations.locations[i];
+        const GLfloat* data = reinterpret_cast<const GLfloat*>(&m_data[parameter.offset]);
+
+        switch (parameter.type)
+        {
+        case MaterialParameterType::TEXTURE_2D:
+            glActiveTexture(GL_TEXTURE0 + textureUnit);
+            glBindTexture(GL_TEXTURE_2D, *reinterpret_cast<const TextureID*>(data));
+            glUniform1i(location, textureUnit++);
+            continue;
+        case MaterialParameterType::TEXTURE_3D:
+            glActiveTexture(GL_TEXTURE0 + textureUnit);
+            glBindTexture(GL_TEXTURE_3D, *reinterpret_cast<const TextureID*>(data));
+            glUniform1i(location, textureUnit++);
+            continue;
+        default: break;
+        }
+
+        if (location < 0)
+            continue;
+
+        switch (parameter.type)
+        {
+        case MaterialParameterType::FLOAT:
+            glUniform1fv(location, 1, data);
+            break;
+        case MaterialParameterType::VEC2:
+            glUniform2fv(location, 1, data);
+            break;
+        case MaterialParameterType::VEC3:
+            glUniform3fv(location, 1, data);
+            break;
+        case MaterialParameterType::VEC4:
+            glUniform4fv(location, 1, data);
+            break;
+        case MaterialParameterType::MAT2:
+            glUniformMatrix2fv(location, 1, GL_FALSE, data);
+            break;
+        case MaterialParameterType::MAT3:
+            glUniformMatrix3fv(location, 1, GL_FALSE, data);
+            break;
+        case MaterialParameterType::MAT4:
+            glUniformMatrix4fv(location, 1, GL_FALSE, data);
+            break;
+        default: break;
+        }
+    }
+}
 
-    for (auto& p : m_mat3Map)
-        shader->setMatrix(p.first, p.second);
+MaterialParameterIndex Material::getParameterIndex(const UniformName& uniformName) const
+{
+    auto it = m_parameterIndices.find(uniformName);
+    return it != m_parameterIndices.end() ? it->second : INVALID_PARAMETER;
+}
 
-    for (auto& p : m_mat4Map)
-        shader->setMatrix(p.first, p.second);
+uint32_t Material::getParameterSize(MaterialParameterType type)
+{
+    switch (type)
+    {
+    case MaterialParameterType::FLOAT: return sizeof(float);
+    case MaterialParameterType::VEC2: return sizeof(glm::vec2);
+    case MaterialParameterType::VEC3: return sizeof(glm::vec3);
+    case MaterialParameterType::VEC4: return sizeof(glm::vec4);
+    case MaterialParameterType::MAT2: return sizeof(glm::mat2);
+    case MaterialParameterType::MAT3: return sizeof(glm::mat3);
+    case MaterialParameterType::MAT4: return sizeof(glm::mat4);
+    case MaterialParameterType::TEXTURE_2D: return sizeof(TextureID);
+    case MaterialParameterType::TEXTURE_3D: return sizeof(TextureID);
+    default:
+        assert(false);
+        return 0;
+    }
+}
 
-    GLint textureUnit = 0;
-    for (auto& tp : m_textures2D)
-        shader->bindTexture2D(tp.second, tp.first, textureUnit++);
+MaterialParameterIndex Material::addParameter(const UniformName& uniformName, MaterialParameterType type)
+{
+    MaterialParameterIndex idx = getParameterIndex(uniformName);
+    uint32_t offset = uint32_t(m_data.size());
+    m_data.resize(m_data.size() + getParameterSize(type));
+
+    if (idx == INVALID_PARAMETER)
+    {
+        idx = MaterialParameterIndex(m_parameters.size());
+        m_parameters.emplace_back(uniformName, type, offset);
+        m_parameterIndices[uniformName] = idx;
+
+        // The cached locations miss the new parameter
+        m_shaderLocations.clear();
+    }
+    else
+    {
+        // The type of an existing parameter changed - the old value is left unused in the buffer
+        m_parameters[idx].type = type;
+        m_parameters[idx].offset = offset;
+    }
+
+    return idx;
+}
 
-    for (auto& tp : m_textures3D)
-        shader->bindTexture3D(tp.second, tp.first, textureUnit++);
+const Material::ShaderLocations& Material::getShaderLocations(const Shader* shader)
+{
+    for (auto& shaderLocations : m_shaderLocations)
+    {
+        if (shaderLocations.shader == shader && shader->hasSameProgram(shaderLocations.program))
+            return shaderLocations;
+    }
+
+    // The shader is new or was recompiled
+    ShaderLocations* shaderLocations = nullptr;
+    for (auto& l : m_shaderLocations)
+    {
+        if (l.shader == shader)
+            shaderLocations = &l;
+    }
+
+    if (!shaderLocations)
+    {
+        m_shaderLocations.emplace_back();
+        shaderLocations = &m_shaderLocations.back();
+    }
+
+    shaderLocations->shader = shader;
+    shaderLocations->program = shader->getProgram();
+    shaderLocations->locations.resize(m_parameters.size());
+
+    for (std::size_t i = 0; i < m_parameters.size(); ++i)
+        shaderLocations->locations[i] = shader->getLocation(m_parameters[i].name.c_str());
+
+    return *shaderLocations;
 }
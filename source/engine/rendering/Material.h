@@ -1,7 +1,11 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstring>
+#include <cassert>
+#include <limits>
 #include <unordered_map>
-#include <glm/detail/type_vec3.hpp>
+#include <glm/glm.hpp>
 #include <memory>
 #include "shader/Shader.h"
 #include "Texture2D.h"
@@ -40,54 +44,156 @@ private:
     static std::unordered_map<UniformName, EditableMaterialDesc> m_materialDescs;
 };
 
+enum class MaterialParameterType : uint8_t
+{
+    FLOAT,
+    VEC2,
+    VEC3,
+    VEC4,
+    MAT2,
+    MAT3,
+    MAT4,
+    TEXTURE_2D,
+    TEXTURE_3D
+};
+
+struct MaterialParameter
+{
+    MaterialParameter() { }
+
+    MaterialParameter(const UniformName& name, MaterialParameterType type, uint32_t offset)
+        : name(name), type(type), offset(offset) { }
+
+    UniformName name;
+    MaterialParameterType type{MaterialParameterType::FLOAT};
+    uint32_t offset{0}; // Byte offset in the parameter buffer of the material
+};
+
+using MaterialParameterIndex = uint32_t;
+
+/**
+* The parameters of a material are stored in a flat byte buffer. The layout (name, type, offset) is fixed
+* when a parameter is set for the first time. Uniform locations are resolved once per shader the material is used with.
+* use() then only uploads the buffer with the cached locations - no name lookups are involved.
+*/
 class Material
 {
     friend class MeshRenderer;
     friend class MeshRenderSystem;
+    friend class RenderQueue;
+    friend class RenderingBenchmark;
 public:
-    Material() { }
+    static const MaterialParameterIndex INVALID_PARAMETER = std::numeric_limits<MaterialParameterIndex>::max();
+
+    Material()
+        : m_id(m_idCounter++) { }
 
     explicit Material(std::shared_ptr<Shader> shader);
 
     void setShader(std::shared_ptr<Shader> shader);
 
-    void setTexture2D(const TextureName& textureName, TextureID textureID);
-    void setTexture3D(const TextureName& textureName, TextureID textureID);
+    void setTexture2D(const TextureName& textureName, TextureID textureID) { setParameter(textureName, MaterialParameterType::TEXTURE_2D, textureID); }
+
+    void setTexture3D(const TextureName& textureName, TextureID textureID) { setParameter(textureName, MaterialParameterType::TEXTURE_3D, textureID); }
 
     std::shared_ptr<Shader> getShader() const { return m_shader; }
 
-    void setFloat(const UniformName& uniformName, float v) noexcept { m_floatMap[uniformName] = v; }
+    /**
+    * Unique id which is used to group draw calls by material.
+    */
+    uint32_t getID() const { return m_id; }
+
+    void setFloat(const UniformName& uniformName, float v) { setParameter(uniformName, MaterialParameterType::FLOAT, v); }
+
+    void setVector(const UniformName& uniformName, const glm::vec2& v) { setParameter(uniformName, MaterialParameterType::VEC2, v); }
+
+    void setVector(const UniformName& uniformName, const glm::vec3& v) { setParameter(uniformName, MaterialParameterType::VEC3, v); }
+
+    void setVector(const UniformName& uniformName, const glm::vec4& v) { setParameter(uniformName, MaterialParameterType::VEC4, v); }
+
+    void setColor(const UniformName& uniformName, const glm::vec3& v) { setParameter(uniformName, MaterialParameterType::VEC3, v); }
+
+    void setColor(const UniformName& uniformName, const glm::vec4& v) { setParameter(uniformName, MaterialParameterType::VEC4, v); }
 
-    void setVector(const UniformName& uniformName, const glm::vec2& v) noexcept { m_vec2Map[uniformName] = v; }
+    void setMatrix(const UniformName& uniformName, const glm::mat2& m) { setParameter(uniformName, MaterialParameterType::MAT2, m); }
 
-    void setVector(const UniformName& uniformName, const glm::vec3& v) noexcept { m_vec3Map[uniformName] = v; }
+    void setMatrix(const UniformName& uniformName, const glm::mat3& m) { setParameter(uniformName, MaterialParameterType::MAT3, m); }
 
-    void setVector(const UniformName& uniformName, const glm::vec4& v) noexcept { m_vec4Map[uniformName] = v; }
+    void setMatrix(const UniformName& uniformName, const glm::mat4& m) { setParameter(uniformName, MaterialParameterType::MAT4, m); }
 
-    void setColor(const UniformName& uniformName, const glm::vec3& v) noexcept { m_vec3Map[uniformName] = v; }
+    /**
+    * Returns INVALID_PARAMETER if the parameter was never set.
+    */
+    MaterialParameterIndex getParameterIndex(const UniformName& uniformName) const;
 
-    void setColor(const UniformName& uniformName, const glm::vec4& v) noexcept { m_vec4Map[uniformName] = v; }
+    /**
+    * Sets an existing parameter without a name lookup. T has to match the type of the parameter.
+    */
+    template <class T>
+    void setParameter(MaterialParameterIndex idx, const T& v);
 
-    void setMatrix(const UniformName& uniformName, const glm::mat2& m) noexcept { m_mat2Map[uniformName] = m; }
+    template <class T>
+    T* getParameterData(MaterialParameterIndex idx);
 
-    void setMatrix(const UniformName& uniformName, const glm::mat3& m) noexcept { m_mat3Map[uniformName] = m; }
+    const std::vector<MaterialParameter>& getParameters() const { return m_parameters; }
 
-    void setMatrix(const UniformName& uniformName, const glm::mat4& m) noexcept { m_mat4Map[uniformName] = m; }
+    static uint32_t getParameterSize(MaterialParameterType type);
 
 private:
+    struct ShaderLocations
+    {
+        const Shader* shader{nullptr};
+        ShaderProgram program{0};
+        std::vector<GLint> locations; // One location per parameter - -1 if the shader doesn't use the parameter
+    };
+
     void use();
     void use(Shader* shader, bool bind = false);
 
+    template <class T>
+    void setParameter(const UniformName& uniformName, MaterialParameterType type, const T& v);
+
+    MaterialParameterIndex addParameter(const UniformName& uniformName, MaterialParameterType type);
+
+    const ShaderLocations& getShaderLocations(const Shader* shader);
+
 private:
+    static uint32_t m_idCounter;
+
+    uint32_t m_id{0};
     std::shared_ptr<Shader> m_shader;
-    std::unordered_map<TextureName, TextureID> m_textures2D;
-    std::unordered_map<TextureName, TextureID> m_textures3D;
-
-    std::unordered_map<UniformName, float> m_floatMap;
-    std::unordered_map<UniformName, glm::vec2> m_vec2Map;
-    std::unordered_map<UniformName, glm::vec3> m_vec3Map;
-    std::unordered_map<UniformName, glm::vec4> m_vec4Map;
-    std::unordered_map<UniformName, glm::mat2> m_mat2Map;
-    std::unordered_map<UniformName, glm::mat3> m_mat3Map;
-    std::unordered_map<UniformName, glm::mat4> m_mat4Map;
+
+    std::vector<MaterialParameter> m_parameters;
+    std::unordered_map<UniformName, MaterialParameterIndex> m_parameterIndices;
+    std::vector<uint8_t> m_data;
+
+    // Materials are used with few shaders (own shader and pass shaders) - a linear search is fast enough
+    std::vector<ShaderLocations> m_shaderLocations;
 };
+
+template <class T>
+void Material::setParameter(MaterialParameterIndex idx, const T& v)
+{
+    assert(idx < m_parameters.size());
+    assert(sizeof(T) == getParameterSize(m_parameters[idx].type));
+    std::memcpy(&m_data[m_parameters[idx].offset], &v, sizeof(T));
+}
+
+template <class T>
+T* Material::getParameterData(MaterialParameterIndex idx)
+{
+    assert(idx < m_parameters.size());
+    assert(sizeof(T) == getParameterSize(m_parameters[idx].type));
+    return reinterpret_cast<T*>(&m_data[m_parameters[idx].offset]);
+}
+
+template <class T>
+void Material::setParameter(const UniformName& uniformName, MaterialParameterType type, const T& v)
+{
+    MaterialParameterIndex idx = getParameterIndex(uniformName);
+
+    if (idx == INVALID_PARAMETER || m_parameters[idx].type != type)
+        idx = addParameter(uniformName, type);
+
+    setParameter(idx, v);
+}
@@ -0,0 +1,233 @@
+#include "RenderingBenchmark.h"
+#include "Material.h"
+#include "architecture/RPBlackboard.h"
+#include <engine/resource/ResourceManager.h>
+#include <engine/util/Timer.h>
+#include <engine/util/Logger.h>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+namespace rendering_benchmark
+{
+    const int MATERIAL_COUNT = 64;
+    const int ITERATIONS = 2000;
+
+    /**
+    * The material before the parameters were stored in a flat buffer: One map per type,
+    * uniform locations are looked up by name on every use.
+    */
+    struct MapMaterial
+    {
+        void use(Shader* shader)
+        {
+            for (auto& p : floatMap)
+                shader->setFloat(p.first, p.second);
+
+            for (auto& p : vec3Map)
+                shader->setVector(p.first, p.second);
+
+            for (auto& p : vec4Map)
+                shader->setVector(p.first, p.second);
+
+            GLint textureUnit = 0;
+            for (auto& tp : textures2D)
+                shader->bindTexture2D(tp.second, tp.first, textureUnit++);
+        }
+
+        std::unordered_map<UniformName, float> floatMap;
+        std::unordered_map<UniformName, glm::vec3> vec3Map;
+        std::unordered_map<UniformName, glm::vec4> vec4Map;
+        std::unordered_map<TextureName, TextureID> textures2D;
+    };
+
+    double nanosecondsPerMaterial(const Timer& timer)
+    {
+        return timer.deltaTimeInMicroseconds() * 1000.0 / (double(MATERIAL_COUNT) * ITERATIONS);
+    }
+
+    const int FRAME_COUNT = 100000;
+
+    /**
+    * The render pipeline data before the blackboard: Every put allocates a new block, every access hashes the key.
+    */
+    struct MapBlackboard
+    {
+        ~MapBlackboard()
+        {
+            for (auto& p : data)
+                delete[] p.second;
+        }
+
+        template <class T>
+        void put(const std::string& key, const T& value)
+        {
+            auto it = data.find(key);
+            if (it != data.end())
+                delete[] it->second;
+
+            char* block = new char[sizeof(T)];
+            memcpy(block, &value, sizeof(T));
+            data[key] = block;
+            ++heapAllocationCount;
+        }
+
+        template <class T>
+        T fetch(const std::string& key) { return *reinterpret_cast<T*>(data.find(key)->second); }
+
+        std::unordered_map<std::string, char*> data;
+        std::size_t heapAllocationCount{0};
+    };
+
+    const RPKey<uint32_t> DIFFUSE_TEXTURE("Benchmark DiffuseTexture");
+    const RPKey<uint32_t> NORMAL_MAP("Benchmark NormalMap");
+    const RPKey<uint32_t> SPECULAR_MAP("Benchmark SpecularMap");
+    const RPKey<uint32_t> EMISSION_MAP("Benchmark EmissionMap");
+    const RPKey<uint32_t> DEPTH_TEXTURE("Benchmark DepthTexture");
+    const RPKey<uint32_t> DIRTY_LEVELS("Benchmark VoxelOpacityDirtyLevels");
+}
+
+using namespace rendering_benchmark;
+
+void RenderingBenchmark::runBenchmarks()
+{
+    benchmarkMaterial();
+    benchmarkBlackboard();
+}
+
+void RenderingBenchmark::benchmarkMaterial()
+{
+    auto shader = ResourceManager::getShader("shaders/forwardShadingPass.vert", "shaders/forwardShadingPass.frag");
+    shader->bind();
+
+    // The parameters of a typical scene material (see EntityCreator::createMaterial)
+    std::vector<UniformName> floatNames = { "u_hasDiffuseTexture", "u_hasNormalMap", "u_hasSpecularMap", "u_hasEmissionMap", "u_hasOpacityMap", "u_shininess" };
+    std::vector<TextureName> textureNames = { "u_diffuseTexture", "u_normalMap", "u_specularMap" };
+
+    std::vector<MapMaterial> mapMaterials(MATERIAL_COUNT);
+    std::vector<Material> materials(MATERIAL_COUNT);
+
+    for (int i = 0; i < MATERIAL_COUNT; ++i)
+    {
+        for (auto& name : floatNames)
+        {
+            mapMaterials[i].floatMap[name] = float(i);
+            materials[i].setFloat(name, float(i));
+        }
+
+        mapMaterials[i].vec4Map["u_color"] = glm::vec4(0.5f);
+        mapMaterials[i].vec3Map["u_emissionColor"] = glm::vec3(0.0f);
+        mapMaterials[i].vec3Map["u_specularColor"] = glm::vec3(0.0f);
+        materials[i].setColor("u_color", glm::vec4(0.5f));
+        materials[i].setColor("u_emissionColor", glm::vec3(0.0f));
+        materials[i].setColor("u_specularColor", glm::vec3(0.0f));
+
+        for (auto& name : textureNames)
+        {
+            mapMaterials[i].textures2D[name] = 0;
+            materials[i].setTexture2D(name, 0);
+        }
+    }
+
+    LOG("Rendering Benchmark: Material with " << materials[0].getParameters().size() << " parameters, "
+        << MATERIAL_COUNT << " materials x " << ITERATIONS << " iterations");
+
+    Timer timer;
+
+    // Bind
+    glFinish();
+    timer.start();
+    for (int it = 0; it < ITERATIONS; ++it)
+        for (auto& m : mapMaterials)
+            m.use(shader.get());
+    glFinish();
+    timer.tick();
+    LOG("Bind - string-keyed maps: " << nanosecondsPerMaterial(timer) << " ns per material");
+
+    timer.start();
+    for (int it = 0; it < ITERATIONS; ++it)
+        for (auto& m : materials)
+            m.use(shader.get());
+    glFinish();
+    timer.tick();
+    LOG("Bind - cached locations: " << nanosecondsPerMaterial(timer) << " ns per material");
+
+    // Set
+    timer.start();
+    for (int it = 0; it < ITERATIONS; ++it)
+        for (auto& m : mapMaterials)
+            m.floatMap["u_shininess"] = float(it);
+    timer.tick();
+    LOG("Set - string-keyed map: " << nanosecondsPerMaterial(timer) << " ns per parameter");
+
+    timer.start();
+    for (int it = 0; it < ITERATIONS; ++it)
+        for (auto& m : materials)
+            m.setFloat("u_shininess", float(it));
+    timer.tick();
+    LOG("Set - by name: " << nanosecondsPerMaterial(timer) << " ns per parameter");
+
+    MaterialParameterIndex shininessIdx = materials[0].getParameterIndex("u_shininess");
+    timer.start();
+    for (int it = 0; it < ITERATIONS; ++it)
+        for (auto& m : materials)
+            m.setParameter(shininessIdx, float(it));
+    timer.tick();
+    LOG("Set - by index: " << nanosecondsPerMaterial(timer) << " ns per parameter");
+}
+
+void RenderingBenchmark::benchmarkBlackboard()
+{
+    // A frame of the GI pipeline: SceneGeometryPass and VoxelizationPass put their outputs, GIPass and WrapBorderPass fetch them
+    uint32_t checksum = 0;
+    Timer timer;
+
+    MapBlackboard mapBlackboard;
+    timer.start();
+    for (int frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        mapBlackboard.put<uint32_t>("DiffuseTexture", frame);
+        mapBlackboard.put<uint32_t>("NormalMap", frame);
+        mapBlackboard.put<uint32_t>("SpecularMap", frame);
+        mapBlackboard.put<uint32_t>("EmissionMap", frame);
+        mapBlackboard.put<uint32_t>("DepthTexture", frame);
+        mapBlackboard.put<uint32_t>("VoxelOpacityDirtyLevels", frame);
+
+        checksum += mapBlackboard.fetch<uint32_t>("DiffuseTexture");
+        checksum += mapBlackboard.fetch<uint32_t>("NormalMap");
+        checksum += mapBlackboard.fetch<uint32_t>("SpecularMap");
+        checksum += mapBlackboard.fetch<uint32_t>("EmissionMap");
+        checksum += mapBlackboard.fetch<uint32_t>("DepthTexture");
+        checksum += mapBlackboard.fetch<uint32_t>("VoxelOpacityDirtyLevels");
+    }
+    timer.tick();
+
+    LOG("Rendering Benchmark: Blackboard with 6 puts and 6 fetches per frame, " << FRAME_COUNT << " frames");
+    LOG("String-keyed map: " << timer.deltaTimeInMicroseconds() * 1000.0 / FRAME_COUNT << " ns per frame, "
+        << double(mapBlackboard.heapAllocationCount) / FRAME_COUNT << " heap allocations per frame");
+
+    RPBlackboard blackboard;
+    timer.start();
+    for (int frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        blackboard.beginFrame();
+        blackboard.put(DIFFUSE_TEXTURE, uint32_t(frame));
+        blackboard.put(NORMAL_MAP, uint32_t(frame));
+        blackboard.put(SPECULAR_MAP, uint32_t(frame));
+        blackboard.put(EMISSION_MAP, uint32_t(frame));
+        blackboard.put(DEPTH_TEXTURE, uint32_t(frame));
+        blackboard.put(DIRTY_LEVELS, uint32_t(frame));
+
+        checksum += blackboard.fetch(DIFFUSE_TEXTURE);
+        checksum += blackboard.fetch(NORMAL_MAP);
+        checksum += blackboard.fetch(SPECULAR_MAP);
+        checksum += blackboard.fetch(EMISSION_MAP);
+        checksum += blackboard.fetch(DEPTH_TEXTURE);
+        checksum += blackboard.fetch(DIRTY_LEVELS);
+    }
+    timer.tick();
+
+    // The only allocations are the initial arena and the slots on the first put
+    LOG("Typed blackboard: " << timer.deltaTimeInMicroseconds() * 1000.0 / FRAME_COUNT << " ns per frame, "
+        << blackboard.getArena().getHeapAllocationCount() << " arena allocations in total (checksum " << checksum << ")");
+}
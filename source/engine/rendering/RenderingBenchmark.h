@@ -0,0 +1,18 @@
+#pragma once
+
+// Runs the rendering benchmarks after the GL context was created and logs the results
+//#define RUN_RENDERING_BENCHMARKS
+
+class RenderingBenchmark
+{
+public:
+    /**
+    * Requires a current GL context.
+    */
+    static void runBenchmarks();
+
+private:
+    static void benchmarkMaterial();
+
+    static void benchmarkBlackboard();
+};
@@ -82,45 +82,75 @@ void Texture2D::createMultisampled(uint8_t numSamples, GLsizei width, GLsizei he
 
 void Texture2D::load(const std::string& path, Texture2DSettings settings)
 {
-    m_target = GL_TEXTURE_2D;
-
     if (isValid())
     {
         glDeleteTextures(1, &m_glId);
         m_glId = 0;
     }
 
-    auto imgData = SOIL_load_image(path.c_str(), &m_width, &m_height, &m_channels, SOIL_LOAD_AUTO);
-    GL_ERROR_CHECK();
+    Texture2DImage image = decode(path);
 
-    if (!imgData)
+    if (!image.isValid())
     {
         LOG("Failed to load: " + path);
         return;
     }
 
+    upload(image, settings);
+}
+
+Texture2DImage Texture2D::decode(const std::string& path)
+{
+    Texture2DImage image;
+    image.pixels.reset(SOIL_load_image(path.c_str(), &image.width, &image.height, &image.channels, SOIL_LOAD_AUTO));
+
+    if (!image.isValid())
+        return image;
+
+    // Invert_Y
+    unsigned char* imgData = image.pixels.get();
+    for (int i = 0; i * 2 < image.height; ++i)
+    {
+        int idx0 = i * image.width * image.channels;
+        int idx1 = (image.height - 1 - i) * image.width * image.channels;
+        for (int j = image.width * image.channels; j > 0; --j)
+            std::swap(imgData[idx0++], imgData[idx1++]);
+    }
+
+    return image;
+}
+
+void Texture2D::upload(const Texture2DImage& image, Texture2DSettings settings)
+{
+    assert(image.isValid());
+    m_target = GL_TEXTURE_2D;
+    m_width = image.width;
+    m_height = image.height;
+    m_channels = image.channels;
+
     // Using SOIL_create_OGL_texture() results in OpenGL errors due to the use of deprecated functionaly (GL_LUMINANCE)
-    glGenTextures(1, &m_glId);
+    if (!isValid())
+        glGenTextures(1, &m_glId);
+
     glBindTexture(m_target, m_glId);
 
+    GLint swizzleMask[] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
     switch (m_channels)
     {
     case 1:
-    {
         m_format = GL_RED;
         m_internalFormat = GL_R16;
-        GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
-        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+        swizzleMask[1] = GL_RED;
+        swizzleMask[2] = GL_RED;
+        swizzleMask[3] = GL_ONE;
         break;
-    }
     case 2:
-    {
         m_format = GL_RG;
         m_internalFormat = GL_RG16;
-        GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
-        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+        swizzleMask[1] = GL_RED;
+        swizzleMask[2] = GL_RED;
+        swizzleMask[3] = GL_GREEN;
         break;
-    }
     case 3:
         m_format = GL_RGB;
         m_internalFormat = GL_RGB8;
@@ -132,24 +162,21 @@ void Texture2D::load(const std::string& path, Texture2DSettings settings)
     default: break;
     }
 
-    // Invert_Y
-    for (int i = 0; i * 2 < m_height; ++i)
-    {
-        int idx0 = i * m_width * m_channels;
-        int idx1 = (m_height - 1 - i) * m_width * m_channels;
-        for (int j = m_width * m_channels; j > 0; --j)
-            std::swap(imgData[idx0++], imgData[idx1++]);
-    }
+    // Reset the swizzle of a previous upload with another channel count
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
 
     m_pixelType = GL_UNSIGNED_BYTE;
-    glTexImage2D(m_target, 0, m_internalFormat, m_width, m_height, 0, m_format, m_pixelType, imgData);
+    glTexImage2D(m_target, 0, m_internalFormat, m_width, m_height, 0, m_format, m_pixelType, image.pixels.get());
 
     applySettings(settings);
-
-    SOIL_free_image_data(imgData);
     GL_ERROR_CHECK();
 }
 
+void Texture2DImage::PixelDeleter::operator()(unsigned char* pixels) const
+{
+    SOIL_free_image_data(pixels);
+}
+
 void Texture2D::setParameteri(GLenum name, GLint value) const
 {
     assert(isValid());
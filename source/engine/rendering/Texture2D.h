@@ -1,6 +1,7 @@
 #pragma once
 #include <GL/glew.h>
 #include <string>
+#include <memory>
 
 using TextureID = GLuint;
 
@@ -16,6 +17,26 @@ enum class Texture2DSettings
     Custom
 };
 
+/**
+* Image data decoded on the CPU. Decoding doesn't need a GL context and can be done on any thread.
+*/
+struct Texture2DImage
+{
+    struct PixelDeleter
+    {
+        void operator()(unsigned char* pixels) const;
+    };
+
+    bool isValid() const { return pixels != nullptr; }
+
+    std::size_t getSizeInBytes() const { return std::size_t(width) * height * channels; }
+
+    std::unique_ptr<unsigned char, PixelDeleter> pixels;
+    int width{0};
+    int height{0};
+    int channels{0};
+};
+
 class Texture2D
 {
 public:
@@ -34,6 +55,17 @@ public:
 
     void load(const std::string& path, Texture2DSettings settings = Texture2DSettings::S_T_REPEAT_MIN_MAG_LINEAR);
 
+    /**
+    * Loads the image and flips it vertically. Returns an invalid image if loading failed.
+    */
+    static Texture2DImage decode(const std::string& path);
+
+    /**
+    * (Re)creates the texture from the decoded image. The GL name is kept if the texture is already valid,
+    * thus materials which reference the texture (e.g. a placeholder) see the new content.
+    */
+    void upload(const Texture2DImage& image, Texture2DSettings settings = Texture2DSettings::S_T_REPEAT_MIN_MAG_LINEAR);
+
     GLsizei getWidth() const noexcept { return m_width; }
 
     GLsizei getHeight() const noexcept { return m_height; }
@@ -0,0 +1,395 @@
+#include "FrameGraph.h"
+#include <engine/util/Logger.h>
+#include <algorithm>
+#include <limits>
+#include <cassert>
+
+namespace
+{
+    const std::size_t NO_PASS = std::numeric_limits<std::size_t>::max();
+
+    uint32_t getBarrierBit(FrameGraphAccess access)
+    {
+        switch (access)
+        {
+        case FrameGraphAccess::TEXTURE: return FrameGraph::TEXTURE_FETCH_BARRIER;
+        case FrameGraphAccess::IMAGE: return FrameGraph::SHADER_IMAGE_ACCESS_BARRIER;
+        case FrameGraphAccess::RENDER_TARGET: return FrameGraph::FRAMEBUFFER_BARRIER;
+        default: return 0;
+        }
+    }
+}
+
+void FrameGraphBuilder::addRead(std::size_t resource, FrameGraphAccess access)
+{
+    m_frameGraph->getResource(resource);
+    m_frameGraph->m_passes[m_passIdx].reads.emplace_back(resource, access);
+}
+
+void FrameGraphBuilder::addWrite(std::size_t resource, FrameGraphAccess access)
+{
+    m_frameGraph->getResource(resource);
+    m_frameGraph->m_passes[m_passIdx].writes.emplace_back(resource, access);
+}
+
+void FrameGraphBuilder::addTexture(std::size_t resource, const FrameGraphTextureDesc& desc)
+{
+    auto& resourceNode = m_frameGraph->getResource(resource);
+    assert(!resourceNode.imported);
+    resourceNode.transient = true;
+    resourceNode.desc = desc;
+}
+
+void FrameGraphBuilder::setSideEffect()
+{
+    m_frameGraph->m_passes[m_passIdx].sideEffect = true;
+}
+
+FrameGraph::FrameGraph(FrameGraphBackend* backend)
+    : m_backend(backend) { }
+
+FrameGraph::~FrameGraph()
+{
+    for (auto& physicalTexture : m_physicalTextures)
+        m_backend->destroyTexture(physicalTexture.texture);
+}
+
+void FrameGraph::reset()
+{
+    m_passCount = 0;
+    m_executionOrder.clear();
+
+    for (auto& resource : m_resources)
+        resource.transient = false;
+}
+
+FrameGraphBuilder FrameGraph::addPass(const std::string& name)
+{
+    if (m_passCount == m_passes.size())
+        m_passes.emplace_back();
+
+    // The node of the last frame is reused - its lists keep their capacity
+    auto& pass = m_passes[m_passCount];
+    pass.name = name;
+    pass.reads.clear();
+    pass.writes.clear();
+    pass.producers.clear();
+    pass.successors.clear();
+    pass.sideEffect = false;
+    pass.culled = false;
+    pass.barriers = 0;
+
+    return FrameGraphBuilder(this, m_passCount++);
+}
+
+void FrameGraph::compile()
+{
+    addDependencies();
+    cull();
+    sortTopologically();
+    placeBarriers();
+    aliasTransientTextures();
+}
+
+void FrameGraph::execute(const std::function<void(std::size_t)>& executePass)
+{
+    for (auto passIdx : m_executionOrder)
+    {
+        if (m_passes[passIdx].barriers != 0)
+            m_backend->memoryBarrier(m_passes[passIdx].barriers);
+
+        executePass(passIdx);
+    }
+
+    uint32_t importBarriers = 0;
+    for (auto& resource : m_resources)
+    {
+        if (resource.imported)
+        {
+            importBarriers |= resource.pendingBarriers;
+            resource.pendingBarriers = 0;
+        }
+    }
+
+    if (importBarriers != 0)
+        m_backend->memoryBarrier(importBarriers);
+}
+
+std::size_t FrameGraph::getCulledPassCount() const
+{
+    return std::size_t(std::count_if(m_passes.begin(), m_passes.begin() + m_passCount, [](const PassNode& pass) { return pass.culled; }));
+}
+
+std::size_t FrameGraph::getBarrierCount() const
+{
+    std::size_t barrierCount = 0;
+    for (auto passIdx : m_executionOrder)
+        if (m_passes[passIdx].barriers != 0)
+            ++barrierCount;
+
+    return barrierCount;
+}
+
+uint32_t FrameGraph::getTexture(std::size_t resource) const
+{
+    assert(resource < m_resources.size() && m_resources[resource].transient);
+
+    if (m_physicalTextures.empty())
+        return 0;
+
+    return m_physicalTextures[m_resources[resource].physicalTexture].texture;
+}
+
+FrameGraph::ResourceNode& FrameGraph::getResource(std::size_t resource)
+{
+    assert(resource != RPKey<int>::INVALID_SLOT);
+
+    // The nodes of all keys are kept - the slots are dense
+    if (resource >= m_resources.size())
+        m_resources.resize(resource + 1);
+
+    return m_resources[resource];
+}
+
+void FrameGraph::addDependencies()
+{
+    m_firstWriters.assign(m_resources.size(), NO_PASS);
+    m_lastWriters.assign(m_resources.size(), NO_PASS);
+
+    // The inner lists are cleared instead of reallocated
+    if (m_readersSinceWrite.size() < m_resources.size())
+        m_readersSinceWrite.resize(m_resources.size());
+
+    for (auto& readers : m_readersSinceWrite)
+        readers.clear();
+
+    for (std::size_t i = m_passCount; i-- > 0;)
+        for (auto& write : m_passes[i].writes)
+            m_firstWriters[write.resource] = i;
+
+    for (std::size_t i = 0; i < m_passCount; ++i)
+    {
+        auto& pass = m_passes[i];
+
+        for (auto& read : pass.reads)
+        {
+            std::size_t producer = m_lastWriters[read.resource];
+
+            // Without a previous writer a transient resource is read after its first writer
+            if (producer == NO_PASS && !m_resources[read.resource].imported)
+                producer = m_firstWriters[read.resource];
+            else
+                m_readersSinceWrite[read.resource].push_back(i);
+
+            if (producer != NO_PASS && producer != i)
+            {
+                m_passes[producer].successors.push_back(i);
+                pass.producers.push_back(producer);
+            }
+        }
+
+        for (auto& write : pass.writes)
+        {
+            std::size_t lastWriter = m_lastWriters[write.resource];
+
+            // Writes keep their order and happen after the reads of the previous content
+            if (lastWriter != NO_PASS && lastWriter != i)
+                m_passes[lastWriter].successors.push_back(i);
+
+            for (auto reader : m_readersSinceWrite[write.resource])
+                if (reader != i)
+                    m_passes[reader].successors.push_back(i);
+
+            m_readersSinceWrite[write.resource].clear();
+            m_lastWriters[write.resource] = i;
+        }
+    }
+}
+
+void FrameGraph::cull()
+{
+    // Passes with side effects or writes to imported resources are the roots - everything they read from is kept
+    m_passStack.clear();
+    for (std::size_t i = 0; i < m_passCount; ++i)
+    {
+        auto& pass = m_passes[i];
+        pass.culled = true;
+
+        bool writesImport = std::any_of(pass.writes.begin(), pass.writes.end(),
+            [this](const ResourceAccess& write) { return m_resources[write.resource].imported; });
+
+        if (pass.sideEffect || writesImport)
+        {
+            pass.culled = false;
+            m_passStack.push_back(i);
+        }
+    }
+
+    while (!m_passStack.empty())
+    {
+        std::size_t passIdx = m_passStack.back();
+        m_passStack.pop_back();
+
+        for (auto producer : m_passes[passIdx].producers)
+        {
+            if (m_passes[producer].culled)
+            {
+                m_passes[producer].culled = false;
+                m_passStack.push_back(producer);
+            }
+        }
+    }
+}
+
+void FrameGraph::sortTopologically()
+{
+    m_inDegrees.assign(m_passCount, 0);
+    m_scheduled.assign(m_passCount, false);
+    std::size_t remainingCount = 0;
+
+    for (std::size_t i = 0; i < m_passCount; ++i)
+    {
+        if (m_passes[i].culled)
+            continue;
+
+        ++remainingCount;
+        for (auto successor : m_passes[i].successors)
+            ++m_inDegrees[successor];
+    }
+
+    while (remainingCount > 0)
+    {
+        // The first ready pass in the order of addPass keeps independent passes in their order
+        std::size_t next = NO_PASS;
+        for (std::size_t i = 0; i < m_passCount && next == NO_PASS; ++i)
+            if (!m_passes[i].culled && !m_scheduled[i] && m_inDegrees[i] == 0)
+                next = i;
+
+        if (next == NO_PASS)
+        {
+            LOG_ERROR("FrameGraph - Error: The passes have cyclic dependencies. The remaining passes are executed in the order they were added.");
+            for (std::size_t i = 0; i < m_passCount; ++i)
+                if (!m_passes[i].culled && !m_scheduled[i])
+                    m_executionOrder.push_back(i);
+
+            return;
+        }
+
+        m_scheduled[next] = true;
+        --remainingCount;
+        m_executionOrder.push_back(next);
+
+        for (auto successor : m_passes[next].successors)
+            --m_inDegrees[successor];
+    }
+}
+
+void FrameGraph::placeBarriers()
+{
+    const uint32_t allBarriers = TEXTURE_FETCH_BARRIER | SHADER_IMAGE_ACCESS_BARRIER | FRAMEBUFFER_BARRIER;
+
+    // The barriers each resource still needs for the kinds of accesses since its last incoherent write
+    m_pendingBarriers.assign(m_resources.size(), 0);
+    for (std::size_t i = 0; i < m_resources.size(); ++i)
+        if (m_resources[i].imported)
+            m_pendingBarriers[i] = m_resources[i].pendingBarriers;
+
+    for (auto passIdx : m_executionOrder)
+    {
+        auto& pass = m_passes[passIdx];
+        pass.barriers = 0;
+
+        for (auto& read : pass.reads)
+            pass.barriers |= m_pendingBarriers[read.resource] & getBarrierBit(read.access);
+
+        for (auto& write : pass.writes)
+            pass.barriers |= m_pendingBarriers[write.resource] & getBarrierBit(write.access);
+
+        // A barrier covers all previous writes: One barrier per pass at most
+        if (pass.barriers != 0)
+        {
+            for (auto& barriers : m_pendingBarriers)
+                barriers &= ~pass.barriers;
+        }
+
+        for (auto& write : pass.writes)
+            if (write.access == FrameGraphAccess::IMAGE)
+                m_pendingBarriers[write.resource] = allBarriers;
+    }
+
+    for (std::size_t i = 0; i < m_resources.size(); ++i)
+        if (m_resources[i].imported)
+            m_resources[i].pendingBarriers = m_pendingBarriers[i];
+}
+
+void FrameGraph::aliasTransientTextures()
+{
+    m_firstUses.assign(m_resources.size(), NO_PASS);
+    m_lastUses.assign(m_resources.size(), 0);
+
+    for (std::size_t pos = 0; pos < m_executionOrder.size(); ++pos)
+    {
+        auto& pass = m_passes[m_executionOrder[pos]];
+        auto use = [&](const ResourceAccess& access)
+        {
+            m_firstUses[access.resource] = std::min(m_firstUses[access.resource], pos);
+            m_lastUses[access.resource] = pos;
+        };
+
+        std::for_each(pass.reads.begin(), pass.reads.end(), use);
+        std::for_each(pass.writes.begin(), pass.writes.end(), use);
+    }
+
+    for (auto& physicalTexture : m_physicalTextures)
+        physicalTexture.used = false;
+
+    // Resources are assigned in the order of their first use: A texture is reused once its last resource is dead
+    for (std::size_t pos = 0; pos < m_executionOrder.size(); ++pos)
+    {
+        for (std::size_t i = 0; i < m_resources.size(); ++i)
+        {
+            auto& resource = m_resources[i];
+            if (!resource.transient || m_firstUses[i] != pos)
+                continue;
+
+            auto it = std::find_if(m_physicalTextures.begin(), m_physicalTextures.end(), [&](const PhysicalTexture& physicalTexture)
+            {
+                return physicalTexture.desc == resource.desc && (!physicalTexture.used || physicalTexture.lastUse < pos);
+            });
+
+            if (it == m_physicalTextures.end())
+            {
+                PhysicalTexture physicalTexture;
+                physicalTexture.desc = resource.desc;
+                physicalTexture.texture = m_backend->createTexture(resource.desc);
+                it = m_physicalTextures.insert(m_physicalTextures.end(), physicalTexture);
+            }
+
+            it->used = true;
+            it->lastUse = m_lastUses[i];
+            resource.physicalTexture = std::size_t(it - m_physicalTextures.begin());
+        }
+    }
+
+    // Textures that are no longer needed by the graph are released
+    m_remappedIndices.resize(m_physicalTextures.size());
+    std::size_t usedCount = 0;
+    for (std::size_t i = 0; i < m_physicalTextures.size(); ++i)
+    {
+        if (m_physicalTextures[i].used)
+        {
+            m_remappedIndices[i] = usedCount;
+            m_physicalTextures[usedCount++] = m_physicalTextures[i];
+        }
+        else
+        {
+            m_backend->destroyTexture(m_physicalTextures[i].texture);
+        }
+    }
+
+    m_physicalTextures.resize(usedCount);
+
+    for (std::size_t i = 0; i < m_resources.size(); ++i)
+        if (m_resources[i].transient && m_firstUses[i] != NO_PASS)
+            m_resources[i].physicalTexture = m_remappedIndices[m_resources[i].physicalTexture];
+}
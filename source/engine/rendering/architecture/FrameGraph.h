@@ -0,0 +1,242 @@
+#pragma once
+#include "RPKey.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+
+class FrameGraph;
+
+/**
+* How a pass accesses a resource. Determines the barriers that are placed between the passes.
+*/
+enum class FrameGraphAccess
+{
+    CPU,            // Data like entity lists that is never touched by the GPU
+    TEXTURE,        // Sampled in shaders
+    IMAGE,          // Image load/store or atomics - the writes have to be made visible with a barrier
+    RENDER_TARGET   // Framebuffer attachment
+};
+
+struct FrameGraphTextureDesc
+{
+    uint32_t width{0};
+    uint32_t height{0};
+    uint32_t format{0}; // Internal format of the backend, e.g. GL_RGBA8
+
+    bool operator==(const FrameGraphTextureDesc& desc) const { return width == desc.width && height == desc.height && format == desc.format; }
+};
+
+/**
+* The GPU side of the frame graph. Allows to test the graph compilation without a GL context.
+*/
+class FrameGraphBackend
+{
+public:
+    virtual ~FrameGraphBackend() { }
+
+    /**
+    * Makes the incoherent writes visible to the given kinds of accesses (FrameGraph::*_BARRIER bits).
+    */
+    virtual void memoryBarrier(uint32_t barriers) = 0;
+
+    virtual uint32_t createTexture(const FrameGraphTextureDesc& desc) = 0;
+
+    virtual void destroyTexture(uint32_t texture) = 0;
+};
+
+/**
+* Declares the resources of a single pass. Resources are identified by the keys of the render pipeline data.
+*/
+class FrameGraphBuilder
+{
+    friend class FrameGraph;
+public:
+    template <class T>
+    void read(const RPKey<T>& key, FrameGraphAccess access) { addRead(key.getSlot(), access); }
+
+    template <class T>
+    void write(const RPKey<T>& key, FrameGraphAccess access) { addWrite(key.getSlot(), access); }
+
+    /**
+    * Declares a transient texture that lives only during this frame. The pass still has to declare its write.
+    * Transient textures with the same description and disjoint lifetimes share the same backend texture.
+    */
+    template <class T>
+    void createTexture(const RPKey<T>& key, const FrameGraphTextureDesc& desc) { addTexture(key.getSlot(), desc); }
+
+    /**
+    * The pass has effects outside of the declared resources and is never culled.
+    */
+    void setSideEffect();
+
+private:
+    FrameGraphBuilder(FrameGraph* frameGraph, std::size_t passIdx)
+        : m_frameGraph(frameGraph), m_passIdx(passIdx) { }
+
+    void addRead(std::size_t resource, FrameGraphAccess access);
+
+    void addWrite(std::size_t resource, FrameGraphAccess access);
+
+    void addTexture(std::size_t resource, const FrameGraphTextureDesc& desc);
+
+private:
+    FrameGraph* m_frameGraph;
+    std::size_t m_passIdx;
+};
+
+/**
+* Orders the passes by the resources they declare, culls passes whose outputs are never read, places the
+* barriers between incoherent writes and the following accesses and aliases transient textures.
+*
+* A read depends on the last pass that writes the resource before the reading pass was added. If there is no such
+* pass the read depends on the first writer - unless the resource is imported and thus still holds the content of the
+* last frame. Passes that are independent of each other keep the order in which they were added.
+*
+* The graph is rebuilt every frame: reset(), addPass() for each pass, compile() and execute(). The nodes and the scratch
+* arrays of the compilation keep their capacity across frames - once the graph has reached its size no heap allocations happen.
+*/
+class FrameGraph
+{
+    friend class FrameGraphBuilder;
+
+    struct ResourceAccess
+    {
+        ResourceAccess(std::size_t resource, FrameGraphAccess access)
+            : resource(resource), access(access) { }
+
+        std::size_t resource;
+        FrameGraphAccess access;
+    };
+
+    struct PassNode
+    {
+        std::string name;
+        std::vector<ResourceAccess> reads;
+        std::vector<ResourceAccess> writes;
+        std::vector<std::size_t> producers; // Passes whose writes are read by this pass
+        std::vector<std::size_t> successors;
+        bool sideEffect{false};
+        bool culled{false};
+        uint32_t barriers{0};
+    };
+
+    // Indexed by the slot of the key
+    struct ResourceNode
+    {
+        bool imported{false};
+        bool transient{false};
+        FrameGraphTextureDesc desc;
+        std::size_t physicalTexture{0}; // Index into m_physicalTextures
+
+        // Barriers that are still missing for the last incoherent write of an imported resource of the last frame
+        uint32_t pendingBarriers{0};
+    };
+
+    struct PhysicalTexture
+    {
+        FrameGraphTextureDesc desc;
+        uint32_t texture{0};
+        std::size_t lastUse{0}; // Position in the execution order
+        bool used{false};
+    };
+
+public:
+    static const uint32_t TEXTURE_FETCH_BARRIER = 1 << 0;
+    static const uint32_t SHADER_IMAGE_ACCESS_BARRIER = 1 << 1;
+    static const uint32_t FRAMEBUFFER_BARRIER = 1 << 2;
+
+    explicit FrameGraph(FrameGraphBackend* backend);
+    ~FrameGraph();
+
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    /**
+    * Imported resources live outside of the graph and keep their content across frames.
+    * Passes that write them are never culled.
+    */
+    template <class T>
+    void importResource(const RPKey<T>& key) { getResource(key.getSlot()).imported = true; }
+
+    /**
+    * Removes the passes and transient resources of the last frame. Imports, backend textures and the capacity of the
+    * nodes are kept.
+    */
+    void reset();
+
+    FrameGraphBuilder addPass(const std::string& name);
+
+    void compile();
+
+    /**
+    * Calls executePass with the index (in the order of addPass) of every pass that survived the culling in the
+    * compiled order. The barriers of the pass are issued before. Afterwards the last incoherent writes to imported
+    * resources are made visible since they are also accessed outside of the graph (e.g. the voxel visualization).
+    */
+    void execute(const std::function<void(std::size_t)>& executePass);
+
+    const std::vector<std::size_t>& getExecutionOrder() const { return m_executionOrder; }
+
+    bool isCulled(std::size_t passIdx) const { assert(passIdx < m_passCount); return m_passes[passIdx].culled; }
+
+    /**
+    * The barriers that are issued before the pass.
+    */
+    uint32_t getBarriers(std::size_t passIdx) const { assert(passIdx < m_passCount); return m_passes[passIdx].barriers; }
+
+    std::size_t getCulledPassCount() const;
+
+    /**
+    * The number of passes with barriers. The barrier after the last pass isn't counted.
+    */
+    std::size_t getBarrierCount() const;
+
+    /**
+    * The backend texture of a transient resource. Only valid after compile().
+    */
+    template <class T>
+    uint32_t getTexture(const RPKey<T>& key) const { return getTexture(key.getSlot()); }
+
+    std::size_t getPhysicalTextureCount() const { return m_physicalTextures.size(); }
+
+private:
+    ResourceNode& getResource(std::size_t resource);
+
+    uint32_t getTexture(std::size_t resource) const;
+
+    void addDependencies();
+
+    void cull();
+
+    void sortTopologically();
+
+    void placeBarriers();
+
+    void aliasTransientTextures();
+
+private:
+    FrameGraphBackend* m_backend;
+
+    // The first m_passCount nodes are the passes of this frame - the others are kept for their capacity
+    std::vector<PassNode> m_passes;
+    std::size_t m_passCount{0};
+    std::vector<ResourceNode> m_resources;
+
+    std::vector<std::size_t> m_executionOrder;
+    std::vector<PhysicalTexture> m_physicalTextures;
+
+    // Scratch arrays of compile()
+    std::vector<std::size_t> m_firstWriters;
+    std::vector<std::size_t> m_lastWriters;
+    std::vector<std::vector<std::size_t>> m_readersSinceWrite;
+    std::vector<std::size_t> m_passStack;
+    std::vector<std::size_t> m_inDegrees;
+    std::vector<bool> m_scheduled;
+    std::vector<uint32_t> m_pendingBarriers;
+    std::vector<std::size_t> m_firstUses;
+    std::vector<std::size_t> m_lastUses;
+    std::vector<std::size_t> m_remappedIndices;
+};
@@ -0,0 +1,297 @@
+#include "FrameGraphTest.h"
+#include "FrameGraph.h"
+#include <engine/memory/HeapAllocationCounter.h>
+#include <algorithm>
+#include <vector>
+#include <cassert>
+
+namespace frame_graph_test
+{
+    /**
+    * Records the barriers and textures instead of issuing GL calls.
+    */
+    class MockFrameGraphBackend : public FrameGraphBackend
+    {
+    public:
+        void memoryBarrier(uint32_t barriers) override { issuedBarriers.push_back(barriers); }
+
+        uint32_t createTexture(const FrameGraphTextureDesc&) override
+        {
+            ++createdTextureCount;
+            return uint32_t(createdTextureCount);
+        }
+
+        void destroyTexture(uint32_t) override { ++destroyedTextureCount; }
+
+        std::vector<uint32_t> issuedBarriers;
+        std::size_t createdTextureCount{0};
+        std::size_t destroyedTextureCount{0};
+    };
+
+    // Test keys - the type only matters for the blackboard
+    const RPKey<int> BACKBUFFER("FrameGraphTest Backbuffer");
+    const RPKey<int> SHADOWS("FrameGraphTest Shadows");
+    const RPKey<int> CAMERA_VISIBLE_ENTITIES("FrameGraphTest CameraVisibleEntities");
+    const RPKey<int> SHADOW_VISIBLE_ENTITIES("FrameGraphTest ShadowVisibleEntities");
+    const RPKey<int> NORMAL_MAP("FrameGraphTest NormalMap");
+    const RPKey<int> OPACITY("FrameGraphTest Opacity");
+    const RPKey<int> RADIANCE("FrameGraphTest Radiance");
+    const RPKey<uint32_t> T1("FrameGraphTest T1");
+    const RPKey<uint32_t> T2("FrameGraphTest T2");
+    const RPKey<uint32_t> T3("FrameGraphTest T3");
+
+    std::size_t getPosition(const FrameGraph& frameGraph, std::size_t passIdx)
+    {
+        auto& order = frameGraph.getExecutionOrder();
+        return std::size_t(std::find(order.begin(), order.end(), passIdx) - order.begin());
+    }
+
+#ifdef RUN_FRAME_GRAPH_TESTS
+    struct FrameGraphTestRunner
+    {
+        FrameGraphTestRunner()
+        {
+            FrameGraphTest::runTests();
+        }
+    };
+
+    FrameGraphTestRunner frameGraphTestRunner;
+#endif
+}
+
+using namespace frame_graph_test;
+
+void FrameGraphTest::runTests()
+{
+    testOrdering();
+    testCulling();
+    testBarrierPlacement();
+    testTransientAliasing();
+    testNoSteadyStateAllocations();
+}
+
+void FrameGraphTest::testOrdering()
+{
+    MockFrameGraphBackend backend;
+    FrameGraph frameGraph(&backend);
+    frameGraph.importResource(BACKBUFFER);
+
+    // The consumer is added before its producer
+    auto consumer = frameGraph.addPass("Consumer");
+    consumer.read(SHADOWS, FrameGraphAccess::TEXTURE);
+    consumer.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+    auto producer = frameGraph.addPass("Producer");
+    producer.write(SHADOWS, FrameGraphAccess::RENDER_TARGET);
+
+    frameGraph.compile();
+
+    assert(frameGraph.getExecutionOrder().size() == 2);
+    assert(frameGraph.getExecutionOrder()[0] == 1);
+    assert(frameGraph.getExecutionOrder()[1] == 0);
+}
+
+void FrameGraphTest::testCulling()
+{
+    MockFrameGraphBackend backend;
+    FrameGraph frameGraph(&backend);
+    frameGraph.importResource(BACKBUFFER);
+
+    // The forward pipeline: Nothing reads the G-buffer
+    auto culling = frameGraph.addPass("CullingPass");
+    culling.write(CAMERA_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+    culling.write(SHADOW_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+
+    auto sceneGeometry = frameGraph.addPass("SceneGeometryPass");
+    sceneGeometry.read(CAMERA_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+    sceneGeometry.write(NORMAL_MAP, FrameGraphAccess::RENDER_TARGET);
+
+    auto shadowMap = frameGraph.addPass("ShadowMapPass");
+    shadowMap.read(SHADOW_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+    shadowMap.write(SHADOWS, FrameGraphAccess::RENDER_TARGET);
+
+    auto forward = frameGraph.addPass("ForwardScenePass");
+    forward.read(SHADOWS, FrameGraphAccess::TEXTURE);
+    forward.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+    auto gui = frameGraph.addPass("GUIPass");
+    gui.setSideEffect();
+
+    frameGraph.compile();
+
+    assert(frameGraph.getCulledPassCount() == 1);
+    assert(frameGraph.isCulled(1));
+    assert(!frameGraph.isCulled(0) && !frameGraph.isCulled(2) && !frameGraph.isCulled(3) && !frameGraph.isCulled(4));
+    assert(frameGraph.getExecutionOrder().size() == 4);
+}
+
+void FrameGraphTest::testBarrierPlacement()
+{
+    MockFrameGraphBackend backend;
+    FrameGraph frameGraph(&backend);
+    frameGraph.importResource(OPACITY);
+    frameGraph.importResource(RADIANCE);
+    frameGraph.importResource(BACKBUFFER);
+
+    auto voxelization = frameGraph.addPass("Voxelization");
+    voxelization.write(OPACITY, FrameGraphAccess::IMAGE);
+
+    auto injection = frameGraph.addPass("Injection");
+    injection.write(RADIANCE, FrameGraphAccess::IMAGE);
+
+    // Both image writes are made visible with a single barrier
+    auto gi = frameGraph.addPass("GI");
+    gi.read(OPACITY, FrameGraphAccess::TEXTURE);
+    gi.read(RADIANCE, FrameGraphAccess::TEXTURE);
+    gi.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+    // The writes are already visible to texture fetches
+    auto debug = frameGraph.addPass("Debug");
+    debug.read(RADIANCE, FrameGraphAccess::TEXTURE);
+    debug.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+    // Image accesses still need their own barrier
+    auto border = frameGraph.addPass("Border");
+    border.read(RADIANCE, FrameGraphAccess::IMAGE);
+    border.write(RADIANCE, FrameGraphAccess::IMAGE);
+
+    frameGraph.compile();
+
+    assert(frameGraph.getBarriers(0) == 0);
+    assert(frameGraph.getBarriers(1) == 0);
+    assert(frameGraph.getBarriers(2) == FrameGraph::TEXTURE_FETCH_BARRIER);
+    assert(frameGraph.getBarriers(3) == 0);
+    assert(frameGraph.getBarriers(4) == FrameGraph::SHADER_IMAGE_ACCESS_BARRIER);
+    assert(frameGraph.getBarrierCount() == 2);
+
+    // The last image write to the imported radiance is made visible after the last pass
+    frameGraph.execute([](std::size_t) { });
+    assert(backend.issuedBarriers.size() == 3);
+    assert(backend.issuedBarriers.back() == (FrameGraph::TEXTURE_FETCH_BARRIER | FrameGraph::SHADER_IMAGE_ACCESS_BARRIER | FrameGraph::FRAMEBUFFER_BARRIER));
+
+    auto buildNextFrame = [&]()
+    {
+        frameGraph.reset();
+        auto nextGI = frameGraph.addPass("GI");
+        nextGI.read(RADIANCE, FrameGraphAccess::TEXTURE);
+        nextGI.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+        auto nextBorder = frameGraph.addPass("Border");
+        nextBorder.read(RADIANCE, FrameGraphAccess::IMAGE);
+        nextBorder.write(RADIANCE, FrameGraphAccess::IMAGE);
+
+        frameGraph.compile();
+    };
+
+    buildNextFrame();
+    assert(frameGraph.getBarriers(0) == 0);
+
+    // Without execute() the last write of the previous frame is made visible in the next frame
+    buildNextFrame();
+    assert(frameGraph.getBarriers(0) == FrameGraph::TEXTURE_FETCH_BARRIER);
+}
+
+void FrameGraphTest::testTransientAliasing()
+{
+    MockFrameGraphBackend backend;
+    FrameGraph frameGraph(&backend);
+    frameGraph.importResource(BACKBUFFER);
+
+    FrameGraphTextureDesc desc;
+    desc.width = 256;
+    desc.height = 256;
+    desc.format = 1;
+
+    auto buildGraph = [&]()
+    {
+        frameGraph.reset();
+
+        auto pass0 = frameGraph.addPass("Pass0");
+        pass0.createTexture(T1, desc);
+        pass0.write(T1, FrameGraphAccess::RENDER_TARGET);
+
+        auto pass1 = frameGraph.addPass("Pass1");
+        pass1.createTexture(T2, desc);
+        pass1.read(T1, FrameGraphAccess::TEXTURE);
+        pass1.write(T2, FrameGraphAccess::RENDER_TARGET);
+
+        // T1 is dead - T3 can reuse its texture
+        auto pass2 = frameGraph.addPass("Pass2");
+        pass2.createTexture(T3, desc);
+        pass2.read(T2, FrameGraphAccess::TEXTURE);
+        pass2.write(T3, FrameGraphAccess::RENDER_TARGET);
+
+        auto pass3 = frameGraph.addPass("Pass3");
+        pass3.read(T3, FrameGraphAccess::TEXTURE);
+        pass3.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+        frameGraph.compile();
+    };
+
+    buildGraph();
+
+    assert(frameGraph.getPhysicalTextureCount() == 2);
+    assert(frameGraph.getTexture(T1) == frameGraph.getTexture(T3));
+    assert(frameGraph.getTexture(T1) != frameGraph.getTexture(T2));
+    assert(backend.createdTextureCount == 2);
+
+    // The textures are kept across frames
+    buildGraph();
+
+    assert(frameGraph.getPhysicalTextureCount() == 2);
+    assert(backend.createdTextureCount == 2);
+    assert(backend.destroyedTextureCount == 0);
+}
+
+void FrameGraphTest::testNoSteadyStateAllocations()
+{
+    MockFrameGraphBackend backend;
+    FrameGraph frameGraph(&backend);
+    frameGraph.importResource(OPACITY);
+    frameGraph.importResource(BACKBUFFER);
+
+    FrameGraphTextureDesc desc;
+    desc.width = 256;
+    desc.height = 256;
+    desc.format = 1;
+
+    // Pass names are short enough to not allocate a temporary string
+    std::size_t executedPassCount = 0;
+    auto buildFrame = [&]()
+    {
+        frameGraph.reset();
+
+        auto culling = frameGraph.addPass("Culling");
+        culling.write(CAMERA_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+
+        auto sceneGeometry = frameGraph.addPass("Geometry");
+        sceneGeometry.read(CAMERA_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+        sceneGeometry.createTexture(T1, desc);
+        sceneGeometry.write(T1, FrameGraphAccess::RENDER_TARGET);
+
+        auto voxelization = frameGraph.addPass("Voxelization");
+        voxelization.write(OPACITY, FrameGraphAccess::IMAGE);
+
+        auto gi = frameGraph.addPass("GI");
+        gi.read(OPACITY, FrameGraphAccess::TEXTURE);
+        gi.read(T1, FrameGraphAccess::TEXTURE);
+        gi.write(BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+
+        frameGraph.compile();
+        frameGraph.execute([&](std::size_t) { ++executedPassCount; });
+    };
+
+    // The first frame sizes the nodes and the scratch arrays
+    buildFrame();
+    backend.issuedBarriers.reserve(64);
+
+    std::size_t allocationCount = HeapAllocationCounter::getAllocationCount();
+    for (int i = 0; i < 10; ++i)
+        buildFrame();
+
+    if (HeapAllocationCounter::isEnabled())
+        assert(HeapAllocationCounter::getAllocationCount() == allocationCount);
+
+    assert(executedPassCount == 11 * 4);
+    assert(backend.createdTextureCount == 1);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_FRAME_GRAPH_TESTS
+#endif
+
+class FrameGraphTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testOrdering();
+    static void testCulling();
+    static void testBarrierPlacement();
+    static void testTransientAliasing();
+    static void testNoSteadyStateAllocations();
+};
@@ -0,0 +1,39 @@
+#include "GLFrameGraphBackend.h"
+#include <GL/glew.h>
+
+void GLFrameGraphBackend::memoryBarrier(uint32_t barriers)
+{
+    GLbitfield glBarriers = 0;
+
+    if (barriers & FrameGraph::TEXTURE_FETCH_BARRIER)
+        glBarriers |= GL_TEXTURE_FETCH_BARRIER_BIT;
+
+    if (barriers & FrameGraph::SHADER_IMAGE_ACCESS_BARRIER)
+        glBarriers |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+
+    if (barriers & FrameGraph::FRAMEBUFFER_BARRIER)
+        glBarriers |= GL_FRAMEBUFFER_BARRIER_BIT;
+
+    glMemoryBarrier(glBarriers);
+}
+
+uint32_t GLFrameGraphBackend::createTexture(const FrameGraphTextureDesc& desc)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GLenum(desc.format), GLsizei(desc.width), GLsizei(desc.height));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+void GLFrameGraphBackend::destroyTexture(uint32_t texture)
+{
+    GLuint glTexture = texture;
+    glDeleteTextures(1, &glTexture);
+}
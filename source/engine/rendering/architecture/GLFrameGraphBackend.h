@@ -0,0 +1,15 @@
+#pragma once
+#include "FrameGraph.h"
+
+/**
+* Issues the barriers of the frame graph with glMemoryBarrier and allocates the transient textures as 2D textures.
+*/
+class GLFrameGraphBackend : public FrameGraphBackend
+{
+public:
+    void memoryBarrier(uint32_t barriers) override;
+
+    uint32_t createTexture(const FrameGraphTextureDesc& desc) override;
+
+    void destroyTexture(uint32_t texture) override;
+};
@@ -0,0 +1,19 @@
+#include "RPBlackboard.h"
+#include <algorithm>
+
+RPBlackboard::RPBlackboard(std::size_t arenaCapacity)
+    : m_arena(arenaCapacity) { }
+
+void RPBlackboard::beginFrame()
+{
+    m_arena.reset();
+    ++m_frame;
+}
+
+void RPBlackboard::growSlots(std::size_t slot)
+{
+    assert(slot != RPKey<int>::INVALID_SLOT);
+
+    // Keys can be created at any time - the slots grow with the first use of a new key
+    m_slots.resize(std::max(slot + 1, RPKeyRegistry::getSlotCount()));
+}
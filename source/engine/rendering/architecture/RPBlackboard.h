@@ -0,0 +1,107 @@
+#pragma once
+#include "RPKey.h"
+#include <engine/memory/LinearAllocator.h>
+#include <engine/util/Logger.h>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+/**
+* Storage of the data that is exchanged between the render passes. Entries are addressed with typed RPKeys.
+*
+* put() copies the value into a linear arena that is reset with beginFrame() - the value is only valid during the frame.
+* putPtr() stores a pointer to data that lives outside of the blackboard and stays valid across frames.
+* Once all keys were used and the arena has grown to its working size the blackboard itself makes no heap allocations.
+* This doesn't hold for a whole frame of the RenderPipeline - the passes and the frame graph allocate on their own.
+*/
+class RPBlackboard
+{
+    struct Slot
+    {
+        void* data{nullptr};
+        uint64_t frame{0}; // Frame of put() - values in the arena are only valid in that frame
+        bool persistent{false};
+    };
+
+public:
+    explicit RPBlackboard(std::size_t arenaCapacity = 1024);
+
+    template <class T>
+    void put(const RPKey<T>& key, const T& value);
+
+    template <class T>
+    void putPtr(const RPKey<T>& key, T* data);
+
+    template <class T>
+    const T& fetch(const RPKey<T>& key) const;
+
+    template <class T>
+    T* fetchPtr(const RPKey<T>& key) const;
+
+    template <class T>
+    bool contains(const RPKey<T>& key) const { return contains(key.getSlot()); }
+
+    /**
+    * Invalidates the values of put() of the last frame.
+    */
+    void beginFrame();
+
+    const LinearAllocator& getArena() const { return m_arena; }
+
+private:
+    Slot& getSlot(std::size_t slot)
+    {
+        if (slot >= m_slots.size())
+            growSlots(slot);
+
+        return m_slots[slot];
+    }
+
+    bool contains(std::size_t slot) const
+    {
+        return slot < m_slots.size() && m_slots[slot].data && (m_slots[slot].persistent || m_slots[slot].frame == m_frame);
+    }
+
+    void growSlots(std::size_t slot);
+
+private:
+    std::vector<Slot> m_slots;
+    LinearAllocator m_arena;
+    uint64_t m_frame{1};
+};
+
+template <class T>
+void RPBlackboard::put(const RPKey<T>& key, const T& value)
+{
+    Slot& slot = getSlot(key.getSlot());
+    slot.data = m_arena.create<T>(value);
+    slot.frame = m_frame;
+    slot.persistent = false;
+}
+
+template <class T>
+void RPBlackboard::putPtr(const RPKey<T>& key, T* data)
+{
+    Slot& slot = getSlot(key.getSlot());
+    slot.data = data;
+    slot.persistent = true;
+}
+
+template <class T>
+const T& RPBlackboard::fetch(const RPKey<T>& key) const
+{
+    return *fetchPtr(key);
+}
+
+template <class T>
+T* RPBlackboard::fetchPtr(const RPKey<T>& key) const
+{
+    if (!contains(key.getSlot()))
+    {
+        LOG_ERROR("RPBlackboard - Error: Expected " << key.getName() << " but not found.");
+        assert(false);
+        return nullptr;
+    }
+
+    return static_cast<T*>(m_slots[key.getSlot()].data);
+}
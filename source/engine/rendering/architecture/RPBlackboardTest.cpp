@@ -0,0 +1,101 @@
+#include "RPBlackboardTest.h"
+#include "RPBlackboard.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cassert>
+
+namespace rp_blackboard_test
+{
+#ifdef RUN_RP_BLACKBOARD_TESTS
+    struct RPBlackboardTestRunner
+    {
+        RPBlackboardTestRunner()
+        {
+            RPBlackboardTest::runTests();
+        }
+    };
+
+    RPBlackboardTestRunner rpBlackboardTestRunner;
+#endif
+}
+
+using namespace rp_blackboard_test;
+
+void RPBlackboardTest::runTests()
+{
+    testPutFetch();
+    testFrameLifetime();
+    testNoSteadyStateAllocations();
+}
+
+void RPBlackboardTest::testPutFetch()
+{
+    RPKey<uint32_t> dirtyLevels("Test DirtyLevels");
+    RPKey<glm::mat4> viewProj("Test ViewProj");
+
+    // Keys of the same name share the slot
+    assert(RPKey<uint32_t>("Test DirtyLevels").getSlot() == dirtyLevels.getSlot());
+    assert(dirtyLevels.getSlot() != viewProj.getSlot());
+    assert(dirtyLevels.getName() == "Test DirtyLevels");
+
+    RPBlackboard blackboard;
+    assert(!blackboard.contains(dirtyLevels));
+
+    blackboard.put(dirtyLevels, uint32_t(0x15));
+    blackboard.put(viewProj, glm::mat4(2.0f));
+    blackboard.put(dirtyLevels, uint32_t(0x3));
+
+    assert(blackboard.fetch(dirtyLevels) == 0x3);
+    assert(blackboard.fetch(viewProj) == glm::mat4(2.0f));
+    assert(reinterpret_cast<std::uintptr_t>(blackboard.fetchPtr(viewProj)) % alignof(glm::mat4) == 0);
+}
+
+void RPBlackboardTest::testFrameLifetime()
+{
+    RPKey<uint32_t> depthTexture("Test DepthTexture");
+    RPKey<std::vector<int>> clipRegions("Test ClipRegions");
+
+    std::vector<int> regions = {1, 2, 3};
+    RPBlackboard blackboard;
+    blackboard.put(depthTexture, uint32_t(7));
+    blackboard.putPtr(clipRegions, &regions);
+
+    blackboard.beginFrame();
+
+    // Copies only live for a frame - pointers stay valid
+    assert(!blackboard.contains(depthTexture));
+    assert(blackboard.contains(clipRegions));
+    assert(blackboard.fetchPtr(clipRegions) == &regions);
+
+    blackboard.put(depthTexture, uint32_t(8));
+    assert(blackboard.fetch(depthTexture) == 8);
+}
+
+void RPBlackboardTest::testNoSteadyStateAllocations()
+{
+    std::vector<RPKey<glm::vec4>> keys;
+    for (int i = 0; i < 8; ++i)
+        keys.emplace_back("Test Key " + std::to_string(i));
+
+    // The frames need more memory than the initial arena
+    RPBlackboard blackboard(16);
+    auto runFrame = [&]()
+    {
+        blackboard.beginFrame();
+        for (std::size_t i = 0; i < keys.size(); ++i)
+            blackboard.put(keys[i], glm::vec4(float(i)));
+
+        for (std::size_t i = 0; i < keys.size(); ++i)
+            assert(blackboard.fetch(keys[i]) == glm::vec4(float(i)));
+    };
+
+    runFrame();
+    runFrame();
+    std::size_t allocationCount = blackboard.getArena().getHeapAllocationCount();
+
+    for (int frame = 0; frame < 10; ++frame)
+        runFrame();
+
+    assert(blackboard.getArena().getHeapAllocationCount() == allocationCount);
+    assert(blackboard.getArena().capacity() >= keys.size() * sizeof(glm::vec4));
+}
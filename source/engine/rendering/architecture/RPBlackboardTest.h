@@ -0,0 +1,16 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_RP_BLACKBOARD_TESTS
+#endif
+
+class RPBlackboardTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testPutFetch();
+    static void testFrameLifetime();
+    static void testNoSteadyStateAllocations();
+};
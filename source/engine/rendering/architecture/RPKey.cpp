@@ -0,0 +1,64 @@
+#include "RPKey.h"
+#include <engine/util/Logger.h>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <cassert>
+
+namespace
+{
+    struct Registry
+    {
+        std::unordered_map<RPMapKey, std::size_t> slots;
+        std::deque<RPMapKey> names; // Stable references for getName()
+        std::vector<const void*> typeIds;
+        std::mutex mutex;
+    };
+
+    // Keys are usually static objects - the registry has to exist before the first of them is constructed
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+}
+
+std::size_t RPKeyRegistry::getSlot(const RPMapKey& name, const void* typeId)
+{
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto it = registry.slots.find(name);
+    if (it != registry.slots.end())
+    {
+        if (registry.typeIds[it->second] != typeId)
+            LOG_ERROR("RPKeyRegistry - Error: The key " << name << " was registered with a different type.");
+
+        assert(registry.typeIds[it->second] == typeId);
+        return it->second;
+    }
+
+    registry.slots[name] = registry.names.size();
+    registry.names.push_back(name);
+    registry.typeIds.push_back(typeId);
+
+    return registry.names.size() - 1;
+}
+
+const RPMapKey& RPKeyRegistry::getName(std::size_t slot)
+{
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    assert(slot < registry.names.size());
+    return registry.names[slot];
+}
+
+std::size_t RPKeyRegistry::getSlotCount()
+{
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    return registry.names.size();
+}
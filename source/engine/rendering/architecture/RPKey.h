@@ -0,0 +1,55 @@
+#pragma once
+#include "RPMapKey.h"
+#include <cstddef>
+#include <limits>
+
+/**
+* Assigns every key name of the render pipeline data a process-wide slot index.
+*/
+class RPKeyRegistry
+{
+public:
+    /**
+    * Returns the slot of the given name and registers it if necessary. A name can only be used with a single type.
+    */
+    static std::size_t getSlot(const RPMapKey& name, const void* typeId);
+
+    static const RPMapKey& getName(std::size_t slot);
+
+    static std::size_t getSlotCount();
+
+    /**
+    * A unique address per type - no RTTI and no hashing.
+    */
+    template <class T>
+    static const void* getTypeId()
+    {
+        static const char typeId = 0;
+        return &typeId;
+    }
+};
+
+/**
+* Typed handle of a render pipeline data entry. The name is resolved once on construction,
+* all accesses through the handle are plain index operations.
+*/
+template <class T>
+class RPKey
+{
+public:
+    static const std::size_t INVALID_SLOT = std::numeric_limits<std::size_t>::max();
+
+    RPKey() { }
+
+    explicit RPKey(const RPMapKey& name)
+        : m_slot(RPKeyRegistry::getSlot(name, RPKeyRegistry::getTypeId<T>())) { }
+
+    std::size_t getSlot() const { return m_slot; }
+
+    const RPMapKey& getName() const { return RPKeyRegistry::getName(m_slot); }
+
+    bool isValid() const { return m_slot != INVALID_SLOT; }
+
+private:
+    std::size_t m_slot{INVALID_SLOT};
+};
@@ -0,0 +1,26 @@
+#include "RPKeys.h"
+
+namespace rp_keys
+{
+    const RPKey<RPGraphResource> BACKBUFFER("Backbuffer");
+
+    const RPKey<Texture3D> VOXEL_OPACITY("VoxelOpacity");
+    const RPKey<Texture3D> VOXEL_RADIANCE("VoxelRadiance");
+    const RPKey<std::vector<BBox>> CLIP_REGION_BBOXES("ClipRegionBBoxes");
+    const RPKey<ClipmapUpdatePolicy> CLIPMAP_UPDATE_POLICY("ClipmapUpdatePolicy");
+
+    const RPKey<std::vector<Entity>> CAMERA_VISIBLE_ENTITIES("CameraVisibleEntities");
+    const RPKey<std::vector<std::vector<Entity>>> SHADOW_VISIBLE_ENTITIES("ShadowVisibleEntities");
+
+    const RPKey<GLuint> DIFFUSE_TEXTURE("DiffuseTexture");
+    const RPKey<GLuint> NORMAL_MAP("NormalMap");
+    const RPKey<GLuint> SPECULAR_MAP("SpecularMap");
+    const RPKey<GLuint> EMISSION_MAP("EmissionMap");
+    const RPKey<GLuint> DEPTH_TEXTURE("DepthTexture");
+
+    const RPKey<RPGraphResource> SHADOW_MAPS("ShadowMaps");
+    const RPKey<std::vector<ReflectiveShadowMap>> REFLECTIVE_SHADOW_MAPS("ReflectiveShadowMaps");
+
+    const RPKey<std::vector<VoxelRegion>> CLIP_REGIONS("ClipRegions");
+    const RPKey<uint32_t> VOXEL_OPACITY_DIRTY_LEVELS("VoxelOpacityDirtyLevels");
+}
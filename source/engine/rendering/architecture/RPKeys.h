@@ -0,0 +1,51 @@
+#pragma once
+#include "RPKey.h"
+#include <GL/glew.h>
+#include <vector>
+#include <cstdint>
+
+class Entity;
+class Texture3D;
+class BBox;
+class ClipmapUpdatePolicy;
+struct VoxelRegion;
+struct ReflectiveShadowMap;
+
+/**
+* Type of the keys that only order the passes in the frame graph and have no data in the blackboard.
+*/
+struct RPGraphResource { };
+
+/**
+* The keys of the data that is exchanged between the render passes.
+*/
+namespace rp_keys
+{
+    // The default framebuffer
+    extern const RPKey<RPGraphResource> BACKBUFFER;
+
+    // Pipeline input
+    extern const RPKey<Texture3D> VOXEL_OPACITY;
+    extern const RPKey<Texture3D> VOXEL_RADIANCE;
+    extern const RPKey<std::vector<BBox>> CLIP_REGION_BBOXES;
+    extern const RPKey<ClipmapUpdatePolicy> CLIPMAP_UPDATE_POLICY;
+
+    // CullingPass
+    extern const RPKey<std::vector<Entity>> CAMERA_VISIBLE_ENTITIES;
+    extern const RPKey<std::vector<std::vector<Entity>>> SHADOW_VISIBLE_ENTITIES;
+
+    // SceneGeometryPass
+    extern const RPKey<GLuint> DIFFUSE_TEXTURE;
+    extern const RPKey<GLuint> NORMAL_MAP;
+    extern const RPKey<GLuint> SPECULAR_MAP;
+    extern const RPKey<GLuint> EMISSION_MAP;
+    extern const RPKey<GLuint> DEPTH_TEXTURE;
+
+    // ShadowMapPass
+    extern const RPKey<RPGraphResource> SHADOW_MAPS;
+    extern const RPKey<std::vector<ReflectiveShadowMap>> REFLECTIVE_SHADOW_MAPS;
+
+    // VoxelizationPass
+    extern const RPKey<std::vector<VoxelRegion>> CLIP_REGIONS;
+    extern const RPKey<uint32_t> VOXEL_OPACITY_DIRTY_LEVELS;
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include "FrameGraph.h"
+#include <engine/util/Profiler.h>
 
 class RenderPipeline;
 
@@ -9,12 +11,18 @@ class RenderPass
 
 public:
     RenderPass(const std::string& name)
-        : m_name(name) { }
+        : m_name(name), m_profileZone(Profiler::registerZone(name.c_str())) { }
 
     virtual ~RenderPass() { }
 
     virtual void update() = 0;
 
+    /**
+    * Declares the resources (keys of the RenderPipeline data) the pass reads and writes in update().
+    * Passes that don't declare their resources are never culled.
+    */
+    virtual void declareResources(FrameGraphBuilder& builder) { builder.setSideEffect(); }
+
     bool isEnabled() const { return m_enabled; }
 
     void setEnabled(bool enabled) { m_enabled = enabled; }
@@ -24,4 +32,5 @@ protected:
 
     bool m_enabled{true};
     std::string m_name;
+    ProfileZoneId m_profileZone;
 };
@@ -1,16 +1,17 @@
 #include "RenderPipeline.h"
+#include "RPKeys.h"
 #include "engine/util/QueryManager.h"
 #include <cstddef>
 
 RenderPipeline::RenderPipeline(ComponentPtr<CameraComponent> camera)
-    : m_camera(camera) {}
-
-RenderPipeline::~RenderPipeline()
+    : m_camera(camera), m_frameGraph(&m_frameGraphBackend)
 {
-    for (auto& p : m_data)
-        p.second.free();
+    // The default framebuffer
+    importResource(rp_keys::BACKBUFFER);
 }
 
+RenderPipeline::~RenderPipeline() { }
+
 std::shared_ptr<RenderPass> RenderPipeline::getRenderPass(const std::string& name, std::size_t idx)
 {
     auto it = m_renderPassesMap.find(name);
@@ -36,29 +37,31 @@ std::shared_ptr<RenderPass> RenderPipeline::getRenderPass(const std::string& nam
 
 void RenderPipeline::update()
 {
+    m_blackboard.beginFrame();
+
+    // The declarations depend on the settings - the graph is rebuilt every frame
+    m_frameGraph.reset();
+    m_enabledRenderPasses.clear();
     for (auto& renderPass : m_renderPasses)
     {
         if (!renderPass->isEnabled())
             continue;
 
-        QueryManager::beginElapsedTime(QueryTarget::CPU, renderPass->m_name);
-        QueryManager::beginElapsedTime(QueryTarget::GPU, renderPass->m_name);
-
-        renderPass->m_renderPipeline = this;
-        renderPass->update();
-
-        QueryManager::endElapsedTime(QueryTarget::CPU, renderPass->m_name);
-        QueryManager::endElapsedTime(QueryTarget::GPU, renderPass->m_name);
+        FrameGraphBuilder builder = m_frameGraph.addPass(renderPass->m_name);
+        renderPass->declareResources(builder);
+        m_enabledRenderPasses.push_back(renderPass.get());
     }
-}
 
-RPDataHandle RenderPipeline::fetchPtr(const RPMapKey& key)
-{
-    auto it = m_dataHandles.find(key);
+    m_frameGraph.compile();
+    QueryManager::setCounter("Frame Graph: Culled Passes", m_frameGraph.getCulledPassCount());
+    QueryManager::setCounter("Frame Graph: Barriers", m_frameGraph.getBarrierCount());
 
-    if (it != m_dataHandles.end())
-        return it->second;
+    m_frameGraph.execute([this](std::size_t passIdx)
+    {
+        RenderPass* renderPass = m_enabledRenderPasses[passIdx];
+        PROFILE_GPU_ZONE_ID(renderPass->m_profileZone);
 
-    LOG_ERROR("Could not find requested data: " << key);
-    return RPDataHandle();
+        renderPass->m_renderPipeline = this;
+        renderPass->update();
+    });
 }
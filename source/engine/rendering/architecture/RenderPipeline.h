@@ -2,45 +2,16 @@
 #include <engine/camera/CameraComponent.h>
 #include <unordered_map>
 #include "RPMapKey.h"
-#include "RPDataHandle.h"
+#include "RPBlackboard.h"
 #include <memory>
 #include "RenderPass.h"
+#include "FrameGraph.h"
+#include "GLFrameGraphBackend.h"
 #include <engine/util/Logger.h>
 #include <cstddef>
 
 class RenderPipeline
 {
-    struct MemoryBlock
-    {
-        MemoryBlock() {}
-
-        MemoryBlock(std::size_t size, char* data)
-            :size(size), data(data) {}
-
-        template<class T>
-        MemoryBlock(T element)
-            : size(sizeof(T))
-        {
-            data = new char[size];
-            memcpy(data, &element, size);
-        }
-
-        void free()
-        {
-            if (data)
-            {
-                delete[] data;
-                data = nullptr;
-            }
-        }
-
-        template<class T>
-        T* get() { return reinterpret_cast<T*>(data); }
-
-        std::size_t size{ 0 };
-        char* data{ nullptr };
-    };
-
     // Multiple render passes of the same name/class are allowed -> a container is necessary
     using RenderPasses = std::vector<std::shared_ptr<RenderPass>>;
 public:
@@ -48,16 +19,25 @@ public:
     ~RenderPipeline();
 
     template <class T>
-    T* fetchPtr(const RPMapKey& key);
+    T* fetchPtr(const RPKey<T>& key) const { return m_blackboard.fetchPtr(key); }
+
+    /**
+    * The data has to outlive its use in the pipeline.
+    */
+    template <class T>
+    void putPtr(const RPKey<T>& key, T* data) { m_blackboard.putPtr(key, data); }
 
     template <class T>
-    void putPtr(const RPMapKey& key, T* data);
+    const T& fetch(const RPKey<T>& key) const { return m_blackboard.fetch(key); }
 
+    /**
+    * Copies the data into the blackboard. It's only valid until the next update().
+    */
     template <class T>
-    T fetch(const RPMapKey& key);
+    void put(const RPKey<T>& key, const T& data) { m_blackboard.put(key, data); }
 
     template <class T>
-    void put(const RPMapKey& key, const T& data);
+    bool contains(const RPKey<T>& key) const { return m_blackboard.contains(key); }
 
     template <class T>
     void addRenderPass(std::shared_ptr<T> renderPass);
@@ -73,60 +53,37 @@ public:
     template <class T>
     std::shared_ptr<T> getRenderPass(std::size_t idx = 0);
 
+    /**
+    * Executes the enabled render passes in the order of the frame graph that is compiled from their declared resources.
+    */
     void update();
 
+    /**
+    * Data that is provided from outside of the pipeline and keeps its content across frames (e.g. the voxel textures).
+    * Render passes writing it are never culled.
+    */
+    template <class T>
+    void importResource(const RPKey<T>& key) { m_frameGraph.importResource(key); }
+
+    const FrameGraph& getFrameGraph() const { return m_frameGraph; }
+
     ComponentPtr<CameraComponent> getCamera() const { return m_camera; }
 
-private:
-    RPDataHandle fetchPtr(const RPMapKey& key);
+    const RPBlackboard& getBlackboard() const { return m_blackboard; }
 
 private:
     ComponentPtr<CameraComponent> m_camera;
 
-    std::unordered_map<RPMapKey, RPDataHandle> m_dataHandles;
-    std::unordered_map<RPMapKey, MemoryBlock> m_data;
+    RPBlackboard m_blackboard;
 
     std::vector<std::shared_ptr<RenderPass>> m_renderPasses;
     std::unordered_map<std::string, RenderPasses> m_renderPassesMap;
     std::unordered_map<std::type_index, RenderPasses> m_renderPassesByTypeIdx;
-};
-
-template <class T>
-T* RenderPipeline::fetchPtr(const RPMapKey& key)
-{
-    RPDataHandle handle = fetchPtr(key);
-
-    return reinterpret_cast<T*>(handle.get());
-}
-
-template <class T>
-void RenderPipeline::putPtr(const RPMapKey& key, T* data)
-{
-    m_dataHandles[key] = RPDataHandle(data);
-}
-
-template <class T>
-T RenderPipeline::fetch(const RPMapKey& key)
-{
-    auto it = m_data.find(key);
-
-    if (it == m_data.end())
-        LOG_ERROR("RenderPipeline - Error: Expected " << key << " but not found.");
-
-    assert(it != m_data.end());
 
-    return *it->second.get<T>();
-}
-
-template <class T>
-void RenderPipeline::put(const RPMapKey& key, const T& data)
-{
-    auto it = m_data.find(key);
-    if (it != m_data.end())
-        it->second.free();
-
-    m_data[key] = MemoryBlock(data);
-}
+    GLFrameGraphBackend m_frameGraphBackend;
+    FrameGraph m_frameGraph;
+    std::vector<RenderPass*> m_enabledRenderPasses; // In the order of the passes of the frame graph
+};
 
 template <class T>
 void RenderPipeline::addRenderPass(std::shared_ptr<T> renderPass)
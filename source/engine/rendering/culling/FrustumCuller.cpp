@@ -0,0 +1,146 @@
+#include "FrustumCuller.h"
+#include <engine/ecs/ECS.h>
+#include <engine/geometry/Transform.h>
+#include <engine/geometry/intersection.h>
+#include <engine/rendering/renderer/MeshRenderer.h>
+#include <engine/util/ThreadPool.h>
+#include <cfloat>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_CULLER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+void FrustumCuller::gatherEntities()
+{
+    m_entities.clear();
+    m_drawCounts.clear();
+
+    for (Entity e : ECS::getEntitiesWithComponents<Transform, MeshRenderer>())
+    {
+        auto mesh = e.getComponent<MeshRenderer>()->getMesh();
+        m_entities.push_back(e);
+        m_drawCounts.push_back(mesh ? uint32_t(mesh->getSubMeshes().size()) : 0);
+    }
+
+    std::size_t paddedCount = (m_entities.size() + 3) / 4 * 4;
+    m_minX.assign(paddedCount, FLT_MAX);
+    m_minY.assign(paddedCount, FLT_MAX);
+    m_minZ.assign(paddedCount, FLT_MAX);
+    m_maxX.assign(paddedCount, -FLT_MAX);
+    m_maxY.assign(paddedCount, -FLT_MAX);
+    m_maxZ.assign(paddedCount, -FLT_MAX);
+
+    for (std::size_t i = 0; i < m_entities.size(); ++i)
+    {
+        const BBox& bbox = m_entities[i].getComponent<Transform>()->getBBox();
+        m_minX[i] = bbox.min().x;
+        m_minY[i] = bbox.min().y;
+        m_minZ[i] = bbox.min().z;
+        m_maxX[i] = bbox.max().x;
+        m_maxY[i] = bbox.max().y;
+        m_maxZ[i] = bbox.max().z;
+    }
+}
+
+void FrustumCuller::cull(std::vector<CullingView>& views, ThreadPool* threadPool) const
+{
+    if (!threadPool)
+    {
+        for (auto& view : views)
+            cull(view);
+
+        return;
+    }
+
+    threadPool->parallelFor(views.size(), 1, [this, &views](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            cull(views[i]);
+    });
+}
+
+void FrustumCuller::cull(CullingView& view) const
+{
+    assert(view.visibleEntities);
+    auto& visibleEntities = *view.visibleEntities;
+    visibleEntities.clear();
+    view.visibleDrawCount = 0;
+    view.culledDrawCount = 0;
+
+    glm::vec4 planes[6];
+    extractPlanes(view.viewProj, planes);
+
+    auto addResult = [&](std::size_t idx, bool visible)
+    {
+        if (visible)
+        {
+            visibleEntities.push_back(m_entities[idx]);
+            view.visibleDrawCount += m_drawCounts[idx];
+        }
+        else
+        {
+            view.culledDrawCount += m_drawCounts[idx];
+        }
+    };
+
+#ifdef FRUSTUM_CULLER_USE_SSE
+    // The corner of a box which is furthest in the direction of the plane normal decides whether it is outside
+    const std::vector<float>* px[6];
+    const std::vector<float>* py[6];
+    const std::vector<float>* pz[6];
+    __m128 nx[6], ny[6], nz[6], d[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        px[p] = planes[p].x >= 0.0f ? &m_maxX : &m_minX;
+        py[p] = planes[p].y >= 0.0f ? &m_maxY : &m_minY;
+        pz[p] = planes[p].z >= 0.0f ? &m_maxZ : &m_minZ;
+        nx[p] = _mm_set1_ps(planes[p].x);
+        ny[p] = _mm_set1_ps(planes[p].y);
+        nz[p] = _mm_set1_ps(planes[p].z);
+        d[p] = _mm_set1_ps(planes[p].w);
+    }
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 allSet = _mm_cmpeq_ps(zero, zero);
+    for (std::size_t i = 0; i < m_minX.size(); i += 4)
+    {
+        __m128 inside = allSet;
+
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(nx[p], _mm_loadu_ps(&(*px[p])[i])), d[p]);
+            dist = _mm_add_ps(dist, _mm_mul_ps(ny[p], _mm_loadu_ps(&(*py[p])[i])));
+            dist = _mm_add_ps(dist, _mm_mul_ps(nz[p], _mm_loadu_ps(&(*pz[p])[i])));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, zero));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (std::size_t j = i; j < std::min(i + 4, m_entities.size()); ++j)
+            addResult(j, (mask & (1 << (j - i))) != 0);
+    }
+#else
+    for (std::size_t i = 0; i < m_entities.size(); ++i)
+    {
+        BBox bbox(glm::vec3(m_minX[i], m_minY[i], m_minZ[i]), glm::vec3(m_maxX[i], m_maxY[i], m_maxZ[i]));
+        addResult(i, intersection::bboxPlanes(bbox, planes, 6));
+    }
+#endif
+}
+
+void FrustumCuller::extractPlanes(const glm::mat4& viewProj, glm::vec4 planes[6])
+{
+    // Rows of the column major matrix
+    glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <engine/ecs/EntityManager.h>
+
+class ThreadPool;
+
+struct CullingView
+{
+    CullingView() { }
+
+    CullingView(const glm::mat4& viewProj, std::vector<Entity>* visibleEntities)
+        : viewProj(viewProj), visibleEntities(visibleEntities) { }
+
+    glm::mat4 viewProj;
+    std::vector<Entity>* visibleEntities{nullptr};
+
+    // Number of draw calls (sub meshes) of the visible/culled entities - set by cull()
+    uint64_t visibleDrawCount{0};
+    uint64_t culledDrawCount{0};
+};
+
+/**
+* Culls all entities with a Transform and a MeshRenderer against the frustums of multiple views.
+* The world bounding boxes are gathered once per frame in structure-of-arrays layout such that
+* 4 boxes are tested against a plane at once with SSE.
+*/
+class FrustumCuller
+{
+public:
+    /**
+    * Packs the world bounding boxes of all active Transform + MeshRenderer entities.
+    */
+    void gatherEntities();
+
+    /**
+    * Fills the visible entity list of each view. The views are culled in parallel if a thread pool is given.
+    */
+    void cull(std::vector<CullingView>& views, ThreadPool* threadPool = nullptr) const;
+
+    void cull(CullingView& view) const;
+
+    std::size_t getEntityCount() const { return m_entities.size(); }
+
+    /**
+    * Extracts the planes (left, right, bottom, top, near, far) of the frustum of the given view projection matrix.
+    * See intersection::bboxPlanes for the plane convention.
+    */
+    static void extractPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]);
+
+private:
+    std::vector<Entity> m_entities;
+    std::vector<uint32_t> m_drawCounts;
+
+    // Padded to a multiple of 4 with empty boxes
+    std::vector<float> m_minX;
+    std::vector<float> m_minY;
+    std::vector<float> m_minZ;
+    std::vector<float> m_maxX;
+    std::vector<float> m_maxY;
+    std::vector<float> m_maxZ;
+};
@@ -108,19 +108,46 @@ void DebugRenderer::init()
     GL_ERROR_CHECK();
 }
 
+void DebugRenderer::DrawCommand::draw() const
+{
+    switch (type)
+    {
+    case Type::LINE:
+        drawLine(start, end, glm::vec3(color));
+        break;
+    case Type::ARROW:
+        drawArrow(start, end, glm::vec3(color));
+        break;
+    case Type::CUBE:
+        drawCube(model, color);
+        break;
+    case Type::NON_FILLED_CUBE:
+        drawNonFilledCube(model, glm::vec3(color));
+        break;
+    case Type::VOLUMETRIC_LINE:
+        drawVolumetricLine(start, end, glm::vec3(color), size);
+        break;
+    case Type::SPHERE:
+        drawSphere(start, size, color);
+        break;
+    }
+}
+
 void DebugRenderer::update()
 {
-    auto it = m_drawCommands.begin();
-    while (it != m_drawCommands.end())
+    // Expired commands are removed in a single pass
+    std::size_t keptCount = 0;
+    for (std::size_t i = 0; i < m_drawCommands.size(); ++i)
     {
-        it->drawFunction();
-        it->duration -= Time::deltaTime();
+        DrawCommand& command = m_drawCommands[i];
+        command.draw();
+        command.duration -= Time::deltaTime();
 
-        if (it->duration <= 0.f)
-            it = m_drawCommands.erase(it);
-        else
-            ++it;
+        if (command.duration > 0.f)
+            m_drawCommands[keptCount++] = command;
     }
+
+    m_drawCommands.erase(m_drawCommands.begin() + keptCount, m_drawCommands.end());
 }
 
 void DebugRenderer::begin(const DebugRenderInfo& debugRenderInfo)
@@ -147,7 +174,7 @@ void DebugRenderer::drawLine(glm::vec3 start, glm::vec3 end, const glm::vec3& co
     m_lineMeshRenderer->bindAndRender();
 
     if (duration > math::EPSILON)
-        m_drawCommands.push_back(DrawCommand([=]() { drawLine(start, end, color); }, duration));
+        m_drawCommands.push_back(DrawCommand(DrawCommand::Type::LINE, start, end, glm::vec4(color, 1.0f), 0.0f, duration));
 }
 
 void DebugRenderer::drawArrow(glm::vec3 start, glm::vec3 end, const glm::vec3& color, float lineThickness, glm::vec3 scale, float duration)
@@ -174,7 +201,7 @@ void DebugRenderer::drawArrow(glm::vec3 start, glm::vec3 end, const glm::vec3& c
     m_arrowHeadMeshRenderer->render(m_debugShader.get());
 
     if (duration > math::EPSILON)
-        m_drawCommands.push_back(DrawCommand([=]() { drawArrow(start, end, color); }, duration));
+        m_drawCommands.push_back(DrawCommand(DrawCommand::Type::ARROW, start, end, glm::vec4(color, 1.0f), 0.0f, duration));
 }
 
 void DebugRenderer::drawCube(glm::vec3 pos, glm::vec3 scale, glm::vec4 color, float duration)
@@ -192,7 +219,7 @@ void DebugRenderer::drawCube(glm::mat4 model, glm::vec4 color, float duration, S
     m_cubeMeshRenderer->render(shader);
 
     if (duration > math::EPSILON)
-        m_drawCommands.push_back(DrawCommand([=]() { drawCube(model, color); }, duration));
+        m_drawCommands.push_back(DrawCommand(DrawCommand::Type::CUBE, model, color, duration));
 }
 
 void DebugRenderer::drawNonFilledCube(glm::vec3 pos, glm::vec3 scale, glm::vec3 color, float lineWidth, float duration)
@@ -212,7 +239,7 @@ void DebugRenderer::drawNonFilledCube(glm::mat4 model, glm::vec3 color, float li
     glLineWidth(1.0f);
 
     if (duration > math::EPSILON)
-        m_drawCommands.push_back(DrawCommand([=]() { drawNonFilledCube(model, color); }, duration));
+        m_drawCommands.push_back(DrawCommand(DrawCommand::Type::NON_FILLED_CUBE, model, glm::vec4(color, 1.0f), duration));
 }
 
 void DebugRenderer::drawCoordinateSystem(const Transform& transform, float duration)
@@ -250,7 +277,7 @@ void DebugRenderer::drawVolumetricLine(glm::vec3 start, glm::vec3 end, const glm
     m_cylinderMeshRenderer->render(m_debugShader.get());
 
     if (duration > math::EPSILON)
-        m_drawCommands.push_back(DrawCommand([=]() { drawVolumetricLine(start, end, color, thickness); }, duration));
+        m_drawCommands.push_back(DrawCommand(DrawCommand::Type::VOLUMETRIC_LINE, start, end, glm::vec4(color, 1.0f), thickness, duration));
 }
 
 void DebugRenderer::drawSphere(const glm::vec3& pos, float radius, const glm::vec4& color, float duration)
@@ -281,7 +308,7 @@ void DebugRenderer::drawSphere(const glm::vec3& pos, float radius, const glm::ve
     }
 
     if (duration > math::EPSILON)
-        m_drawCommands.push_back(DrawCommand([=]() { drawSphere(pos, radius, color); }, duration));
+        m_drawCommands.push_back(DrawCommand(DrawCommand::Type::SPHERE, pos, pos, color, radius, duration));
 }
 
 void DebugRenderer::drawSphere(Shader* shader, const glm::vec3& pos, float radius, const glm::vec4& color, float duration)
@@ -321,7 +348,7 @@ void DebugRenderer::clearDrawQueue() { m_drawQueue.clear(); }
 
 void DebugRenderer::queueDrawCube(glm::vec3 pos, glm::vec3 scale, glm::vec4 color)
 {
-    DrawCommand drawCommand = DrawCommand([=]() { drawCube(glm::translate(pos) * glm::scale(scale), color); }, 0.0f);
+    DrawCommand drawCommand(DrawCommand::Type::CUBE, glm::translate(pos) * glm::scale(scale), color, 0.0f);
     drawCommand.pos = pos;
     m_drawQueue.push_back(drawCommand);
 }
@@ -337,7 +364,7 @@ void DebugRenderer::drawQueuedCommands(bool sortByDistanceToCamera, bool alphaBl
 
     if (sortByDistanceToCamera) { std::sort(m_drawQueue.begin(), m_drawQueue.end(), DrawCommand::DistToCameraSortCondition(m_cameraPos)); }
 
-    for (auto& c : m_drawQueue) { c.drawFunction(); }
+    for (auto& c : m_drawQueue) { c.draw(); }
 
     if (alphaBlending)
     {
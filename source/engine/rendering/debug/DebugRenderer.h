@@ -3,7 +3,6 @@
 #include <engine/camera/CameraComponent.h>
 #include <engine/rendering/geometry/Mesh.h>
 #include <engine/rendering/shader/Shader.h>
-#include <functional>
 #include <memory>
 #include <engine/rendering/renderer/MeshRenderer.h>
 #include <engine/rendering/renderer/SimpleMeshRenderer.h>
@@ -61,16 +60,39 @@ struct DebugRenderInfo
 */
 class DebugRenderer
 {
+    /**
+    * A plain description of a draw call instead of a std::function - commands are copied without heap allocations.
+    */
     struct DrawCommand
     {
-        std::function<void()> drawFunction;
+        enum class Type
+        {
+            LINE,
+            ARROW,
+            CUBE,
+            NON_FILLED_CUBE,
+            VOLUMETRIC_LINE,
+            SPHERE
+        };
+
+        Type type{Type::CUBE};
+        glm::mat4 model;    // CUBE, NON_FILLED_CUBE
+        glm::vec3 start;    // LINE, ARROW, VOLUMETRIC_LINE and the center of a SPHERE
+        glm::vec3 end;
+        glm::vec4 color;
+        float size{0.0f};   // Thickness of a VOLUMETRIC_LINE, radius of a SPHERE
         float duration{0.0f};
         glm::vec3 pos;
 
         DrawCommand() { }
 
-        DrawCommand(std::function<void()> drawFunction, float duration)
-            : drawFunction(drawFunction), duration(duration) { }
+        DrawCommand(Type type, const glm::vec3& start, const glm::vec3& end, const glm::vec4& color, float size, float duration)
+            : type(type), start(start), end(end), color(color), size(size), duration(duration) { }
+
+        DrawCommand(Type type, const glm::mat4& model, const glm::vec4& color, float duration)
+            : type(type), model(model), color(color), duration(duration) { }
+
+        void draw() const;
 
         struct DistToCameraSortCondition
         {
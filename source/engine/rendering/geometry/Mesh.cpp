@@ -124,91 +124,112 @@ void Mesh::setSubMesh(const SubMesh& subMesh, SubMeshIndex subMeshIdx)
 void Mesh::finalize()
 {
     freeGLResources();
+    ++m_version;
 
     // Go through all submeshes and create ibos/vbos/vaos
+    std::vector<float> interleavedVertices;
     for (std::size_t mi = 0; mi < m_subMeshes.size(); ++mi)
     {
         auto& subMesh = m_subMeshes[mi];
         auto& renderData = m_subMeshRenderData[mi];
-        std::vector<float> vertices;
+        InterleavedSubMeshData data = subMesh.interleaved;
 
-        if (subMesh.vertices.size() == 0)
-            continue;
-
-        // Interleave vertex data
-        for (std::size_t i = 0; i < subMesh.vertices.size(); ++i)
+        if (!data.vertices)
         {
-            vertices.push_back(subMesh.vertices[i].x);
-            vertices.push_back(subMesh.vertices[i].y);
-            vertices.push_back(subMesh.vertices[i].z);
-
-            if (subMesh.normals.size() > 0)
-            {
-                vertices.push_back(subMesh.normals[i].x);
-                vertices.push_back(subMesh.normals[i].y);
-                vertices.push_back(subMesh.normals[i].z);
-            }
+            if (subMesh.vertices.size() == 0)
+                continue;
 
-            if (subMesh.tangents.size() > 0)
-            {
-                vertices.push_back(subMesh.tangents[i].x);
-                vertices.push_back(subMesh.tangents[i].y);
-                vertices.push_back(subMesh.tangents[i].z);
-            }
-
-            if (subMesh.bitangents.size() > 0)
-            {
-                vertices.push_back(subMesh.bitangents[i].x);
-                vertices.push_back(subMesh.bitangents[i].y);
-                vertices.push_back(subMesh.bitangents[i].z);
-            }
+            data.attributes = VERTEX_POS | (subMesh.normals.size() > 0 ? VERTEX_NORMAL : 0) |
+                (subMesh.tangents.size() > 0 ? VERTEX_TANGENT : 0) | (subMesh.bitangents.size() > 0 ? VERTEX_BITANGENT : 0) |
+                (subMesh.uvs.size() > 0 ? VERTEX_UV : 0) | (subMesh.colors.size() > 0 ? VERTEX_COLOR : 0);
 
-            if (subMesh.uvs.size() > 0)
+            // Interleave vertex data
+            interleavedVertices.clear();
+            interleavedVertices.reserve(subMesh.vertices.size() * getFloatsPerVertex(data.attributes));
+            for (std::size_t i = 0; i < subMesh.vertices.size(); ++i)
             {
-                vertices.push_back(subMesh.uvs[i].x);
-                vertices.push_back(subMesh.uvs[i].y);
+                interleavedVertices.push_back(subMesh.vertices[i].x);
+                interleavedVertices.push_back(subMesh.vertices[i].y);
+                interleavedVertices.push_back(subMesh.vertices[i].z);
+
+                if (subMesh.normals.size() > 0)
+                {
+                    interleavedVertices.push_back(subMesh.normals[i].x);
+                    interleavedVertices.push_back(subMesh.normals[i].y);
+                    interleavedVertices.push_back(subMesh.normals[i].z);
+                }
+
+                if (subMesh.tangents.size() > 0)
+                {
+                    interleavedVertices.push_back(subMesh.tangents[i].x);
+                    interleavedVertices.push_back(subMesh.tangents[i].y);
+                    interleavedVertices.push_back(subMesh.tangents[i].z);
+                }
+
+                if (subMesh.bitangents.size() > 0)
+                {
+                    interleavedVertices.push_back(subMesh.bitangents[i].x);
+                    interleavedVertices.push_back(subMesh.bitangents[i].y);
+                    interleavedVertices.push_back(subMesh.bitangents[i].z);
+                }
+
+                if (subMesh.uvs.size() > 0)
+                {
+                    interleavedVertices.push_back(subMesh.uvs[i].x);
+                    interleavedVertices.push_back(subMesh.uvs[i].y);
+                }
+
+                if (subMesh.colors.size() > 0)
+                {
+                    interleavedVertices.push_back(subMesh.colors[i].r);
+                    interleavedVertices.push_back(subMesh.colors[i].g);
+                    interleavedVertices.push_back(subMesh.colors[i].b);
+                }
             }
 
-            if (subMesh.colors.size() > 0)
-            {
-                vertices.push_back(subMesh.colors[i].r);
-                vertices.push_back(subMesh.colors[i].g);
-                vertices.push_back(subMesh.colors[i].b);
-            }
+            data.vertices = interleavedVertices.data();
+            data.vertexCount = uint32_t(subMesh.vertices.size());
+            data.indices = subMesh.indices.data();
+            data.indexCount = uint32_t(subMesh.indices.size());
+        }
+        else if (data.vertexCount == 0)
+        {
+            continue;
         }
 
-        MeshBuilder builder(vertices.size());
-        VBODescription vboDesc(vertices.size() * sizeof(float), &vertices[0]);
+        std::size_t floatCount = data.vertexCount * getFloatsPerVertex(data.attributes);
+        MeshBuilder builder(floatCount);
+        VBODescription vboDesc(floatCount * sizeof(float), data.vertices);
 
         // Position
         vboDesc.attribute(3, GL_FLOAT);
 
-        if (subMesh.normals.size() > 0)
+        if ((data.attributes & VERTEX_NORMAL) == VERTEX_NORMAL)
             vboDesc.attribute(3, GL_FLOAT);
 
-        if (subMesh.tangents.size() > 0)
+        if ((data.attributes & VERTEX_TANGENT) == VERTEX_TANGENT)
             vboDesc.attribute(3, GL_FLOAT);
 
-        if (subMesh.bitangents.size() > 0)
+        if ((data.attributes & VERTEX_BITANGENT) == VERTEX_BITANGENT)
             vboDesc.attribute(3, GL_FLOAT);
 
-        if (subMesh.uvs.size() > 0)
+        if ((data.attributes & VERTEX_UV) == VERTEX_UV)
             vboDesc.attribute(2, GL_FLOAT);
 
-        if (subMesh.colors.size() > 0)
+        if ((data.attributes & VERTEX_COLOR) == VERTEX_COLOR)
             vboDesc.attribute(3, GL_FLOAT);
 
         builder.createVBO(vboDesc);
 
-        if (subMesh.indices.size() > 0)
-            builder.createIBO(subMesh.indices.size(), &subMesh.indices[0]);
+        if (data.indexCount > 0)
+            builder.createIBO(data.indexCount, data.indices);
 
         builder.finalize();
 
         renderData.vbo = builder.getVBO(0);
         renderData.ibo = builder.getIBO();
         renderData.vao = builder.getVAO();
-        renderData.renderMode = subMesh.indices.size() > 0 ? GL_TRIANGLES : GL_TRIANGLE_STRIP;
+        renderData.renderMode = data.indexCount > 0 ? GL_TRIANGLES : GL_TRIANGLE_STRIP;
     }
 }
 
@@ -218,15 +239,66 @@ void Mesh::setSubMeshes(const std::vector<SubMesh>& subMeshes)
     m_subMeshRenderData.resize(m_subMeshes.size());
 }
 
+std::size_t Mesh::getFloatsPerVertex(uint32_t vertexAttribFlags)
+{
+    return getAttributeOffset(vertexAttribFlags, VERTEX_COLOR) + ((vertexAttribFlags & VERTEX_COLOR) == VERTEX_COLOR ? 3 : 0);
+}
+
+std::size_t Mesh::getAttributeOffset(uint32_t vertexAttribFlags, uint32_t attribute)
+{
+    // Attributes in interleaving order with their float count
+    static const uint32_t attributes[] = { VERTEX_NORMAL, VERTEX_TANGENT, VERTEX_BITANGENT, VERTEX_UV, VERTEX_COLOR };
+    static const std::size_t sizes[] = { 3, 3, 3, 2, 3 };
+
+    std::size_t offset = 3;
+    for (std::size_t i = 0; i < 5 && attributes[i] != attribute; ++i)
+    {
+        if ((vertexAttribFlags & attributes[i]) == attributes[i])
+            offset += sizes[i];
+    }
+
+    return attribute == VERTEX_POS ? 0 : offset;
+}
+
+const Vertices& Mesh::SubMesh::getPositions(Vertices& storage) const
+{
+    if (!interleaved.vertices)
+        return vertices;
+
+    storage.resize(interleaved.vertexCount);
+    for (std::size_t i = 0; i < storage.size(); ++i)
+        storage[i] = getPosition(i);
+
+    return storage;
+}
+
+const Indices& Mesh::SubMesh::getIndices(Indices& storage) const
+{
+    if (!interleaved.vertices)
+        return indices;
+
+    storage.assign(interleaved.indices, interleaved.indices + interleaved.indexCount);
+    return storage;
+}
+
+glm::vec3 Mesh::SubMesh::getPosition(std::size_t vertexIdx) const
+{
+    if (!interleaved.vertices)
+        return vertices[vertexIdx];
+
+    const float* v = interleaved.vertices + vertexIdx * getFloatsPerVertex(interleaved.attributes);
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
 glm::vec3 Mesh::computeCenter() const
 {
     std::size_t count = 0;
     glm::vec3 center;
     for (auto& subMesh : m_subMeshes)
     {
-        for (auto& v : subMesh.vertices)
+        for (std::size_t i = 0; i < subMesh.getVertexCount(); ++i)
         {
-            center += v;
+            center += subMesh.getPosition(i);
             ++count;
         }
     }
@@ -253,8 +325,8 @@ BBox Mesh::computeBBox() const
     BBox box;
 
     for (auto& subMesh : getSubMeshes())
-        for (auto& v : subMesh.vertices)
-            box.unite(v);
+        for (std::size_t i = 0; i < subMesh.getVertexCount(); ++i)
+            box.unite(subMesh.getPosition(i));
 
     return box;
 }
@@ -2,6 +2,7 @@
 #include <GL/glew.h>
 #include <string>
 #include <vector>
+#include <memory>
 #include <engine/util/Logger.h>
 #include "GeometryGenerator.h"
 #include "engine/geometry/BBox.h"
@@ -26,11 +27,41 @@ using Bitangents = std::vector<glm::vec3>;
 using UVs = std::vector<glm::vec2>;
 using Colors = std::vector<glm::vec3>;
 
+/**
+* Vertex and index data in the upload layout of Mesh::finalize(): Per vertex the position followed by the attributes
+* given by the VERTEX_* flags in the order normal, tangent, bitangent, uv, color.
+*/
+struct InterleavedSubMeshData
+{
+    std::shared_ptr<const void> owner; // Keeps the memory alive - e.g. a mapped mesh cache
+    const float* vertices{nullptr};
+    const IndexType* indices{nullptr};
+    uint32_t vertexCount{0};
+    uint32_t indexCount{0};
+    uint32_t attributes{VERTEX_POS};
+};
+
 class Mesh
 {
 public:
     struct SubMesh
     {
+        /**
+        * Returns the positions - copied from the interleaved data into storage if there is no vertex vector.
+        */
+        const Vertices& getPositions(Vertices& storage) const;
+
+        /**
+        * Returns the indices - copied from the interleaved data into storage if there is no index vector.
+        */
+        const Indices& getIndices(Indices& storage) const;
+
+        glm::vec3 getPosition(std::size_t vertexIdx) const;
+
+        std::size_t getVertexCount() const { return interleaved.vertices ? interleaved.vertexCount : vertices.size(); }
+
+        std::size_t getIndexCount() const { return interleaved.vertices ? interleaved.indexCount : indices.size(); }
+
         Indices indices;
         Vertices vertices;
         Normals normals;
@@ -38,6 +69,9 @@ public:
         Bitangents bitangents;
         UVs uvs;
         Colors colors;
+
+        // Used instead of the vectors above (which stay empty) if vertices is set - finalize() uploads the data as is
+        InterleavedSubMeshData interleaved;
     };
 
     struct SubMeshRenderData
@@ -50,6 +84,7 @@ public:
 
     friend class MeshRenderer;
     friend class MeshRenderSystem;
+    friend class RenderQueue;
 
     Mesh() { }
 
@@ -70,10 +105,25 @@ public:
 
     void setSubMeshes(const std::vector<SubMesh>& subMeshes);
 
+    static std::size_t getFloatsPerVertex(uint32_t vertexAttribFlags);
+
+    /**
+    * Returns the offset of the attribute in floats within an interleaved vertex with the given attributes.
+    */
+    static std::size_t getAttributeOffset(uint32_t vertexAttribFlags, uint32_t attribute);
+
     const std::vector<SubMesh>& getSubMeshes() const { return m_subMeshes; }
 
+    /**
+    * Incremented by finalize() - users of the CPU side geometry can compare it to detect changes.
+    */
+    uint32_t getVersion() const { return m_version; }
+
     glm::vec3 computeCenter() const;
 
+    /**
+    * Only modifies the vertex vectors - interleaved sub meshes are left unchanged.
+    */
     void scale(const glm::vec3& s);
     void translate(const glm::vec3& t);
 
@@ -94,4 +144,5 @@ private:
 private:
     std::vector<SubMesh> m_subMeshes;
     std::vector<SubMeshRenderData> m_subMeshRenderData;
+    uint32_t m_version{0};
 };
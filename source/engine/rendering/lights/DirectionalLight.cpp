@@ -1,5 +1,7 @@
 #include "DirectionalLight.h"
 #include <imgui/imgui.h>
+#include <engine/geometry/Transform.h>
+#include <engine/util/math.h>
 
 void DirectionalLight::onShowInEditor()
 {
@@ -11,3 +13,19 @@ void DirectionalLight::onShowInEditor()
     ImGui::DragFloat("Z-Near", &zNear, 0.1f, 0.1f, 5.0f);
     ImGui::DragFloat("Z-Far", &zFar, 0.1f, 0.1f, 100.0f);
 }
+
+void DirectionalLight::updateShadowMatrices(const ComponentPtr<Transform>& transform)
+{
+    glm::vec3 lightDir = transform->getForward();
+    glm::vec3 lightPos = transform->getPosition();
+
+    glm::vec3 up = glm::vec3(0.f, 1.f, 0.f);
+    if (math::nearEq(std::abs(glm::dot(lightDir, up)), 1.0f))
+        up = glm::vec3(0.0f, 0.0f, 1.0f);
+
+    view = glm::lookAt(lightPos, lightPos + lightDir, up);
+
+    float hw = shadowProjectionSize.x * 0.5f;
+    float hh = shadowProjectionSize.y * 0.5f;
+    proj = math::orthoLH(-hw, hw, -hh, hh, zNear, zFar);
+}
@@ -3,9 +3,13 @@
 #include <glm/glm.hpp>
 #include <GL/glew.h>
 
+class Transform;
+
 class DirectionalLight : public Component
 {
 public:
+    static constexpr ComponentUsage USAGE_HINT = ComponentUsage::MostlyStatic;
+
     DirectionalLight() { }
 
     DirectionalLight(const glm::vec3& color, float intensity)
@@ -15,6 +19,11 @@ public:
 
     std::string getName() const override { return "Directional Light"; }
 
+    /**
+    * Computes the view and projection matrices of the shadow map from the transform of the light.
+    */
+    void updateShadowMatrices(const ComponentPtr<Transform>& transform);
+
     glm::vec3 color{1.0f};
     float intensity{1.0f};
 
@@ -25,5 +34,6 @@ public:
     glm::mat4 proj;
     float zNear{0.3f};
     float zFar{30.0f};
+    glm::vec2 shadowProjectionSize{37.0f, 37.0f};
     float pcfRadius{ 0.001f };
 };
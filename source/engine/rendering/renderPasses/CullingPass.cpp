@@ -0,0 +1,54 @@
+#include "CullingPass.h"
+#include <engine/ecs/ECS.h>
+#include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
+#include <engine/rendering/lights/DirectionalLight.h>
+#include "engine/util/QueryManager.h"
+
+CullingPass::CullingPass()
+    : RenderPass("CullingPass"), m_shadowVisibleEntities(MAX_DIR_LIGHT_COUNT) { }
+
+void CullingPass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.write(rp_keys::CAMERA_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+    builder.write(rp_keys::SHADOW_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+}
+
+void CullingPass::update()
+{
+    m_culler.gatherEntities();
+
+    m_views.clear();
+    m_views.emplace_back(m_renderPipeline->getCamera()->viewProj(), &m_cameraVisibleEntities);
+
+    // Same light order as in ShadowMapPass
+    int lightCount = 0;
+    for (auto dirLight : ECS::getEntitiesWithComponents<DirectionalLight, Transform>())
+    {
+        if (lightCount == MAX_DIR_LIGHT_COUNT)
+            break;
+
+        auto dirLightComponent = dirLight.getComponent<DirectionalLight>();
+        m_shadowVisibleEntities[lightCount].clear();
+
+        if (dirLightComponent->shadowsEnabled)
+        {
+            dirLightComponent->updateShadowMatrices(dirLight.getComponent<Transform>());
+            m_views.emplace_back(dirLightComponent->proj * dirLightComponent->view, &m_shadowVisibleEntities[lightCount]);
+        }
+
+        lightCount++;
+    }
+
+    m_culler.cull(m_views, ECS::getThreadPool());
+
+    uint64_t shadowCulledDrawCount = 0;
+    for (std::size_t i = 1; i < m_views.size(); ++i)
+        shadowCulledDrawCount += m_views[i].culledDrawCount;
+
+    QueryManager::setCounter("Culled Draws: Camera", m_views[0].culledDrawCount);
+    QueryManager::setCounter("Culled Draws: Shadow Maps", shadowCulledDrawCount);
+
+    m_renderPipeline->putPtr(rp_keys::CAMERA_VISIBLE_ENTITIES, &m_cameraVisibleEntities);
+    m_renderPipeline->putPtr(rp_keys::SHADOW_VISIBLE_ENTITIES, &m_shadowVisibleEntities);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <engine/rendering/architecture/RenderPass.h>
+#include <engine/rendering/culling/FrustumCuller.h>
+#include "engine/rendering/voxelConeTracing/Globals.h"
+
+/**
+* Computes the entities which are visible to the camera and to the shadow maps of the directional lights.
+* All views are culled in parallel. Has to run before SceneGeometryPass and ShadowMapPass which render
+* "CameraVisibleEntities" and "ShadowVisibleEntities" (one list per light) instead of all entities.
+*/
+class CullingPass : public RenderPass
+{
+public:
+    CullingPass();
+
+    void update() override;
+
+    void declareResources(FrameGraphBuilder& builder) override;
+
+private:
+    FrustumCuller m_culler;
+    std::vector<CullingView> m_views;
+
+    std::vector<Entity> m_cameraVisibleEntities;
+    std::vector<std::vector<Entity>> m_shadowVisibleEntities;
+};
@@ -2,10 +2,13 @@
 #include <GL/glew.h>
 #include <engine/resource/ResourceManager.h>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/util/functions.h>
 #include "engine/rendering/voxelConeTracing/Globals.h"
 #include "engine/rendering/voxelConeTracing/settings/VoxelConeTracingSettings.h"
 #include "engine/util/ECSUtil/ECSUtil.h"
+#include <engine/ecs/ECS.h>
+#include <engine/rendering/renderer/MeshRenderer.h>
 
 ForwardScenePass::ForwardScenePass()
     : RenderPass("ForwardScenePass")
@@ -13,15 +16,31 @@ ForwardScenePass::ForwardScenePass()
     m_shader = ResourceManager::getShader("shaders/forwardShadingPass.vert", "shaders/forwardShadingPass.frag");
 }
 
+void ForwardScenePass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.read(rp_keys::SHADOW_MAPS, FrameGraphAccess::TEXTURE);
+    builder.write(rp_keys::BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+}
+
 void ForwardScenePass::update()
 {
+    m_renderQueue.clear();
+    m_renderQueue.resetStats();
+
+    for (auto e : ECS::getEntitiesWithComponents<Transform, MeshRenderer>())
+        m_renderQueue.add(e);
+
+    m_renderQueue.sort();
+
     render(false);
 
     if (RENDERING_SETTINGS.wireFrame)
         render(true);
+
+    m_renderQueue.reportStats(m_name);
 }
 
-void ForwardScenePass::render(bool wireframe) const
+void ForwardScenePass::render(bool wireframe)
 {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_SCISSOR_TEST);
@@ -59,7 +78,7 @@ void ForwardScenePass::render(bool wireframe) const
     m_shader->setInt("u_BRDFMode", RENDERING_SETTINGS.brdfMode);
     m_shader->setCamera(MainCamera->view(), MainCamera->proj());
 
-    ECSUtil::renderEntities(m_shader.get());
+    m_renderQueue.render(m_shader.get());
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     glDisable(GL_CULL_FACE);
@@ -2,6 +2,7 @@
 #include <memory>
 #include <engine/rendering/architecture/RenderPass.h>
 #include <engine/rendering/shader/Shader.h>
+#include <engine/rendering/renderer/RenderQueue.h>
 
 class ForwardScenePass : public RenderPass
 {
@@ -10,9 +11,12 @@ public:
 
     void update() override;
 
+    void declareResources(FrameGraphBuilder& builder) override;
+
 private:
-    void render(bool wireframe) const;
+    void render(bool wireframe);
 
 private:
     std::shared_ptr<Shader> m_shader;
+    RenderQueue m_renderQueue;
 };
@@ -2,56 +2,50 @@
 #include <engine/rendering/Screen.h>
 #include <engine/camera/CameraComponent.h>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/ecs/ECS.h>
 #include <engine/resource/ResourceManager.h>
 #include "engine/util/ECSUtil/ECSUtil.h"
 #include "engine/rendering/voxelConeTracing/settings/VoxelConeTracingSettings.h"
 
+namespace
+{
+    struct GBufferTexture
+    {
+        const RPKey<GLuint>* key;
+        GLenum attachment;
+        GLenum format;
+    };
+
+    const GBufferTexture G_BUFFER_TEXTURES[] = {
+        { &rp_keys::DIFFUSE_TEXTURE, GL_COLOR_ATTACHMENT0, GL_RGB8 },
+        { &rp_keys::NORMAL_MAP, GL_COLOR_ATTACHMENT1, GL_RGB16F },
+        { &rp_keys::SPECULAR_MAP, GL_COLOR_ATTACHMENT2, GL_RGBA8 },
+        { &rp_keys::EMISSION_MAP, GL_COLOR_ATTACHMENT3, GL_RGB8 },
+        { &rp_keys::DEPTH_TEXTURE, GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24 }
+    };
+}
+
 SceneGeometryPass::SceneGeometryPass()
     : RenderPass("SceneRenderPass")
 {
-    Input::subscribe(this);
-
-    // Set up framebuffer
-    m_framebuffer = std::make_unique<Framebuffer>(Screen::getWidth(), Screen::getHeight(), false);
-
-    m_framebuffer->begin();
-
-    // Albedo
-    std::shared_ptr<Texture2D> albedo = std::make_shared<Texture2D>();
-    albedo->create(Screen::getWidth(), Screen::getHeight(), GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE);
-    m_framebuffer->attachRenderTexture2D(albedo, GL_COLOR_ATTACHMENT0);
-
-    // Normal
-    std::shared_ptr<Texture2D> normal = std::make_shared<Texture2D>();
-    normal->create(Screen::getWidth(), Screen::getHeight(), GL_RGB16F, GL_RGB, GL_FLOAT);
-    m_framebuffer->attachRenderTexture2D(normal, GL_COLOR_ATTACHMENT1);
-
-    // Specular
-    std::shared_ptr<Texture2D> specular = std::make_shared<Texture2D>();
-    specular->create(Screen::getWidth(), Screen::getHeight(), GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
-    m_framebuffer->attachRenderTexture2D(specular, GL_COLOR_ATTACHMENT2);
-
-    // Emission
-    std::shared_ptr<Texture2D> emission = std::make_shared<Texture2D>();
-    emission->create(Screen::getWidth(), Screen::getHeight(), GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE);
-    m_framebuffer->attachRenderTexture2D(emission, GL_COLOR_ATTACHMENT3);
+    // Set up framebuffer - the textures are attached every frame
+    m_framebuffer = std::make_unique<Framebuffer>();
 
-    // Depth
-    m_framebuffer->attachDepthBuffer(Screen::getWidth(), Screen::getHeight());
-    m_framebuffer->setDrawBuffers();
-
-    m_framebuffer->end();
+    m_framebuffer->bind();
+    GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+    glDrawBuffers(4, drawBuffers);
+    m_framebuffer->unbind();
 
     m_shader = ResourceManager::getShader("shaders/voxelConeTracing/scenePass.vert", "shaders/voxelConeTracing/scenePass.frag");
 }
 
-void SceneGeometryPass::render() const
+void SceneGeometryPass::render()
 {
     if (RENDERING_SETTINGS.wireFrame)
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    m_framebuffer->begin();
+    m_framebuffer->begin(Screen::getWidth(), Screen::getHeight());
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -68,7 +62,12 @@ void SceneGeometryPass::render() const
     m_shader->bind();
     m_shader->setCamera(m_renderPipeline->getCamera()->view(), m_renderPipeline->getCamera()->proj());
 
-    ECSUtil::renderEntities(m_shader.get());
+    m_renderQueue.clear();
+    m_renderQueue.resetStats();
+    m_renderQueue.add(*m_renderPipeline->fetchPtr(rp_keys::CAMERA_VISIBLE_ENTITIES));
+    m_renderQueue.sort();
+    m_renderQueue.render(m_shader.get());
+    m_renderQueue.reportStats(m_name);
 
     glDisable(GL_CULL_FACE);
     m_framebuffer->end();
@@ -76,24 +75,39 @@ void SceneGeometryPass::render() const
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 
-void SceneGeometryPass::onWindowEvent(const SDL_WindowEvent& windowEvent)
+void SceneGeometryPass::declareResources(FrameGraphBuilder& builder)
 {
-    switch (windowEvent.event)
+    builder.read(rp_keys::CAMERA_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+
+    FrameGraphTextureDesc desc;
+    desc.width = uint32_t(Screen::getWidth());
+    desc.height = uint32_t(Screen::getHeight());
+
+    for (auto& gBufferTexture : G_BUFFER_TEXTURES)
     {
-    case SDL_WINDOWEVENT_RESIZED:
-        m_framebuffer->resize(static_cast<GLsizei>(windowEvent.data1), static_cast<GLsizei>(windowEvent.data2));
-        break;
-    default: break;
+        desc.format = gBufferTexture.format;
+        builder.createTexture(*gBufferTexture.key, desc);
+        builder.write(*gBufferTexture.key, FrameGraphAccess::RENDER_TARGET);
     }
 }
 
+void SceneGeometryPass::attachGBufferTextures()
+{
+    auto& frameGraph = m_renderPipeline->getFrameGraph();
+
+    m_framebuffer->bind();
+    for (auto& gBufferTexture : G_BUFFER_TEXTURES)
+        glFramebufferTexture2D(GL_FRAMEBUFFER, gBufferTexture.attachment, GL_TEXTURE_2D, frameGraph.getTexture(*gBufferTexture.key), 0);
+
+    m_framebuffer->unbind();
+}
+
 void SceneGeometryPass::update()
 {
+    attachGBufferTextures();
     render();
 
-    m_renderPipeline->put<GLuint>("DiffuseTexture", getRenderTexture(GL_COLOR_ATTACHMENT0));
-    m_renderPipeline->put<GLuint>("NormalMap", getRenderTexture(GL_COLOR_ATTACHMENT1));
-    m_renderPipeline->put<GLuint>("SpecularMap", getRenderTexture(GL_COLOR_ATTACHMENT2));
-    m_renderPipeline->put<GLuint>("EmissionMap", getRenderTexture(GL_COLOR_ATTACHMENT3));
-    m_renderPipeline->put<GLuint>("DepthTexture", getDepthTexture());
+    auto& frameGraph = m_renderPipeline->getFrameGraph();
+    for (auto& gBufferTexture : G_BUFFER_TEXTURES)
+        m_renderPipeline->put(*gBufferTexture.key, GLuint(frameGraph.getTexture(*gBufferTexture.key)));
 }
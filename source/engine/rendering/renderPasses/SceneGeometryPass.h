@@ -2,30 +2,33 @@
 #include <engine/rendering/shader/Shader.h>
 #include <engine/rendering/Framebuffer.h>
 #include <engine/rendering/architecture/RenderPass.h>
-#include "engine/input/Input.h"
+#include <engine/rendering/renderer/RenderQueue.h>
 #include <cstddef>
 
 class MeshRenderer;
 
 /**
  * Renders the scene into G-Buffers for deferred shading.
+ * The G-Buffer textures are transient textures of the frame graph: They only exist if a pass reads them and have the size of the screen.
  */
-class SceneGeometryPass : public RenderPass, public InputHandler
+class SceneGeometryPass : public RenderPass
 {
 public:
     SceneGeometryPass();
-    void render() const;
-
-    GLuint getRenderTexture(GLenum colorAttachment = GL_COLOR_ATTACHMENT0) const noexcept { return m_framebuffer->getRenderTexture(colorAttachment); }
-    GLuint getDepthTexture() const noexcept { return m_framebuffer->getDepthTexture(); }
-    std::size_t getRenderTextureCount() const noexcept { return m_framebuffer->getRenderTextureCount(); }
+    void render();
 
     void update() override;
 
-protected:
-    void onWindowEvent(const SDL_WindowEvent& windowEvent) override;
+    void declareResources(FrameGraphBuilder& builder) override;
+
+private:
+    /**
+    * The textures of the frame graph can change every frame.
+    */
+    void attachGBufferTextures();
 
 private:
     std::unique_ptr<Framebuffer> m_framebuffer;
     std::shared_ptr<Shader> m_shader;
+    RenderQueue m_renderQueue;
 };
@@ -6,6 +6,7 @@
 #include <engine/geometry/Rect.h>
 #include <engine/rendering/debug/DebugRenderer.h>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/resource/ResourceManager.h>
 #include <engine/ecs/ECS.h>
 #include <engine/rendering/lights/DirectionalLight.h>
@@ -29,10 +30,24 @@ ShadowMapPass::ShadowMapPass(uint32_t shadowMapResolution)
     m_fullscreenQuadRenderer = MeshRenderers::fullscreenQuad();
     m_quadShader = ResourceManager::getShader("shaders/simple/fullscreenQuad.vert", "shaders/simple/fullscreenQuad.frag", {"in_pos"});
     m_shader = ResourceManager::getShader("shaders/shadows/shadowMap.vert", "shaders/shadows/shadowMap.frag", {"in_pos"});
+    m_rsmShader = ResourceManager::getShader("shaders/shadows/reflectiveShadowMap.vert", "shaders/shadows/reflectiveShadowMap.frag");
+}
+
+void ShadowMapPass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.read(rp_keys::SHADOW_VISIBLE_ENTITIES, FrameGraphAccess::CPU);
+    builder.write(rp_keys::SHADOW_MAPS, FrameGraphAccess::RENDER_TARGET);
+
+    if (m_renderReflectiveShadowMaps)
+        builder.write(rp_keys::REFLECTIVE_SHADOW_MAPS, FrameGraphAccess::RENDER_TARGET);
 }
 
 void ShadowMapPass::update()
 {
+    auto visibleEntities = m_renderPipeline->fetchPtr(rp_keys::SHADOW_VISIBLE_ENTITIES);
+    m_renderQueue.resetStats();
+    m_reflectiveShadowMaps.clear();
+
     int lightCount = 0;
     for (auto dirLight : ECS::getEntitiesWithComponents<DirectionalLight, Transform>())
     {
@@ -48,46 +63,83 @@ void ShadowMapPass::update()
             continue;
         }
 
-        m_framebuffers[lightCount]->bind();
+        Framebuffer* framebuffer = m_renderReflectiveShadowMaps ? getReflectiveShadowMapFramebuffer(lightCount) : m_framebuffers[lightCount].get();
+        framebuffer->bind();
         glDisable(GL_SCISSOR_TEST);
 
-        glm::vec3 lightDir = dirLightTransform->getForward();
-        glm::vec3 lightPos = dirLightTransform->getPosition();
-
-        glm::vec3 up = glm::vec3(0.f, 1.f, 0.f);
-        if (math::nearEq(std::abs(glm::dot(lightDir, up)), 1.0f))
-            up = glm::vec3(0.0f, 0.0f, 1.0f);
-
-        glm::mat4 view = glm::lookAt(lightPos, lightPos + lightDir, up);
-
         GL::setViewport(Rect(0.f, 0.f, static_cast<float>(m_resolution), static_cast<float>(m_resolution)));
 
-        float hw = m_projectionSize.x * 0.5f;
-        float hh = m_projectionSize.y * 0.5f;
-        glm::mat4 proj = math::orthoLH(-hw, hw, -hh, hh, dirLightComponent->zNear, dirLightComponent->zFar);
+        dirLightComponent->updateShadowMatrices(dirLightTransform);
 
-        dirLightComponent->view = view;
-        dirLightComponent->proj = proj;
-        
-        render(view, proj);
+        if (m_renderReflectiveShadowMaps)
+        {
+            m_rsmShader->bind();
+            m_rsmShader->setVector("u_lightColor", dirLightComponent->color * dirLightComponent->intensity);
+            render(m_rsmShader.get(), dirLightComponent->view, dirLightComponent->proj, (*visibleEntities)[lightCount]);
+
+            ReflectiveShadowMap rsm;
+            rsm.fluxTexture = framebuffer->getRenderTexture(GL_COLOR_ATTACHMENT0);
+            rsm.normalTexture = framebuffer->getRenderTexture(GL_COLOR_ATTACHMENT1);
+            rsm.depthTexture = framebuffer->getDepthTexture();
+            rsm.viewProj = dirLightComponent->proj * dirLightComponent->view;
+            rsm.lightDirection = dirLightTransform->getForward();
+            rsm.resolution = m_resolution;
+            rsm.texelSizeWorld = dirLightComponent->shadowProjectionSize.x / m_resolution;
+            m_reflectiveShadowMaps.push_back(rsm);
+        }
+        else
+        {
+            render(m_shader.get(), dirLightComponent->view, dirLightComponent->proj, (*visibleEntities)[lightCount]);
+        }
 
-        dirLightComponent->shadowMap = getDepthTexture(lightCount);
+        dirLightComponent->shadowMap = framebuffer->getDepthTexture();
 
-        m_framebuffers[lightCount]->unbind();
+        framebuffer->unbind();
 
         lightCount++;
     }
 
     GL::setViewport(Rect(0.0f, 0.0f, static_cast<float>(Screen::getWidth()), static_cast<float>(Screen::getHeight())));
+    m_renderQueue.reportStats(m_name);
+
+    m_renderPipeline->putPtr(rp_keys::REFLECTIVE_SHADOW_MAPS, &m_reflectiveShadowMaps);
 }
 
-void ShadowMapPass::render(glm::mat4 view, glm::mat4 proj) const
+void ShadowMapPass::render(Shader* shader, const glm::mat4& view, const glm::mat4& proj, const std::vector<Entity>& entities)
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    m_shader->bind();
-    m_shader->setMatrix("u_view", view);
-    m_shader->setMatrix("u_proj", proj);
+    shader->bind();
+    shader->setMatrix("u_view", view);
+    shader->setMatrix("u_proj", proj);
+
+    m_renderQueue.clear();
+    m_renderQueue.add(entities);
+    m_renderQueue.sort();
+    m_renderQueue.render(shader);
+}
+
+Framebuffer* ShadowMapPass::getReflectiveShadowMapFramebuffer(int idx)
+{
+    if (m_rsmFramebuffers[idx])
+        return m_rsmFramebuffers[idx].get();
+
+    GLsizei resolution = static_cast<GLsizei>(m_resolution);
+    m_rsmFramebuffers[idx] = std::make_unique<Framebuffer>(resolution, resolution, false, GL_FLOAT, true);
+    m_rsmFramebuffers[idx]->bind();
+
+    // The flux is not clamped since it is scaled by the cosine term during the injection
+    auto flux = std::make_shared<Texture2D>();
+    flux->create(resolution, resolution, GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, Texture2DSettings::S_T_CLAMP_TO_BORDER_MIN_MAX_NEAREST);
+    m_rsmFramebuffers[idx]->attachRenderTexture2D(flux, GL_COLOR_ATTACHMENT0);
+
+    auto normal = std::make_shared<Texture2D>();
+    normal->create(resolution, resolution, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, Texture2DSettings::S_T_CLAMP_TO_BORDER_MIN_MAX_NEAREST);
+    m_rsmFramebuffers[idx]->attachRenderTexture2D(normal, GL_COLOR_ATTACHMENT1);
+
+    m_rsmFramebuffers[idx]->setDrawBuffers();
+    m_rsmFramebuffers[idx]->checkFramebufferStatus();
+    m_rsmFramebuffers[idx]->unbind();
 
-    ECSUtil::renderEntities(m_shader.get());
+    return m_rsmFramebuffers[idx].get();
 }
@@ -7,11 +7,27 @@
 #include <engine/util/functions.h>
 #include <engine/rendering/architecture/RenderPass.h>
 #include <engine/rendering/renderer/SimpleMeshRenderer.h>
+#include <engine/rendering/renderer/RenderQueue.h>
 #include "engine/rendering/voxelConeTracing/Globals.h"
 
 class CameraComponent;
 class MeshRenderer;
 
+/**
+* Render targets of the reflective shadow map of a directional light (see reflectiveShadowMap.frag).
+* The depth texture is the shadow map of the light.
+*/
+struct ReflectiveShadowMap
+{
+    GLuint fluxTexture{0};
+    GLuint normalTexture{0};
+    GLuint depthTexture{0};
+    glm::mat4 viewProj;
+    glm::vec3 lightDirection;
+    uint32_t resolution{0};
+    float texelSizeWorld{0.0f};
+};
+
 class ShadowMapPass : public RenderPass
 {
 public:
@@ -19,23 +35,35 @@ public:
 
     void update() override;
 
+    void declareResources(FrameGraphBuilder& builder) override;
+
+    /**
+    * Renders the flux and the normals of the surfaces seen by the lights into reflective shadow maps
+    * together with the shadow maps. The reflective shadow maps are put as "ReflectiveShadowMaps".
+    */
+    void setRenderReflectiveShadowMaps(bool enabled) { m_renderReflectiveShadowMaps = enabled; }
+
     GLuint getDepthTexture(int idx) const { return m_framebuffers[idx]->getDepthTexture(); }
 
     //GLuint getRenderTexture(int idx) const { return m_framebuffers[idx]->getRenderTexture(GL_COLOR_ATTACHMENT0); }
 
-    void setProjSize(glm::vec2 projSize) { m_projectionSize = projSize; }
-
 private:
-    void render(glm::mat4 view, glm::mat4 proj) const;
+    void render(Shader* shader, const glm::mat4& view, const glm::mat4& proj, const std::vector<Entity>& entities);
+
+    Framebuffer* getReflectiveShadowMapFramebuffer(int idx);
 
 private:
     std::unique_ptr<Framebuffer> m_framebuffers[MAX_DIR_LIGHT_COUNT];
+    std::unique_ptr<Framebuffer> m_rsmFramebuffers[MAX_DIR_LIGHT_COUNT]; // Created on first use
     std::shared_ptr<Shader> m_shader;
+    std::shared_ptr<Shader> m_rsmShader;
     std::shared_ptr<Shader> m_quadShader;
 
     std::shared_ptr<SimpleMeshRenderer> m_fullscreenQuadRenderer;
-
-    glm::vec2 m_projectionSize{37.0f, 37.0f};
+    RenderQueue m_renderQueue;
 
     uint32_t m_resolution;
+
+    bool m_renderReflectiveShadowMaps{false};
+    std::vector<ReflectiveShadowMap> m_reflectiveShadowMaps;
 };
@@ -14,41 +14,35 @@ void MeshRenderer::onShowInEditor()
 
         if (ImGui::TreeNode(materialName.c_str()))
         {
-            for (auto& pair : material->m_floatMap)
+            auto& parameters = material->m_parameters;
+            for (MaterialParameterIndex j = 0; j < parameters.size(); ++j)
             {
-                auto desc = EditableMaterialProperties::getDesc(pair.first);
-                if (desc)
-                    ImGui::SliderFloat(pair.first.c_str(), &pair.second, desc->min, desc->max);
-            }
+                auto desc = EditableMaterialProperties::getDesc(parameters[j].name);
+                if (!desc)
+                    continue;
 
-            for (auto& pair : material->m_vec2Map)
-            {
-                auto desc = EditableMaterialProperties::getDesc(pair.first);
-                if (desc)
-                    ImGui::SliderFloat2(pair.first.c_str(), &pair.second[0], desc->min, desc->max);
-            }
-
-            for (auto& pair : material->m_vec3Map)
-            {
-                auto desc = EditableMaterialProperties::getDesc(pair.first);
-                if (desc)
+                const char* name = parameters[j].name.c_str();
+                switch (parameters[j].type)
                 {
+                case MaterialParameterType::FLOAT:
+                    ImGui::SliderFloat(name, material->getParameterData<float>(j), desc->min, desc->max);
+                    break;
+                case MaterialParameterType::VEC2:
+                    ImGui::SliderFloat2(name, &(*material->getParameterData<glm::vec2>(j))[0], desc->min, desc->max);
+                    break;
+                case MaterialParameterType::VEC3:
                     if (desc->isColor)
-                        ImGui::ColorEdit3(pair.first.c_str(), &pair.second[0]);
+                        ImGui::ColorEdit3(name, &(*material->getParameterData<glm::vec3>(j))[0]);
                     else
-                        ImGui::SliderFloat3(pair.first.c_str(), &pair.second[0], desc->min, desc->max);
-                }
-            }
-
-            for (auto& pair : material->m_vec4Map)
-            {
-                auto desc = EditableMaterialProperties::getDesc(pair.first);
-                if (desc)
-                {
+                        ImGui::SliderFloat3(name, &(*material->getParameterData<glm::vec3>(j))[0], desc->min, desc->max);
+                    break;
+                case MaterialParameterType::VEC4:
                     if (desc->isColor)
-                        ImGui::ColorEdit4(pair.first.c_str(), &pair.second[0]);
+                        ImGui::ColorEdit4(name, &(*material->getParameterData<glm::vec4>(j))[0]);
                     else
-                        ImGui::SliderFloat4(pair.first.c_str(), &pair.second[0], desc->min, desc->max);
+                        ImGui::SliderFloat4(name, &(*material->getParameterData<glm::vec4>(j))[0], desc->min, desc->max);
+                    break;
+                default: break;
                 }
             }
 
@@ -122,16 +116,16 @@ void MeshRenderer::bindAndRender(SubMeshIndex subMeshIdx) const
 
     glBindVertexArray(renderData.vao);
 
-    if (subMesh.indices.size() > 0)
+    if (subMesh.getIndexCount() > 0)
     {
         assert(renderData.ibo != 0);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderData.ibo);
     }
 
-    if (subMesh.indices.size() > 0)
-        glDrawElements(renderData.renderMode, GLsizei(subMesh.indices.size()), GL_UNSIGNED_INT, nullptr);
+    if (subMesh.getIndexCount() > 0)
+        glDrawElements(renderData.renderMode, GLsizei(subMesh.getIndexCount()), GL_UNSIGNED_INT, nullptr);
     else
-        glDrawArrays(renderData.renderMode, 0, GLsizei(subMesh.vertices.size()));
+        glDrawArrays(renderData.renderMode, 0, GLsizei(subMesh.getVertexCount()));
 }
 
 void MeshRenderer::ensureIntegrity() const
@@ -10,6 +10,7 @@ class Shader;
 class MeshRenderer : public Component
 {
     friend class MeshRenderSystem;
+    friend class RenderQueue;
 public:
     MeshRenderer() { }
 
@@ -0,0 +1,196 @@
+#include "RenderQueue.h"
+#include "MeshRenderer.h"
+#include <engine/rendering/Material.h>
+#include <engine/util/ECSUtil/ECSUtil.h>
+#include <engine/util/QueryManager.h>
+#include <engine/memory/FrameArena.h>
+#include <cassert>
+#include <limits>
+
+const uint32_t RenderQueue::PASS_BITS;
+const uint32_t RenderQueue::SHADER_BITS;
+const uint32_t RenderQueue::MATERIAL_BITS;
+const uint32_t RenderQueue::VAO_BITS;
+
+void RenderQueue::clear()
+{
+    m_draws.clear();
+    m_sortEntries.clear();
+}
+
+void RenderQueue::add(Entity entity, uint8_t pass)
+{
+    auto renderer = entity.getComponent<MeshRenderer>();
+    assert(renderer);
+    renderer->ensureIntegrity();
+
+    Mesh* mesh = renderer->m_mesh.get();
+    for (SubMeshIndex i = 0; i < mesh->m_subMeshes.size(); ++i)
+    {
+        Material* material = renderer->m_materials[i].get();
+        GLuint vao = mesh->m_subMeshRenderData[i].vao;
+        ShaderProgram program = material->m_shader ? material->m_shader->getProgram() : 0;
+
+        m_sortEntries.push_back({computeKey(pass, program, material->getID(), vao), uint32_t(m_draws.size())});
+        m_draws.push_back({entity, mesh, material, i});
+    }
+}
+
+void RenderQueue::add(const std::vector<Entity>& entities, uint8_t pass)
+{
+    for (auto& e : entities)
+        add(e, pass);
+}
+
+void RenderQueue::sort()
+{
+    radixSort(m_sortEntries, m_sortTmp);
+}
+
+void RenderQueue::render(Shader* shader)
+{
+    assert(shader);
+    render(shader, false);
+}
+
+void RenderQueue::render()
+{
+    render(nullptr, true);
+}
+
+void RenderQueue::reportStats(const std::string& name) const
+{
+    // The counter names are built in the frame arena - this is called by several passes every frame
+    auto setCounter = [&name](const char* counter, uint64_t value)
+    {
+        FrameString counterName(name.c_str());
+        counterName += counter;
+        QueryManager::setCounter(counterName.c_str(), value);
+    };
+
+    setCounter(": Draws", m_stats.drawCount);
+    setCounter(": Material Binds Skipped", m_stats.materialBindsSkipped);
+    setCounter(": VAO Binds Skipped", m_stats.vaoBindsSkipped);
+
+    if (m_stats.shaderBinds + m_stats.shaderBindsSkipped > 0)
+        setCounter(": Shader Binds Skipped", m_stats.shaderBindsSkipped);
+}
+
+uint64_t RenderQueue::computeKey(uint8_t pass, ShaderProgram program, uint32_t materialID, GLuint vao)
+{
+    // Ids that don't fit are truncated - this only affects the grouping, not the correctness
+    uint64_t key = uint64_t(pass) << (SHADER_BITS + MATERIAL_BITS + VAO_BITS);
+    key |= uint64_t(program & ((1u << SHADER_BITS) - 1)) << (MATERIAL_BITS + VAO_BITS);
+    key |= uint64_t(materialID & ((1u << MATERIAL_BITS) - 1)) << VAO_BITS;
+    key |= uint64_t(vao & ((1u << VAO_BITS) - 1));
+
+    return key;
+}
+
+void RenderQueue::radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& tmp)
+{
+    tmp.resize(entries.size());
+
+    // LSD radix sort with 8 bit digits - digits which are equal for all keys are skipped
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::size_t counts[256] = {};
+        for (auto& e : entries)
+            ++counts[(e.key >> shift) & 0xFF];
+
+        if (counts[(entries.empty() ? 0 : entries[0].key >> shift) & 0xFF] == entries.size())
+            continue;
+
+        std::size_t offset = 0;
+        for (auto& c : counts)
+        {
+            std::size_t count = c;
+            c = offset;
+            offset += count;
+        }
+
+        for (auto& e : entries)
+            tmp[counts[(e.key >> shift) & 0xFF]++] = e;
+
+        entries.swap(tmp);
+    }
+}
+
+void RenderQueue::render(Shader* overrideShader, bool useMaterialShaders)
+{
+    Shader* shader = overrideShader;
+    const Material* boundMaterial = nullptr;
+    EntityID entityUniformsID = std::numeric_limits<EntityID>::max();
+    GLuint boundVAO = 0;
+
+    for (auto& sortEntry : m_sortEntries)
+    {
+        const Draw& draw = m_draws[sortEntry.drawIdx];
+
+        if (useMaterialShaders)
+        {
+            Shader* materialShader = draw.material->m_shader.get();
+            assert(materialShader);
+
+            if (materialShader != shader)
+            {
+                shader = materialShader;
+                shader->bind();
+                boundMaterial = nullptr;
+                entityUniformsID = std::numeric_limits<EntityID>::max();
+                ++m_stats.shaderBinds;
+            }
+            else
+            {
+                ++m_stats.shaderBindsSkipped;
+            }
+        }
+
+        if (draw.material != boundMaterial)
+        {
+            draw.material->use(shader);
+            boundMaterial = draw.material;
+            ++m_stats.materialBinds;
+        }
+        else
+        {
+            ++m_stats.materialBindsSkipped;
+        }
+
+        // Sub meshes of the same entity share the model matrix
+        if (draw.entity.getID() != entityUniformsID)
+        {
+            ECSUtil::setEntityUniforms(draw.entity, shader);
+            entityUniformsID = draw.entity.getID();
+        }
+
+        const Mesh::SubMesh& subMesh = draw.mesh->m_subMeshes[draw.subMeshIdx];
+        const Mesh::SubMeshRenderData& renderData = draw.mesh->m_subMeshRenderData[draw.subMeshIdx];
+        assert(renderData.vbo != 0 && renderData.vao != 0);
+
+        if (renderData.vao != boundVAO)
+        {
+            glBindVertexArray(renderData.vao);
+
+            if (subMesh.getIndexCount() > 0)
+            {
+                assert(renderData.ibo != 0);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderData.ibo);
+            }
+
+            boundVAO = renderData.vao;
+            ++m_stats.vaoBinds;
+        }
+        else
+        {
+            ++m_stats.vaoBindsSkipped;
+        }
+
+        if (subMesh.getIndexCount() > 0)
+            glDrawElements(renderData.renderMode, GLsizei(subMesh.getIndexCount()), GL_UNSIGNED_INT, nullptr);
+        else
+            glDrawArrays(renderData.renderMode, 0, GLsizei(subMesh.getVertexCount()));
+
+        ++m_stats.drawCount;
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <engine/ecs/EntityManager.h>
+#include <engine/rendering/shader/Shader.h>
+#include <engine/rendering/geometry/Mesh.h>
+
+class Material;
+
+struct RenderQueueStats
+{
+    uint64_t drawCount{0};
+    uint64_t shaderBinds{0};
+    uint64_t shaderBindsSkipped{0};
+    uint64_t materialBinds{0};
+    uint64_t materialBindsSkipped{0};
+    uint64_t vaoBinds{0};
+    uint64_t vaoBindsSkipped{0};
+};
+
+/**
+* Collects the sub mesh draws of entities with a Transform and a MeshRenderer and sorts them by a 64 bit key
+* (pass | shader | material | vertex array) such that draws with the same state are adjacent.
+* Rendering skips binding shaders, materials and vertex arrays which are already bound.
+*/
+class RenderQueue
+{
+public:
+    static const uint32_t PASS_BITS = 8;
+    static const uint32_t SHADER_BITS = 12;
+    static const uint32_t MATERIAL_BITS = 20;
+    static const uint32_t VAO_BITS = 24;
+
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t drawIdx;
+    };
+
+    void clear();
+
+    /**
+    * Adds a draw for every sub mesh of the entity. Lower passes are drawn first.
+    */
+    void add(Entity entity, uint8_t pass = 0);
+    void add(const std::vector<Entity>& entities, uint8_t pass = 0);
+
+    /**
+    * Sorts the draws by their keys with a radix sort.
+    */
+    void sort();
+
+    /**
+    * Renders all draws with the materials of the entities but with the given shader like ECSUtil::renderEntities().
+    * The shader has to be bound.
+    */
+    void render(Shader* shader);
+
+    /**
+    * Renders all draws with the shaders of their materials.
+    */
+    void render();
+
+    std::size_t size() const { return m_draws.size(); }
+
+    const RenderQueueStats& getStats() const { return m_stats; }
+
+    void resetStats() { m_stats = RenderQueueStats(); }
+
+    /**
+    * Reports the stats as QueryManager counters with the given name prefix.
+    */
+    void reportStats(const std::string& name) const;
+
+    static uint64_t computeKey(uint8_t pass, ShaderProgram program, uint32_t materialID, GLuint vao);
+
+    /**
+    * Sorts the entries by key. tmp is used as scratch memory.
+    */
+    static void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& tmp);
+
+private:
+    struct Draw
+    {
+        Entity entity;
+        Mesh* mesh;
+        Material* material;
+        SubMeshIndex subMeshIdx;
+    };
+
+    void render(Shader* overrideShader, bool useMaterialShaders);
+
+private:
+    std::vector<Draw> m_draws;
+    std::vector<SortEntry> m_sortEntries;
+    std::vector<SortEntry> m_sortTmp;
+    RenderQueueStats m_stats;
+};
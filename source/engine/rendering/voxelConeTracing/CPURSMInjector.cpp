@@ -0,0 +1,164 @@
+#include "CPURSMInjector.h"
+#include "CPUVoxelizer.h"
+#include <engine/util/math.h>
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    uint32_t packRGBA8(const glm::vec4& value)
+    {
+        return (uint32_t(value.w) & 0xFF) << 24 |
+               (uint32_t(value.z) & 0xFF) << 16 |
+               (uint32_t(value.y) & 0xFF) << 8 |
+               (uint32_t(value.x) & 0xFF);
+    }
+
+    glm::ivec3 computeVoxelFaceIndices(const glm::vec3& direction)
+    {
+        return glm::ivec3(direction.x > 0.0f ? 0 : 1,
+                          direction.y > 0.0f ? 2 : 3,
+                          direction.z > 0.0f ? 4 : 5);
+    }
+}
+
+void CPURSMInjector::inject(const ReflectiveShadowMapTexels& rsm, const std::vector<VoxelRegion>& clipRegions, int clipmapLevel,
+                            int downsampleTransitionRegionSize, int texelStride)
+{
+    assert(clipmapLevel >= 0 && clipmapLevel < int(clipRegions.size()));
+    assert(texelStride > 0);
+
+    // The uniforms of voxelization.glsl
+    const VoxelRegion& clipRegion = clipRegions[clipmapLevel];
+    float voxelSize = clipRegion.voxelSize;
+    float maxExtent = clipRegion.getExtentWorld().x;
+    glm::vec3 regionMin = clipRegion.getMinPosWorld() - math::EPSILON5;
+    glm::vec3 regionMax = clipRegion.getMaxPosWorld() + math::EPSILON5;
+    float transitionSize = downsampleTransitionRegionSize * voxelSize;
+    glm::vec3 prevRegionMin;
+    glm::vec3 prevRegionMax;
+
+    if (clipmapLevel > 0)
+    {
+        prevRegionMin = clipRegions[clipmapLevel - 1].getMinPosWorld();
+        prevRegionMax = clipRegions[clipmapLevel - 1].getMaxPosWorld();
+    }
+
+    int resolutionWithBorder = CPUVoxelizer::RESOLUTION_WITH_BORDER;
+
+    for (int y = 0; y < rsm.height; y += texelStride)
+    {
+        for (int x = 0; x < rsm.width; x += texelStride)
+        {
+            std::size_t idx = std::size_t(y) * rsm.width + x;
+            float depth = rsm.depth[idx];
+            if (depth >= 1.0f)
+                continue;
+
+            glm::vec2 uv = (glm::vec2(x, y) + 0.5f) / glm::vec2(rsm.width, rsm.height);
+            glm::vec4 posW4 = rsm.viewProjInv * glm::vec4(glm::vec3(uv, depth) * 2.0f - 1.0f, 1.0f);
+            glm::vec3 posW = glm::vec3(posW4) / posW4.w;
+
+            // failsPreConditions
+            if (clipmapLevel > 0 && glm::all(glm::greaterThanEqual(posW, prevRegionMin + transitionSize)) &&
+                                    glm::all(glm::lessThanEqual(posW, prevRegionMax - transitionSize)))
+                continue;
+
+            if (glm::any(glm::lessThan(posW, regionMin)) || glm::any(glm::greaterThan(posW, regionMax)))
+                continue;
+
+            // computeImageCoords
+            float c = voxelSize * 0.25f;
+            glm::vec3 clampedPosW = glm::clamp(posW, regionMin + c, regionMax - c);
+            glm::vec3 clipCoords = glm::fract(clampedPosW / maxExtent);
+            glm::ivec3 imageCoords = (glm::ivec3(clipCoords * float(VOXEL_RESOLUTION)) & (VOXEL_RESOLUTION - 1)) + CPUVoxelizer::BORDER_WIDTH;
+            imageCoords.y += resolutionWithBorder * clipmapLevel;
+
+            glm::vec3 flux = rsm.flux[idx];
+            glm::vec4 normal = rsm.normal[idx];
+
+            // Emitted light
+            if (normal.w > 0.0f)
+            {
+                glm::vec4 emission(glm::clamp(flux, 0.0f, 1.0f), 1.0f);
+                for (int face = 0; face < FACE_COUNT; ++face)
+                    storeAtomicRGBA8Avg(imageCoords + glm::ivec3(resolutionWithBorder * face, 0, 0), emission);
+
+                continue;
+            }
+
+            glm::vec3 n = glm::normalize(glm::vec3(normal) * 2.0f - 1.0f);
+            glm::vec3 radiance = glm::clamp(std::max(0.0f, glm::dot(n, -rsm.lightDirection)) * flux, 0.0f, 1.0f);
+
+            if (glm::all(glm::equal(radiance, glm::vec3(0.0f))))
+                continue;
+
+            glm::ivec3 faceIndices = computeVoxelFaceIndices(-n);
+            glm::vec3 weight = glm::abs(n);
+            storeAtomicRGBA8Avg(imageCoords + glm::ivec3(faceIndices.x * resolutionWithBorder, 0, 0), glm::vec4(radiance * weight.x, 1.0f));
+            storeAtomicRGBA8Avg(imageCoords + glm::ivec3(faceIndices.y * resolutionWithBorder, 0, 0), glm::vec4(radiance * weight.y, 1.0f));
+            storeAtomicRGBA8Avg(imageCoords + glm::ivec3(faceIndices.z * resolutionWithBorder, 0, 0), glm::vec4(radiance * weight.z, 1.0f));
+        }
+    }
+}
+
+uint32_t CPURSMInjector::getRadiance(int clipmapLevel, int face, const glm::ivec3& voxelPos) const
+{
+    auto it = m_texels.find(texelIndex(CPUVoxelizer::getImageCoords(clipmapLevel, face, voxelPos)));
+    return it != m_texels.end() ? it->second : 0;
+}
+
+std::size_t CPURSMInjector::countLitVoxels(const VoxelRegion& region, int clipmapLevel) const
+{
+    std::size_t count = 0;
+    glm::ivec3 maxPos = region.getMaxPos();
+
+    for (int z = region.minPos.z; z < maxPos.z; ++z)
+        for (int y = region.minPos.y; y < maxPos.y; ++y)
+            for (int x = region.minPos.x; x < maxPos.x; ++x)
+            {
+                for (int face = 0; face < FACE_COUNT; ++face)
+                {
+                    if ((getRadiance(clipmapLevel, face, glm::ivec3(x, y, z)) >> 24) > 0)
+                    {
+                        ++count;
+                        break;
+                    }
+                }
+            }
+
+    return count;
+}
+
+int CPURSMInjector::computeTexelStride(float voxelSize, float texelSizeWorld)
+{
+    return std::max(1, int(voxelSize / (2.0f * texelSizeWorld)));
+}
+
+glm::vec4 CPURSMInjector::unpackRGBA8(uint32_t value)
+{
+    return glm::vec4(float(value & 0xFF), float((value >> 8) & 0xFF), float((value >> 16) & 0xFF), float((value >> 24) & 0xFF));
+}
+
+std::size_t CPURSMInjector::texelIndex(const glm::ivec3& imageCoords) const
+{
+    glm::ivec3 size = CPUVoxelizer::getImageSize();
+    return (std::size_t(imageCoords.z) * size.y + imageCoords.y) * size.x + imageCoords.x;
+}
+
+void CPURSMInjector::storeAtomicRGBA8Avg(const glm::ivec3& imageCoords, glm::vec4 value)
+{
+    // Same arithmetic as imageAtomicRGBA8Avg - the first sample is stored as is
+    uint32_t& storedValue = m_texels[texelIndex(imageCoords)];
+    value = glm::vec4(glm::vec3(value) * 255.0f, value.w);
+
+    if (storedValue == 0)
+    {
+        storedValue = packRGBA8(value);
+        return;
+    }
+
+    glm::vec4 curValue = unpackRGBA8(storedValue);
+    curValue = glm::vec4(glm::vec3(curValue) * curValue.w, curValue.w) + value;
+    storedValue = packRGBA8(glm::vec4(glm::vec3(curValue) / curValue.w, curValue.w));
+}
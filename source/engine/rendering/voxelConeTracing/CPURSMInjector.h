@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Globals.h"
+#include "VoxelRegion.h"
+
+/**
+* Texels of a reflective shadow map as they are stored in the render targets of ShadowMapPass (reflectiveShadowMap.frag).
+*/
+struct ReflectiveShadowMapTexels
+{
+    int width{0};
+    int height{0};
+    std::vector<float> depth; // Window space depth - 1 where no surface was rendered
+    std::vector<glm::vec3> flux;
+    std::vector<glm::vec4> normal; // xyz: world space normal mapped to [0, 1], w: 1 if the flux is emitted light
+    glm::mat4 viewProjInv;
+    glm::vec3 lightDirection;
+};
+
+/**
+* CPU reference implementation of the reflective shadow map scatter (injectLightByReflectiveShadowMaps.comp).
+*
+* The texels are addressed like in the GPU radiance clipmap (see CPUVoxelizer) but only the written texels are stored.
+* Every texel is a packed RGBA8 value that is averaged like imageAtomicRGBA8Avg does: rgb is the average and alpha
+* counts the samples.
+*/
+class CPURSMInjector
+{
+public:
+    void clear() { m_texels.clear(); }
+
+    /**
+    * Scatters every texelStride-th texel (in both directions) of the reflective shadow map into the clip region of the level.
+    * Texels inside of the downsample region of the finer level are skipped like in the voxelization.
+    */
+    void inject(const ReflectiveShadowMapTexels& rsm, const std::vector<VoxelRegion>& clipRegions, int clipmapLevel,
+                int downsampleTransitionRegionSize, int texelStride = 1);
+
+    /**
+    * Returns the packed RGBA8 radiance of the voxel face at the given position in voxel coordinates.
+    */
+    uint32_t getRadiance(int clipmapLevel, int face, const glm::ivec3& voxelPos) const;
+
+    /**
+    * Returns the number of voxels inside of the region with at least one sample on any face.
+    */
+    std::size_t countLitVoxels(const VoxelRegion& region, int clipmapLevel) const;
+
+    /**
+    * Returns the stride between the sampled texels such that 2 to 4 samples per axis fall into a voxel of the given size.
+    * Keeps the scatter cost of coarse levels low and the sample count of a voxel below the 255 samples the RGBA8
+    * average can count. The GPU injection uses the same stride.
+    */
+    static int computeTexelStride(float voxelSize, float texelSizeWorld);
+
+    static glm::vec4 unpackRGBA8(uint32_t value);
+
+private:
+    std::size_t texelIndex(const glm::ivec3& imageCoords) const;
+
+    void storeAtomicRGBA8Avg(const glm::ivec3& imageCoords, glm::vec4 value);
+
+private:
+    std::unordered_map<std::size_t, uint32_t> m_texels; // Written texels by their index in the GPU radiance image
+};
@@ -0,0 +1,121 @@
+#include "CPURadianceAccumulation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    uint32_t packRGBA8(const glm::vec4& value)
+    {
+        return (uint32_t(value.w) & 0xFF) << 24 |
+               (uint32_t(value.z) & 0xFF) << 16 |
+               (uint32_t(value.y) & 0xFF) << 8 |
+               (uint32_t(value.x) & 0xFF);
+    }
+
+    glm::vec4 unpackRGBA8(uint32_t value)
+    {
+        return glm::vec4(float(value & 0xFF), float((value >> 8) & 0xFF), float((value >> 16) & 0xFF), float((value >> 24) & 0xFF));
+    }
+
+    /**
+    * An invocation executing the imageAtomicCompSwap loop of imageAtomicRGBA8Avg.
+    */
+    struct CASInvocation
+    {
+        glm::vec4 value;
+        uint32_t newValue;
+        uint32_t prevStoredValue{0};
+        int iteration{0};
+        bool done{false};
+    };
+}
+
+RadianceAccumulationResult CPURadianceAccumulation::accumulateRGBA8Avg(const std::vector<glm::vec3>& fragments, std::size_t waveSize)
+{
+    RadianceAccumulationResult result;
+    uint32_t storedValue = 0;
+    std::vector<CASInvocation> wave;
+
+    for (std::size_t waveStart = 0; waveStart < fragments.size(); waveStart += waveSize)
+    {
+        std::size_t waveEnd = std::min(waveStart + waveSize, fragments.size());
+        wave.clear();
+        for (std::size_t i = waveStart; i < waveEnd; ++i)
+        {
+            CASInvocation invocation;
+            invocation.value = glm::vec4(glm::clamp(fragments[i], 0.0f, 1.0f) * 255.0f, 1.0f);
+            invocation.newValue = packRGBA8(invocation.value);
+            wave.push_back(invocation);
+        }
+
+        std::size_t activeCount = wave.size();
+        while (activeCount > 0)
+        {
+            for (auto& invocation : wave)
+            {
+                if (invocation.done)
+                    continue;
+
+                // imageAtomicCompSwap
+                ++result.atomicOperationCount;
+                uint32_t curStoredValue = storedValue;
+                if (curStoredValue == invocation.prevStoredValue)
+                    storedValue = invocation.newValue;
+
+                if (curStoredValue == invocation.prevStoredValue || invocation.iteration >= MAX_CAS_ITERATIONS)
+                {
+                    if (curStoredValue != invocation.prevStoredValue)
+                        ++result.droppedFragmentCount;
+
+                    invocation.done = true;
+                    --activeCount;
+                    continue;
+                }
+
+                invocation.prevStoredValue = curStoredValue;
+                glm::vec4 curValue = unpackRGBA8(curStoredValue);
+                curValue = glm::vec4(glm::vec3(curValue) * curValue.w, curValue.w) + invocation.value;
+                invocation.newValue = packRGBA8(glm::vec4(glm::vec3(curValue) / curValue.w, curValue.w));
+                ++invocation.iteration;
+            }
+        }
+    }
+
+    result.radiance = glm::vec3(unpackRGBA8(storedValue)) / 255.0f;
+    return result;
+}
+
+RadianceAccumulationResult CPURadianceAccumulation::accumulateFixedPoint(const std::vector<glm::vec3>& fragments)
+{
+    RadianceAccumulationResult result;
+    uint32_t sum[3] = {0, 0, 0};
+    uint32_t sampleCount = 0;
+
+    for (auto& fragment : fragments)
+    {
+        glm::vec3 value = glm::clamp(fragment, 0.0f, 1.0f) * float(FIXED_POINT_SCALE);
+        for (int c = 0; c < 3; ++c)
+            sum[c] += uint32_t(std::round(value[c]));
+
+        ++sampleCount;
+        result.atomicOperationCount += 4;
+    }
+
+    // The resolve stores the average into the RGBA8 clipmap which rounds to the nearest representable value
+    if (sampleCount > 0)
+    {
+        for (int c = 0; c < 3; ++c)
+            result.radiance[c] = std::round(float(sum[c]) / (float(sampleCount) * FIXED_POINT_SCALE) * 255.0f) / 255.0f;
+    }
+
+    return result;
+}
+
+glm::vec3 CPURadianceAccumulation::computeReference(const std::vector<glm::vec3>& fragments)
+{
+    glm::dvec3 sum(0.0);
+    for (auto& fragment : fragments)
+        sum += glm::dvec3(glm::clamp(fragment, 0.0f, 1.0f));
+
+    return fragments.empty() ? glm::vec3(0.0f) : glm::vec3(sum / double(fragments.size()));
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+struct RadianceAccumulationResult
+{
+    glm::vec3 radiance{0.0f}; // Resolved average as it ends up in the RGBA8 radiance clipmap
+    std::size_t atomicOperationCount{0};
+    std::size_t droppedFragmentCount{0}; // Fragments that gave up before their contribution was stored
+};
+
+/**
+* CPU simulation of the atomic accumulation of fragment radiance into a single voxel face.
+*
+* The fragments are replayed in waves of invocations that execute concurrently and hit the same texel. The atomics on
+* a texel are serialized: In every round each active invocation of the wave issues its atomic operation in invocation order.
+*/
+class CPURadianceAccumulation
+{
+public:
+    // Has to match imageAtomicRGBA8Avg in atomicOperations.glsl
+    static const int MAX_CAS_ITERATIONS = 100;
+
+    // Has to match RADIANCE_FIXED_POINT_SCALE in atomicOperations.glsl
+    static const uint32_t FIXED_POINT_SCALE = 1 << 16;
+
+    /**
+    * Replays the imageAtomicCompSwap loop of imageAtomicRGBA8Avg. Only one invocation of a wave succeeds per round,
+    * the others retry with the returned value until they run out of iterations.
+    */
+    static RadianceAccumulationResult accumulateRGBA8Avg(const std::vector<glm::vec3>& fragments, std::size_t waveSize);
+
+    /**
+    * Replays imageAtomicFixedPointAdd followed by the resolve pass. Every fragment costs 4 imageAtomicAdd operations
+    * regardless of the contention.
+    */
+    static RadianceAccumulationResult accumulateFixedPoint(const std::vector<glm::vec3>& fragments);
+
+    /**
+    * The exact average of the fragments.
+    */
+    static glm::vec3 computeReference(const std::vector<glm::vec3>& fragments);
+};
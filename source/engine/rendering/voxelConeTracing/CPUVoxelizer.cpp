@@ -0,0 +1,331 @@
+#include "CPUVoxelizer.h"
+#include <engine/geometry/intersection.h>
+#include <engine/util/ThreadPool.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CPU_VOXELIZER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+const int CPUVoxelizer::BORDER_WIDTH;
+const int CPUVoxelizer::RESOLUTION_WITH_BORDER;
+const int CPUVoxelizer::BRICK_SIZE;
+
+namespace
+{
+    // Toroidal addressing masks the voxel coordinates like the shaders do
+    static_assert((VOXEL_RESOLUTION & (VOXEL_RESOLUTION - 1)) == 0, "The voxel resolution has to be a power of two.");
+
+    const std::size_t TRIANGLES_PER_JOB = 4096;
+    const std::size_t BRICKS_PER_JOB = 4;
+
+    const uint8_t OPAQUE = 255;
+}
+
+CPUVoxelizer::CPUVoxelizer()
+{
+    glm::ivec3 size = getImageSize();
+    m_data.resize(std::size_t(size.x) * size.y * size.z, 0);
+}
+
+void CPUVoxelizer::clear()
+{
+    std::fill(m_data.begin(), m_data.end(), uint8_t(0));
+}
+
+void CPUVoxelizer::clear(const VoxelRegion& region, int clipmapLevel)
+{
+    glm::ivec3 maxPos = region.getMaxPos();
+
+    for (int z = region.minPos.z; z < maxPos.z; ++z)
+        for (int y = region.minPos.y; y < maxPos.y; ++y)
+            for (int x = region.minPos.x; x < maxPos.x; ++x)
+            {
+                std::size_t idx = texelIndex(getImageCoords(clipmapLevel, 0, glm::ivec3(x, y, z)));
+                for (int face = 0; face < FACE_COUNT; ++face)
+                    m_data[idx + face * RESOLUTION_WITH_BORDER] = 0;
+            }
+}
+
+std::size_t CPUVoxelizer::voxelize(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+                                   const VoxelRegion& region, int clipmapLevel, ThreadPool* threadPool)
+{
+    assert(clipmapLevel >= 0 && clipmapLevel < CLIP_REGION_COUNT);
+    assert(glm::all(glm::lessThanEqual(region.extent, glm::ivec3(VOXEL_RESOLUTION))));
+
+    if (glm::any(glm::lessThanEqual(region.extent, glm::ivec3(0))))
+        return 0;
+
+    float voxelSize = region.voxelSize;
+    glm::ivec3 regionMin = region.minPos;
+    glm::ivec3 regionMax = region.getMaxPos() - 1;
+    std::size_t triangleCount = indices.size() / 3;
+
+    // Compute the voxel ranges of the triangles clamped to the region
+    m_triangleRanges.resize(triangleCount);
+    auto computeRanges = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const glm::vec3& v0 = vertices[indices[3 * i]];
+            const glm::vec3& v1 = vertices[indices[3 * i + 1]];
+            const glm::vec3& v2 = vertices[indices[3 * i + 2]];
+            TriangleRange& range = m_triangleRanges[i];
+
+            // Degenerated triangles are not rasterized on the GPU either
+            glm::vec3 n = glm::cross(v1 - v0, v2 - v0);
+            if (glm::dot(n, n) == 0.0f)
+            {
+                range.minPos = glm::ivec3(1);
+                range.maxPos = glm::ivec3(0);
+                continue;
+            }
+
+            // ceil - 1 includes voxels that only touch the triangle bbox, BBox::overlaps is inclusive
+            range.minPos = glm::max(glm::ivec3(glm::ceil(glm::min(glm::min(v0, v1), v2) / voxelSize)) - 1, regionMin);
+            range.maxPos = glm::min(glm::ivec3(glm::floor(glm::max(glm::max(v0, v1), v2) / voxelSize)), regionMax);
+        }
+    };
+
+    if (threadPool)
+        threadPool->parallelFor(triangleCount, TRIANGLES_PER_JOB, computeRanges);
+    else
+        computeRanges(0, triangleCount);
+
+    // Bin the triangles into the bricks they overlap (counting sort)
+    glm::ivec3 brickCount = (region.extent + BRICK_SIZE - 1) / BRICK_SIZE;
+    std::size_t brickTotal = std::size_t(brickCount.x) * brickCount.y * brickCount.z;
+    auto brickIndex = [&brickCount](int x, int y, int z) { return (std::size_t(z) * brickCount.y + y) * brickCount.x + x; };
+
+    m_brickOffsets.assign(brickTotal + 1, 0);
+    std::size_t overlapCount = 0;
+
+    auto forEachBrick = [&](const TriangleRange& range, auto func)
+    {
+        glm::ivec3 b0 = (range.minPos - regionMin) / BRICK_SIZE;
+        glm::ivec3 b1 = (range.maxPos - regionMin) / BRICK_SIZE;
+
+        for (int z = b0.z; z <= b1.z; ++z)
+            for (int y = b0.y; y <= b1.y; ++y)
+                for (int x = b0.x; x <= b1.x; ++x)
+                    func(brickIndex(x, y, z));
+    };
+
+    for (const auto& range : m_triangleRanges)
+    {
+        if (glm::any(glm::greaterThan(range.minPos, range.maxPos)))
+            continue;
+
+        ++overlapCount;
+        forEachBrick(range, [this](std::size_t brickIdx) { ++m_brickOffsets[brickIdx + 1]; });
+    }
+
+    for (std::size_t i = 1; i <= brickTotal; ++i)
+        m_brickOffsets[i] += m_brickOffsets[i - 1];
+
+    m_brickTriangles.resize(m_brickOffsets[brickTotal]);
+
+    for (uint32_t i = 0; i < m_triangleRanges.size(); ++i)
+    {
+        const auto& range = m_triangleRanges[i];
+        if (glm::any(glm::greaterThan(range.minPos, range.maxPos)))
+            continue;
+
+        forEachBrick(range, [this, i](std::size_t brickIdx) { m_brickTriangles[m_brickOffsets[brickIdx]++] = i; });
+    }
+
+    // Filling moved every offset to the start of the next brick
+    for (std::size_t i = brickTotal; i > 0; --i)
+        m_brickOffsets[i] = m_brickOffsets[i - 1];
+    m_brickOffsets[0] = 0;
+
+    m_nonEmptyBricks.clear();
+    for (uint32_t i = 0; i < brickTotal; ++i)
+        if (m_brickOffsets[i + 1] > m_brickOffsets[i])
+            m_nonEmptyBricks.push_back(i);
+
+    // Bricks don't share voxels and can thus be voxelized in parallel
+    auto voxelizeBricks = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            uint32_t brickIdx = m_nonEmptyBricks[i];
+            glm::ivec3 brick(brickIdx % brickCount.x, (brickIdx / brickCount.x) % brickCount.y, brickIdx / (brickCount.x * brickCount.y));
+            glm::ivec3 brickMin = regionMin + brick * BRICK_SIZE;
+            glm::ivec3 brickMax = glm::min(brickMin + BRICK_SIZE - 1, regionMax);
+            voxelizeBrick(vertices, indices, brickMin, brickMax, brickIdx, voxelSize, clipmapLevel);
+        }
+    };
+
+    if (threadPool)
+        threadPool->parallelFor(m_nonEmptyBricks.size(), BRICKS_PER_JOB, voxelizeBricks);
+    else
+        voxelizeBricks(0, m_nonEmptyBricks.size());
+
+    return overlapCount;
+}
+
+std::size_t CPUVoxelizer::voxelize(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+                                   const std::vector<VoxelRegion>& clipRegions, ThreadPool* threadPool)
+{
+    assert(clipRegions.size() <= CLIP_REGION_COUNT);
+    clear();
+
+    std::size_t overlapCount = 0;
+    for (std::size_t i = 0; i < clipRegions.size(); ++i)
+        overlapCount += voxelize(vertices, indices, clipRegions[i], int(i), threadPool);
+
+    return overlapCount;
+}
+
+void CPUVoxelizer::voxelizeBrick(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+                                 const glm::ivec3& brickMin, const glm::ivec3& brickMax, uint32_t brickIdx,
+                                 float voxelSize, int clipmapLevel)
+{
+    intersection::TriangleBBox t;
+    glm::vec3 dp(voxelSize);
+
+    for (uint32_t i = m_brickOffsets[brickIdx]; i < m_brickOffsets[brickIdx + 1]; ++i)
+    {
+        uint32_t triangleIdx = m_brickTriangles[i];
+        const TriangleRange& range = m_triangleRanges[triangleIdx];
+        glm::ivec3 minPos = glm::max(range.minPos, brickMin);
+        glm::ivec3 maxPos = glm::min(range.maxPos, brickMax);
+
+        t.setTriangle(vertices[indices[3 * triangleIdx]], vertices[indices[3 * triangleIdx + 1]], vertices[indices[3 * triangleIdx + 2]]);
+        t.setBBoxScale(dp);
+
+        const glm::vec3& triMin = t.triangleBBox.min();
+        const glm::vec3& triMax = t.triangleBBox.max();
+
+#ifdef CPU_VOXELIZER_USE_SSE
+        // Same operations in the same order as TriangleBBox::test to get identical results
+        __m128 voxelSize4 = _mm_set1_ps(voxelSize);
+        __m128 triMinX = _mm_set1_ps(triMin.x);
+        __m128 triMaxX = _mm_set1_ps(triMax.x);
+        __m128 nX = _mm_set1_ps(t.n.x);
+        __m128 d1 = _mm_set1_ps(t.d1);
+        __m128 d2 = _mm_set1_ps(t.d2);
+        __m128 nXY0 = _mm_set1_ps(t.n_xy_e0.x);
+        __m128 nXY1 = _mm_set1_ps(t.n_xy_e1.x);
+        __m128 nXY2 = _mm_set1_ps(t.n_xy_e2.x);
+        __m128 dXY0 = _mm_set1_ps(t.d_xy_e0);
+        __m128 dXY1 = _mm_set1_ps(t.d_xy_e1);
+        __m128 dXY2 = _mm_set1_ps(t.d_xy_e2);
+        __m128 nZX0 = _mm_set1_ps(t.n_zx_e0.y);
+        __m128 nZX1 = _mm_set1_ps(t.n_zx_e1.y);
+        __m128 nZX2 = _mm_set1_ps(t.n_zx_e2.y);
+        __m128 dZX0 = _mm_set1_ps(t.d_zx_e0);
+        __m128 dZX1 = _mm_set1_ps(t.d_zx_e1);
+        __m128 dZX2 = _mm_set1_ps(t.d_zx_e2);
+        __m128 zero = _mm_setzero_ps();
+#endif
+
+        for (int z = minPos.z; z <= maxPos.z; ++z)
+        {
+            float pz = float(z) * voxelSize;
+            if (pz > triMax.z || pz + voxelSize < triMin.z)
+                continue;
+
+            for (int y = minPos.y; y <= maxPos.y; ++y)
+            {
+                float py = float(y) * voxelSize;
+                if (py > triMax.y || py + voxelSize < triMin.y)
+                    continue;
+
+#ifdef CPU_VOXELIZER_USE_SSE
+                // The YZ projection doesn't depend on x
+                glm::vec2 p_yz(py, pz);
+                if ((glm::dot(t.n_yz_e0, p_yz) + t.d_yz_e0 < 0.0f) ||
+                    (glm::dot(t.n_yz_e1, p_yz) + t.d_yz_e1 < 0.0f) ||
+                    (glm::dot(t.n_yz_e2, p_yz) + t.d_yz_e2 < 0.0f))
+                    continue;
+
+                __m128 nYpY = _mm_set1_ps(t.n.y * py);
+                __m128 nZpZ = _mm_set1_ps(t.n.z * pz);
+                __m128 nXYpY0 = _mm_set1_ps(t.n_xy_e0.y * py);
+                __m128 nXYpY1 = _mm_set1_ps(t.n_xy_e1.y * py);
+                __m128 nXYpY2 = _mm_set1_ps(t.n_xy_e2.y * py);
+                __m128 nZXpZ0 = _mm_set1_ps(t.n_zx_e0.x * pz);
+                __m128 nZXpZ1 = _mm_set1_ps(t.n_zx_e1.x * pz);
+                __m128 nZXpZ2 = _mm_set1_ps(t.n_zx_e2.x * pz);
+
+                // Test 4 voxels of the row at once
+                for (int x = minPos.x; x <= maxPos.x; x += 4)
+                {
+                    __m128 px = _mm_mul_ps(_mm_setr_ps(float(x), float(x + 1), float(x + 2), float(x + 3)), voxelSize4);
+                    __m128 inside = _mm_and_ps(_mm_cmple_ps(px, triMaxX), _mm_cmpge_ps(_mm_add_ps(px, voxelSize4), triMinX));
+
+                    __m128 np = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nX, px), nYpY), nZpZ);
+                    inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_mul_ps(_mm_add_ps(np, d1), _mm_add_ps(np, d2)), zero));
+
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nXY0, px), nXYpY0), dXY0), zero));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nXY1, px), nXYpY1), dXY1), zero));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nXY2, px), nXYpY2), dXY2), zero));
+
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(nZXpZ0, _mm_mul_ps(nZX0, px)), dZX0), zero));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(nZXpZ1, _mm_mul_ps(nZX1, px)), dZX1), zero));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(nZXpZ2, _mm_mul_ps(nZX2, px)), dZX2), zero));
+
+                    int mask = _mm_movemask_ps(inside) & ((1 << std::min(maxPos.x - x + 1, 4)) - 1);
+                    for (int lane = 0; mask != 0; ++lane, mask >>= 1)
+                        if (mask & 1)
+                            setOpaque(glm::ivec3(x + lane, y, z), clipmapLevel);
+                }
+#else
+                for (int x = minPos.x; x <= maxPos.x; ++x)
+                {
+                    glm::vec3 p = glm::vec3(x, y, z) * voxelSize;
+                    if (t.test(BBox(p, p + dp)))
+                        setOpaque(glm::ivec3(x, y, z), clipmapLevel);
+                }
+#endif
+            }
+        }
+    }
+}
+
+void CPUVoxelizer::setOpaque(const glm::ivec3& voxelPos, int clipmapLevel)
+{
+    // The shader writes the same opacity to all faces
+    std::size_t idx = texelIndex(getImageCoords(clipmapLevel, 0, voxelPos));
+    for (int face = 0; face < FACE_COUNT; ++face)
+        m_data[idx + face * RESOLUTION_WITH_BORDER] = OPAQUE;
+}
+
+uint8_t CPUVoxelizer::getOpacity(int clipmapLevel, int face, const glm::ivec3& voxelPos) const
+{
+    return m_data[texelIndex(getImageCoords(clipmapLevel, face, voxelPos))];
+}
+
+std::size_t CPUVoxelizer::countOpaqueVoxels(const VoxelRegion& region, int clipmapLevel) const
+{
+    std::size_t count = 0;
+    glm::ivec3 maxPos = region.getMaxPos();
+
+    for (int z = region.minPos.z; z < maxPos.z; ++z)
+        for (int y = region.minPos.y; y < maxPos.y; ++y)
+            for (int x = region.minPos.x; x < maxPos.x; ++x)
+                if (getOpacity(clipmapLevel, 0, glm::ivec3(x, y, z)) != 0)
+                    ++count;
+
+    return count;
+}
+
+glm::ivec3 CPUVoxelizer::getImageCoords(int clipmapLevel, int face, const glm::ivec3& voxelPos)
+{
+    // Equal to VoxelRegion::getMinPosImage for a power of two resolution
+    glm::ivec3 p = (voxelPos & (VOXEL_RESOLUTION - 1)) + BORDER_WIDTH;
+    p.x += face * RESOLUTION_WITH_BORDER;
+    p.y += clipmapLevel * RESOLUTION_WITH_BORDER;
+    return p;
+}
+
+std::size_t CPUVoxelizer::texelIndex(const glm::ivec3& imageCoords) const
+{
+    glm::ivec3 size = getImageSize();
+    return (std::size_t(imageCoords.z) * size.y + imageCoords.y) * size.x + imageCoords.x;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Globals.h"
+#include "VoxelRegion.h"
+
+class ThreadPool;
+
+/**
+* CPU reference implementation of the 6-face opacity voxelization (conservative6SeparatingOpacityVoxelization).
+* Can be used to validate or bake voxel data without a GPU.
+*
+* The result has the layout of the GPU opacity clipmap: the faces are stacked along x, the clipmap levels along y
+* and every level has a border of BORDER_WIDTH texels on each side. Voxels are addressed toroidally.
+* One byte is stored per texel because all RGBA channels of the GPU opacity are equal.
+*
+* The triangles are binned into bricks of BRICK_SIZE^3 voxels and the bricks are voxelized in parallel.
+* Thus every voxel is written by exactly one thread.
+*/
+class CPUVoxelizer
+{
+public:
+    static const int BORDER_WIDTH = 1;
+    static const int RESOLUTION_WITH_BORDER = VOXEL_RESOLUTION + 2 * BORDER_WIDTH;
+    static const int BRICK_SIZE = 8;
+
+    CPUVoxelizer();
+
+    /**
+    * Clears all levels including the borders.
+    */
+    void clear();
+
+    /**
+    * Clears the region of the given clipmap level on all faces.
+    */
+    void clear(const VoxelRegion& region, int clipmapLevel);
+
+    /**
+    * Voxelizes the triangles (in world space) into the region of the given clipmap level.
+    * The region has to be inside of the clip region of that level. Existing voxels are not cleared.
+    * Returns the number of triangles that overlap the region.
+    */
+    std::size_t voxelize(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+                         const VoxelRegion& region, int clipmapLevel, ThreadPool* threadPool = nullptr);
+
+    /**
+    * Clears everything and voxelizes the triangles into all clip regions.
+    * Returns the summed number of triangles that overlap the clip regions.
+    */
+    std::size_t voxelize(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+                         const std::vector<VoxelRegion>& clipRegions, ThreadPool* threadPool = nullptr);
+
+    /**
+    * Returns the opacity of the voxel at the given position in voxel coordinates. 255 is opaque.
+    */
+    uint8_t getOpacity(int clipmapLevel, int face, const glm::ivec3& voxelPos) const;
+
+    /**
+    * Returns the number of opaque voxels inside of the region.
+    */
+    std::size_t countOpaqueVoxels(const VoxelRegion& region, int clipmapLevel) const;
+
+    /**
+    * Returns the texel coordinates of the voxel in the clipmap image using toroidal addressing.
+    */
+    static glm::ivec3 getImageCoords(int clipmapLevel, int face, const glm::ivec3& voxelPos);
+
+    static glm::ivec3 getImageSize() { return glm::ivec3(RESOLUTION_WITH_BORDER * FACE_COUNT, RESOLUTION_WITH_BORDER * CLIP_REGION_COUNT, RESOLUTION_WITH_BORDER); }
+
+    /**
+    * The texels ordered like glGetTexImage returns them: x first, then y, then z.
+    */
+    const std::vector<uint8_t>& getData() const { return m_data; }
+
+private:
+    struct TriangleRange
+    {
+        glm::ivec3 minPos;
+        glm::ivec3 maxPos; // Inclusive
+    };
+
+    std::size_t texelIndex(const glm::ivec3& imageCoords) const;
+
+    void voxelizeBrick(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+                       const glm::ivec3& brickMin, const glm::ivec3& brickMax, uint32_t brickIdx,
+                       float voxelSize, int clipmapLevel);
+
+    void setOpaque(const glm::ivec3& voxelPos, int clipmapLevel);
+
+private:
+    std::vector<uint8_t> m_data;
+
+    // Binning state of the current voxelize() call - kept to avoid reallocations
+    std::vector<TriangleRange> m_triangleRanges;
+    std::vector<uint32_t> m_brickOffsets;
+    std::vector<uint32_t> m_brickTriangles;
+    std::vector<uint32_t> m_nonEmptyBricks;
+};
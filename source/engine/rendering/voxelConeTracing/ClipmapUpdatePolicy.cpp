@@ -1,30 +1,100 @@
 #include "ClipmapUpdatePolicy.h"
+#include "Globals.h"
 #include <math.h>
 #include <assert.h>
+#include <algorithm>
+#include <numeric>
+
+constexpr double ClipmapUpdatePolicy::DEFAULT_LEVEL_COST;
+constexpr double ClipmapUpdatePolicy::COST_SMOOTHING;
+constexpr double ClipmapUpdatePolicy::DIRTY_WEIGHT;
+
+ClipmapUpdatePolicy::ClipmapUpdatePolicy(Type type, int clipRegionCount)
+    : m_type(type),
+      m_clipRegionCount(clipRegionCount),
+      m_framesSinceUpdate(clipRegionCount, 0),
+      m_dirtyVoxels(clipRegionCount, 0),
+      m_voxelizationCosts(clipRegionCount, DEFAULT_LEVEL_COST),
+      m_downsamplingCosts(clipRegionCount, 0.0)
+{
+    assert(clipRegionCount <= 32);
+}
 
 void ClipmapUpdatePolicy::update()
 {
+    // The levels of the last frame have been updated including the voxels that changed during that frame
+    for (int level : m_levelsScheduledForUpdate)
+    {
+        m_framesSinceUpdate[level] = 0;
+        m_dirtyVoxels[level] = 0;
+    }
+
+    for (auto& frames : m_framesSinceUpdate)
+        ++frames;
+
     m_levelsScheduledForUpdate.clear();
 
     switch (m_type)
     {
-    case Type::ALL_PER_FRAME: 
+    case Type::ALL_PER_FRAME:
         updateAll();
         break;
-    case Type::ONE_PER_FRAME_PRIORITY: 
+    case Type::ONE_PER_FRAME_PRIORITY:
         updateOnePriority();
         break;
-    default: 
+    case Type::BUDGET:
+        updateBudget();
+        break;
+    default:
         assert(false);
         break;
     }
 
+    uint32_t levelMask = 0;
+    for (int level : m_levelsScheduledForUpdate)
+        levelMask |= 1u << level;
+
+    m_scheduledLevelMasks.push_front(levelMask);
+    if (m_scheduledLevelMasks.size() > m_timingLatency + 1)
+        m_scheduledLevelMasks.resize(m_timingLatency + 1);
+
     ++m_frameCounter;
 
     if (m_frameCounter == static_cast<int>(exp2(m_clipRegionCount - 1)))
         m_frameCounter = 0;
 }
 
+void ClipmapUpdatePolicy::reportTimings(double voxelizationTime, double downsamplingTime)
+{
+    if (m_scheduledLevelMasks.size() <= m_timingLatency)
+        return;
+
+    uint32_t levelMask = m_scheduledLevelMasks[m_timingLatency];
+    distributeTime(m_voxelizationCosts, levelMask, voxelizationTime);
+    distributeTime(m_downsamplingCosts, levelMask & ~1u, downsamplingTime);
+}
+
+void ClipmapUpdatePolicy::addDirtyVoxels(int level, std::size_t voxelCount)
+{
+    m_dirtyVoxels[level] += voxelCount;
+}
+
+double ClipmapUpdatePolicy::getEstimatedCost(int level) const
+{
+    return m_voxelizationCosts[level] + m_downsamplingCosts[level];
+}
+
+double ClipmapUpdatePolicy::getPriority(int level) const
+{
+    // Like in ONE_PER_FRAME_PRIORITY coarser levels may be stale for longer
+    double staleness = m_framesSinceUpdate[level] / exp2(level);
+
+    double levelVoxelCount = double(VOXEL_RESOLUTION) * VOXEL_RESOLUTION * VOXEL_RESOLUTION;
+    double dirtyFraction = std::min(m_dirtyVoxels[level] / levelVoxelCount, 1.0);
+
+    return staleness + DIRTY_WEIGHT * dirtyFraction;
+}
+
 void ClipmapUpdatePolicy::updateAll()
 {
     for (int i = 0; i < m_clipRegionCount; ++i)
@@ -51,3 +121,52 @@ void ClipmapUpdatePolicy::updateOnePriority()
         }
     }
 }
+
+void ClipmapUpdatePolicy::updateBudget()
+{
+    std::vector<int> levels(m_clipRegionCount);
+    std::iota(levels.begin(), levels.end(), 0);
+
+    std::stable_sort(levels.begin(), levels.end(), [this](int l0, int l1) { return getPriority(l0) > getPriority(l1); });
+
+    // Greedily take the levels with the highest priority that still fit into the budget
+    double usedBudget = 0.0;
+    for (int level : levels)
+    {
+        double cost = getEstimatedCost(level);
+        if (!m_levelsScheduledForUpdate.empty() && usedBudget + cost > m_budget)
+            continue;
+
+        m_levelsScheduledForUpdate.push_back(level);
+        usedBudget += cost;
+    }
+
+    // Finer levels first because the radiance of a level is downsampled from the previous level
+    std::sort(m_levelsScheduledForUpdate.begin(), m_levelsScheduledForUpdate.end());
+}
+
+void ClipmapUpdatePolicy::distributeTime(std::vector<double>& costs, uint32_t levelMask, double time) const
+{
+    int levelCount = 0;
+    double estimatedTime = 0.0;
+    for (int i = 0; i < m_clipRegionCount; ++i)
+    {
+        if (levelMask & (1u << i))
+        {
+            ++levelCount;
+            estimatedTime += costs[i];
+        }
+    }
+
+    if (levelCount == 0)
+        return;
+
+    // Normalized least mean squares: The error of the summed estimate is split evenly between the levels.
+    // Since the combinations of scheduled levels vary, the estimates converge to the costs of the individual levels.
+    double error = time - estimatedTime;
+    for (int i = 0; i < m_clipRegionCount; ++i)
+    {
+        if (levelMask & (1u << i))
+            costs[i] = std::max(costs[i] + COST_SMOOTHING * error / levelCount, 0.0);
+    }
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
 
 class ClipmapUpdatePolicy
 {
@@ -7,13 +10,21 @@ public:
     enum class Type
     {
         ALL_PER_FRAME,
-        ONE_PER_FRAME_PRIORITY // Update Level 0 every 2 frames, level 1 every 4 frames, level 2 every 8 frames...
+        ONE_PER_FRAME_PRIORITY, // Update Level 0 every 2 frames, level 1 every 4 frames, level 2 every 8 frames...
+        BUDGET // Update the most stale/dirty levels whose estimated cost fits into the budget
     };
 
+    // Initial cost estimate of the radiance update of a level until timings are reported
+    static constexpr double DEFAULT_LEVEL_COST = 1.0;
+
+    // Weight of the reported timings in the smoothed cost estimates
+    static constexpr double COST_SMOOTHING = 0.25;
+
+    // A completely dirty level has the same priority as a level that wasn't updated for this many frames
+    static constexpr double DIRTY_WEIGHT = 64.0;
+
 public:
-    ClipmapUpdatePolicy(Type type, int clipRegionCount)
-        : m_type(type),
-          m_clipRegionCount(clipRegionCount) {}
+    ClipmapUpdatePolicy(Type type, int clipRegionCount);
 
     void update();
 
@@ -21,13 +32,64 @@ public:
     Type getType() const { return m_type; }
     const std::vector<int>& getLevelsScheduledForUpdate() const { return m_levelsScheduledForUpdate; }
 
+    /**
+    * Sets the time in milliseconds that the radiance updates of the BUDGET policy may take per frame.
+    * At least one level is updated per frame even if no level fits into the budget.
+    */
+    void setBudget(double budgetInMilliseconds) { m_budget = budgetInMilliseconds; }
+    double getBudget() const { return m_budget; }
+
+    /**
+    * Timings are reported with a delay because GPU queries are read back a few frames later.
+    * A latency of 0 means that the timings belong to the levels of the last update().
+    */
+    void setTimingLatency(std::size_t frameCount) { m_timingLatency = frameCount; }
+
+    /**
+    * Reports the measured radiance voxelization and downsampling times in milliseconds of the frame
+    * that was scheduled timing latency updates ago. The times are distributed to the levels of that frame.
+    */
+    void reportTimings(double voxelizationTime, double downsamplingTime);
+
+    /**
+    * Adds changed voxels of the level (e.g. revoxelized opacity due to moved entities or camera movement).
+    * Counts since the last update of the level raise its priority.
+    */
+    void addDirtyVoxels(int level, std::size_t voxelCount);
+
+    /**
+    * Returns the estimated time in milliseconds to update the radiance of the level.
+    */
+    double getEstimatedCost(int level) const;
+
+    /**
+    * Returns the number of frames since the level was last scheduled.
+    */
+    int getStaleness(int level) const { return m_framesSinceUpdate[level]; }
+
+    /**
+    * Returns the priority of the level for the BUDGET policy: Staleness scaled by the level size plus the weighted dirty fraction.
+    */
+    double getPriority(int level) const;
+
 private:
     void updateAll();
     void updateOnePriority();
+    void updateBudget();
+
+    void distributeTime(std::vector<double>& costs, uint32_t levelMask, double time) const;
 
 private:
     Type m_type{ Type::ONE_PER_FRAME_PRIORITY };
     std::vector<int> m_levelsScheduledForUpdate;
     int m_frameCounter{ 0 };
     int m_clipRegionCount;
+
+    double m_budget{ 2.0 };
+    std::size_t m_timingLatency{ 0 };
+    std::deque<uint32_t> m_scheduledLevelMasks; // Most recent first
+    std::vector<int> m_framesSinceUpdate;
+    std::vector<std::size_t> m_dirtyVoxels;
+    std::vector<double> m_voxelizationCosts;
+    std::vector<double> m_downsamplingCosts; // Level 0 is not downsampled
 };
@@ -0,0 +1,197 @@
+#include "ClipmapUpdatePolicyTest.h"
+#include "ClipmapUpdatePolicy.h"
+#include "Globals.h"
+#include <vector>
+#include <deque>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+namespace clipmap_update_policy_test
+{
+    /**
+    * Runs the policy for the given number of frames. The synthetic GPU timings are the sum of the level costs
+    * of the scheduled levels and are reported with the given latency like the Profiler does.
+    * Returns the highest staleness of every level.
+    */
+    std::vector<int> simulate(ClipmapUpdatePolicy& policy, const std::vector<double>& voxelizationCosts,
+                              const std::vector<double>& downsamplingCosts, std::size_t latency, int frameCount)
+    {
+        std::deque<std::pair<double, double>> pendingTimings;
+        std::vector<int> maxStaleness(voxelizationCosts.size(), 0);
+        policy.setTimingLatency(latency);
+
+        for (int frame = 0; frame < frameCount; ++frame)
+        {
+            if (pendingTimings.size() > latency)
+            {
+                policy.reportTimings(pendingTimings.front().first, pendingTimings.front().second);
+                pendingTimings.pop_front();
+            }
+
+            policy.update();
+
+            double voxelizationTime = 0.0;
+            double downsamplingTime = 0.0;
+            for (int level : policy.getLevelsScheduledForUpdate())
+            {
+                voxelizationTime += voxelizationCosts[level];
+                downsamplingTime += downsamplingCosts[level];
+            }
+
+            pendingTimings.emplace_back(voxelizationTime, downsamplingTime);
+
+            for (std::size_t level = 0; level < maxStaleness.size(); ++level)
+                maxStaleness[level] = std::max(maxStaleness[level], policy.getStaleness(int(level)));
+        }
+
+        return maxStaleness;
+    }
+
+    bool isScheduled(const ClipmapUpdatePolicy& policy, int level)
+    {
+        auto& levels = policy.getLevelsScheduledForUpdate();
+        return std::find(levels.begin(), levels.end(), level) != levels.end();
+    }
+
+#ifdef RUN_CLIPMAP_UPDATE_POLICY_TESTS
+    struct ClipmapUpdatePolicyTestRunner
+    {
+        ClipmapUpdatePolicyTestRunner()
+        {
+            ClipmapUpdatePolicyTest::runTests();
+        }
+    };
+
+    ClipmapUpdatePolicyTestRunner clipmapUpdatePolicyTestRunner;
+#endif
+}
+
+using namespace clipmap_update_policy_test;
+
+void ClipmapUpdatePolicyTest::runTests()
+{
+    testOnePerFramePriority();
+    testBudgetFitsAllLevels();
+    testBudgetLimitsLevels();
+    testDirtyLevelIsPreferred();
+    testCostEstimation();
+}
+
+void ClipmapUpdatePolicyTest::testOnePerFramePriority()
+{
+    ClipmapUpdatePolicy policy(ClipmapUpdatePolicy::Type::ONE_PER_FRAME_PRIORITY, 4);
+    int expectedLevels[] = {0, 1, 0, 2, 0, 1, 0, 3, 0, 1};
+
+    for (int expectedLevel : expectedLevels)
+    {
+        policy.update();
+        assert(policy.getLevelsScheduledForUpdate().size() == 1);
+        assert(policy.getLevelsScheduledForUpdate()[0] == expectedLevel);
+    }
+}
+
+void ClipmapUpdatePolicyTest::testBudgetFitsAllLevels()
+{
+    ClipmapUpdatePolicy policy(ClipmapUpdatePolicy::Type::BUDGET, CLIP_REGION_COUNT);
+    policy.setBudget(100.0);
+
+    std::vector<double> voxelizationCosts(CLIP_REGION_COUNT, 1.0);
+    std::vector<double> downsamplingCosts(CLIP_REGION_COUNT, 0.5);
+    downsamplingCosts[0] = 0.0;
+
+    std::vector<int> maxStaleness = simulate(policy, voxelizationCosts, downsamplingCosts, 2, 16);
+
+    assert(policy.getLevelsScheduledForUpdate().size() == CLIP_REGION_COUNT);
+    for (int staleness : maxStaleness)
+        assert(staleness == 1);
+
+    // Levels are sorted because coarser levels are downsampled from finer levels
+    assert(std::is_sorted(policy.getLevelsScheduledForUpdate().begin(), policy.getLevelsScheduledForUpdate().end()));
+}
+
+void ClipmapUpdatePolicyTest::testBudgetLimitsLevels()
+{
+    // Every level costs 1 ms thus at most 2 levels fit into the budget
+    ClipmapUpdatePolicy policy(ClipmapUpdatePolicy::Type::BUDGET, CLIP_REGION_COUNT);
+    policy.setBudget(2.5);
+
+    std::vector<double> voxelizationCosts(CLIP_REGION_COUNT, 1.0);
+    std::vector<double> downsamplingCosts(CLIP_REGION_COUNT, 0.0);
+    simulate(policy, voxelizationCosts, downsamplingCosts, 2, 64);
+
+    for (int frame = 0; frame < 32; ++frame)
+    {
+        simulate(policy, voxelizationCosts, downsamplingCosts, 2, 1);
+        assert(policy.getLevelsScheduledForUpdate().size() <= 2);
+    }
+
+    // No level starves and finer levels are updated more often
+    std::vector<int> maxStaleness = simulate(policy, voxelizationCosts, downsamplingCosts, 2, 64);
+    for (int level = 0; level < CLIP_REGION_COUNT; ++level)
+        assert(maxStaleness[level] > 0 && maxStaleness[level] < 64);
+
+    assert(maxStaleness[0] < maxStaleness[CLIP_REGION_COUNT - 1]);
+
+    // A budget that no level fits into still updates one level per frame
+    policy.setBudget(0.1);
+    simulate(policy, voxelizationCosts, downsamplingCosts, 2, 8);
+    assert(policy.getLevelsScheduledForUpdate().size() == 1);
+}
+
+void ClipmapUpdatePolicyTest::testDirtyLevelIsPreferred()
+{
+    ClipmapUpdatePolicy policy(ClipmapUpdatePolicy::Type::BUDGET, CLIP_REGION_COUNT);
+    policy.setBudget(1.0);
+
+    std::vector<double> voxelizationCosts(CLIP_REGION_COUNT, 1.0);
+    std::vector<double> downsamplingCosts(CLIP_REGION_COUNT, 0.0);
+    simulate(policy, voxelizationCosts, downsamplingCosts, 0, 16);
+
+    // A coarse level where a large object moved wins over the stale fine levels
+    int dirtyLevel = CLIP_REGION_COUNT - 1;
+    std::size_t levelVoxelCount = std::size_t(VOXEL_RESOLUTION) * VOXEL_RESOLUTION * VOXEL_RESOLUTION;
+    policy.addDirtyVoxels(dirtyLevel, levelVoxelCount / 4);
+    simulate(policy, voxelizationCosts, downsamplingCosts, 0, 1);
+    assert(isScheduled(policy, dirtyLevel));
+
+    // The dirty voxels are consumed by the update
+    simulate(policy, voxelizationCosts, downsamplingCosts, 0, 1);
+    assert(!isScheduled(policy, dirtyLevel));
+    assert(policy.getPriority(dirtyLevel) < ClipmapUpdatePolicy::DIRTY_WEIGHT / 4.0);
+}
+
+void ClipmapUpdatePolicyTest::testCostEstimation()
+{
+    ClipmapUpdatePolicy policy(ClipmapUpdatePolicy::Type::BUDGET, CLIP_REGION_COUNT);
+    policy.setBudget(3.0);
+
+    // Finer levels contain more geometry details and are more expensive
+    std::vector<double> voxelizationCosts(CLIP_REGION_COUNT);
+    std::vector<double> downsamplingCosts(CLIP_REGION_COUNT, 0.25);
+    downsamplingCosts[0] = 0.0;
+    for (int level = 0; level < CLIP_REGION_COUNT; ++level)
+        voxelizationCosts[level] = 2.0 / (level + 1);
+
+    simulate(policy, voxelizationCosts, downsamplingCosts, 2, 256);
+
+    // The estimates predict the time of the scheduled levels and keep it within the budget
+    for (int frame = 0; frame < 32; ++frame)
+    {
+        simulate(policy, voxelizationCosts, downsamplingCosts, 2, 1);
+
+        double time = 0.0;
+        double estimatedTime = 0.0;
+        for (int level : policy.getLevelsScheduledForUpdate())
+        {
+            time += voxelizationCosts[level] + downsamplingCosts[level];
+            estimatedTime += policy.getEstimatedCost(level);
+        }
+
+        assert(std::abs(estimatedTime - time) < 0.1 * time);
+        assert(time <= policy.getBudget() * 1.1);
+    }
+
+    for (int level = 1; level < CLIP_REGION_COUNT; ++level)
+        assert(policy.getEstimatedCost(0) > policy.getEstimatedCost(level));
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_CLIPMAP_UPDATE_POLICY_TESTS
+#endif
+
+class ClipmapUpdatePolicyTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testOnePerFramePriority();
+    static void testBudgetFitsAllLevels();
+    static void testBudgetLimitsLevels();
+    static void testDirtyLevelIsPreferred();
+    static void testCostEstimation();
+};
@@ -0,0 +1,132 @@
+#include "DirtyBrickMap.h"
+#include "voxelization.h"
+#include <engine/geometry/BBox.h>
+#include <engine/util/math.h>
+#include <algorithm>
+#include <cassert>
+
+const int DirtyBrickMap::BRICK_SIZE;
+const int DirtyBrickMap::BRICK_COUNT;
+
+namespace
+{
+    int lowestBit(uint32_t v)
+    {
+        assert(v != 0);
+        int idx = 0;
+        while ((v & 1) == 0)
+        {
+            v >>= 1;
+            ++idx;
+        }
+
+        return idx;
+    }
+}
+
+void DirtyBrickMap::reset(const VoxelRegion& clipRegion)
+{
+    assert(clipRegion.extent == glm::ivec3(VOXEL_RESOLUTION));
+    m_clipRegion = clipRegion;
+
+    if (!m_empty)
+        std::fill(std::begin(m_rows), std::end(m_rows), Row(0));
+
+    m_minBrick = glm::ivec3(BRICK_COUNT);
+    m_maxBrick = glm::ivec3(-1);
+    m_empty = true;
+}
+
+void DirtyBrickMap::mark(const VoxelRegion& region)
+{
+    VoxelRegion clampedRegion = m_clipRegion.intersect(region);
+    if (clampedRegion.empty())
+        return;
+
+    glm::ivec3 minBrick = (clampedRegion.minPos - m_clipRegion.minPos) / BRICK_SIZE;
+    glm::ivec3 maxBrick = (clampedRegion.getMaxPos() - 1 - m_clipRegion.minPos) / BRICK_SIZE;
+    Row mask = Row((uint64_t(1) << (maxBrick.x + 1)) - (uint64_t(1) << minBrick.x));
+
+    for (int z = minBrick.z; z <= maxBrick.z; ++z)
+        for (int y = minBrick.y; y <= maxBrick.y; ++y)
+            row(y, z) |= mask;
+
+    m_minBrick = glm::min(m_minBrick, minBrick);
+    m_maxBrick = glm::max(m_maxBrick, maxBrick);
+    m_empty = false;
+}
+
+void DirtyBrickMap::mark(const BBox& bbox, int overestimationWidth)
+{
+    // Geometry can be very thin (0 scale) thus the bbox is extended by epsilon (see VoxelizationPass)
+    glm::vec3 pMin = bbox.min() / m_clipRegion.voxelSize - math::EPSILON5;
+    glm::vec3 pMax = bbox.max() / m_clipRegion.voxelSize + math::EPSILON5;
+
+    glm::ivec3 minPos = voxelization::computeLowerBound(pMin) - overestimationWidth;
+    glm::ivec3 maxPos = voxelization::computeUpperBound(pMax) + overestimationWidth;
+
+    mark(VoxelRegion(minPos, maxPos - minPos, m_clipRegion.voxelSize));
+}
+
+void DirtyBrickMap::extractRegions(std::vector<VoxelRegion>& regions)
+{
+    if (m_empty)
+        return;
+
+    for (int z = m_minBrick.z; z <= m_maxBrick.z; ++z)
+    {
+        for (int y = m_minBrick.y; y <= m_maxBrick.y; ++y)
+        {
+            while (row(y, z) != 0)
+            {
+                // Longest run of dirty bricks along x starting at the first dirty brick
+                Row r = row(y, z);
+                int x0 = lowestBit(r);
+                Row shifted = r >> x0;
+                int length = ~shifted == 0 ? 32 - x0 : lowestBit(~shifted);
+                Row mask = Row((uint64_t(1) << (x0 + length)) - (uint64_t(1) << x0));
+
+                // Grow along y while the rows contain the run
+                int y1 = y + 1;
+                while (y1 <= m_maxBrick.y && (row(y1, z) & mask) == mask)
+                    ++y1;
+
+                // Grow along z while all rows of the slab contain the run
+                int z1 = z + 1;
+                while (z1 <= m_maxBrick.z)
+                {
+                    bool slabDirty = true;
+                    for (int yi = y; yi < y1 && slabDirty; ++yi)
+                        slabDirty = (row(yi, z1) & mask) == mask;
+
+                    if (!slabDirty)
+                        break;
+
+                    ++z1;
+                }
+
+                for (int zi = z; zi < z1; ++zi)
+                    for (int yi = y; yi < y1; ++yi)
+                        row(yi, zi) &= ~mask;
+
+                glm::ivec3 minPos = m_clipRegion.minPos + glm::ivec3(x0, y, z) * BRICK_SIZE;
+                glm::ivec3 extent = glm::ivec3(length, y1 - y, z1 - z) * BRICK_SIZE;
+                regions.push_back(VoxelRegion(minPos, extent, m_clipRegion.voxelSize));
+            }
+        }
+    }
+
+    m_minBrick = glm::ivec3(BRICK_COUNT);
+    m_maxBrick = glm::ivec3(-1);
+    m_empty = true;
+}
+
+std::size_t DirtyBrickMap::getDirtyBrickCount() const
+{
+    std::size_t count = 0;
+    for (Row r : m_rows)
+        for (; r != 0; r &= r - 1)
+            ++count;
+
+    return count;
+}
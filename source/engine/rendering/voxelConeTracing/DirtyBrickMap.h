@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Globals.h"
+#include "VoxelRegion.h"
+
+class BBox;
+
+/**
+* Bitmap of the dirty bricks (BRICK_SIZE^3 voxels) of one clip region.
+* Moved entities mark their old and new bounds and the dirty bricks are then extracted as a small set of boxes.
+* Marking costs O(touched bricks) and the extraction is linear in the number of bricks, so the cost grows
+* linearly with the number of moving entities instead of quadratically like uniting overlapping bounding boxes.
+*/
+class DirtyBrickMap
+{
+public:
+    static const int BRICK_SIZE = 8;
+    static const int BRICK_COUNT = VOXEL_RESOLUTION / BRICK_SIZE; // Per axis
+
+    /**
+    * Clears the map and aligns the bricks to the given clip region.
+    */
+    void reset(const VoxelRegion& clipRegion);
+
+    /**
+    * Marks all bricks that overlap the region given in voxel coordinates. Parts outside of the clip region are ignored.
+    */
+    void mark(const VoxelRegion& region);
+
+    /**
+    * Converts the bbox to voxel coordinates like the revoxelization of dynamic entities and marks it.
+    */
+    void mark(const BBox& bbox, int overestimationWidth = 0);
+
+    /**
+    * Appends boxes that cover exactly the dirty bricks and clears the map.
+    * Boxes are grown greedily along x, then y and then z.
+    */
+    void extractRegions(std::vector<VoxelRegion>& regions);
+
+    bool empty() const { return m_empty; }
+
+    std::size_t getDirtyBrickCount() const;
+
+private:
+    using Row = uint32_t;
+    static_assert(BRICK_COUNT <= 32, "A row of bricks has to fit into a Row.");
+
+    Row& row(int y, int z) { return m_rows[z * BRICK_COUNT + y]; }
+
+private:
+    // Bit x of the row (y, z) is set if the brick (x, y, z) is dirty
+    Row m_rows[BRICK_COUNT * BRICK_COUNT] = {};
+    VoxelRegion m_clipRegion;
+
+    // Bounds of the dirty bricks - the extraction only visits these rows
+    glm::ivec3 m_minBrick{BRICK_COUNT};
+    glm::ivec3 m_maxBrick{-1};
+    bool m_empty{true};
+};
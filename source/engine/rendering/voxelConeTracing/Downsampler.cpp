@@ -14,20 +14,43 @@ void Downsampler::init()
 }
 
 void Downsampler::downsampleOpacity(Texture3D* texture, const std::vector<VoxelRegion>* clipRegions, int clipmapLevel)
+{
+    downsampleOpacity(texture, clipRegions, clipmapLevel, getDownsampleRegion(clipRegions, clipmapLevel));
+}
+
+std::size_t Downsampler::downsampleOpacity(Texture3D* texture, const std::vector<VoxelRegion>* clipRegions, int clipmapLevel, const VoxelRegion& region)
 {
     assert(clipmapLevel > 0 && clipmapLevel < CLIP_REGION_COUNT);
 
+    VoxelRegion downsampleRegion = getDownsampleRegion(clipRegions, clipmapLevel);
+    VoxelRegion clampedRegion = downsampleRegion.intersect(region);
+
+    if (clampedRegion.empty())
+        return 0;
+
+    // The previous level was written by the voxelization or the downsampling of the previous level
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     m_downsampleOpacityShader->bind();
 
     m_downsampleOpacityShader->bindImage3D(*texture, "u_image", GL_READ_WRITE, GL_RGBA8, 0);
 
     m_downsampleOpacityShader->setInt("u_downsampleTransitionRegionSize", GI_SETTINGS.downsampleTransitionRegionSize);
     m_downsampleOpacityShader->setVectori("u_prevRegionMin", clipRegions->at(clipmapLevel - 1).minPos);
+    m_downsampleOpacityShader->setVectori("u_regionOffset", clampedRegion.minPos - downsampleRegion.minPos);
+    m_downsampleOpacityShader->setVectori("u_regionExtent", clampedRegion.extent);
     m_downsampleOpacityShader->setInt("u_clipmapLevel", clipmapLevel);
     m_downsampleOpacityShader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
-    GLuint groupCount = GLuint(VOXEL_RESOLUTION / 2 / 8);
-    m_downsampleOpacityShader->dispatchCompute(groupCount, groupCount, groupCount);
-    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    glm::uvec3 groupCount = glm::uvec3(clampedRegion.extent + 7) / 8u;
+    m_downsampleOpacityShader->dispatchCompute(groupCount.x, groupCount.y, groupCount.z);
+
+    return std::size_t(clampedRegion.extent.x) * clampedRegion.extent.y * clampedRegion.extent.z;
+}
+
+VoxelRegion Downsampler::getDownsampleRegion(const std::vector<VoxelRegion>* clipRegions, int clipmapLevel)
+{
+    // Same as toCurrentLevelVoxelCoordinates(u_prevRegionMin) in the shaders
+    const VoxelRegion& prevRegion = clipRegions->at(clipmapLevel - 1);
+    return VoxelRegion(prevRegion.minPos / 2, glm::ivec3(VOXEL_RESOLUTION / 2), clipRegions->at(clipmapLevel).voxelSize);
 }
 
 void Downsampler::downsample(Texture3D* image, const std::vector<VoxelRegion>* clipRegions)
@@ -37,13 +60,13 @@ void Downsampler::downsample(Texture3D* image, const std::vector<VoxelRegion>* c
 
     for (int i = 1; i < CLIP_REGION_COUNT; ++i)
     {
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
         m_downsampleShader->setInt("u_downsampleTransitionRegionSize", GI_SETTINGS.downsampleTransitionRegionSize);
         m_downsampleShader->setVectori("u_prevRegionMin", clipRegions->at(i - 1).minPos);
         m_downsampleShader->setInt("u_clipmapLevel", i);
         m_downsampleShader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
         GLuint groupCount = GLuint(VOXEL_RESOLUTION / 2 / 8);
         m_downsampleShader->dispatchCompute(groupCount, groupCount, groupCount);
-        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
 }
 
@@ -51,6 +74,7 @@ void Downsampler::downsample(Texture3D* image, const std::vector<VoxelRegion>* c
 {
     assert(clipmapLevel > 0 && clipmapLevel < CLIP_REGION_COUNT);
 
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     m_downsampleShader->bind();
     m_downsampleShader->bindImage3D(*image, "u_image", GL_READ_WRITE, GL_RGBA8, 0);
 
@@ -60,5 +84,4 @@ void Downsampler::downsample(Texture3D* image, const std::vector<VoxelRegion>* c
     m_downsampleShader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
     GLuint groupCount = GLuint(VOXEL_RESOLUTION / 2 / 8);
     m_downsampleShader->dispatchCompute(groupCount, groupCount, groupCount);
-    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 }
@@ -7,12 +7,27 @@
 class Texture3D;
 class Shader;
 
+/**
+* Every dispatch waits for the previous image writes to the texture. The writes of the last dispatch are not made visible -
+* the frame graph places the barrier before the next pass that accesses the texture.
+*/
 class Downsampler
 {
 public:
     static void init();
 
     static void downsampleOpacity(Texture3D* texture, const std::vector<VoxelRegion>* clipRegions, int clipmapLevel);
+
+    /**
+    * Downsamples only the given region of the clipmap level from the previous level. The region is in voxel coordinates
+    * of clipmapLevel and is clamped to getDownsampleRegion(). Returns the number of downsampled voxels.
+    */
+    static std::size_t downsampleOpacity(Texture3D* texture, const std::vector<VoxelRegion>* clipRegions, int clipmapLevel, const VoxelRegion& region);
+
+    /**
+    * Returns the part of the clipmap level that is covered by the previous level and is thus computed by downsampling.
+    */
+    static VoxelRegion getDownsampleRegion(const std::vector<VoxelRegion>* clipRegions, int clipmapLevel);
     static void downsample(Texture3D* image, const std::vector<VoxelRegion>* clipRegions);
     static void downsample(Texture3D* image, const std::vector<VoxelRegion>* clipRegions, int clipmapLevel);
 
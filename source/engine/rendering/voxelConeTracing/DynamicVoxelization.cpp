@@ -0,0 +1,23 @@
+#include "DynamicVoxelization.h"
+#include <engine/geometry/Transform.h>
+#include <engine/event/event.h>
+#include <engine/event/DynamicVoxelizationChangedEvent.h>
+
+void DynamicVoxelization::setDynamic(Entity entity, bool dynamic)
+{
+    if (entity.hasComponent<DynamicVoxelization>() != dynamic)
+    {
+        if (dynamic)
+            entity.addComponent<DynamicVoxelization>();
+        else
+            entity.removeComponent<DynamicVoxelization>();
+
+        Event::transmit<DynamicVoxelizationChangedEvent>(entity);
+    }
+
+    if (!entity.hasComponent<Transform>())
+        return;
+
+    for (auto& child : entity.getComponent<Transform>()->getChildren())
+        setDynamic(child->getOwner(), dynamic);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <engine/ecs/ECS.h>
+
+/**
+* Flags an entity as dynamic for the opacity voxelization. Entities without this component are static.
+* Static opacity is kept in a separate volume and only voxelized when the clip regions move or static entities change.
+* Where a dynamic entity moves, the static opacity is restored from that volume and only dynamic entities are voxelized.
+*/
+class DynamicVoxelization : public Component
+{
+public:
+    static constexpr ComponentUsage USAGE_HINT = ComponentUsage::MostlyStatic;
+
+    std::string getName() const override { return "Dynamic Voxelization"; }
+
+    /**
+    * Adds or removes the component of the entity and all its children.
+    * A DynamicVoxelizationChangedEvent is transmitted for every entity that changed.
+    */
+    static void setDynamic(Entity entity, bool dynamic);
+};
@@ -2,6 +2,7 @@
 #include <vector>
 #include <engine/rendering/Texture3D.h>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/rendering/util/GLUtil.h>
 #include <engine/rendering/Screen.h>
 #include "Globals.h"
@@ -25,18 +26,30 @@ GIPass::GIPass()
     m_fullscreenQuadRenderer = MeshRenderers::fullscreenQuad();
 }
 
+void GIPass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.read(rp_keys::VOXEL_RADIANCE, FrameGraphAccess::TEXTURE);
+    builder.read(rp_keys::CLIP_REGIONS, FrameGraphAccess::CPU);
+    builder.read(rp_keys::SHADOW_MAPS, FrameGraphAccess::TEXTURE);
+
+    for (auto gBufferTexture : { &rp_keys::DIFFUSE_TEXTURE, &rp_keys::NORMAL_MAP, &rp_keys::SPECULAR_MAP, &rp_keys::EMISSION_MAP, &rp_keys::DEPTH_TEXTURE })
+        builder.read(*gBufferTexture, FrameGraphAccess::TEXTURE);
+
+    builder.write(rp_keys::BACKBUFFER, FrameGraphAccess::RENDER_TARGET);
+}
+
 void GIPass::update()
 {
     // Fetch the data
-    Texture3D* voxelRadiance = m_renderPipeline->fetchPtr<Texture3D>("VoxelRadiance");
-    auto clipRegions = m_renderPipeline->fetchPtr<std::vector<VoxelRegion>>("ClipRegions");
+    Texture3D* voxelRadiance = m_renderPipeline->fetchPtr(rp_keys::VOXEL_RADIANCE);
+    auto clipRegions = m_renderPipeline->fetchPtr(rp_keys::CLIP_REGIONS);
     auto camera = m_renderPipeline->getCamera();
 
-    GLuint diffuseTexture = m_renderPipeline->fetch<GLuint>("DiffuseTexture");
-    GLuint normalMap = m_renderPipeline->fetch<GLuint>("NormalMap");
-    GLuint specularMap = m_renderPipeline->fetch<GLuint>("SpecularMap");
-    GLuint emissionMap = m_renderPipeline->fetch<GLuint>("EmissionMap");
-    GLuint depthTexture = m_renderPipeline->fetch<GLuint>("DepthTexture");
+    GLuint diffuseTexture = m_renderPipeline->fetch(rp_keys::DIFFUSE_TEXTURE);
+    GLuint normalMap = m_renderPipeline->fetch(rp_keys::NORMAL_MAP);
+    GLuint specularMap = m_renderPipeline->fetch(rp_keys::SPECULAR_MAP);
+    GLuint emissionMap = m_renderPipeline->fetch(rp_keys::EMISSION_MAP);
+    GLuint depthTexture = m_renderPipeline->fetch(rp_keys::DEPTH_TEXTURE);
 
     glDisable(GL_DEPTH_TEST);
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -11,6 +11,8 @@ public:
 
     void update() override;
 
+    void declareResources(FrameGraphBuilder& builder) override;
+
 private:
     std::shared_ptr<Shader> m_finalLightPassShader;
     std::shared_ptr<SimpleMeshRenderer> m_fullscreenQuadRenderer;
@@ -0,0 +1,189 @@
+#include "RSMInjectionTest.h"
+#include "CPURSMInjector.h"
+#include "Globals.h"
+#include <engine/util/math.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <cmath>
+#include <cassert>
+
+namespace rsm_injection_test
+{
+    const float EXTENT_WORLD_LEVEL_0 = 32.0f;
+    const int DOWNSAMPLE_TRANSITION_REGION_SIZE = 2;
+
+    /**
+    * Clip regions centered around the origin like VoxelizationPass::init() creates them.
+    */
+    std::vector<VoxelRegion> createClipRegions()
+    {
+        std::vector<VoxelRegion> clipRegions(CLIP_REGION_COUNT);
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        {
+            clipRegions[i].minPos = glm::ivec3(-VOXEL_RESOLUTION / 2);
+            clipRegions[i].extent = glm::ivec3(VOXEL_RESOLUTION);
+            clipRegions[i].voxelSize = (EXTENT_WORLD_LEVEL_0 * std::exp2f(float(i))) / VOXEL_RESOLUTION;
+        }
+
+        return clipRegions;
+    }
+
+    /**
+    * Reflective shadow map of a light that looks straight down onto a floor at floorY.
+    * The shadow matrices are computed like DirectionalLight::updateShadowMatrices() does.
+    */
+    ReflectiveShadowMapTexels createFloorRSM(int resolution, float projectionSize, float floorY, const glm::vec3& flux, bool emissive = false)
+    {
+        glm::vec3 lightPos(0.0f, 20.0f, 0.0f);
+        glm::vec3 lightDir(0.0f, -1.0f, 0.0f);
+        glm::mat4 view = glm::lookAt(lightPos, lightPos + lightDir, glm::vec3(0.0f, 0.0f, 1.0f));
+        float hs = projectionSize * 0.5f;
+        glm::mat4 proj = math::orthoLH(-hs, hs, -hs, hs, 0.3f, 30.0f);
+
+        ReflectiveShadowMapTexels rsm;
+        rsm.width = resolution;
+        rsm.height = resolution;
+        rsm.viewProjInv = glm::inverse(proj * view);
+        rsm.lightDirection = lightDir;
+
+        for (int y = 0; y < resolution; ++y)
+        {
+            for (int x = 0; x < resolution; ++x)
+            {
+                // The depth is linear in an orthographic projection: Intersect the texel ray with the floor
+                glm::vec2 ndc = (glm::vec2(x, y) + 0.5f) / float(resolution) * 2.0f - 1.0f;
+                glm::vec4 p0 = rsm.viewProjInv * glm::vec4(ndc, -1.0f, 1.0f);
+                glm::vec4 p1 = rsm.viewProjInv * glm::vec4(ndc, 1.0f, 1.0f);
+                float depth = (floorY - p0.y / p0.w) / (p1.y / p1.w - p0.y / p0.w);
+
+                rsm.depth.push_back(depth >= 0.0f && depth < 1.0f ? depth : 1.0f);
+                rsm.flux.push_back(flux);
+                rsm.normal.push_back(glm::vec4(0.5f, 1.0f, 0.5f, emissive ? 1.0f : 0.0f));
+            }
+        }
+
+        return rsm;
+    }
+
+    /**
+    * The layer of voxels at the given y coordinate in voxel coordinates.
+    */
+    VoxelRegion getLayer(int y)
+    {
+        return VoxelRegion(glm::ivec3(-VOXEL_RESOLUTION / 2, y, -VOXEL_RESOLUTION / 2), glm::ivec3(VOXEL_RESOLUTION, 1, VOXEL_RESOLUTION), 1.0f);
+    }
+
+    bool nearEqRGB(uint32_t packed, const glm::vec3& color)
+    {
+        glm::vec3 rgb = glm::vec3(CPURSMInjector::unpackRGBA8(packed));
+        return glm::all(glm::lessThanEqual(glm::abs(rgb - color * 255.0f), glm::vec3(1.0f)));
+    }
+
+#ifdef RUN_RSM_INJECTION_TESTS
+    struct RSMInjectionTestRunner
+    {
+        RSMInjectionTestRunner()
+        {
+            RSMInjectionTest::runTests();
+        }
+    };
+
+    RSMInjectionTestRunner rsmInjectionTestRunner;
+#endif
+}
+
+using namespace rsm_injection_test;
+
+void RSMInjectionTest::runTests()
+{
+    testFloorIsLit();
+    testDownsampleRegionIsSkipped();
+    testTexelStrideKeepsCoverage();
+    testEmission();
+}
+
+void RSMInjectionTest::testFloorIsLit()
+{
+    // Level 0: voxel size 0.25, the floor is in the middle of the voxel layer y = 2
+    std::vector<VoxelRegion> clipRegions = createClipRegions();
+    glm::vec3 flux(0.5f, 0.25f, 1.0f);
+    ReflectiveShadowMapTexels rsm = createFloorRSM(256, 16.0f, 0.625f, flux);
+
+    CPURSMInjector injector;
+    injector.inject(rsm, clipRegions, 0, DOWNSAMPLE_TRANSITION_REGION_SIZE);
+
+    // The 16x16 footprint covers 64x64 voxels
+    assert(injector.countLitVoxels(getLayer(2), 0) == 64 * 64);
+    assert(injector.countLitVoxels(getLayer(1), 0) == 0);
+    assert(injector.countLitVoxels(getLayer(3), 0) == 0);
+    assert(injector.countLitVoxels(VoxelRegion(glm::ivec3(32, 2, 0), glm::ivec3(1), 1.0f), 0) == 0);
+
+    // The light arrives from above: The radiance is stored on the -y face (-normal), the other faces are weighted with 0
+    uint32_t radiance = injector.getRadiance(0, 3, glm::ivec3(0, 2, 0));
+    assert(nearEqRGB(radiance, flux));
+    assert(CPURSMInjector::unpackRGBA8(radiance).w == 16.0f);
+    assert(nearEqRGB(injector.getRadiance(0, 1, glm::ivec3(0, 2, 0)), glm::vec3(0.0f)));
+    assert(injector.getRadiance(0, 2, glm::ivec3(0, 2, 0)) == 0);
+}
+
+void RSMInjectionTest::testDownsampleRegionIsSkipped()
+{
+    // Level 1: voxel size 0.5, the finer level covers [-16, 16] and the transition region is 2 voxels (1.0) wide
+    std::vector<VoxelRegion> clipRegions = createClipRegions();
+    ReflectiveShadowMapTexels rsm = createFloorRSM(384, 48.0f, 1.25f, glm::vec3(1.0f));
+
+    CPURSMInjector injector;
+    injector.inject(rsm, clipRegions, 1, DOWNSAMPLE_TRANSITION_REGION_SIZE);
+
+    // [-24, 24] is lit except for [-15, 15] which is downsampled from the finer level
+    assert(injector.countLitVoxels(getLayer(2), 1) == 96 * 96 - 60 * 60);
+    assert(injector.getRadiance(1, 3, glm::ivec3(0, 2, 0)) == 0);
+    assert(injector.getRadiance(1, 3, glm::ivec3(29, 2, 0)) == 0);
+    assert(injector.getRadiance(1, 3, glm::ivec3(30, 2, 0)) != 0);
+    assert(injector.getRadiance(1, 3, glm::ivec3(-31, 2, 0)) != 0);
+}
+
+void RSMInjectionTest::testTexelStrideKeepsCoverage()
+{
+    // The footprint covers level 0 and a 1 voxel (level 1) wide ring of level 1 outside of the downsample region
+    std::vector<VoxelRegion> clipRegions = createClipRegions();
+    glm::vec3 flux(0.5f, 0.25f, 1.0f);
+    float texelSize = 32.0f / 512;
+    ReflectiveShadowMapTexels rsm = createFloorRSM(512, 32.0f, 0.625f, flux);
+    glm::ivec3 sampledVoxels[] = { glm::ivec3(0, 2, 0), glm::ivec3(-32, 1, 0) };
+
+    for (int level = 0; level < 2; ++level)
+    {
+        int stride = CPURSMInjector::computeTexelStride(clipRegions[level].voxelSize, texelSize);
+        assert(stride == 2 * (level + 1));
+
+        int y = sampledVoxels[level].y;
+        CPURSMInjector full;
+        CPURSMInjector strided;
+        full.inject(rsm, clipRegions, level, DOWNSAMPLE_TRANSITION_REGION_SIZE);
+        strided.inject(rsm, clipRegions, level, DOWNSAMPLE_TRANSITION_REGION_SIZE, stride);
+
+        std::size_t litVoxelCount = full.countLitVoxels(getLayer(y), level);
+        assert(litVoxelCount == (level == 0 ? 128 * 128 : 64 * 64 - 60 * 60));
+        assert(strided.countLitVoxels(getLayer(y), level) == litVoxelCount);
+
+        // Every voxel still gets 2x2 samples with the same average
+        uint32_t radiance = strided.getRadiance(level, 3, sampledVoxels[level]);
+        assert(nearEqRGB(radiance, flux));
+        assert(CPURSMInjector::unpackRGBA8(radiance).w == 4.0f);
+    }
+}
+
+void RSMInjectionTest::testEmission()
+{
+    std::vector<VoxelRegion> clipRegions = createClipRegions();
+    glm::vec3 emission(0.0f, 1.0f, 0.5f);
+    ReflectiveShadowMapTexels rsm = createFloorRSM(64, 16.0f, 0.625f, emission, true);
+
+    CPURSMInjector injector;
+    injector.inject(rsm, clipRegions, 0, DOWNSAMPLE_TRANSITION_REGION_SIZE);
+
+    // Emitted light is independent of the light direction and stored on all faces
+    for (int face = 0; face < FACE_COUNT; ++face)
+        assert(nearEqRGB(injector.getRadiance(0, face, glm::ivec3(0, 2, 0)), emission));
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_RSM_INJECTION_TESTS
+#endif
+
+class RSMInjectionTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testFloorIsLit();
+    static void testDownsampleRegionIsSkipped();
+    static void testTexelStrideKeepsCoverage();
+    static void testEmission();
+};
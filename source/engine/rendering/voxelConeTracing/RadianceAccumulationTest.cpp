@@ -0,0 +1,98 @@
+#include "RadianceAccumulationTest.h"
+#include "CPURadianceAccumulation.h"
+#include <vector>
+#include <cassert>
+
+namespace radiance_accumulation_test
+{
+    /**
+    * Distinct colors in [0, 1].
+    */
+    std::vector<glm::vec3> createFragments(std::size_t count)
+    {
+        std::vector<glm::vec3> fragments;
+        for (std::size_t i = 0; i < count; ++i)
+            fragments.push_back(glm::vec3(float(i % 7) / 6.0f, float(i % 5) / 4.0f, float(i % 3) / 2.0f));
+
+        return fragments;
+    }
+
+    bool nearEq(const glm::vec3& v0, const glm::vec3& v1, float maxError)
+    {
+        return glm::all(glm::lessThanEqual(glm::abs(v0 - v1), glm::vec3(maxError)));
+    }
+
+#ifdef RUN_RADIANCE_ACCUMULATION_TESTS
+    struct RadianceAccumulationTestRunner
+    {
+        RadianceAccumulationTestRunner()
+        {
+            RadianceAccumulationTest::runTests();
+        }
+    };
+
+    RadianceAccumulationTestRunner radianceAccumulationTestRunner;
+#endif
+}
+
+using namespace radiance_accumulation_test;
+
+void RadianceAccumulationTest::runTests()
+{
+    testUncontended();
+    testContentionDropsFragments();
+    testSampleCountWraps();
+}
+
+void RadianceAccumulationTest::testUncontended()
+{
+    std::vector<glm::vec3> fragments = createFragments(16);
+    glm::vec3 reference = CPURadianceAccumulation::computeReference(fragments);
+
+    // The first compare and swap of an invocation expects an empty texel - all but the first fragment need 2 attempts
+    auto rgba8Avg = CPURadianceAccumulation::accumulateRGBA8Avg(fragments, 1);
+    assert(rgba8Avg.droppedFragmentCount == 0);
+    assert(rgba8Avg.atomicOperationCount == 2 * fragments.size() - 1);
+
+    // Every renormalization truncates the running average: The error grows with the sample count
+    assert(glm::all(glm::lessThanEqual(rgba8Avg.radiance, reference)));
+    assert(nearEq(rgba8Avg.radiance, reference, 6.0f / 255.0f));
+
+    auto fixedPoint = CPURadianceAccumulation::accumulateFixedPoint(fragments);
+    assert(fixedPoint.droppedFragmentCount == 0);
+    assert(fixedPoint.atomicOperationCount == 4 * fragments.size());
+    assert(nearEq(fixedPoint.radiance, reference, 0.5f / 255.0f));
+}
+
+void RadianceAccumulationTest::testContentionDropsFragments()
+{
+    // One invocation per round succeeds: Only the first MAX_CAS_ITERATIONS + 1 invocations of a wave store their value
+    std::size_t waveSize = 256;
+    std::vector<glm::vec3> fragments = createFragments(waveSize);
+    glm::vec3 reference = CPURadianceAccumulation::computeReference(fragments);
+
+    auto rgba8Avg = CPURadianceAccumulation::accumulateRGBA8Avg(fragments, waveSize);
+    std::size_t storedCount = CPURadianceAccumulation::MAX_CAS_ITERATIONS + 1;
+    assert(rgba8Avg.droppedFragmentCount == waveSize - storedCount);
+    assert(rgba8Avg.atomicOperationCount > waveSize * storedCount / 2);
+
+    auto fixedPoint = CPURadianceAccumulation::accumulateFixedPoint(fragments);
+    assert(fixedPoint.droppedFragmentCount == 0);
+    assert(fixedPoint.atomicOperationCount == 4 * waveSize);
+    assert(nearEq(fixedPoint.radiance, reference, 0.5f / 255.0f));
+}
+
+void RadianceAccumulationTest::testSampleCountWraps()
+{
+    // The 8 bit sample count of the RGBA8 average wraps to 0 after 255 samples and the previous samples are lost
+    std::vector<glm::vec3> fragments(256, glm::vec3(0.0f));
+    fragments.resize(300, glm::vec3(1.0f));
+    glm::vec3 reference = CPURadianceAccumulation::computeReference(fragments);
+
+    auto rgba8Avg = CPURadianceAccumulation::accumulateRGBA8Avg(fragments, 1);
+    assert(rgba8Avg.droppedFragmentCount == 0);
+    assert(nearEq(rgba8Avg.radiance, glm::vec3(1.0f), 1e-5f));
+
+    auto fixedPoint = CPURadianceAccumulation::accumulateFixedPoint(fragments);
+    assert(nearEq(fixedPoint.radiance, reference, 0.5f / 255.0f));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_RADIANCE_ACCUMULATION_TESTS
+#endif
+
+class RadianceAccumulationTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testUncontended();
+    static void testContentionDropsFragments();
+    static void testSampleCountWraps();
+};
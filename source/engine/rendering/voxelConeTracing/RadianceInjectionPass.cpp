@@ -3,16 +3,20 @@
 #include <engine/camera/CameraComponent.h>
 #include <engine/rendering/Texture3D.h>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/resource/ResourceManager.h>
 #include <engine/ecs/ECS.h>
 #include "settings/VoxelConeTracingSettings.h"
 #include "voxelization.h"
 #include "Downsampler.h"
 #include "engine/util/QueryManager.h"
+#include "engine/util/Profiler.h"
 #include "VoxelConeTracing.h"
 #include "engine/rendering/util/ImageCleaner.h"
 #include "engine/util/ECSUtil/ECSUtil.h"
 #include "ClipmapUpdatePolicy.h"
+#include "CPURSMInjector.h"
+#include "engine/rendering/renderPasses/ShadowMapPass.h"
 
 RadianceInjectionPass::RadianceInjectionPass()
     : RenderPass("RadianceInjectionPass")
@@ -20,21 +24,40 @@ RadianceInjectionPass::RadianceInjectionPass()
     m_conservativeVoxelizationShader = ResourceManager::getShader("shaders/voxelConeTracing/injectLightByConservativeVoxelization.vert",
         "shaders/voxelConeTracing/injectLightByConservativeVoxelization.frag", "shaders/voxelConeTracing/injectLightByConservativeVoxelization.geom");
 
+    m_multiRegionConservativeVoxelizationShader = ResourceManager::getShader("shaders/voxelConeTracing/injectLightByConservativeVoxelization.vert",
+        "shaders/voxelConeTracing/injectLightByConservativeVoxelizationMultiRegion.frag", "shaders/voxelConeTracing/conservativeMultiRegionVoxelization.geom");
+
     m_msaaVoxelizationShader = ResourceManager::getShader("shaders/voxelConeTracing/injectLightByMSAAVoxelization.vert",
         "shaders/voxelConeTracing/injectLightByMSAAVoxelization.frag", "shaders/voxelConeTracing/injectLightByMSAAVoxelization.geom");
 
     m_copyAlphaShader = ResourceManager::getComputeShader("shaders/voxelConeTracing/copyAlpha6Faces.comp");
+    m_rsmInjectionShader = ResourceManager::getComputeShader("shaders/voxelConeTracing/injectLightByReflectiveShadowMaps.comp");
+    m_resolveRadianceShader = ResourceManager::getComputeShader("shaders/voxelConeTracing/resolveRadianceAccumulation.comp");
 
     m_cachedClipRegions.resize(CLIP_REGION_COUNT);
 }
 
+void RadianceInjectionPass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.read(rp_keys::VOXEL_OPACITY, FrameGraphAccess::TEXTURE);
+    builder.read(rp_keys::CLIP_REGIONS, FrameGraphAccess::CPU);
+    builder.read(rp_keys::CLIPMAP_UPDATE_POLICY, FrameGraphAccess::CPU);
+
+    if (GI_SETTINGS.radianceInjectionMode.asString() == "Reflective Shadow Maps")
+        builder.read(rp_keys::REFLECTIVE_SHADOW_MAPS, FrameGraphAccess::TEXTURE);
+    else
+        builder.read(rp_keys::SHADOW_MAPS, FrameGraphAccess::TEXTURE);
+
+    builder.write(rp_keys::VOXEL_RADIANCE, FrameGraphAccess::IMAGE);
+}
+
 void RadianceInjectionPass::update()
 {
-    auto voxelRadiance = m_renderPipeline->fetchPtr<Texture3D>("VoxelRadiance");
-    auto voxelOpacity = m_renderPipeline->fetchPtr<Texture3D>("VoxelOpacity");
-    m_clipmapUpdatePolicy = m_renderPipeline->fetchPtr<ClipmapUpdatePolicy>("ClipmapUpdatePolicy");
+    auto voxelRadiance = m_renderPipeline->fetchPtr(rp_keys::VOXEL_RADIANCE);
+    auto voxelOpacity = m_renderPipeline->fetchPtr(rp_keys::VOXEL_OPACITY);
+    m_clipmapUpdatePolicy = m_renderPipeline->fetchPtr(rp_keys::CLIPMAP_UPDATE_POLICY);
 
-    auto clipRegions = m_renderPipeline->fetchPtr<std::vector<VoxelRegion>>("ClipRegions");
+    auto clipRegions = m_renderPipeline->fetchPtr(rp_keys::CLIP_REGIONS);
 
     if (m_initializing)
     {
@@ -49,18 +72,31 @@ void RadianceInjectionPass::update()
         }
     }
 
-    injectByVoxelization(getSelectedShader(), voxelRadiance, m_voxelizationMode);
+    m_fixedPointAccumulation = GI_SETTINGS.radianceAccumulation.asString() == "Fixed-Point";
+
+    if (m_fixedPointAccumulation && !m_radianceAccumulator.isValid())
+        createRadianceAccumulator();
+
+    // The resolve of the fixed-point accumulation overwrites the levels
+    if (!m_fixedPointAccumulation)
+        clearRadiance(voxelRadiance);
+
+    if (GI_SETTINGS.radianceInjectionMode.asString() == "Reflective Shadow Maps")
+        injectByReflectiveShadowMaps(voxelRadiance);
+    else
+        injectByVoxelization(getSelectedShader(), voxelRadiance, m_voxelizationMode);
+
     copyAlpha(voxelRadiance, voxelOpacity);
     downsample(voxelRadiance);
 
     m_initializing = false;
 }
 
-void RadianceInjectionPass::injectByVoxelization(Shader* shader, Texture3D* voxelRadiance, VoxelizationMode voxelizationMode)
+void RadianceInjectionPass::clearRadiance(Texture3D* voxelRadiance) const
 {
     static unsigned char zero[]{ 0, 0, 0, 0 };
 
-    QueryManager::beginElapsedTime(QueryTarget::GPU, "Clear Radiance Voxels");
+    PROFILE_GPU_ZONE("Clear Radiance Voxels");
 
     auto& levelsToUpdate = m_clipmapUpdatePolicy->getLevelsScheduledForUpdate();
 
@@ -76,20 +112,62 @@ void RadianceInjectionPass::injectByVoxelization(Shader* shader, Texture3D* voxe
             ImageCleaner::clear6FacesImage3D(*voxelRadiance, GL_RGBA8, glm::ivec3(0), glm::ivec3(VOXEL_RESOLUTION), VOXEL_RESOLUTION, clipLevel, 1);
         }
 
-        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
+}
 
-    QueryManager::endElapsedTime(QueryTarget::GPU, "Clear Radiance Voxels");
+void RadianceInjectionPass::injectByVoxelization(Shader* shader, Texture3D* voxelRadiance, VoxelizationMode voxelizationMode)
+{
+    auto& levelsToUpdate = m_clipmapUpdatePolicy->getLevelsScheduledForUpdate();
 
-    QueryManager::beginElapsedTime(QueryTarget::GPU, "Radiance Voxelization");
+    PROFILE_GPU_ZONE("Radiance Voxelization");
     VoxelizationDesc desc;
     desc.mode = voxelizationMode;
     desc.clipRegions = m_cachedClipRegions;
     desc.voxelizationShader = shader;
+    desc.multiRegion = m_multiRegionVoxelization;
     desc.downsampleTransitionRegionSize = GI_SETTINGS.downsampleTransitionRegionSize;
     Voxelizer* voxelizer = VoxelConeTracing::voxelizer();
-    voxelizer->beginVoxelization(desc);
-    shader->bindImage3D(*voxelRadiance, "u_voxelRadiance", GL_READ_WRITE, GL_R32UI, 0);
+
+    if (m_fixedPointAccumulation)
+    {
+        // The accumulators hold a single clipmap level: Every level is voxelized and resolved on its own
+        std::size_t drawCount = 0;
+        for (auto level : levelsToUpdate)
+        {
+            beginRadianceVoxelization(desc, &m_radianceAccumulator);
+            voxelizer->voxelize(m_cachedClipRegions.at(level), level);
+            drawCount += voxelizer->getDrawCount();
+            voxelizer->endVoxelization(m_renderPipeline->getCamera()->getViewport());
+
+            resolveRadiance(voxelRadiance, level);
+        }
+
+        QueryManager::setCounter("Radiance Voxelization: Draws", drawCount);
+    }
+    else
+    {
+        beginRadianceVoxelization(desc, voxelRadiance);
+
+        m_voxelizationRegions.clear();
+        for (auto level : levelsToUpdate)
+        {
+            m_voxelizationRegions.push_back({m_cachedClipRegions.at(level), level});
+        }
+
+        voxelizer->voxelize(m_voxelizationRegions);
+        QueryManager::setCounter("Radiance Voxelization: Draws", voxelizer->getDrawCount());
+
+        voxelizer->endVoxelization(m_renderPipeline->getCamera()->getViewport());
+    }
+}
+
+void RadianceInjectionPass::beginRadianceVoxelization(const VoxelizationDesc& desc, Texture3D* target) const
+{
+    Shader* shader = desc.voxelizationShader;
+    VoxelConeTracing::voxelizer()->beginVoxelization(desc);
+    shader->bindImage3D(*target, "u_voxelRadiance", GL_READ_WRITE, GL_R32UI, 0);
+    shader->setInt("u_fixedPointRadianceAccumulation", m_fixedPointAccumulation ? 1 : 0);
 
     // Set ShadowMap/Light uniforms
     GLint shadowMapStartTextureUnit = 5;
@@ -97,14 +175,76 @@ void RadianceInjectionPass::injectByVoxelization(Shader* shader, Texture3D* voxe
 
     shader->setFloat("u_depthBias", SHADOW_SETTINGS.depthBias);
     shader->setFloat("u_usePoissonFilter", SHADOW_SETTINGS.usePoissonFilter ? 1.0f : 0.0f);
+}
+
+void RadianceInjectionPass::injectByReflectiveShadowMaps(Texture3D* voxelRadiance)
+{
+    auto reflectiveShadowMaps = m_renderPipeline->fetchPtr(rp_keys::REFLECTIVE_SHADOW_MAPS);
+    auto& levelsToUpdate = m_clipmapUpdatePolicy->getLevelsScheduledForUpdate();
+
+    // Same timer name as the voxelization since the clipmap update policy learns the injection costs from it
+    PROFILE_GPU_ZONE("Radiance Voxelization");
+    Texture3D* target = m_fixedPointAccumulation ? &m_radianceAccumulator : voxelRadiance;
 
     for (auto level : levelsToUpdate)
     {
-        voxelizer->voxelize(m_cachedClipRegions.at(level), level);
+        const VoxelRegion& clipRegion = m_cachedClipRegions.at(level);
+        m_rsmInjectionShader->bind();
+        m_rsmInjectionShader->bindImage3D(*target, "u_voxelRadiance", GL_READ_WRITE, GL_R32UI, 0);
+        m_rsmInjectionShader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
+        m_rsmInjectionShader->setInt("u_clipmapResolutionWithBorder", VOXEL_RESOLUTION + 2);
+        m_rsmInjectionShader->setInt("u_fixedPointRadianceAccumulation", m_fixedPointAccumulation ? 1 : 0);
+        voxelization::setRegionUniforms(m_rsmInjectionShader.get(), clipRegion, level, m_cachedClipRegions, GI_SETTINGS.downsampleTransitionRegionSize);
+
+        for (auto& rsm : *reflectiveShadowMaps)
+        {
+            m_rsmInjectionShader->bindTexture2D(rsm.fluxTexture, "u_flux", 0);
+            m_rsmInjectionShader->bindTexture2D(rsm.normalTexture, "u_normal", 1);
+            m_rsmInjectionShader->bindTexture2D(rsm.depthTexture, "u_depth", 2);
+            m_rsmInjectionShader->setMatrix("u_viewProjInv", glm::inverse(rsm.viewProj));
+            m_rsmInjectionShader->setVector("u_lightDirection", rsm.lightDirection);
+
+            int texelStride = CPURSMInjector::computeTexelStride(clipRegion.voxelSize, rsm.texelSizeWorld);
+            m_rsmInjectionShader->setInt("u_texelStride", texelStride);
+
+            GLuint sampleCount = (rsm.resolution + texelStride - 1) / texelStride;
+            GLuint groupCount = (sampleCount + 7) / 8;
+            m_rsmInjectionShader->dispatchCompute(groupCount, groupCount, 1);
+        }
+
+        if (m_fixedPointAccumulation)
+            resolveRadiance(voxelRadiance, level);
     }
+}
+
+void RadianceInjectionPass::createRadianceAccumulator()
+{
+    static GLuint zero = 0;
+
+    m_radianceAccumulator.create(VOXEL_RESOLUTION * FACE_COUNT, VOXEL_RESOLUTION * 4, VOXEL_RESOLUTION,
+        GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, Texture3DSettings::Custom);
+
+    // The resolve only resets the touched accumulators
+    glClearTexImage(m_radianceAccumulator, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+}
+
+void RadianceInjectionPass::resolveRadiance(Texture3D* voxelRadiance, int clipLevel) const
+{
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
-    voxelizer->endVoxelization(m_renderPipeline->getCamera()->getViewport());
-    QueryManager::endElapsedTime(QueryTarget::GPU, "Radiance Voxelization");
+    m_resolveRadianceShader->bind();
+    m_resolveRadianceShader->bindImage3D(m_radianceAccumulator, "u_radianceAccumulator", GL_READ_WRITE, GL_R32UI, 0);
+    m_resolveRadianceShader->bindImage3D(*voxelRadiance, "u_voxelRadiance", GL_WRITE_ONLY, GL_RGBA8, 1);
+
+    m_resolveRadianceShader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
+    m_resolveRadianceShader->setInt("u_clipmapResolutionWithBorder", VOXEL_RESOLUTION + 2);
+    m_resolveRadianceShader->setInt("u_clipmapLevel", clipLevel);
+
+    GLuint groupCount = VOXEL_RESOLUTION / 8;
+    m_resolveRadianceShader->dispatchCompute(groupCount, groupCount, groupCount);
+
+    // The accumulators are reset for the next level
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 }
 
 void RadianceInjectionPass::copyAlpha(Texture3D* voxelRadiance, Texture3D* voxelOpacity, int clipLevel) const
@@ -127,9 +267,12 @@ Shader* RadianceInjectionPass::getSelectedShader()
     {
     case 0:
         m_voxelizationMode = VoxelizationMode::CONSERVATIVE;
-        return m_conservativeVoxelizationShader.get();
+        // The accumulators of the fixed-point accumulation hold a single clipmap level
+        m_multiRegionVoxelization = GI_SETTINGS.multiRegionVoxelization && !m_fixedPointAccumulation;
+        return m_multiRegionVoxelization ? m_multiRegionConservativeVoxelizationShader.get() : m_conservativeVoxelizationShader.get();
     case 1:
         m_voxelizationMode = VoxelizationMode::MSAA;
+        m_multiRegionVoxelization = false; // The MSAA voxelization has no multi-region variant
         return m_msaaVoxelizationShader.get();
     default:
         assert(false);
@@ -139,7 +282,7 @@ Shader* RadianceInjectionPass::getSelectedShader()
 
 void RadianceInjectionPass::downsample(Texture3D* voxelRadiance) const
 {
-    QueryManager::beginElapsedTime(QueryTarget::GPU, "Radiance Downsampling");
+    PROFILE_GPU_ZONE("Radiance Downsampling");
     auto& levelsToUpdate = m_clipmapUpdatePolicy->getLevelsScheduledForUpdate();
 
     if (m_clipmapUpdatePolicy->getType() == ClipmapUpdatePolicy::Type::ALL_PER_FRAME)
@@ -154,22 +297,19 @@ void RadianceInjectionPass::downsample(Texture3D* voxelRadiance) const
                 Downsampler::downsample(voxelRadiance, &m_cachedClipRegions, level);
         }
     }
-
-    QueryManager::endElapsedTime(QueryTarget::GPU, "Radiance Downsampling");
 }
 
 void RadianceInjectionPass::copyAlpha(Texture3D* voxelRadiance, Texture3D* voxelOpacity) const
 {
-    QueryManager::beginElapsedTime(QueryTarget::GPU, "Copy Alpha");
+    PROFILE_GPU_ZONE("Copy Alpha");
     auto& levelsToUpdate = m_clipmapUpdatePolicy->getLevelsScheduledForUpdate();
 
+    // The injected radiance - the opacity was made visible by the frame graph
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
     // Copy alpha from opacity texture (this allows us to access just one texture during GI pass)
     for (auto level : levelsToUpdate)
     {
         copyAlpha(voxelRadiance, voxelOpacity, level);
     }
-
-    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-    QueryManager::endElapsedTime(QueryTarget::GPU, "Copy Alpha");
 }
@@ -2,12 +2,12 @@
 #include <engine/rendering/shader/Shader.h>
 #include <engine/rendering/geometry/Mesh.h>
 #include <engine/rendering/architecture/RenderPass.h>
+#include <engine/rendering/Texture3D.h>
 #include "voxelization.h"
 #include "Globals.h"
 #include "ClipmapUpdatePolicy.h"
 
 class Framebuffer;
-class Texture3D;
 class BBox;
 
 struct DirLight
@@ -27,20 +27,53 @@ public:
     explicit RadianceInjectionPass();
 
     void update() override;
+
+    void declareResources(FrameGraphBuilder& builder) override;
 private:
+    void clearRadiance(Texture3D* voxelRadiance) const;
+
     void injectByVoxelization(Shader* shader, Texture3D* voxelRadiance, VoxelizationMode voxelizationMode);
 
+    /**
+    * Begins the voxelization with the light uniforms set and the target bound as u_voxelRadiance.
+    */
+    void beginRadianceVoxelization(const VoxelizationDesc& desc, Texture3D* target) const;
+
+    /**
+    * Scatters the texels of the reflective shadow maps rendered by ShadowMapPass into the radiance clipmap.
+    * The cost is independent of the number of triangles in the scene.
+    */
+    void injectByReflectiveShadowMaps(Texture3D* voxelRadiance);
+
+    /**
+    * The accumulators cover a single clipmap level: 6 faces along x and the channels r, g, b and sample count along y.
+    */
+    void createRadianceAccumulator();
+
+    /**
+    * Writes the averages of the fixed-point accumulators into the clipmap level and resets the accumulators.
+    * Every voxel of the level is written - the level doesn't need to be cleared before.
+    */
+    void resolveRadiance(Texture3D* voxelRadiance, int clipLevel) const;
+
     void downsample(Texture3D* voxelRadiance) const;
     void copyAlpha(Texture3D* voxelRadiance, Texture3D* voxelOpacity) const;
     void copyAlpha(Texture3D* voxelRadiance, Texture3D* voxelOpacity, int clipLevel) const;
     Shader* getSelectedShader();
 private:
     std::shared_ptr<Shader> m_conservativeVoxelizationShader;
+    std::shared_ptr<Shader> m_multiRegionConservativeVoxelizationShader;
     std::shared_ptr<Shader> m_msaaVoxelizationShader;
     std::shared_ptr<Shader> m_copyAlphaShader;
+    std::shared_ptr<Shader> m_rsmInjectionShader;
+    std::shared_ptr<Shader> m_resolveRadianceShader;
     VoxelizationMode m_voxelizationMode{VoxelizationMode::CONSERVATIVE};
+    bool m_multiRegionVoxelization{false};
+    bool m_fixedPointAccumulation{false};
+    Texture3D m_radianceAccumulator; // Created once the fixed-point accumulation is selected
 
     ClipmapUpdatePolicy* m_clipmapUpdatePolicy{ nullptr };
     std::vector<VoxelRegion> m_cachedClipRegions;
+    std::vector<VoxelizationRegion> m_voxelizationRegions; // Scheduled levels voxelized at once
     bool m_initializing{ true };
 };
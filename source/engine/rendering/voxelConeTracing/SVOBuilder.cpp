@@ -0,0 +1,310 @@
+#include "SVOBuilder.h"
+#include "CPUVoxelizer.h"
+#include "VoxelRegion.h"
+#include <engine/util/ThreadPool.h>
+#include <engine/util/morton/morton.h>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+
+const uint32_t SVOBuilder::MAX_DEPTH;
+
+namespace
+{
+    const std::size_t FRAGMENTS_PER_JOB = 4096;
+    const std::size_t NODES_PER_JOB = 1024;
+
+    // The radix sort splits the keys into at most MAX_SORT_CHUNK_COUNT chunks with at least MIN_SORT_CHUNK_SIZE keys
+    const std::size_t MAX_SORT_CHUNK_COUNT = 64;
+    const std::size_t MIN_SORT_CHUNK_SIZE = 16384;
+
+    uint32_t mortonCode(uint64_t key) { return uint32_t(key >> 32); }
+}
+
+void SVOBuilder::build(const std::vector<VoxelFragment>& fragments, const glm::ivec3& origin, uint32_t depth, float voxelSize,
+                       SparseVoxelOctree& svo, ThreadPool* threadPool)
+{
+    assert(depth <= MAX_DEPTH);
+    svo.m_nodes.clear();
+    svo.m_payloads.clear();
+    svo.m_levelOffsets.assign(depth + 2, 0);
+    svo.m_origin = origin;
+    svo.m_depth = depth;
+    svo.m_voxelSize = voxelSize;
+
+    if (fragments.empty())
+        return;
+
+    // Keys contain the Morton code in the upper and the fragment index in the lower 32 bits
+    m_keys.resize(fragments.size());
+    auto computeKeys = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            glm::ivec3 p = fragments[i].position - origin;
+            assert(glm::all(glm::greaterThanEqual(p, glm::ivec3(0))) && glm::all(glm::lessThan(p, glm::ivec3(1 << depth))));
+            m_keys[i] = (morton::encode(uint32_t(p.x), uint32_t(p.y), uint32_t(p.z)) << 32) | uint64_t(i);
+        }
+    };
+
+    if (threadPool)
+        threadPool->parallelFor(fragments.size(), FRAGMENTS_PER_JOB, computeKeys);
+    else
+        computeKeys(0, fragments.size());
+
+    radixSort(m_keys, m_tmpKeys, 32, 32 + 3 * depth, threadPool);
+
+    m_levels.resize(depth + 1);
+    buildLeaves(fragments, m_levels[depth], threadPool);
+
+    for (uint32_t d = depth; d-- > 0;)
+        buildParents(m_levels[d + 1], m_levels[d], threadPool);
+
+    // Store the levels breadth-first
+    for (uint32_t d = 0; d <= depth; ++d)
+        svo.m_levelOffsets[d + 1] = svo.m_levelOffsets[d] + uint32_t(m_levels[d].codes.size());
+
+    svo.m_nodes.resize(svo.m_levelOffsets[depth + 1]);
+    svo.m_payloads.resize(svo.m_nodes.size());
+
+    for (uint32_t d = 0; d <= depth; ++d)
+    {
+        const Level& level = m_levels[d];
+        uint32_t offset = svo.m_levelOffsets[d];
+
+        for (std::size_t i = 0; i < level.codes.size(); ++i)
+        {
+            auto& node = svo.m_nodes[offset + i];
+
+            if (d < depth)
+            {
+                node.firstChild = svo.m_levelOffsets[d + 1] + level.childStarts[i];
+                node.childMask = level.childMasks[i];
+            }
+            else
+            {
+                node = SparseVoxelOctree::Node();
+            }
+
+            svo.m_payloads[offset + i] = level.payloads[i];
+        }
+    }
+}
+
+void SVOBuilder::buildLeaves(const std::vector<VoxelFragment>& fragments, Level& leaves, ThreadPool* threadPool)
+{
+    // Every run of equal Morton codes becomes a leaf
+    leaves.codes.clear();
+    leaves.childStarts.clear();
+    leaves.childMasks.clear();
+
+    for (uint32_t i = 0; i < m_keys.size(); ++i)
+    {
+        if (i == 0 || mortonCode(m_keys[i]) != mortonCode(m_keys[i - 1]))
+        {
+            leaves.codes.push_back(mortonCode(m_keys[i]));
+            leaves.childStarts.push_back(i); // Start of the fragment run
+        }
+    }
+
+    leaves.payloads.resize(leaves.codes.size());
+
+    auto averageFragments = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            uint32_t runStart = leaves.childStarts[i];
+            uint32_t runEnd = i + 1 < leaves.childStarts.size() ? leaves.childStarts[i + 1] : uint32_t(m_keys.size());
+            uint32_t count = runEnd - runStart;
+
+            for (int face = 0; face < FACE_COUNT; ++face)
+            {
+                uint32_t sums[4] = {};
+                for (uint32_t j = runStart; j < runEnd; ++j)
+                {
+                    uint32_t value = fragments[uint32_t(m_keys[j])].payload[face];
+                    for (int c = 0; c < 4; ++c)
+                        sums[c] += (value >> (8 * c)) & 0xFF;
+                }
+
+                uint32_t average = 0;
+                for (int c = 0; c < 4; ++c)
+                    average |= ((sums[c] + count / 2) / count) << (8 * c);
+
+                leaves.payloads[i][face] = average;
+            }
+        }
+    };
+
+    if (threadPool)
+        threadPool->parallelFor(leaves.codes.size(), NODES_PER_JOB, averageFragments);
+    else
+        averageFragments(0, leaves.codes.size());
+}
+
+void SVOBuilder::buildParents(const Level& children, Level& parents, ThreadPool* threadPool)
+{
+    // Children are sorted by their codes, thus the children of a parent are a contiguous run
+    parents.codes.clear();
+    parents.childStarts.clear();
+    parents.childMasks.clear();
+
+    for (uint32_t i = 0; i < children.codes.size(); ++i)
+    {
+        uint32_t parentCode = children.codes[i] >> 3;
+
+        if (parents.codes.empty() || parents.codes.back() != parentCode)
+        {
+            parents.codes.push_back(parentCode);
+            parents.childStarts.push_back(i);
+            parents.childMasks.push_back(0);
+        }
+
+        parents.childMasks.back() |= uint8_t(1u << (children.codes[i] & 7));
+    }
+
+    parents.payloads.resize(parents.codes.size());
+
+    auto downsampleChildren = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const SparseVoxelOctree::FacePayload* childPayloads[8] = {};
+            uint32_t childIdx = parents.childStarts[i];
+
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                if (parents.childMasks[i] & (1u << octant))
+                    childPayloads[octant] = &children.payloads[childIdx++];
+
+            parents.payloads[i] = downsample(childPayloads);
+        }
+    };
+
+    if (threadPool)
+        threadPool->parallelFor(parents.codes.size(), NODES_PER_JOB, downsampleChildren);
+    else
+        downsampleChildren(0, parents.codes.size());
+}
+
+void SVOBuilder::collectFragments(const CPUVoxelizer& voxelizer, const VoxelRegion& region, int clipmapLevel, std::vector<VoxelFragment>& fragments)
+{
+    glm::ivec3 maxPos = region.getMaxPos();
+
+    for (int z = region.minPos.z; z < maxPos.z; ++z)
+        for (int y = region.minPos.y; y < maxPos.y; ++y)
+            for (int x = region.minPos.x; x < maxPos.x; ++x)
+            {
+                glm::ivec3 p(x, y, z);
+                if (voxelizer.getOpacity(clipmapLevel, 0, p) == 0)
+                    continue;
+
+                VoxelFragment fragment;
+                fragment.position = p;
+
+                // The opacity is stored in all channels
+                for (int face = 0; face < FACE_COUNT; ++face)
+                    fragment.payload[face] = uint32_t(voxelizer.getOpacity(clipmapLevel, face, p)) * 0x01010101u;
+
+                fragments.push_back(fragment);
+            }
+}
+
+SparseVoxelOctree::FacePayload SVOBuilder::downsample(const SparseVoxelOctree::FacePayload* children[8])
+{
+    SparseVoxelOctree::FacePayload result;
+
+    // Faces are ordered +X, -X, +Y, -Y, +Z, -Z
+    for (int face = 0; face < FACE_COUNT; ++face)
+    {
+        uint32_t axisBit = 1u << (face / 2);
+        bool positive = face % 2 == 0;
+        glm::vec4 sum(0.0f);
+
+        for (uint32_t octant = 0; octant < 8; ++octant)
+        {
+            if (octant & axisBit)
+                continue;
+
+            uint32_t frontOctant = positive ? octant : octant | axisBit;
+            uint32_t backOctant = positive ? octant | axisBit : octant;
+            glm::vec4 front = children[frontOctant] ? glm::unpackUnorm4x8((*children[frontOctant])[face]) : glm::vec4(0.0f);
+            glm::vec4 back = children[backOctant] ? glm::unpackUnorm4x8((*children[backOctant])[face]) : glm::vec4(0.0f);
+
+            // Front-to-back compositing
+            sum += front + (1.0f - front.a) * back;
+        }
+
+        result[face] = glm::packUnorm4x8(sum * 0.25f);
+    }
+
+    return result;
+}
+
+void SVOBuilder::radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& tmp, uint32_t beginBit, uint32_t endBit, ThreadPool* threadPool)
+{
+    std::size_t count = keys.size();
+    if (count == 0)
+        return;
+
+    tmp.resize(count);
+
+    // Every chunk has its own histogram which makes counting and scattering independent between chunks
+    std::size_t chunkCount = std::max(std::size_t(1), std::min(MAX_SORT_CHUNK_COUNT, count / MIN_SORT_CHUNK_SIZE));
+    std::size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    std::vector<std::array<std::size_t, 256>> histograms(chunkCount);
+
+    auto forEachChunk = [&](const std::function<void(std::size_t begin, std::size_t end, std::array<std::size_t, 256>& histogram)>& func)
+    {
+        auto run = [&](std::size_t chunkBegin, std::size_t chunkEnd)
+        {
+            for (std::size_t c = chunkBegin; c < chunkEnd; ++c)
+                func(c * chunkSize, std::min((c + 1) * chunkSize, count), histograms[c]);
+        };
+
+        if (threadPool)
+            threadPool->parallelFor(chunkCount, 1, run);
+        else
+            run(0, chunkCount);
+    };
+
+    for (uint32_t shift = beginBit; shift < endBit; shift += 8)
+    {
+        uint64_t digitMask = endBit - shift >= 8 ? 0xFF : (1u << (endBit - shift)) - 1;
+
+        forEachChunk([&](std::size_t begin, std::size_t end, std::array<std::size_t, 256>& histogram)
+        {
+            histogram.fill(0);
+            for (std::size_t i = begin; i < end; ++i)
+                ++histogram[(keys[i] >> shift) & digitMask];
+        });
+
+        // Skip digits which are equal for all keys
+        std::size_t firstDigit = (keys[0] >> shift) & digitMask;
+        std::size_t firstDigitCount = 0;
+        for (auto& histogram : histograms)
+            firstDigitCount += histogram[firstDigit];
+
+        if (firstDigitCount == count)
+            continue;
+
+        // Convert the counts to offsets: all keys with a smaller digit come first, then the same digit in earlier chunks
+        std::size_t offset = 0;
+        for (std::size_t digit = 0; digit < 256; ++digit)
+        {
+            for (auto& histogram : histograms)
+            {
+                std::size_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+        }
+
+        forEachChunk([&](std::size_t begin, std::size_t end, std::array<std::size_t, 256>& histogram)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                tmp[histogram[(keys[i] >> shift) & digitMask]++] = keys[i];
+        });
+
+        keys.swap(tmp);
+    }
+}
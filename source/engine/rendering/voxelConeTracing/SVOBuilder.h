@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "SparseVoxelOctree.h"
+
+class ThreadPool;
+class CPUVoxelizer;
+struct VoxelRegion;
+
+struct VoxelFragment
+{
+    glm::ivec3 position; // Voxel coordinates
+    SparseVoxelOctree::FacePayload payload;
+};
+
+/**
+* Builds a SparseVoxelOctree from voxel fragments.
+* The fragments are sorted by their Morton codes with a parallel radix sort. Fragments of the same voxel are averaged.
+* The octree is then built bottom-up: the parents of a sorted level are runs of equal codes >> 3 and
+* their payloads are computed with the anisotropic filter of the clipmap downsampling (downsample3DImage.comp).
+*/
+class SVOBuilder
+{
+public:
+    // Morton codes are limited to 32 bits
+    static const uint32_t MAX_DEPTH = 10;
+
+    /**
+    * Fragment positions relative to origin have to be in [0, 2^depth).
+    */
+    void build(const std::vector<VoxelFragment>& fragments, const glm::ivec3& origin, uint32_t depth, float voxelSize,
+               SparseVoxelOctree& svo, ThreadPool* threadPool = nullptr);
+
+    /**
+    * Appends a fragment for every opaque voxel of the region.
+    */
+    static void collectFragments(const CPUVoxelizer& voxelizer, const VoxelRegion& region, int clipmapLevel, std::vector<VoxelFragment>& fragments);
+
+    /**
+    * Computes the payload of a parent from its 8 children in octant order. Missing children are nullptr.
+    * Each face composites the two children along its axis front-to-back and averages the 4 results.
+    */
+    static SparseVoxelOctree::FacePayload downsample(const SparseVoxelOctree::FacePayload* children[8]);
+
+    /**
+    * Stable LSD radix sort of the keys by the bits [beginBit, endBit) with 8 bit digits.
+    */
+    static void radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& tmp, uint32_t beginBit, uint32_t endBit, ThreadPool* threadPool = nullptr);
+
+private:
+    struct Level
+    {
+        std::vector<uint32_t> codes;
+        std::vector<uint32_t> childStarts; // Index of the first child in the next level - first fragment key for leaves
+        std::vector<uint8_t> childMasks;
+        std::vector<SparseVoxelOctree::FacePayload> payloads;
+    };
+
+    void buildLeaves(const std::vector<VoxelFragment>& fragments, Level& leaves, ThreadPool* threadPool);
+
+    void buildParents(const Level& children, Level& parents, ThreadPool* threadPool);
+
+private:
+    // Reused between builds to avoid reallocations
+    std::vector<uint64_t> m_keys;
+    std::vector<uint64_t> m_tmpKeys;
+    std::vector<Level> m_levels;
+};
@@ -0,0 +1,28 @@
+#include "SparseVoxelOctree.h"
+
+const uint32_t SparseVoxelOctree::INVALID_NODE;
+
+uint32_t SparseVoxelOctree::lookup(const glm::ivec3& voxelPos, uint32_t depth) const
+{
+    assert(depth <= m_depth);
+    glm::ivec3 p = voxelPos - m_origin;
+    int resolution = int(getResolution());
+
+    if (m_nodes.empty() || glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, glm::ivec3(resolution))))
+        return INVALID_NODE;
+
+    uint32_t nodeIdx = 0;
+    for (uint32_t d = 0; d < depth && nodeIdx != INVALID_NODE; ++d)
+    {
+        uint32_t shift = m_depth - d - 1;
+        uint32_t octant = ((p.x >> shift) & 1) | (((p.y >> shift) & 1) << 1) | (((p.z >> shift) & 1) << 2);
+        nodeIdx = getChild(nodeIdx, octant);
+    }
+
+    return nodeIdx;
+}
+
+std::size_t SparseVoxelOctree::getMemoryUsage() const
+{
+    return m_nodes.size() * sizeof(Node) + m_payloads.size() * sizeof(FacePayload) + m_levelOffsets.size() * sizeof(uint32_t);
+}
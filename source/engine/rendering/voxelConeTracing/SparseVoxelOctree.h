@@ -0,0 +1,161 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <glm/glm.hpp>
+#include "Globals.h"
+
+/**
+* Pointer-less sparse voxel octree built by the SVOBuilder.
+* Nodes are stored in breadth-first order, so the root is node 0 and all nodes of a depth are stored
+* contiguously in Morton order. The children of a node are contiguous as well: A node only stores the index of
+* its first child and a mask of the existing children.
+*
+* Every node stores an anisotropic payload with one RGBA8 value per face (+X, -X, +Y, -Y, +Z, -Z) like the clipmap.
+* Positions are given in voxel coordinates of the leaf depth.
+*/
+class SparseVoxelOctree
+{
+    friend class SVOBuilder;
+
+public:
+    static const uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+
+    // 8 bytes
+    struct Node
+    {
+        bool isLeaf() const { return childMask == 0; }
+
+        uint32_t firstChild{0};
+        uint32_t childMask{0}; // Bit i is set if the child in octant i = x + 2y + 4z exists
+    };
+
+    // RGBA8 per face with red in the lowest byte (like packUnorm4x8)
+    using FacePayload = std::array<uint32_t, FACE_COUNT>;
+
+    /**
+    * Returns the node at the given depth that contains the voxel or INVALID_NODE if the voxel is empty at that depth.
+    */
+    uint32_t lookup(const glm::ivec3& voxelPos, uint32_t depth) const;
+
+    /**
+    * Returns the leaf that contains the voxel or INVALID_NODE.
+    */
+    uint32_t lookup(const glm::ivec3& voxelPos) const { return lookup(voxelPos, m_depth); }
+
+    /**
+    * Returns the child of the node in the given octant (x + 2y + 4z) or INVALID_NODE.
+    */
+    uint32_t getChild(uint32_t nodeIdx, uint32_t octant) const;
+
+    /**
+    * Visits the nodes depth-first. func(uint32_t nodeIdx, uint32_t depth, const glm::ivec3& minPos) is called for every node
+    * with the minimum voxel position covered by the node and has to return true to visit the children.
+    */
+    template <class TFunc>
+    void traverse(TFunc func) const;
+
+    glm::vec4 getColor(uint32_t nodeIdx, int face) const { return glm::unpackUnorm4x8(m_payloads[nodeIdx][face]); }
+
+    const Node& getNode(uint32_t nodeIdx) const { return m_nodes[nodeIdx]; }
+
+    const FacePayload& getPayload(uint32_t nodeIdx) const { return m_payloads[nodeIdx]; }
+
+    /**
+    * Returns the index of the first node of the given depth. The nodes of depth d are in [getLevelOffset(d), getLevelOffset(d + 1)).
+    */
+    uint32_t getLevelOffset(uint32_t depth) const { return m_levelOffsets[depth]; }
+
+    bool empty() const { return m_nodes.empty(); }
+
+    std::size_t getNodeCount() const { return m_nodes.size(); }
+
+    /**
+    * The depth of the leaves. The root has depth 0.
+    */
+    uint32_t getDepth() const { return m_depth; }
+
+    uint32_t getResolution() const { return 1u << m_depth; }
+
+    /**
+    * The voxel position of the minimum corner of the root.
+    */
+    const glm::ivec3& getOrigin() const { return m_origin; }
+
+    float getVoxelSize() const { return m_voxelSize; }
+
+    std::size_t getMemoryUsage() const;
+
+private:
+    static uint32_t countBits(uint32_t v);
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<FacePayload> m_payloads;
+    std::vector<uint32_t> m_levelOffsets;
+    glm::ivec3 m_origin{0};
+    uint32_t m_depth{0};
+    float m_voxelSize{1.0f};
+};
+
+inline uint32_t SparseVoxelOctree::countBits(uint32_t v)
+{
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+inline uint32_t SparseVoxelOctree::getChild(uint32_t nodeIdx, uint32_t octant) const
+{
+    const Node& node = m_nodes[nodeIdx];
+    uint32_t bit = 1u << octant;
+
+    if ((node.childMask & bit) == 0)
+        return INVALID_NODE;
+
+    return node.firstChild + countBits(node.childMask & (bit - 1));
+}
+
+template <class TFunc>
+void SparseVoxelOctree::traverse(TFunc func) const
+{
+    if (m_nodes.empty())
+        return;
+
+    struct Entry
+    {
+        uint32_t nodeIdx;
+        uint32_t depth;
+        glm::ivec3 minPos;
+    };
+
+    // At most 7 siblings per level wait on the stack
+    std::vector<Entry> stack;
+    stack.reserve(7 * m_depth + 1);
+    stack.push_back({0, 0, m_origin});
+
+    while (!stack.empty())
+    {
+        Entry e = stack.back();
+        stack.pop_back();
+
+        if (!func(e.nodeIdx, e.depth, e.minPos) || e.depth == m_depth)
+            continue;
+
+        int childSize = 1 << (m_depth - e.depth - 1);
+
+        // Push in reverse to visit the children in Morton order
+        for (uint32_t octant = 8; octant-- > 0;)
+        {
+            uint32_t child = getChild(e.nodeIdx, octant);
+            if (child == INVALID_NODE)
+                continue;
+
+            glm::ivec3 offset(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+            stack.push_back({child, e.depth + 1, e.minPos + offset * childSize});
+        }
+    }
+}
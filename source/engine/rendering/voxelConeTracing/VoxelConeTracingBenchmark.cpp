@@ -0,0 +1,617 @@
+#include "VoxelConeTracingBenchmark.h"
+#include "CPUVoxelizer.h"
+#include "SVOBuilder.h"
+#include "DirtyBrickMap.h"
+#include "CPURadianceAccumulation.h"
+#include "voxelization.h"
+#include <engine/geometry/BVH.h>
+#include <engine/geometry/intersection.h>
+#include <engine/util/Timer.h>
+#include <engine/util/ThreadPool.h>
+#include <engine/util/Logger.h>
+#include <random>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+namespace voxel_cone_tracing_benchmark
+{
+    /**
+    * Sponza-like triangle soup: Clusters of small triangles in a 38 x 16 x 24 box with roughly as many triangles as Sponza.
+    */
+    const int CLUSTER_COUNT = 512;
+    const int TRIANGLES_PER_CLUSTER = 512;
+    const glm::vec3 SCENE_EXTENT(38.0f, 16.0f, 24.0f);
+    const float EXTENT_WORLD_LEVEL_0 = 16.0f;
+
+    // The voxels around these triangles are compared with TriangleBBox::test
+    const std::size_t VALIDATION_TRIANGLE_COUNT = 1000;
+
+    // Moving objects of the dirty brick benchmark
+    const std::size_t MOVING_OBJECT_COUNTS[] = {250, 500, 1000, 2000};
+    const int MOVING_FRAME_COUNT = 10;
+
+    // Entities of the region query benchmark - every MOVING_ENTITY_STRIDE-th entity moves
+    const std::size_t REGION_QUERY_ENTITY_COUNTS[] = {1000, 10000, 50000};
+    const std::size_t MOVING_ENTITY_STRIDE = 20;
+
+    // Fragments of the radiance accumulation benchmark that hit the same voxel face and the number executing concurrently
+    const std::size_t ACCUMULATED_FRAGMENT_COUNT = 4096;
+    const std::size_t ACCUMULATION_WAVE_SIZES[] = {1, 32, 64, 128, 256};
+
+    std::vector<VoxelRegion> createClipRegions(const glm::vec3& center, float extentWorldLevel0)
+    {
+        // Clip regions around the center like VoxelizationPass::init places them around the camera
+        std::vector<VoxelRegion> clipRegions(CLIP_REGION_COUNT);
+        for (std::size_t i = 0; i < clipRegions.size(); ++i)
+        {
+            float voxelSize = (extentWorldLevel0 * std::exp2f(float(i))) / VOXEL_RESOLUTION;
+            glm::ivec3 voxelCenter = glm::ivec3(glm::floor(center / voxelSize));
+            clipRegions[i] = VoxelRegion(voxelCenter - VOXEL_RESOLUTION / 2, glm::ivec3(VOXEL_RESOLUTION), voxelSize);
+        }
+
+        return clipRegions;
+    }
+
+    /**
+    * The voxels of the bbox inside of the clip region like VoxelizationPass computes them.
+    */
+    VoxelRegion computeRegion(const BBox& bbox, const VoxelRegion& clipRegion)
+    {
+        glm::ivec3 minPos = voxelization::computeLowerBound(bbox.min() / clipRegion.voxelSize - math::EPSILON5);
+        glm::ivec3 maxPos = voxelization::computeUpperBound(bbox.max() / clipRegion.voxelSize + math::EPSILON5);
+        return clipRegion.intersect(VoxelRegion(minPos, maxPos - minPos, clipRegion.voxelSize));
+    }
+
+    /**
+    * The revoxelization regions of the moved objects computed like VoxelizationPass did before the DirtyBrickMap:
+    * Overlapping bounding boxes are united until no boxes overlap anymore.
+    */
+    void computeUnitedRegions(const std::vector<BBox>& lastFrameBBoxes, const std::vector<BBox>& bboxes,
+                              const std::vector<VoxelRegion>& clipRegions, std::vector<VoxelRegion>* regions)
+    {
+        std::vector<BBox> portions;
+        for (std::size_t i = 0; i < bboxes.size(); ++i)
+        {
+            BBox bbox = bboxes[i];
+            if (bbox.overlaps(lastFrameBBoxes[i]))
+                bbox.unite(lastFrameBBoxes[i]);
+            else
+                portions.push_back(lastFrameBBoxes[i]);
+
+            portions.push_back(bbox);
+        }
+
+        std::vector<bool> markedPortions(portions.size(), false);
+        for (std::size_t i = 0; i < portions.size(); ++i)
+        {
+            if (markedPortions[i])
+                continue;
+
+            std::size_t j = i + 1;
+            while (j < portions.size())
+            {
+                if (!markedPortions[j] && portions[i].overlaps(portions[j]))
+                {
+                    portions[i].unite(portions[j]);
+                    markedPortions[j] = true;
+                    j = i + 1;
+                }
+                else
+                    ++j;
+            }
+        }
+
+        for (std::size_t j = 0; j < portions.size(); ++j)
+        {
+            if (markedPortions[j])
+                continue;
+
+            for (std::size_t i = 0; i < clipRegions.size(); ++i)
+            {
+                VoxelRegion region = computeRegion(portions[j], clipRegions[i]);
+                if (!region.empty())
+                    regions[i].push_back(region);
+            }
+        }
+    }
+
+    std::size_t computeVolume(const std::vector<VoxelRegion>* regions)
+    {
+        std::size_t volume = 0;
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+            for (auto& region : regions[i])
+                volume += std::size_t(region.extent.x) * region.extent.y * region.extent.z;
+
+        return volume;
+    }
+
+#ifdef RUN_VOXEL_CONE_TRACING_BENCHMARKS
+    struct VoxelConeTracingBenchmarkRunner
+    {
+        VoxelConeTracingBenchmarkRunner()
+        {
+            VoxelConeTracingBenchmark::runBenchmarks();
+        }
+    };
+
+    VoxelConeTracingBenchmarkRunner voxelConeTracingBenchmarkRunner;
+#endif
+}
+
+using namespace voxel_cone_tracing_benchmark;
+
+void VoxelConeTracingBenchmark::runBenchmarks()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+
+    for (int c = 0; c < CLUSTER_COUNT; ++c)
+    {
+        glm::vec3 center = glm::vec3(unit(rng), unit(rng), unit(rng)) * SCENE_EXTENT;
+
+        for (int t = 0; t < TRIANGLES_PER_CLUSTER; ++t)
+        {
+            glm::vec3 p = center + (glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f) * 2.0f;
+
+            for (int v = 0; v < 3; ++v)
+            {
+                indices.push_back(uint32_t(vertices.size()));
+                vertices.push_back(p + (glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f) * 0.2f);
+            }
+        }
+    }
+
+    benchmarkCPUVoxelizer("Triangle clusters", vertices, indices, EXTENT_WORLD_LEVEL_0);
+
+    for (std::size_t objectCount : MOVING_OBJECT_COUNTS)
+        benchmarkDirtyBricks(objectCount);
+
+    for (std::size_t objectCount : REGION_QUERY_ENTITY_COUNTS)
+        benchmarkRegionQueries(objectCount);
+
+    for (std::size_t waveSize : ACCUMULATION_WAVE_SIZES)
+        benchmarkRadianceAccumulation(waveSize);
+}
+
+void VoxelConeTracingBenchmark::benchmarkCPUVoxelizer(const std::string& sceneName, const std::vector<glm::vec3>& vertices,
+                                                      const std::vector<uint32_t>& indices, float extentWorldLevel0)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    std::vector<BBox> triangleBBoxes(triangleCount);
+    BBox sceneBBox;
+
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        triangleBBoxes[i].unite({vertices[indices[3 * i]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]]});
+        sceneBBox.unite(triangleBBoxes[i]);
+    }
+
+    std::vector<VoxelRegion> clipRegions = createClipRegions(sceneBBox.center(), extentWorldLevel0);
+
+    LOG("Voxel Cone Tracing Benchmark: CPU voxelization of " << sceneName << " with " << triangleCount << " triangles into "
+        << CLIP_REGION_COUNT << " clip regions of " << VOXEL_RESOLUTION << "^3 voxels");
+
+    auto singleThreaded = std::make_unique<CPUVoxelizer>();
+    Timer timer;
+    std::size_t overlapCount = singleThreaded->voxelize(vertices, indices, clipRegions);
+    timer.tick();
+    double singleThreadedTime = double(std::max(timer.deltaTimeInMicroseconds(), uint64_t(1)));
+
+    auto parallel = std::make_unique<CPUVoxelizer>();
+    {
+        ThreadPool threadPool;
+        timer.start();
+        parallel->voxelize(vertices, indices, clipRegions, &threadPool);
+        timer.tick();
+    }
+    double parallelTime = double(std::max(timer.deltaTimeInMicroseconds(), uint64_t(1)));
+
+    // Every triangle is processed once per level
+    double processedTriangles = double(triangleCount * clipRegions.size());
+    LOG("CPU voxelization: " << processedTriangles / singleThreadedTime << " Mtris/s single threaded (" << singleThreadedTime / 1000.0 << " ms), "
+        << processedTriangles / parallelTime << " Mtris/s on " << ThreadPool::defaultWorkerCount() + 1 << " threads (" << parallelTime / 1000.0 << " ms), "
+        << overlapCount << " triangle/clip region overlaps, " << parallel->countOpaqueVoxels(clipRegions[0], 0) << " opaque voxels in level 0");
+
+    if (singleThreaded->getData() != parallel->getData())
+        LOG_ERROR("Parallel CPU voxelization differs from the single threaded voxelization");
+
+    // Compare the voxels around random triangles with the scalar overlap test
+    BVH bvh;
+    bvh.build(triangleBBoxes);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::size_t> triangleDistribution(0, triangleCount > 0 ? triangleCount - 1 : 0);
+    std::size_t mismatchCount = 0;
+    std::size_t testedVoxelCount = 0;
+    const VoxelRegion& region = clipRegions[0];
+    float voxelSize = region.voxelSize;
+
+    for (std::size_t i = 0; i < std::min(VALIDATION_TRIANGLE_COUNT, triangleCount); ++i)
+    {
+        const BBox& bbox = triangleBBoxes[triangleDistribution(rng)];
+        glm::ivec3 minPos = glm::max(glm::ivec3(glm::floor(bbox.min() / voxelSize)) - 1, region.minPos);
+        glm::ivec3 maxPos = glm::min(glm::ivec3(glm::floor(bbox.max() / voxelSize)) + 1, region.getMaxPos() - 1);
+
+        for (int z = minPos.z; z <= maxPos.z; ++z)
+            for (int y = minPos.y; y <= maxPos.y; ++y)
+                for (int x = minPos.x; x <= maxPos.x; ++x)
+                {
+                    glm::vec3 p = glm::vec3(x, y, z) * voxelSize;
+                    BBox voxelBBox(p, p + glm::vec3(voxelSize));
+                    bool opaque = false;
+
+                    bvh.query(voxelBBox, [&](uint32_t triangleIdx)
+                    {
+                        const glm::vec3& v0 = vertices[indices[3 * triangleIdx]];
+                        const glm::vec3& v1 = vertices[indices[3 * triangleIdx + 1]];
+                        const glm::vec3& v2 = vertices[indices[3 * triangleIdx + 2]];
+                        glm::vec3 n = glm::cross(v1 - v0, v2 - v0);
+
+                        if (opaque || glm::dot(n, n) == 0.0f)
+                            return;
+
+                        intersection::TriangleBBox t;
+                        t.setTriangle(v0, v1, v2);
+                        t.setBBoxScale(glm::vec3(voxelSize));
+                        opaque = t.test(voxelBBox);
+                    });
+
+                    if (opaque != (parallel->getOpacity(0, 0, glm::ivec3(x, y, z)) != 0))
+                        ++mismatchCount;
+
+                    ++testedVoxelCount;
+                }
+    }
+
+    if (mismatchCount > 0)
+        LOG_ERROR("CPU voxelization differs from TriangleBBox::test for " << mismatchCount << " of " << testedVoxelCount << " voxels");
+
+    benchmarkSVOBuilder(*parallel, clipRegions[0], 0);
+}
+
+void VoxelConeTracingBenchmark::benchmarkSVOBuilder(const CPUVoxelizer& voxelizer, const VoxelRegion& region, int clipmapLevel)
+{
+    std::vector<VoxelFragment> fragments;
+    SVOBuilder::collectFragments(voxelizer, region, clipmapLevel, fragments);
+
+    uint32_t depth = 0;
+    while ((1 << depth) < VOXEL_RESOLUTION)
+        ++depth;
+
+    LOG("Voxel Cone Tracing Benchmark: Sparse voxel octree with " << fragments.size() << " fragments and depth " << depth);
+
+    SVOBuilder builder;
+    SparseVoxelOctree svo;
+    Timer timer;
+    builder.build(fragments, region.minPos, depth, region.voxelSize, svo);
+    timer.tick();
+    double singleThreadedTime = double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+    {
+        ThreadPool threadPool;
+        timer.start();
+        builder.build(fragments, region.minPos, depth, region.voxelSize, svo, &threadPool);
+        timer.tick();
+    }
+    double parallelTime = double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+    // Dense anisotropic 3D texture with a full mip chain built with the same filter
+    timer.start();
+    std::vector<std::vector<SparseVoxelOctree::FacePayload>> mips(depth + 1);
+    mips[0].assign(std::size_t(VOXEL_RESOLUTION) * VOXEL_RESOLUTION * VOXEL_RESOLUTION, SparseVoxelOctree::FacePayload());
+    auto texelIndex = [](const glm::ivec3& p, int resolution) { return (std::size_t(p.z) * resolution + p.y) * resolution + p.x; };
+
+    for (auto& fragment : fragments)
+        mips[0][texelIndex(fragment.position - region.minPos, VOXEL_RESOLUTION)] = fragment.payload;
+
+    for (uint32_t mip = 1; mip <= depth; ++mip)
+    {
+        int resolution = VOXEL_RESOLUTION >> mip;
+        mips[mip].resize(std::size_t(resolution) * resolution * resolution);
+
+        for (int z = 0; z < resolution; ++z)
+            for (int y = 0; y < resolution; ++y)
+                for (int x = 0; x < resolution; ++x)
+                {
+                    const SparseVoxelOctree::FacePayload* children[8];
+                    for (int octant = 0; octant < 8; ++octant)
+                    {
+                        glm::ivec3 child = glm::ivec3(x, y, z) * 2 + glm::ivec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+                        children[octant] = &mips[mip - 1][texelIndex(child, resolution * 2)];
+                    }
+
+                    mips[mip][texelIndex(glm::ivec3(x, y, z), resolution)] = SVOBuilder::downsample(children);
+                }
+    }
+    timer.tick();
+    double denseTime = double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+    std::size_t denseMemory = 0;
+    for (auto& mip : mips)
+        denseMemory += mip.size() * sizeof(SparseVoxelOctree::FacePayload);
+
+    LOG("SVO build: " << singleThreadedTime << " ms single threaded, " << parallelTime << " ms on " << ThreadPool::defaultWorkerCount() + 1
+        << " threads, dense mip chain: " << denseTime << " ms");
+    LOG("SVO memory: " << svo.getMemoryUsage() / 1024 << " KB for " << svo.getNodeCount() << " nodes, dense 3D texture: "
+        << mips[0].size() * sizeof(SparseVoxelOctree::FacePayload) / 1024 << " KB, with mipmaps: " << denseMemory / 1024 << " KB");
+
+    // Every node has to match the dense texture and every fragment has to be found
+    std::size_t mismatchCount = 0;
+    svo.traverse([&](uint32_t nodeIdx, uint32_t nodeDepth, const glm::ivec3& minPos)
+    {
+        uint32_t mip = depth - nodeDepth;
+        glm::ivec3 p = (minPos - region.minPos) >> int(mip);
+        if (svo.getPayload(nodeIdx) != mips[mip][texelIndex(p, VOXEL_RESOLUTION >> mip)])
+            ++mismatchCount;
+
+        return true;
+    });
+
+    for (auto& fragment : fragments)
+    {
+        uint32_t leaf = svo.lookup(fragment.position);
+        if (leaf == SparseVoxelOctree::INVALID_NODE || svo.getPayload(leaf) != fragment.payload)
+            ++mismatchCount;
+    }
+
+    if (mismatchCount > 0)
+        LOG_ERROR("Sparse voxel octree differs from the dense texture for " << mismatchCount << " nodes");
+}
+
+void VoxelConeTracingBenchmark::benchmarkDirtyBricks(std::size_t objectCount)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<VoxelRegion> clipRegions = createClipRegions(SCENE_EXTENT * 0.5f, EXTENT_WORLD_LEVEL_0);
+
+    // Boxes of 0.1 to 1 units that move up to 0.2 units per frame
+    std::vector<BBox> bboxes(objectCount);
+    std::vector<glm::vec3> velocities(objectCount);
+    for (std::size_t i = 0; i < objectCount; ++i)
+    {
+        glm::vec3 p = glm::vec3(unit(rng), unit(rng), unit(rng)) * SCENE_EXTENT;
+        bboxes[i] = BBox(p, p + glm::vec3(0.1f + 0.9f * unit(rng)));
+        velocities[i] = (glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f) * 0.4f;
+    }
+
+    DirtyBrickMap dirtyBricks[CLIP_REGION_COUNT];
+    double unitedTime = 0.0;
+    double brickTime = 0.0;
+    std::size_t unitedVolume = 0;
+    std::size_t brickVolume = 0;
+    std::size_t unitedRegionCount = 0;
+    std::size_t brickRegionCount = 0;
+    std::size_t uncoveredVoxelCount = 0;
+    std::size_t overlappingBrickCount = 0;
+    Timer timer;
+
+    for (int frame = 0; frame < MOVING_FRAME_COUNT; ++frame)
+    {
+        std::vector<BBox> lastFrameBBoxes = bboxes;
+        for (std::size_t i = 0; i < objectCount; ++i)
+            bboxes[i] = BBox(bboxes[i].min() + velocities[i], bboxes[i].max() + velocities[i]);
+
+        std::vector<VoxelRegion> unitedRegions[CLIP_REGION_COUNT];
+        timer.start();
+        computeUnitedRegions(lastFrameBBoxes, bboxes, clipRegions, unitedRegions);
+        timer.tick();
+        unitedTime += double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+        std::vector<VoxelRegion> brickRegions[CLIP_REGION_COUNT];
+        std::size_t dirtyBrickCount = 0;
+        timer.start();
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+            dirtyBricks[i].reset(clipRegions[i]);
+
+        for (std::size_t j = 0; j < objectCount; ++j)
+        {
+            for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+            {
+                dirtyBricks[i].mark(lastFrameBBoxes[j]);
+                dirtyBricks[i].mark(bboxes[j]);
+            }
+        }
+
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        {
+            dirtyBrickCount += dirtyBricks[i].getDirtyBrickCount();
+            dirtyBricks[i].extractRegions(brickRegions[i]);
+        }
+        timer.tick();
+        brickTime += double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+        unitedVolume += computeVolume(unitedRegions);
+        brickVolume += computeVolume(brickRegions);
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        {
+            unitedRegionCount += unitedRegions[i].size();
+            brickRegionCount += brickRegions[i].size();
+        }
+
+        // The extracted regions must not overlap
+        std::size_t brickVoxelCount = std::size_t(DirtyBrickMap::BRICK_SIZE) * DirtyBrickMap::BRICK_SIZE * DirtyBrickMap::BRICK_SIZE;
+        if (computeVolume(brickRegions) != dirtyBrickCount * brickVoxelCount)
+            ++overlappingBrickCount;
+
+        // Every voxel of a moved object has to be revoxelized
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        {
+            const VoxelRegion& clipRegion = clipRegions[i];
+            std::vector<bool> covered(std::size_t(VOXEL_RESOLUTION) * VOXEL_RESOLUTION * VOXEL_RESOLUTION, false);
+            auto forEachVoxel = [&](const VoxelRegion& region, const std::function<void(std::size_t)>& func)
+            {
+                for (int z = region.minPos.z; z < region.getMaxPos().z; ++z)
+                    for (int y = region.minPos.y; y < region.getMaxPos().y; ++y)
+                        for (int x = region.minPos.x; x < region.getMaxPos().x; ++x)
+                        {
+                            glm::ivec3 p = glm::ivec3(x, y, z) - clipRegion.minPos;
+                            func((std::size_t(p.z) * VOXEL_RESOLUTION + p.y) * VOXEL_RESOLUTION + p.x);
+                        }
+            };
+
+            for (auto& region : brickRegions[i])
+                forEachVoxel(region, [&](std::size_t idx) { covered[idx] = true; });
+
+            for (std::size_t j = 0; j < objectCount; ++j)
+            {
+                forEachVoxel(computeRegion(lastFrameBBoxes[j], clipRegion), [&](std::size_t idx) { if (!covered[idx]) ++uncoveredVoxelCount; });
+                forEachVoxel(computeRegion(bboxes[j], clipRegion), [&](std::size_t idx) { if (!covered[idx]) ++uncoveredVoxelCount; });
+            }
+        }
+    }
+
+    LOG("Dirty bricks with " << objectCount << " moving objects: " << unitedTime / MOVING_FRAME_COUNT << " ms per frame uniting bounding boxes ("
+        << unitedVolume / MOVING_FRAME_COUNT << " voxels in " << unitedRegionCount / MOVING_FRAME_COUNT << " regions), " << brickTime / MOVING_FRAME_COUNT << " ms per frame with dirty bricks ("
+        << brickVolume / MOVING_FRAME_COUNT << " voxels in " << brickRegionCount / MOVING_FRAME_COUNT << " regions)");
+
+    if (uncoveredVoxelCount > 0 || overlappingBrickCount > 0)
+        LOG_ERROR("Dirty brick regions miss " << uncoveredVoxelCount << " voxels of moved objects or overlap in " << overlappingBrickCount << " frames");
+}
+
+void VoxelConeTracingBenchmark::benchmarkRegionQueries(std::size_t objectCount)
+{
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<VoxelRegion> clipRegions = createClipRegions(SCENE_EXTENT * 0.5f, EXTENT_WORLD_LEVEL_0);
+
+    // Boxes of 0.1 to 1 units - the moving ones move up to 0.2 units per frame
+    std::vector<BBox> bboxes(objectCount);
+    std::vector<glm::vec3> velocities(objectCount, glm::vec3(0.0f));
+    for (std::size_t i = 0; i < objectCount; ++i)
+    {
+        glm::vec3 p = glm::vec3(unit(rng), unit(rng), unit(rng)) * SCENE_EXTENT;
+        bboxes[i] = BBox(p, p + glm::vec3(0.1f + 0.9f * unit(rng)));
+
+        if (i % MOVING_ENTITY_STRIDE == 0)
+            velocities[i] = (glm::vec3(unit(rng), unit(rng), unit(rng)) - 0.5f) * 0.4f;
+    }
+
+    // Like the static layer of the Voxelizer: The moving entities are filtered out
+    auto isStatic = [](uint32_t idx) { return idx % MOVING_ENTITY_STRIDE != 0; };
+
+    // Like SceneBVH: Built once and refitted when entities move
+    BVH bvh;
+    bvh.build(bboxes, 1);
+
+    DirtyBrickMap dirtyBricks[CLIP_REGION_COUNT];
+    std::vector<VoxelRegion> regions;
+    std::vector<BBox> regionBBoxes;
+    std::vector<std::vector<uint32_t>> scannedDrawLists;
+    BVH::BatchQueryResult drawLists;
+    std::vector<uint32_t> regionDrawList;
+    double refitTime = 0.0;
+    double scanTime = 0.0;
+    double batchedTime = 0.0;
+    std::size_t regionCount = 0;
+    std::size_t drawCount = 0;
+    std::size_t drawListEntityCount = 0;
+    std::size_t mismatchCount = 0;
+    Timer timer;
+
+    for (int frame = 0; frame < MOVING_FRAME_COUNT; ++frame)
+    {
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+            dirtyBricks[i].reset(clipRegions[i]);
+
+        for (std::size_t j = 0; j < objectCount; j += MOVING_ENTITY_STRIDE)
+        {
+            for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+                dirtyBricks[i].mark(bboxes[j]);
+
+            bboxes[j] = BBox(bboxes[j].min() + velocities[j], bboxes[j].max() + velocities[j]);
+
+            for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+                dirtyBricks[i].mark(bboxes[j]);
+        }
+
+        timer.start();
+        bvh.refit(bboxes);
+        timer.tick();
+        refitTime += double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        {
+            regions.clear();
+            dirtyBricks[i].extractRegions(regions);
+            regionCount += regions.size();
+
+            // Extended by epsilon like Voxelizer::voxelize
+            regionBBoxes.clear();
+            for (auto& region : regions)
+                regionBBoxes.push_back(BBox(region.getMinPosWorld() - math::EPSILON5, region.getMaxPosWorld() + math::EPSILON5));
+
+            // Every region scans all entities like ECSUtil::renderEntitiesInAABB
+            timer.start();
+            scannedDrawLists.resize(regionBBoxes.size());
+            for (std::size_t j = 0; j < regionBBoxes.size(); ++j)
+            {
+                scannedDrawLists[j].clear();
+                for (uint32_t k = 0; k < uint32_t(objectCount); ++k)
+                {
+                    if (isStatic(k) && regionBBoxes[j].overlaps(bboxes[k]))
+                        scannedDrawLists[j].push_back(k);
+                }
+            }
+            timer.tick();
+            scanTime += double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+            timer.start();
+            bvh.query(regionBBoxes, isStatic, drawLists);
+            timer.tick();
+            batchedTime += double(timer.deltaTimeInMicroseconds()) / 1000.0;
+
+            drawCount += drawLists.bboxPrimitives.size();
+            drawListEntityCount += drawLists.primitives.size();
+
+            for (std::size_t j = 0; j < regionBBoxes.size(); ++j)
+            {
+                regionDrawList.clear();
+                for (uint32_t k = drawLists.bboxOffsets[j]; k < drawLists.bboxOffsets[j + 1]; ++k)
+                    regionDrawList.push_back(drawLists.primitives[drawLists.bboxPrimitives[k]]);
+
+                std::sort(regionDrawList.begin(), regionDrawList.end());
+                if (regionDrawList != scannedDrawLists[j])
+                    ++mismatchCount;
+            }
+        }
+    }
+
+    auto throughput = [regionCount](double time) { return double(regionCount) / std::max(time, 0.001); };
+
+    LOG("Region queries with " << objectCount << " entities and " << regionCount / MOVING_FRAME_COUNT << " regions per frame: "
+        << scanTime / MOVING_FRAME_COUNT << " ms per frame scanning all entities (" << throughput(scanTime) << " regions/ms), "
+        << batchedTime / MOVING_FRAME_COUNT << " ms per frame with batched BVH queries per level (" << throughput(batchedTime) << " regions/ms), "
+        << refitTime / MOVING_FRAME_COUNT << " ms BVH refit, " << drawCount / MOVING_FRAME_COUNT << " draws of "
+        << drawListEntityCount / MOVING_FRAME_COUNT << " distinct entities");
+
+    if (mismatchCount > 0)
+        LOG_ERROR("Batched BVH queries differ from the scan in " << mismatchCount << " regions");
+}
+
+void VoxelConeTracingBenchmark::benchmarkRadianceAccumulation(std::size_t waveSize)
+{
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> fragments(ACCUMULATED_FRAGMENT_COUNT);
+
+    for (auto& fragment : fragments)
+        fragment = glm::vec3(unit(rng), unit(rng), unit(rng));
+
+    glm::vec3 reference = CPURadianceAccumulation::computeReference(fragments);
+    auto maxError = [&reference](const RadianceAccumulationResult& result)
+    {
+        glm::vec3 error = glm::abs(result.radiance - reference) * 255.0f;
+        return std::max(error.x, std::max(error.y, error.z));
+    };
+
+    RadianceAccumulationResult rgba8Avg = CPURadianceAccumulation::accumulateRGBA8Avg(fragments, waveSize);
+    RadianceAccumulationResult fixedPoint = CPURadianceAccumulation::accumulateFixedPoint(fragments);
+    double fragmentCount = double(fragments.size());
+
+    LOG("Radiance accumulation of " << fragments.size() << " fragments in waves of " << waveSize << ": "
+        << "RGBA8 average " << rgba8Avg.atomicOperationCount / fragmentCount << " atomics per fragment, " << rgba8Avg.droppedFragmentCount
+        << " dropped fragments, max error " << maxError(rgba8Avg) << "/255 - fixed-point " << fixedPoint.atomicOperationCount / fragmentCount
+        << " atomics per fragment, " << fixedPoint.droppedFragmentCount << " dropped fragments, max error " << maxError(fixedPoint) << "/255");
+}
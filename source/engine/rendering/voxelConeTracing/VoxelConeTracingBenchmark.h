@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class CPUVoxelizer;
+struct VoxelRegion;
+
+// Runs the voxel cone tracing benchmarks on startup and logs the results
+//#define RUN_VOXEL_CONE_TRACING_BENCHMARKS
+
+class VoxelConeTracingBenchmark
+{
+public:
+    static void runBenchmarks();
+
+    /**
+    * Measures the triangle throughput of the CPUVoxelizer for clip regions centered around the given triangles
+    * and compares the result with TriangleBBox::test.
+    */
+    static void benchmarkCPUVoxelizer(const std::string& sceneName, const std::vector<glm::vec3>& vertices,
+                                      const std::vector<uint32_t>& indices, float extentWorldLevel0);
+
+private:
+    /**
+    * Compares the revoxelization regions of moving objects computed by uniting overlapping bounding boxes
+    * with the regions extracted from a DirtyBrickMap.
+    */
+    static void benchmarkDirtyBricks(std::size_t objectCount);
+
+    /**
+    * Compares the draw lists of the revoxelization regions of moving objects computed by scanning all entities per region
+    * (like ECSUtil::renderEntitiesInAABB) with the batched BVH query per clipmap level of the Voxelizer.
+    */
+    static void benchmarkRegionQueries(std::size_t objectCount);
+
+    /**
+    * Replays a fragment stream hitting a single voxel face in waves of concurrent invocations and compares accuracy and
+    * atomic operation counts of the RGBA8 compare and swap average with the fixed-point accumulation.
+    */
+    static void benchmarkRadianceAccumulation(std::size_t waveSize);
+
+    /**
+    * Compares build time and memory of a sparse voxel octree over the region with a dense anisotropic 3D texture with mipmaps.
+    */
+    static void benchmarkSVOBuilder(const CPUVoxelizer& voxelizer, const VoxelRegion& region, int clipmapLevel);
+};
@@ -46,10 +46,29 @@ struct VoxelRegion
         return VoxelRegion(minPos * 2, extent * 2, voxelSize / 2.0f);
     }
 
+    /**
+    * Returns the region of the next (coarser) level that covers this region.
+    * Rounds the min down and the max up, also for negative coordinates.
+    */
     VoxelRegion toNextLevelRegion() const
     {
-        // extent + 1 is used to make sure that the upper bound is computed
-        return VoxelRegion(minPos / 2, (extent + 1) / 2, voxelSize * 2.0f);
+        glm::ivec3 nextMinPos = glm::ivec3(glm::floor(glm::vec3(minPos) * 0.5f));
+        glm::ivec3 nextMaxPos = glm::ivec3(glm::ceil(glm::vec3(getMaxPos()) * 0.5f));
+        return VoxelRegion(nextMinPos, nextMaxPos - nextMinPos, voxelSize * 2.0f);
+    }
+
+    bool empty() const { return glm::any(glm::lessThanEqual(extent, glm::ivec3(0))); }
+
+    bool contains(const VoxelRegion& r) const { return glm::all(glm::lessThanEqual(minPos, r.minPos)) && glm::all(glm::lessThanEqual(r.getMaxPos(), getMaxPos())); }
+
+    /**
+    * Returns the overlap of both regions. The result is empty() if they don't overlap.
+    */
+    VoxelRegion intersect(const VoxelRegion& r) const
+    {
+        glm::ivec3 newMinPos = glm::max(minPos, r.minPos);
+        glm::ivec3 newMaxPos = glm::min(getMaxPos(), r.getMaxPos());
+        return VoxelRegion(newMinPos, glm::max(newMaxPos - newMinPos, glm::ivec3(0)), voxelSize);
     }
 
     glm::ivec3 minPos;       // The minimum position in local voxel coordinates
@@ -4,6 +4,7 @@
 #include <engine/util/Logger.h>
 #include <engine/geometry/BBox.h>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/ecs/ECS.h>
 #include <engine/resource/ResourceManager.h>
 #include <engine/rendering/util/ImageCleaner.h>
@@ -12,7 +13,10 @@
 #include "voxelization.h"
 #include "Downsampler.h"
 #include "engine/util/QueryManager.h"
+#include "engine/util/Profiler.h"
 #include "VoxelConeTracing.h"
+#include "ClipmapUpdatePolicy.h"
+#include "DynamicVoxelization.h"
 #include <cstddef>
 
 VoxelizationPass::VoxelizationPass()
@@ -21,6 +25,11 @@ VoxelizationPass::VoxelizationPass()
     m_voxelizeShader = ResourceManager::getShader("shaders/voxelConeTracing/conservative6SeparatingOpacityVoxelization.vert", 
     	"shaders/voxelConeTracing/conservative6SeparatingOpacityVoxelization.frag", "shaders/voxelConeTracing/conservative6SeparatingOpacityVoxelization.geom");
 
+    m_multiRegionVoxelizeShader = ResourceManager::getShader("shaders/voxelConeTracing/conservative6SeparatingOpacityVoxelization.vert",
+        "shaders/voxelConeTracing/conservative6SeparatingOpacityVoxelizationMultiRegion.frag", "shaders/voxelConeTracing/conservativeMultiRegionVoxelization.geom");
+
+    m_copyStaticOpacityShader = ResourceManager::getComputeShader("shaders/voxelConeTracing/copyStaticOpacity.comp");
+
     m_clipRegions.resize(CLIP_REGION_COUNT);
 }
 
@@ -38,7 +47,7 @@ void VoxelizationPass::init(float extentWorldLevel0)
     }
 
     // Move regions to be "centered" (close to the center in discrete voxel coordinates) around the camera
-    auto clipRegionBBoxes = m_renderPipeline->fetchPtr<std::vector<BBox>>("ClipRegionBBoxes");
+    auto clipRegionBBoxes = m_renderPipeline->fetchPtr(rp_keys::CLIP_REGION_BBOXES);
     
     for (uint32_t clipmapLevel = 0; clipmapLevel < CLIP_REGION_COUNT; ++clipmapLevel)
     {
@@ -50,14 +59,32 @@ void VoxelizationPass::init(float extentWorldLevel0)
         clipRegion.minPos += delta;
     }
 
+    // One face is enough because all faces of the voxelized opacity are equal
+    GLsizei resolutionWithBorder = VOXEL_RESOLUTION + 2;
+    m_staticVoxelOpacity.create(resolutionWithBorder, CLIP_REGION_COUNT * resolutionWithBorder, resolutionWithBorder,
+        GL_R8, GL_RED, GL_UNSIGNED_BYTE, Texture3DSettings::Custom);
+
     m_forceFullRevoxelization = true;
 }
 
+void VoxelizationPass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.read(rp_keys::CLIP_REGION_BBOXES, FrameGraphAccess::CPU);
+    builder.read(rp_keys::CLIPMAP_UPDATE_POLICY, FrameGraphAccess::CPU);
+    builder.write(rp_keys::CLIPMAP_UPDATE_POLICY, FrameGraphAccess::CPU); // Dirty voxels
+    builder.write(rp_keys::VOXEL_OPACITY, FrameGraphAccess::IMAGE);
+    builder.write(rp_keys::CLIP_REGIONS, FrameGraphAccess::CPU);
+    builder.write(rp_keys::VOXEL_OPACITY_DIRTY_LEVELS, FrameGraphAccess::CPU);
+}
+
 void VoxelizationPass::update()
 {
     // Fetch the data
-    m_voxelOpacity = m_renderPipeline->fetchPtr<Texture3D>("VoxelOpacity");
-    auto clipRegionBBoxes = m_renderPipeline->fetchPtr<std::vector<BBox>>("ClipRegionBBoxes");
+    m_voxelOpacity = m_renderPipeline->fetchPtr(rp_keys::VOXEL_OPACITY);
+    auto clipRegionBBoxes = m_renderPipeline->fetchPtr(rp_keys::CLIP_REGION_BBOXES);
+
+    // Also used by the radiance voxelization later in the frame
+    VoxelConeTracing::voxelizer()->updateSceneBVH();
 
     if (m_forceFullRevoxelization)
     {
@@ -65,6 +92,7 @@ void VoxelizationPass::update()
         {
             m_revoxelizationRegions[i].clear();
             m_revoxelizationRegions[i].push_back(m_clipRegions[i]);
+            m_dynamicRegions[i].clear();
         }
 
         m_forceFullRevoxelization = false;
@@ -74,60 +102,158 @@ void VoxelizationPass::update()
         for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
         {
             m_revoxelizationRegions[i].clear();
+            m_dynamicRegions[i].clear();
             computeRevoxelizationRegionsClipmap(i, clipRegionBBoxes->at(i));
         }
 
         computeRevoxelizationRegionsDynamicEntities();
     }
 
-    QueryManager::beginElapsedTime(QueryTarget::GPU, "Clear Voxel Opacity Regions");
-    for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
     {
-        // Clear the regions
-        for (auto& region : m_revoxelizationRegions[i])
+        PROFILE_GPU_ZONE("Clear Voxel Opacity Regions");
+        for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
         {
-            ImageCleaner::clear6FacesImage3D(*m_voxelOpacity, GL_RGBA8, region.getMinPosImage(m_clipRegions[i].extent), region.extent, VOXEL_RESOLUTION, GLuint(i), 1);
+            // Clear the regions
+            for (auto& region : m_revoxelizationRegions[i])
+            {
+                ImageCleaner::clear6FacesImage3D(*m_voxelOpacity, GL_RGBA8, region.getMinPosImage(m_clipRegions[i].extent), region.extent, VOXEL_RESOLUTION, GLuint(i), 1);
+            }
         }
+
+        // The voxelization overwrites the cleared voxels
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
 
-    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-    QueryManager::endElapsedTime(QueryTarget::GPU, "Clear Voxel Opacity Regions");
+    m_staticVoxelizationRegions.clear();
+    m_dynamicVoxelizationRegions.clear();
+    for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+    {
+        for (auto& region : m_revoxelizationRegions[i])
+        {
+            m_staticVoxelizationRegions.push_back({region, i});
+            m_dynamicVoxelizationRegions.push_back({region, i});
+        }
+
+        for (auto& region : m_dynamicRegions[i])
+            m_dynamicVoxelizationRegions.push_back({region, i});
+    }
 
     VoxelizationDesc desc;
     desc.mode = VoxelizationMode::CONSERVATIVE;
     desc.clipRegions = m_clipRegions;
-    desc.voxelizationShader = m_voxelizeShader.get();
+    desc.multiRegion = GI_SETTINGS.multiRegionVoxelization;
+    desc.voxelizationShader = desc.multiRegion ? m_multiRegionVoxelizeShader.get() : m_voxelizeShader.get();
     desc.downsampleTransitionRegionSize = GI_SETTINGS.downsampleTransitionRegionSize;
     Voxelizer* voxelizer = VoxelConeTracing::voxelizer();
+
+    // Static geometry is only voxelized in the revoxelization regions and stored in the static opacity
     voxelizer->beginVoxelization(desc);
-    m_voxelizeShader->bindImage3D(*m_voxelOpacity, "u_voxelOpacity", GL_WRITE_ONLY, GL_RGBA8, 0); // GL_WRITE_ONLY, GL_RGBA8
+    desc.voxelizationShader->bindImage3D(*m_voxelOpacity, "u_voxelOpacity", GL_WRITE_ONLY, GL_RGBA8, 0); // GL_WRITE_ONLY, GL_RGBA8
+    voxelizer->voxelize(m_staticVoxelizationRegions, VoxelizationLayer::STATIC);
+    std::size_t drawCount = voxelizer->getDrawCount();
+    voxelizer->endVoxelization(m_renderPipeline->getCamera()->getViewport());
 
-    for (int i = 0; i < CLIP_REGION_COUNT; ++i)
     {
-        // Voxelize the regions
-        for (auto& region : m_revoxelizationRegions[i])
+        PROFILE_GPU_ZONE("Copy Static Voxel Opacity");
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
         {
-            voxelizer->voxelize(region, i);
+            for (auto& region : m_revoxelizationRegions[i])
+                copyStaticOpacity(region, i, false);
         }
+
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        // Removes the dynamic entities where they have been
+        for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        {
+            for (auto& region : m_dynamicRegions[i])
+                copyStaticOpacity(region, i, true);
+        }
+
+        // The dynamic voxelization writes over the copied voxels - the downsampling waits for its writes
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
 
+    // The dynamic overlay is rebuilt in all regions
+    voxelizer->beginVoxelization(desc);
+    desc.voxelizationShader->bindImage3D(*m_voxelOpacity, "u_voxelOpacity", GL_WRITE_ONLY, GL_RGBA8, 0);
+    voxelizer->voxelize(m_dynamicVoxelizationRegions, VoxelizationLayer::DYNAMIC);
+    drawCount += voxelizer->getDrawCount();
     voxelizer->endVoxelization(m_renderPipeline->getCamera()->getViewport());
+
+    QueryManager::setCounter("Opacity Voxelization: Draws", drawCount);
     
-    bool m_downsampleUpdateNecessary = false;
+    downsample();
+
+    recordDebugInfo();
+
+    m_renderPipeline->putPtr(rp_keys::CLIP_REGIONS, &m_clipRegions);
+}
+
+void VoxelizationPass::downsample()
+{
+    // Only the changed regions are downsampled: The dirty regions of a level are propagated to the next level
+    std::size_t voxelCount = 0;
+    std::size_t fullLevelVoxelCount = 0;
+    std::size_t halfResolution = VOXEL_RESOLUTION / 2;
+    uint32_t dirtyLevelMask = 0;
+    auto clipmapUpdatePolicy = m_renderPipeline->fetchPtr(rp_keys::CLIPMAP_UPDATE_POLICY);
 
-    // Downsample - this can be significantly improved by downsampling only the required regions
-    for (int i = 1; i < CLIP_REGION_COUNT; ++i)
+    for (int i = 0; i < CLIP_REGION_COUNT; ++i)
     {
-        if (m_downsampleUpdateNecessary || m_revoxelizationRegions[i].size() > 0)
+        auto& dirtyRegions = m_dirtyRegions[i];
+        std::vector<VoxelRegion> revoxelizedRegions = m_revoxelizationRegions[i];
+        revoxelizedRegions.insert(revoxelizedRegions.end(), m_dynamicRegions[i].begin(), m_dynamicRegions[i].end());
+        dirtyRegions = revoxelizedRegions;
+
+        if (i > 0)
         {
-            m_downsampleUpdateNecessary = true;
-            Downsampler::downsampleOpacity(m_voxelOpacity, &m_clipRegions, i);
+            std::vector<VoxelRegion> downsampledRegions;
+            auto downsampleRegion = [&](const VoxelRegion& region)
+            {
+                VoxelRegion clampedRegion = Downsampler::getDownsampleRegion(&m_clipRegions, i).intersect(region);
+                if (clampedRegion.empty())
+                    return;
+
+                for (auto& r : downsampledRegions)
+                    if (r.contains(clampedRegion))
+                        return;
+
+                voxelCount += Downsampler::downsampleOpacity(m_voxelOpacity, &m_clipRegions, i, clampedRegion);
+                downsampledRegions.push_back(clampedRegion);
+            };
+
+            // Revoxelization overwrote the downsampled values, thus they are recomputed as well
+            for (auto& region : revoxelizedRegions)
+                downsampleRegion(region);
+
+            for (auto& region : m_dirtyRegions[i - 1])
+            {
+                std::size_t downsampledRegionCount = downsampledRegions.size();
+                downsampleRegion(region.toNextLevelRegion());
+
+                if (downsampledRegions.size() > downsampledRegionCount)
+                    dirtyRegions.push_back(downsampledRegions.back());
+            }
+
+            // Previously all levels starting with the first changed level were downsampled completely
+            if (fullLevelVoxelCount > 0 || revoxelizedRegions.size() > 0)
+                fullLevelVoxelCount += halfResolution * halfResolution * halfResolution;
         }
+
+        if (dirtyRegions.size() > 0)
+            dirtyLevelMask |= 1u << i;
+
+        // Changed opacity (moved entities and camera) makes the radiance of the level more urgent
+        for (auto& region : dirtyRegions)
+            clipmapUpdatePolicy->addDirtyVoxels(i, std::size_t(region.extent.x) * region.extent.y * region.extent.z);
     }
 
-    recordDebugInfo();
+    QueryManager::setCounter("Opacity Downsampling: Voxels", voxelCount);
+    QueryManager::setCounter("Opacity Downsampling: Voxels (Full Levels)", fullLevelVoxelCount);
 
-    m_renderPipeline->putPtr("ClipRegions", &m_clipRegions);
+    m_renderPipeline->put(rp_keys::VOXEL_OPACITY_DIRTY_LEVELS, dirtyLevelMask);
 }
 
 void VoxelizationPass::computeRevoxelizationRegionsClipmap(uint32_t clipmapLevel, const BBox& curBBox)
@@ -202,114 +328,74 @@ glm::ivec3 VoxelizationPass::computeChangeDeltaV(uint32_t clipmapLevel, const BB
 
 void VoxelizationPass::computeRevoxelizationRegionsDynamicEntities()
 {
-    // Revoxelize portions of entities that moved
-    m_portionsOfDynamicEntities.clear();
-    std::vector<bool> markedPortions;
-
-    for (auto e : ECS::getEntitiesWithComponents<Transform, MeshRenderer>())
+    // Static entities that moved require a revoxelization of the static opacity around them.
+    // Where dynamic entities moved the static opacity is restored and only the dynamic entities are voxelized.
+    for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
     {
-        auto transform = e.getComponent<Transform>();
-        if (transform->hasChangedSinceLastFrame())
-        {
-            BBox bbox = transform->getBBox();
-            auto& lastFrameBBox = transform->getLastFrameBBox();
-            if (bbox.overlaps(lastFrameBBox))
-                bbox.unite(transform->getLastFrameBBox());
-            else
-                m_portionsOfDynamicEntities.push_back(lastFrameBBox);
-
-            m_portionsOfDynamicEntities.push_back(bbox);
-        }
+        m_dirtyBricks[i].reset(m_clipRegions[i]);
+        m_dynamicDirtyBricks[i].reset(m_clipRegions[i]);
     }
 
-    for (auto& e : m_activatedDeactivatedEntities)
+    auto markEntity = [this](Entity e)
     {
         auto transform = e.getComponent<Transform>();
-        BBox bbox = transform->getBBox();
-        auto& lastFrameBBox = transform->getLastFrameBBox();
-        if (bbox.overlaps(lastFrameBBox))
-            bbox.unite(transform->getLastFrameBBox());
-        else
-            m_portionsOfDynamicEntities.push_back(lastFrameBBox);
-
-        m_portionsOfDynamicEntities.push_back(bbox);
-    }
-
-    m_activatedDeactivatedEntities.clear();
-
-    if (m_portionsOfDynamicEntities.size() == 0)
-        return;
-
-    // Marked portions will be skipped
-    markedPortions.resize(m_portionsOfDynamicEntities.size(), false);
+        DirtyBrickMap* dirtyBricks = e.hasComponent<DynamicVoxelization>() ? m_dynamicDirtyBricks : m_dirtyBricks;
 
-    // Unite overlapping portions
-    for (std::size_t i = 0; i < m_portionsOfDynamicEntities.size(); ++i)
-    {
-        if (markedPortions[i])
-            continue;
-
-        BBox& a = m_portionsOfDynamicEntities[i];
-
-        std::size_t j = i + 1;
-        while (j < m_portionsOfDynamicEntities.size())
+        for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
         {
-            BBox& b = m_portionsOfDynamicEntities[j];
-            if (!markedPortions[j] && a.overlaps(b))
-            {
-                a.unite(b);
-                markedPortions[j] = true;
-                j = i + 1;
-            }
-            else
-                ++j;
+            dirtyBricks[i].mark(transform->getLastFrameBBox(), m_overestimationWidth);
+            dirtyBricks[i].mark(transform->getBBox(), m_overestimationWidth);
         }
-    }
+    };
 
-    // Remove all marked portions
-    for (int i = int(m_portionsOfDynamicEntities.size()) - 1; i >= 0; --i)
+    for (auto e : ECS::getEntitiesWithComponents<Transform, MeshRenderer>())
     {
-        if (markedPortions[i])
-            m_portionsOfDynamicEntities.erase(m_portionsOfDynamicEntities.begin() + i);
+        if (e.getComponent<Transform>()->hasChangedSinceLastFrame())
+            markEntity(e);
     }
 
-    // Compute the correct regions for each clip region and add for revoxelization
-    for (std::size_t j = 0; j < m_portionsOfDynamicEntities.size(); ++j)
-    {
-        const BBox& portion = m_portionsOfDynamicEntities[j];
-
-        for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
-        {
-            auto& clipRegion = m_clipRegions[i];
-
-            VoxelRegion region;
-            region.voxelSize = clipRegion.voxelSize;
+    for (auto& e : m_activatedDeactivatedEntities)
+        markEntity(e);
 
-            // Geometry can be very thin (0 scale) and yield an extent of 0 so it's important to make
-            // it a bit thicker (BBox) to avoid this problem (extend by epsilon in each direction). 
-            // Just setting extent to 1 in this case isn't enough either because if this thin 
-            // geometry is exactly at a discrete voxel size step/is right between two voxels (voxel coords -> world coords)
-            // the extent should be two because it falls in both voxels in this case.
+    m_activatedDeactivatedEntities.clear();
 
-            glm::vec3 pMin = portion.min() / region.voxelSize - math::EPSILON5;
-            glm::vec3 pMax = portion.max() / region.voxelSize + math::EPSILON5;
+    // The static opacity must be revoxelized with or without the entity regardless of its new flag
+    for (auto& e : m_dynamicVoxelizationChangedEntities)
+    {
+        auto transform = e.getComponent<Transform>();
+        for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
+            m_dirtyBricks[i].mark(transform->getBBox(), m_overestimationWidth);
+    }
 
-            region.minPos = voxelization::computeLowerBound(pMin) - m_overestimationWidth;
-            glm::ivec3 maxPos = voxelization::computeUpperBound(pMax) + m_overestimationWidth;
-            region.extent = maxPos - region.minPos;
+    m_dynamicVoxelizationChangedEntities.clear();
 
-            // Skip if the region is outside of the current clipmap
-            if (glm::any(glm::greaterThanEqual(region.minPos, clipRegion.getMaxPos())) || glm::any(glm::lessThanEqual(region.getMaxPos(), clipRegion.minPos)))
-                continue;
+    std::size_t dirtyBrickCount = 0;
+    std::size_t dynamicDirtyBrickCount = 0;
+    for (uint32_t i = 0; i < CLIP_REGION_COUNT; ++i)
+    {
+        dirtyBrickCount += m_dirtyBricks[i].getDirtyBrickCount();
+        dynamicDirtyBrickCount += m_dynamicDirtyBricks[i].getDirtyBrickCount();
+        m_dirtyBricks[i].extractRegions(m_revoxelizationRegions[i]);
+        m_dynamicDirtyBricks[i].extractRegions(m_dynamicRegions[i]);
+    }
 
-            // Clamp region to the current clipRegion
-            maxPos = glm::min(region.getMaxPos(), clipRegion.getMaxPos());
-            region.minPos = glm::max(region.minPos, clipRegion.minPos);
-            region.extent = maxPos - region.minPos;
+    QueryManager::setCounter("Revoxelization: Dirty Bricks", dirtyBrickCount);
+    QueryManager::setCounter("Revoxelization: Dynamic Dirty Bricks", dynamicDirtyBrickCount);
+}
 
-            m_revoxelizationRegions[i].push_back(region);
-        }
-    }
+void VoxelizationPass::copyStaticOpacity(const VoxelRegion& region, int clipmapLevel, bool restore)
+{
+    m_copyStaticOpacityShader->bind();
+    m_copyStaticOpacityShader->bindImage3D(*m_voxelOpacity, "u_voxelOpacity", GL_READ_WRITE, GL_RGBA8, 0);
+    m_copyStaticOpacityShader->bindImage3D(m_staticVoxelOpacity, "u_staticOpacity", GL_READ_WRITE, GL_R8, 1);
+    m_copyStaticOpacityShader->setVectori("u_min", region.getMinPosImage(m_clipRegions[clipmapLevel].extent));
+    m_copyStaticOpacityShader->setVectori("u_extent", region.extent);
+    m_copyStaticOpacityShader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
+    m_copyStaticOpacityShader->setInt("u_clipmapLevel", clipmapLevel);
+    m_copyStaticOpacityShader->setInt("u_restore", restore ? 1 : 0);
+
+    glm::ivec3 groupCount = glm::ivec3(glm::ceil(glm::vec3(region.extent) / 8.0f));
+    m_copyStaticOpacityShader->dispatchCompute(GLuint(groupCount.x), GLuint(groupCount.y), GLuint(groupCount.z));
 }
 
 void VoxelizationPass::receive(const EntityDeactivatedEvent& e)
@@ -324,11 +410,17 @@ void VoxelizationPass::receive(const EntityActivatedEvent& e)
         m_activatedDeactivatedEntities.push_back(e.entity);
 }
 
+void VoxelizationPass::receive(const DynamicVoxelizationChangedEvent& e)
+{
+    if (e.entity.hasComponents<Transform, MeshRenderer>())
+        m_dynamicVoxelizationChangedEntities.push_back(e.entity);
+}
+
 void VoxelizationPass::recordDebugInfo()
 {
     for (int i = 0; i < CLIP_REGION_COUNT; ++i)
     {
-        if (m_revoxelizationRegions[i].size() > 0)
+        if (m_revoxelizationRegions[i].size() > 0 || m_dynamicRegions[i].size() > 0)
         {
             m_debugInfo.lastRevoxelizationRegions.clear();
             break;
@@ -337,8 +429,9 @@ void VoxelizationPass::recordDebugInfo()
 
     for (int i = 0; i < CLIP_REGION_COUNT; ++i)
     {
-        if (m_revoxelizationRegions[i].size() > 0)
-            m_debugInfo.lastRevoxelizationRegions.insert(m_debugInfo.lastRevoxelizationRegions.end(), 
-                m_revoxelizationRegions[i].begin(), m_revoxelizationRegions[i].end());
+        m_debugInfo.lastRevoxelizationRegions.insert(m_debugInfo.lastRevoxelizationRegions.end(), 
+            m_revoxelizationRegions[i].begin(), m_revoxelizationRegions[i].end());
+        m_debugInfo.lastRevoxelizationRegions.insert(m_debugInfo.lastRevoxelizationRegions.end(), 
+            m_dynamicRegions[i].begin(), m_dynamicRegions[i].end());
     }
 }
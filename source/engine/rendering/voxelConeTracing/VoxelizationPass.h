@@ -6,13 +6,17 @@
 #include "engine/event/event.h"
 #include "engine/event/EntityDeactivatedEvent.h"
 #include "engine/event/EntityActivatedEvent.h"
+#include "engine/event/DynamicVoxelizationChangedEvent.h"
 #include "VoxelRegion.h"
+#include "DirtyBrickMap.h"
+#include "voxelization.h"
+#include <engine/rendering/Texture3D.h>
 
 class MeshRenderer;
-class Texture3D;
 class BBox;
 
-class VoxelizationPass : public RenderPass, public Receiver<EntityDeactivatedEvent>, public Receiver<EntityActivatedEvent>
+class VoxelizationPass : public RenderPass, public Receiver<EntityDeactivatedEvent>, public Receiver<EntityActivatedEvent>,
+                         public Receiver<DynamicVoxelizationChangedEvent>
 {
     struct DebugInfo
     {
@@ -25,8 +29,16 @@ public:
 
     void update() override;
 
+    void declareResources(FrameGraphBuilder& builder) override;
+
     const DebugInfo& getDebugInfo() const { return m_debugInfo; }
 private:
+    /**
+    * Downsamples the revoxelized regions into the coarser levels and reports the levels that changed
+    * as "VoxelOpacityDirtyLevels" bit mask.
+    */
+    void downsample();
+
     void computeRevoxelizationRegionsClipmap(uint32_t clipmapLevel, const BBox& curBBox);
 
     /**
@@ -37,22 +49,37 @@ private:
 
     void computeRevoxelizationRegionsDynamicEntities();
 
+    /**
+    * Stores the voxelized opacity of the region in the static opacity or restores the opacity from it.
+    */
+    void copyStaticOpacity(const VoxelRegion& region, int clipmapLevel, bool restore);
+
     void receive(const EntityDeactivatedEvent& e) override;
     void receive(const EntityActivatedEvent& e) override;
+    void receive(const DynamicVoxelizationChangedEvent& e) override;
 
     void recordDebugInfo();
 private:
     std::shared_ptr<Shader> m_voxelizeShader;
+    std::shared_ptr<Shader> m_multiRegionVoxelizeShader;
+    std::shared_ptr<Shader> m_copyStaticOpacityShader;
 
-    std::vector<VoxelRegion> m_revoxelizationRegions[CLIP_REGION_COUNT];
+    std::vector<VoxelRegion> m_revoxelizationRegions[CLIP_REGION_COUNT]; // Static and dynamic entities are revoxelized
+    std::vector<VoxelRegion> m_dynamicRegions[CLIP_REGION_COUNT]; // Static opacity is restored and dynamic entities are revoxelized
+    std::vector<VoxelRegion> m_dirtyRegions[CLIP_REGION_COUNT]; // Revoxelized and downsampled regions of the current frame
     std::vector<Entity> m_activatedDeactivatedEntities;
-    std::vector<BBox> m_portionsOfDynamicEntities;
+    std::vector<Entity> m_dynamicVoxelizationChangedEntities; // Their opacity moves between the static and the dynamic entities
+    DirtyBrickMap m_dirtyBricks[CLIP_REGION_COUNT]; // Bricks touched by moved static entities
+    DirtyBrickMap m_dynamicDirtyBricks[CLIP_REGION_COUNT]; // Bricks touched by moved dynamic entities
     std::vector<VoxelRegion> m_clipRegions;
+    std::vector<VoxelizationRegion> m_staticVoxelizationRegions; // Regions of all levels voxelized at once
+    std::vector<VoxelizationRegion> m_dynamicVoxelizationRegions;
 
     // A portion consisting of a multiple of voxel size is revoxelized
     int m_minChange[CLIP_REGION_COUNT] = {2, 2, 2, 2, 2, 1};
 
     Texture3D* m_voxelOpacity{nullptr};
+    Texture3D m_staticVoxelOpacity; // Opacity of the static entities with one face
 
     DebugInfo m_debugInfo;
     int m_overestimationWidth{ 0 };
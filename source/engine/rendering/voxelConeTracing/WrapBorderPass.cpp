@@ -1,8 +1,11 @@
 #include "WrapBorderPass.h"
 #include "engine/rendering/architecture/RenderPipeline.h"
+#include "engine/rendering/architecture/RPKeys.h"
 #include "engine/resource/ResourceManager.h"
 #include "engine/rendering/Texture3D.h"
+#include "engine/util/QueryManager.h"
 #include "Globals.h"
+#include "ClipmapUpdatePolicy.h"
 
 WrapBorderPass::WrapBorderPass()
     : RenderPass("WrapBorderPass")
@@ -10,28 +13,62 @@ WrapBorderPass::WrapBorderPass()
     m_shader = ResourceManager::getComputeShader("shaders/voxelConeTracing/copyWrappedBorder.comp");
 }
 
+void WrapBorderPass::declareResources(FrameGraphBuilder& builder)
+{
+    builder.read(rp_keys::CLIPMAP_UPDATE_POLICY, FrameGraphAccess::CPU);
+    builder.read(rp_keys::VOXEL_OPACITY_DIRTY_LEVELS, FrameGraphAccess::CPU);
+
+    for (auto voxelTexture : { &rp_keys::VOXEL_OPACITY, &rp_keys::VOXEL_RADIANCE })
+    {
+        builder.read(*voxelTexture, FrameGraphAccess::IMAGE);
+        builder.write(*voxelTexture, FrameGraphAccess::IMAGE);
+    }
+}
+
 void WrapBorderPass::update()
 {
     // Fetch the data
-    auto voxelOpacity = m_renderPipeline->fetchPtr<Texture3D>("VoxelOpacity");
-    auto voxelRadiance = m_renderPipeline->fetchPtr<Texture3D>("VoxelRadiance");
+    auto voxelOpacity = m_renderPipeline->fetchPtr(rp_keys::VOXEL_OPACITY);
+    auto voxelRadiance = m_renderPipeline->fetchPtr(rp_keys::VOXEL_RADIANCE);
+    auto clipmapUpdatePolicy = m_renderPipeline->fetchPtr(rp_keys::CLIPMAP_UPDATE_POLICY);
+
+    // Only levels that were written this frame need new borders
+    uint32_t opacityLevelMask = m_renderPipeline->fetch(rp_keys::VOXEL_OPACITY_DIRTY_LEVELS);
+    uint32_t radianceLevelMask = 0;
+    for (auto level : clipmapUpdatePolicy->getLevelsScheduledForUpdate())
+        radianceLevelMask |= 1u << level;
 
-    copyBorder(voxelOpacity);
-    copyBorder(voxelRadiance);
+    std::size_t texelCount = copyBorder(voxelOpacity, opacityLevelMask);
+    texelCount += copyBorder(voxelRadiance, radianceLevelMask);
+
+    QueryManager::setCounter("Wrap Border: Texels", texelCount);
 }
 
-void WrapBorderPass::copyBorder(Texture3D* texture) const
+std::size_t WrapBorderPass::copyBorder(Texture3D* texture, uint32_t clipmapLevelMask) const
 {
+    if (clipmapLevelMask == 0)
+        return 0;
+
     m_shader->bind();
 
     m_shader->setInt("u_clipmapResolution", VOXEL_RESOLUTION);
     m_shader->setInt("u_clipmapResolutionWithBorder", VOXEL_RESOLUTION + 2);
     m_shader->setInt("u_faceCount", FACE_COUNT);
     m_shader->setInt("u_clipmapCount", CLIP_REGION_COUNT);
+    m_shader->setInt("u_clipmapLevelMask", int(clipmapLevelMask));
     m_shader->bindImage3D(*texture, "u_image", GL_READ_WRITE, GL_RGBA8, 0);
 
     float borderWidth2 = 2.0f;
     GLuint groupCount = GLuint(ceil((VOXEL_RESOLUTION + borderWidth2) / 8.0f));
     m_shader->dispatchCompute(groupCount, groupCount, groupCount);
-    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    std::size_t levelCount = 0;
+    for (int i = 0; i < CLIP_REGION_COUNT; ++i)
+        if (clipmapLevelMask & (1u << i))
+            ++levelCount;
+
+    std::size_t resolutionWithBorder = VOXEL_RESOLUTION + 2;
+    std::size_t borderTexelCount = resolutionWithBorder * resolutionWithBorder * resolutionWithBorder - std::size_t(VOXEL_RESOLUTION) * VOXEL_RESOLUTION * VOXEL_RESOLUTION;
+
+    return borderTexelCount * FACE_COUNT * levelCount;
 }
@@ -14,8 +14,14 @@ public:
 
     void update() override;
 
+    void declareResources(FrameGraphBuilder& builder) override;
+
 private:
-    void copyBorder(Texture3D* texture) const;
+    /**
+    * Copies the wrapped borders of the levels whose bit is set in clipmapLevelMask.
+    * Returns the number of written border texels.
+    */
+    std::size_t copyBorder(Texture3D* texture, uint32_t clipmapLevelMask) const;
 
 private:
     std::shared_ptr<Shader> m_shader;
@@ -48,7 +48,7 @@ struct GISettings : VCTSettings
                           &indirectDiffuseIntensity, &indirectSpecularIntensity, &traceStartOffset,
                           &directLighting, &indirectDiffuseLighting, &indirectSpecularLighting, &ambientOcclusion,
                           &radianceInjectionMode, &visualizeMinLevelSelection, &downsampleTransitionRegionSize,
-                          &updateOneClipLevelPerFrame });
+                          &clipmapUpdatePolicy, &clipmapUpdateBudget, &multiRegionVoxelization, &radianceAccumulation });
     }
 
     SliderFloat occlusionDecay{"Occlusion Decay", 5.0f, 0.001f, 80.0f};
@@ -61,10 +61,13 @@ struct GISettings : VCTSettings
     CheckBox indirectDiffuseLighting{ "Indirect Diffuse Lighting", true };
     CheckBox indirectSpecularLighting{ "Indirect Specular Lighting", true };
     CheckBox ambientOcclusion{ "Ambient Occlusion", true };
-    ComboBox radianceInjectionMode = ComboBox("Radiance Injection Mode", { "Conservative", "MSAA" }, 1);
+    ComboBox radianceInjectionMode = ComboBox("Radiance Injection Mode", { "Conservative", "MSAA", "Reflective Shadow Maps" }, 1);
     CheckBox visualizeMinLevelSelection{"Visualize Min Level Selection", false};
     SliderInt downsampleTransitionRegionSize{ "Downsample Transition Region Size", 10, 1, VOXEL_RESOLUTION / 4 };
-    CheckBox updateOneClipLevelPerFrame{ "Update One Clip Level Per Frame", true };
+    ComboBox clipmapUpdatePolicy = ComboBox("Clipmap Update Policy", { "All Per Frame", "One Per Frame Priority", "Budget" }, 1);
+    SliderFloat clipmapUpdateBudget{ "Clipmap Update Budget (ms)", 2.0f, 0.1f, 16.0f };
+    CheckBox multiRegionVoxelization{ "Multi-Region Voxelization", true };
+    ComboBox radianceAccumulation = ComboBox("Radiance Accumulation", { "RGBA8 Average", "Fixed-Point" }, 0);
 };
 
 struct DebugSettings : VCTSettings
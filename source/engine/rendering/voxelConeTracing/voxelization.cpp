@@ -6,6 +6,9 @@
 #include "engine/rendering/util/GLUtil.h"
 #include "VoxelRegion.h"
 #include "engine/util/ECSUtil/ECSUtil.h"
+#include "engine/rendering/renderer/MeshRenderer.h"
+#include "DynamicVoxelization.h"
+#include <glm/gtc/matrix_transform.hpp>
 
 namespace voxelization
 {
@@ -53,7 +56,7 @@ namespace voxelization
             computeUpperBound(vec.z));
     }
 
-    void setViewProjectionMatrices(Shader* shader, const VoxelRegion& voxelRegion)
+    void computeViewProjectionMatrices(const VoxelRegion& voxelRegion, glm::mat4 viewProj[3], glm::mat4 viewProjInv[3])
     {
         glm::vec3 size = voxelRegion.getExtentWorld();
 
@@ -63,9 +66,6 @@ namespace voxelization
         proj[1] = math::orthoLH(0.0f, size.x, 0.0f, size.z, 0.0f, size.y);
         proj[2] = math::orthoLH(0.0f, size.x, 0.0f, size.y, 0.0f, size.z);
 
-        glm::mat4 viewProj[3];
-        glm::mat4 viewProjInv[3];
-
         glm::vec3 xyStart = voxelRegion.getMinPosWorld() + glm::vec3(0.0f, 0.0f, size.z);
         viewProj[0] = glm::lookAt(xyStart, xyStart + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         viewProj[1] = glm::lookAt(xyStart, xyStart + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
@@ -76,6 +76,20 @@ namespace voxelization
             viewProj[i] = proj[i] * viewProj[i];
             viewProjInv[i] = glm::inverse(viewProj[i]);
         }
+    }
+
+    void computeViewportSizes(const glm::vec3& viewportSize, glm::vec2 viewportSizes[3])
+    {
+        viewportSizes[0] = glm::vec2(viewportSize.z, viewportSize.y);
+        viewportSizes[1] = glm::vec2(viewportSize.x, viewportSize.z);
+        viewportSizes[2] = glm::vec2(viewportSize.x, viewportSize.y);
+    }
+
+    void setViewProjectionMatrices(Shader* shader, const VoxelRegion& voxelRegion)
+    {
+        glm::mat4 viewProj[3];
+        glm::mat4 viewProjInv[3];
+        computeViewProjectionMatrices(voxelRegion, viewProj, viewProjInv);
 
         glUniformMatrix4fv(glGetUniformLocation(shader->getProgram(), "u_viewProj"), 3, GL_FALSE, &viewProj[0][0][0]);
         glUniformMatrix4fv(glGetUniformLocation(shader->getProgram(), "u_viewProjInv"), 3, GL_FALSE, &viewProjInv[0][0][0]);
@@ -84,9 +98,7 @@ namespace voxelization
     void setViewports(Shader* shader, const glm::vec3& viewportSize)
     {
         glm::vec2 viewportSizes[3];
-        viewportSizes[0] = glm::vec2(viewportSize.z, viewportSize.y);
-        viewportSizes[1] = glm::vec2(viewportSize.x, viewportSize.z);
-        viewportSizes[2] = glm::vec2(viewportSize.x, viewportSize.y);
+        computeViewportSizes(viewportSize, viewportSizes);
 
         // Set the viewports
         glViewportIndexedf(0, 0.f, 0.f, viewportSizes[0].x, viewportSizes[0].y);
@@ -99,6 +111,24 @@ namespace voxelization
 
         glUniform2fv(glGetUniformLocation(shader->getProgram(), "u_viewportSizes"), 3, &viewportSizes[0][0]);
     }
+
+    void setRegionUniforms(Shader* shader, const VoxelRegion& voxelRegion, int clipmapLevel,
+                           const std::vector<VoxelRegion>& clipRegions, int downsampleTransitionRegionSize)
+    {
+        // Extend by epsilon to prevent potential floating point imprecision problems (fragments that fail to be voxelized)
+        shader->setVector("u_regionMin", voxelRegion.getMinPosWorld() - math::EPSILON5);
+        shader->setVector("u_regionMax", voxelRegion.getMaxPosWorld() + math::EPSILON5);
+        shader->setInt("u_clipmapLevel", clipmapLevel);
+        shader->setFloat("u_maxExtent", clipRegions[clipmapLevel].getExtentWorld().x);
+        shader->setFloat("u_voxelSize", clipRegions[clipmapLevel].voxelSize);
+
+        if (clipmapLevel > 0)
+        {
+            shader->setVector("u_prevRegionMin", clipRegions[clipmapLevel - 1].getMinPosWorld());
+            shader->setVector("u_prevRegionMax", clipRegions[clipmapLevel - 1].getMaxPosWorld());
+            shader->setFloat("u_downsampleTransitionRegionSize", downsampleTransitionRegionSize * voxelRegion.voxelSize);
+        }
+    }
 }
 
 Voxelizer::Voxelizer()
@@ -124,11 +154,21 @@ Voxelizer::Voxelizer()
     glFramebufferParameteri(GL_FRAMEBUFFER, GL_FRAMEBUFFER_DEFAULT_FIXED_SAMPLE_LOCATIONS, GL_TRUE);
     m_msaaFramebuffer->checkFramebufferStatus();
     m_msaaFramebuffer->unbind();
+
+    glGenBuffers(1, &m_regionBuffer);
+}
+
+Voxelizer::~Voxelizer()
+{
+    glDeleteBuffers(1, &m_regionBuffer);
 }
 
 void Voxelizer::beginVoxelization(const VoxelizationDesc& desc)
 {
+    assert(!desc.multiRegion || desc.mode == VoxelizationMode::CONSERVATIVE);
+
     m_voxelizationDesc = desc;
+    m_drawCount = 0;
 
     glDisable(GL_BLEND);
     glDisable(GL_STENCIL_TEST);
@@ -156,16 +196,171 @@ void Voxelizer::beginVoxelization(const VoxelizationDesc& desc)
 
     shader->setInt("u_clipmapResolution", int(VOXEL_RESOLUTION));
     shader->setInt("u_clipmapResolutionWithBorder", int(VOXEL_RESOLUTION + 2));
+
+    // The viewport of a region is part of its matrices
+    if (desc.multiRegion)
+        voxelization::setViewports(shader, glm::vec3(float(VOXEL_RESOLUTION + 2)));
+}
+
+void Voxelizer::voxelize(const VoxelRegion& voxelRegion, int clipmapLevel, VoxelizationLayer layer)
+{
+    m_levelRegions.clear();
+    m_levelRegions.push_back({voxelRegion, clipmapLevel});
+    voxelize(m_levelRegions.data(), m_levelRegions.size(), layer);
+}
+
+void Voxelizer::voxelize(const std::vector<VoxelRegion>& voxelRegions, int clipmapLevel, VoxelizationLayer layer)
+{
+    m_levelRegions.clear();
+    for (auto& region : voxelRegions)
+        m_levelRegions.push_back({region, clipmapLevel});
+
+    voxelize(m_levelRegions.data(), m_levelRegions.size(), layer);
+}
+
+void Voxelizer::voxelize(const std::vector<VoxelizationRegion>& voxelRegions, VoxelizationLayer layer)
+{
+    voxelize(voxelRegions.data(), voxelRegions.size(), layer);
+}
+
+void Voxelizer::voxelize(const VoxelizationRegion* voxelRegions, std::size_t regionCount, VoxelizationLayer layer)
+{
+    if (regionCount == 0)
+        return;
+
+    // Extend by epsilon to prevent potential floating point imprecision problems (fragments that fail to be voxelized)
+    m_regionBBoxes.clear();
+    for (std::size_t i = 0; i < regionCount; ++i)
+    {
+        const VoxelRegion& region = voxelRegions[i].region;
+        m_regionBBoxes.push_back(BBox(region.getMinPosWorld() - math::EPSILON5, region.getMaxPosWorld() + math::EPSILON5));
+    }
+
+    switch (layer)
+    {
+    case VoxelizationLayer::ALL:
+        m_sceneBVH.getEntitiesInAABBs(m_regionBBoxes, [](Entity) { return true; }, m_drawLists);
+        break;
+    case VoxelizationLayer::STATIC:
+        m_sceneBVH.getEntitiesInAABBs(m_regionBBoxes, [](Entity e) { return !e.hasComponent<DynamicVoxelization>(); }, m_drawLists);
+        break;
+    case VoxelizationLayer::DYNAMIC:
+        m_sceneBVH.getEntitiesInAABBs(m_regionBBoxes, [](Entity e) { return e.hasComponent<DynamicVoxelization>(); }, m_drawLists);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+
+    if (m_voxelizationDesc.multiRegion)
+    {
+        voxelizeMultiRegion(voxelRegions, regionCount);
+        return;
+    }
+
+    for (std::size_t i = 0; i < regionCount; ++i)
+    {
+        if (m_drawLists.bboxOffsets[i] == m_drawLists.bboxOffsets[i + 1])
+            continue;
+
+        setRegionUniforms(voxelRegions[i].region, voxelRegions[i].clipmapLevel);
+
+        for (uint32_t j = m_drawLists.bboxOffsets[i]; j < m_drawLists.bboxOffsets[i + 1]; ++j)
+            renderEntity(m_sceneBVH.getEntity(m_drawLists.primitives[m_drawLists.bboxPrimitives[j]]));
+    }
 }
 
-void Voxelizer::voxelize(const VoxelRegion& voxelRegion, int clipmapLevel)
+void Voxelizer::voxelizeMultiRegion(const VoxelizationRegion* voxelRegions, std::size_t regionCount)
 {
     Shader* shader = m_voxelizationDesc.voxelizationShader;
     auto& clipRegions = m_voxelizationDesc.clipRegions;
+    float framebufferSize = float(VOXEL_RESOLUTION + 2);
 
-    // Extend by epsilon to prevent potential floating point imprecision problems (fragments that fail to be voxelized)
-    glm::vec3 regionMinWorld = voxelRegion.getMinPosWorld() - math::EPSILON5;
-    glm::vec3 regionMaxWorld = voxelRegion.getMaxPosWorld() + math::EPSILON5;
+    // Only regions with a non-empty draw list are uploaded
+    m_regionData.clear();
+    m_multiRegionIndices.clear();
+    for (std::size_t i = 0; i < regionCount; ++i)
+    {
+        if (m_drawLists.bboxOffsets[i] == m_drawLists.bboxOffsets[i + 1])
+            continue;
+
+        const VoxelRegion& voxelRegion = voxelRegions[i].region;
+        int clipmapLevel = voxelRegions[i].clipmapLevel;
+        VoxelizationRegionData data;
+
+        // Use an extended Voxel Region for the viewProj matrix calculation to ensure that no pixels are missed
+        VoxelRegion extendedRegion = voxelRegion;
+        extendedRegion.extent = voxelRegion.extent + 2;
+        extendedRegion.minPos -= 1;
+
+        voxelization::computeViewProjectionMatrices(extendedRegion, data.viewProj, data.viewProjInv);
+
+        // All viewports cover the whole framebuffer: Map clip space to the part of the framebuffer that the region viewport would cover
+        glm::vec2 viewportSizes[3];
+        voxelization::computeViewportSizes(extendedRegion.extent, viewportSizes);
+        for (int j = 0; j < 3; ++j)
+        {
+            glm::vec2 scale = viewportSizes[j] / framebufferSize;
+            glm::mat4 toViewport = glm::translate(glm::mat4(1.0f), glm::vec3(scale - 1.0f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(scale, 1.0f));
+            data.viewProj[j] = toViewport * data.viewProj[j];
+            data.viewProjInv[j] = glm::inverse(data.viewProj[j]);
+        }
+
+        // Extend by epsilon to prevent potential floating point imprecision problems (fragments that fail to be voxelized)
+        data.regionMin = glm::vec4(voxelRegion.getMinPosWorld() - math::EPSILON5, float(clipmapLevel));
+        data.regionMax = glm::vec4(voxelRegion.getMaxPosWorld() + math::EPSILON5, clipRegions[clipmapLevel].voxelSize);
+        data.prevRegionMin = glm::vec4(glm::vec3(0.0f), clipRegions[clipmapLevel].getExtentWorld().x);
+        data.prevRegionMax = glm::vec4(glm::vec3(0.0f), m_voxelizationDesc.downsampleTransitionRegionSize * voxelRegion.voxelSize);
+
+        if (clipmapLevel > 0)
+        {
+            data.prevRegionMin = glm::vec4(clipRegions[clipmapLevel - 1].getMinPosWorld(), data.prevRegionMin.w);
+            data.prevRegionMax = glm::vec4(clipRegions[clipmapLevel - 1].getMaxPosWorld(), data.prevRegionMax.w);
+        }
+
+        m_regionData.push_back(data);
+        m_multiRegionIndices.push_back(i);
+    }
+
+    if (m_regionData.empty())
+        return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_regionBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(m_regionData.size() * sizeof(VoxelizationRegionData)), m_regionData.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_regionBuffer);
+
+    // Every entity is drawn once per batch - the geometry shader instances voxelize it into the regions of the batch
+    m_drawnInBatch.assign(m_drawLists.primitives.size(), 0);
+    uint32_t batch = 0;
+    for (std::size_t offset = 0; offset < m_regionData.size(); offset += MAX_REGIONS_PER_DRAW)
+    {
+        std::size_t batchRegionCount = std::min(std::size_t(MAX_REGIONS_PER_DRAW), m_regionData.size() - offset);
+        shader->setInt("u_regionOffset", int(offset));
+        shader->setInt("u_regionCount", int(batchRegionCount));
+        ++batch;
+
+        for (std::size_t i = offset; i < offset + batchRegionCount; ++i)
+        {
+            std::size_t regionIdx = m_multiRegionIndices[i];
+            for (uint32_t j = m_drawLists.bboxOffsets[regionIdx]; j < m_drawLists.bboxOffsets[regionIdx + 1]; ++j)
+            {
+                uint32_t slot = m_drawLists.bboxPrimitives[j];
+                if (m_drawnInBatch[slot] == batch)
+                    continue;
+
+                m_drawnInBatch[slot] = batch;
+                renderEntity(m_sceneBVH.getEntity(m_drawLists.primitives[slot]));
+            }
+        }
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Voxelizer::setRegionUniforms(const VoxelRegion& voxelRegion, int clipmapLevel)
+{
+    Shader* shader = m_voxelizationDesc.voxelizationShader;
 
     // Use an extended Voxel Region for the viewProj matrix calculation to ensure that no pixels are missed
     VoxelRegion extendedRegion = voxelRegion;
@@ -174,22 +369,13 @@ void Voxelizer::voxelize(const VoxelRegion& voxelRegion, int clipmapLevel)
 
     voxelization::setViewports(shader, extendedRegion.extent);
     voxelization::setViewProjectionMatrices(shader, extendedRegion);
-    
-    shader->setVector("u_regionMin", regionMinWorld);
-    shader->setVector("u_regionMax", regionMaxWorld);
-    shader->setInt("u_clipmapLevel", clipmapLevel);
-    shader->setFloat("u_maxExtent", clipRegions[clipmapLevel].getExtentWorld().x);
-    shader->setFloat("u_voxelSize", clipRegions[clipmapLevel].voxelSize);
-
-    if (clipmapLevel > 0)
-    {
-        shader->setVector("u_prevRegionMin", clipRegions[clipmapLevel - 1].getMinPosWorld());
-        shader->setVector("u_prevRegionMax", clipRegions[clipmapLevel - 1].getMaxPosWorld());
-        shader->setFloat("u_downsampleTransitionRegionSize", m_voxelizationDesc.downsampleTransitionRegionSize * voxelRegion.voxelSize);
-    }
+    voxelization::setRegionUniforms(shader, voxelRegion, clipmapLevel, m_voxelizationDesc.clipRegions, m_voxelizationDesc.downsampleTransitionRegionSize);
+}
 
-    ECSUtil::renderEntitiesInAABB(BBox(regionMinWorld, regionMaxWorld), shader);
-    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+void Voxelizer::renderEntity(Entity entity)
+{
+    ECSUtil::renderEntity(entity, m_voxelizationDesc.voxelizationShader);
+    ++m_drawCount;
 }
 
 void Voxelizer::endVoxelization(const Rect& originalViewport)
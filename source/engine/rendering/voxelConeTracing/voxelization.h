@@ -1,10 +1,12 @@
 #pragma once
+#include <vector>
 #include <glm/glm.hpp>
 #include "engine/rendering/Framebuffer.h"
+#include "engine/util/ECSUtil/SceneBVH.h"
+#include "VoxelRegion.h"
 
 class Rect;
 class Shader;
-struct VoxelRegion;
 
 enum class VoxelizationMode
 {
@@ -12,32 +14,118 @@ enum class VoxelizationMode
     MSAA
 };
 
+enum class VoxelizationLayer
+{
+    ALL,
+    STATIC, // Entities without DynamicVoxelization
+    DYNAMIC
+};
+
+struct VoxelizationRegion
+{
+    VoxelRegion region;
+    int clipmapLevel{0};
+};
+
 struct VoxelizationDesc
 {
     Shader* voxelizationShader{nullptr};
     VoxelizationMode mode{VoxelizationMode::CONSERVATIVE};
     std::vector<VoxelRegion> clipRegions;
     int downsampleTransitionRegionSize{0};
+
+    // The shader is a MULTI_REGION_VOXELIZATION variant (only conservative voxelization): The regions are read from a
+    // shader storage buffer and up to Voxelizer::MAX_REGIONS_PER_DRAW regions are voxelized with one draw per entity.
+    bool multiRegion{false};
 };
 
 class Voxelizer
 {
 public:
+    // Geometry shader invocations of conservativeMultiRegionVoxelization.geom
+    static const std::size_t MAX_REGIONS_PER_DRAW = 32;
+
     Voxelizer();
+    ~Voxelizer();
+
+    /**
+    * Updates the BVH over the entity bounding boxes that is used to find the entities of the voxelized regions.
+    * Has to be called once per frame before the first voxelization and before ECS::lateUpdate().
+    */
+    void updateSceneBVH() { m_sceneBVH.update(); }
+
+    SceneBVH& getSceneBVH() { return m_sceneBVH; }
 
     void beginVoxelization(const VoxelizationDesc& desc);
 
-    void voxelize(const VoxelRegion& voxelRegion, int clipmapLevel);
+    /**
+    * Voxelizes the entities of the layer that overlap the region. The image writes are not made visible - the caller issues
+    * the barrier before it accesses them in the same pass, the frame graph places it between passes.
+    */
+    void voxelize(const VoxelRegion& voxelRegion, int clipmapLevel, VoxelizationLayer layer = VoxelizationLayer::ALL);
+
+    /**
+    * Voxelizes the entities of the layer that overlap the regions of the clipmap level.
+    * The draw lists of all regions are gathered with one batched query of the scene BVH.
+    */
+    void voxelize(const std::vector<VoxelRegion>& voxelRegions, int clipmapLevel, VoxelizationLayer layer = VoxelizationLayer::ALL);
+
+    /**
+    * Voxelizes the entities of the layer that overlap the regions of (possibly) different clipmap levels.
+    * With a multi-region shader an entity is drawn once per batch of regions instead of once per region.
+    */
+    void voxelize(const std::vector<VoxelizationRegion>& voxelRegions, VoxelizationLayer layer = VoxelizationLayer::ALL);
 
     void endVoxelization(const Rect& originalViewport);
 
+    /**
+    * Number of entity draws since the last beginVoxelization().
+    */
+    std::size_t getDrawCount() const { return m_drawCount; }
+
 private:
+    // std430 layout of VoxelizationRegion in voxelization.glsl
+    struct VoxelizationRegionData
+    {
+        glm::mat4 viewProj[3];
+        glm::mat4 viewProjInv[3];
+        glm::vec4 regionMin; // w: clipmap level
+        glm::vec4 regionMax; // w: voxel size
+        glm::vec4 prevRegionMin; // w: max extent
+        glm::vec4 prevRegionMax; // w: downsample transition region size
+    };
+
+    static_assert(sizeof(VoxelizationRegionData) == 448, "VoxelizationRegionData has to match the std430 layout in voxelization.glsl");
+
     Framebuffer* getFramebuffer(VoxelizationMode mode);
 
+    void voxelize(const VoxelizationRegion* voxelRegions, std::size_t regionCount, VoxelizationLayer layer);
+
+    void voxelizeMultiRegion(const VoxelizationRegion* voxelRegions, std::size_t regionCount);
+
+    void setRegionUniforms(const VoxelRegion& voxelRegion, int clipmapLevel);
+
+    void renderEntity(Entity entity);
+
 private:
     VoxelizationDesc m_voxelizationDesc;
     std::unique_ptr<Framebuffer> m_framebuffer;
     std::unique_ptr<Framebuffer> m_msaaFramebuffer;
+
+    SceneBVH m_sceneBVH;
+
+    // Draw lists of the current voxelize() call - kept to avoid reallocations
+    std::vector<BBox> m_regionBBoxes;
+    BVH::BatchQueryResult m_drawLists;
+    std::vector<VoxelizationRegion> m_levelRegions;
+
+    // Multi-region voxelization
+    GLuint m_regionBuffer{0};
+    std::vector<VoxelizationRegionData> m_regionData; // Uploaded to m_regionBuffer
+    std::vector<std::size_t> m_multiRegionIndices; // Regions with a non-empty draw list
+    std::vector<uint32_t> m_drawnInBatch; // Last batch (+1) that drew the primitive
+
+    std::size_t m_drawCount{0};
 };
 
 namespace voxelization
@@ -47,6 +135,15 @@ namespace voxelization
     glm::ivec3 computeLowerBound(const glm::vec3& vec);
     glm::ivec3 computeUpperBound(const glm::vec3& vec);
 
+    void computeViewProjectionMatrices(const VoxelRegion& voxelRegion, glm::mat4 viewProj[3], glm::mat4 viewProjInv[3]);
+    void computeViewportSizes(const glm::vec3& viewportSize, glm::vec2 viewportSizes[3]);
+
     void setViewProjectionMatrices(Shader* shader, const VoxelRegion& voxelRegion);
     void setViewports(Shader* shader, const glm::vec3& viewportSize);
+
+    /**
+    * Sets the region and clipmap level uniforms of voxelization.glsl.
+    */
+    void setRegionUniforms(Shader* shader, const VoxelRegion& voxelRegion, int clipmapLevel,
+                           const std::vector<VoxelRegion>& clipRegions, int downsampleTransitionRegionSize);
 }
@@ -4,13 +4,15 @@
 #include <engine/rendering/geometry/Mesh.h>
 #include <memory>
 #include <engine/util/util.h>
+#include <engine/util/ThreadPool.h>
 
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <cstddef>
+#include <cstring>
 
-std::shared_ptr<Model> AssetImporter::import(const std::string& filename)
+std::shared_ptr<Model> AssetImporter::import(const std::string& filename, ThreadPool* threadPool)
 {
     const aiScene* scene = aiImportFile(filename.c_str(), aiProcessPreset_TargetRealtime_Fast | aiProcess_MakeLeftHanded | aiProcess_FlipWindingOrder);
 
@@ -20,9 +22,28 @@ std::shared_ptr<Model> AssetImporter::import(const std::string& filename)
         return nullptr;
     }
 
-    auto model = process(scene, scene->mRootNode);
+    // Convert the meshes in parallel - the node hierarchy only references them
+    std::vector<ImportedMesh> meshes(scene->mNumMeshes);
+    auto convert = [scene, &meshes](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            convertMesh(scene, scene->mMeshes[i], meshes[i]);
+    };
+
+    if (threadPool)
+        threadPool->parallelFor(meshes.size(), 1, convert);
+    else
+        convert(0, meshes.size());
+
+    std::vector<uint32_t> meshReferences(scene->mNumMeshes, 0);
+    countMeshReferences(scene->mRootNode, meshReferences);
+
+    auto model = process(scene, scene->mRootNode, meshes, meshReferences);
     aiReleaseImport(scene);
 
+    // The entities are placed at the centers by ECSUtil::loadMeshEntities()
+    model->recenter();
+
     return model;
 }
 
@@ -65,7 +86,73 @@ void setFloat(const char* pKey, unsigned type, unsigned idx, aiMaterial* materia
         vOut = defaultVal;
 }
 
-std::shared_ptr<Model> AssetImporter::process(const aiScene* scene, const aiNode* node)
+void AssetImporter::convertMesh(const aiScene* scene, const aiMesh* mesh, ImportedMesh& importedMesh)
+{
+    Mesh::SubMesh& subMesh = importedMesh.subMesh;
+    MaterialDescription& materialDesc = importedMesh.material;
+
+    auto vertices = mesh->mVertices;
+    auto normals = mesh->mNormals;
+    auto tangents = mesh->mTangents;
+    auto bitangents = mesh->mBitangents;
+    auto uvs = mesh->mTextureCoords[0];
+    //auto colors = mesh->mColors[0];
+
+    auto mat = scene->mMaterials[mesh->mMaterialIndex];
+    addTextures(aiTextureType_DIFFUSE, mat, materialDesc.diffuseTextures);
+    addTextures(aiTextureType_HEIGHT, mat, materialDesc.normalTextures);
+    addTextures(aiTextureType_SPECULAR, mat, materialDesc.specularTextures);
+    addTextures(aiTextureType_AMBIENT, mat, materialDesc.emissionTextures);
+    addTextures(aiTextureType_EMISSIVE, mat, materialDesc.emissionTextures);
+    addTextures(aiTextureType_OPACITY, mat, materialDesc.opacityTextures);
+
+    setColor(AI_MATKEY_COLOR_DIFFUSE, mat, glm::vec3(1.f), materialDesc.diffuseColor);
+    setColor(AI_MATKEY_COLOR_SPECULAR, mat, glm::vec3(1.f), materialDesc.specularColor);
+    setColor(AI_MATKEY_COLOR_EMISSIVE, mat, glm::vec3(0.f), materialDesc.emissiveColor);
+    setFloat(AI_MATKEY_SHININESS, mat, 0.f, materialDesc.shininess);
+    setFloat(AI_MATKEY_OPACITY, mat, 1.0f, materialDesc.opacity);
+
+    // aiVector3D and glm::vec3 are both three tightly packed floats - copy whole arrays
+    static_assert(sizeof(aiVector3D) == sizeof(glm::vec3), "Vertex attributes can't be copied as arrays.");
+    auto copyArray = [&](const aiVector3D* src, std::vector<glm::vec3>& dst)
+    {
+        dst.resize(mesh->mNumVertices);
+        std::memcpy(static_cast<void*>(dst.data()), src, mesh->mNumVertices * sizeof(glm::vec3));
+    };
+
+    copyArray(vertices, subMesh.vertices);
+
+    if (mesh->HasNormals())
+        copyArray(normals, subMesh.normals);
+
+    if (mesh->HasTangentsAndBitangents())
+    {
+        copyArray(tangents, subMesh.tangents);
+        copyArray(bitangents, subMesh.bitangents);
+    }
+
+    if (mesh->HasTextureCoords(0))
+    {
+        subMesh.uvs.resize(mesh->mNumVertices);
+        for (unsigned int j = 0; j < mesh->mNumVertices; ++j)
+            subMesh.uvs[j] = glm::vec2(uvs[j].x, uvs[j].y);
+    }
+
+    // Faces are triangles after aiProcess_Triangulate
+    subMesh.indices.reserve(mesh->mNumFaces * 3);
+
+    for (unsigned int k = 0; k < mesh->mNumFaces; ++k)
+    {
+        auto face = mesh->mFaces[k];
+
+        for (unsigned int j = 0; j < face.mNumIndices; ++j)
+        {
+            subMesh.indices.push_back(face.mIndices[j]);
+        }
+    }
+}
+
+std::shared_ptr<Model> AssetImporter::process(const aiScene* scene, const aiNode* node, std::vector<ImportedMesh>& meshes, std::vector<uint32_t>& meshReferences)
 {
     std::shared_ptr<Model> model = std::make_shared<Model>();
     model->name = node->mName.C_Str();
@@ -77,70 +164,19 @@ std::shared_ptr<Model> AssetImporter::process(const aiScene* scene, const aiNode
 
         for (unsigned int i = 0; i < node->mNumMeshes; ++i)
         {
-            Mesh::SubMesh& subMesh = model->subMeshes[i];
-            MaterialDescription& materialDesc = model->materials[i];
-
             auto meshIdx = node->mMeshes[i];
-            auto mesh = scene->mMeshes[meshIdx];
-            auto vertices = mesh->mVertices;
-            auto normals = mesh->mNormals;
-            auto tangents = mesh->mTangents;
-            auto bitangents = mesh->mBitangents;
-            auto uvs = mesh->mTextureCoords[0];
-            //auto colors = mesh->mColors[0];
-
-            auto mat = scene->mMaterials[mesh->mMaterialIndex];
-            addTextures(aiTextureType_DIFFUSE, mat, materialDesc.diffuseTextures);
-            addTextures(aiTextureType_HEIGHT, mat, materialDesc.normalTextures);
-            addTextures(aiTextureType_SPECULAR, mat, materialDesc.specularTextures);
-            addTextures(aiTextureType_AMBIENT, mat, materialDesc.emissionTextures);
-            addTextures(aiTextureType_EMISSIVE, mat, materialDesc.emissionTextures);
-            addTextures(aiTextureType_OPACITY, mat, materialDesc.opacityTextures);
-
-            setColor(AI_MATKEY_COLOR_DIFFUSE, mat, glm::vec3(1.f), materialDesc.diffuseColor);
-            setColor(AI_MATKEY_COLOR_SPECULAR, mat, glm::vec3(1.f), materialDesc.specularColor);
-            setColor(AI_MATKEY_COLOR_EMISSIVE, mat, glm::vec3(0.f), materialDesc.emissiveColor);
-            setFloat(AI_MATKEY_SHININESS, mat, 0.f, materialDesc.shininess);
-            setFloat(AI_MATKEY_OPACITY, mat, 1.0f, materialDesc.opacity);
-
-            for (unsigned int j = 0; j < mesh->mNumVertices; ++j)
+            ImportedMesh& mesh = meshes[meshIdx];
+
+            // The last node which references the mesh takes the data
+            if (--meshReferences[meshIdx] == 0)
             {
-                subMesh.vertices.push_back(glm::vec3(vertices[j].x, vertices[j].y, vertices[j].z));
-
-                if (mesh->HasNormals())
-                {
-                    subMesh.normals.push_back(glm::vec3(normals[j].x, normals[j].y, normals[j].z));
-                }
-
-                if (mesh->HasTangentsAndBitangents())
-                {
-                    subMesh.tangents.push_back(glm::vec3(tangents[j].x, tangents[j].y, tangents[j].z));
-                }
-
-                if (mesh->HasTangentsAndBitangents())
-                {
-                    subMesh.bitangents.push_back(glm::vec3(bitangents[j].x, bitangents[j].y, bitangents[j].z));
-                }
-
-                if (mesh->HasTextureCoords(0))
-                {
-                    subMesh.uvs.push_back(glm::vec2(uvs[j].x, uvs[j].y));
-                }
-
-                //if (mesh->HasVertexColors(0))
-                //{
-                //    subMesh.colors.push_back(glm::vec3(colors[j].r, colors[j].g, colors[j].b));
-                //}
+                model->subMeshes[i] = std::move(mesh.subMesh);
+                model->materials[i] = std::move(mesh.material);
             }
-
-            for (unsigned int k = 0; k < mesh->mNumFaces; ++k)
+            else
             {
-                auto face = mesh->mFaces[k];
-
-                for (unsigned int j = 0; j < face.mNumIndices; ++j)
-                {
-                    subMesh.indices.push_back(face.mIndices[j]);
-                }
+                model->subMeshes[i] = mesh.subMesh;
+                model->materials[i] = mesh.material;
             }
         }
     }
@@ -157,9 +193,18 @@ std::shared_ptr<Model> AssetImporter::process(const aiScene* scene, const aiNode
 
     for (unsigned int i = 0; i < node->mNumChildren; ++i)
     {
-        auto childModel = process(scene, node->mChildren[i]);
+        auto childModel = process(scene, node->mChildren[i], meshes, meshReferences);
         model->addChild(childModel);
     }
 
     return model;
 }
+
+void AssetImporter::countMeshReferences(const aiNode* node, std::vector<uint32_t>& meshReferences)
+{
+    for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+        ++meshReferences[node->mMeshes[i]];
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+        countMeshReferences(node->mChildren[i], meshReferences);
+}
@@ -1,17 +1,34 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "Model.h"
 
 struct aiScene;
 struct aiNode;
+struct aiMesh;
 class Mesh;
+class ThreadPool;
 
 class AssetImporter
 {
 public:
-    static std::shared_ptr<Model> import(const std::string& filename);
+    /**
+    * The meshes of the scene are converted in parallel if a thread pool is given.
+    */
+    static std::shared_ptr<Model> import(const std::string& filename, ThreadPool* threadPool = nullptr);
 
 private:
-    static std::shared_ptr<Model> process(const aiScene* scene, const aiNode* aiNode);
+    struct ImportedMesh
+    {
+        Mesh::SubMesh subMesh;
+        MaterialDescription material;
+    };
+
+    static void convertMesh(const aiScene* scene, const aiMesh* mesh, ImportedMesh& importedMesh);
+
+    static std::shared_ptr<Model> process(const aiScene* scene, const aiNode* aiNode, std::vector<ImportedMesh>& meshes, std::vector<uint32_t>& meshReferences);
+
+    static void countMeshReferences(const aiNode* node, std::vector<uint32_t>& meshReferences);
 };
@@ -0,0 +1,440 @@
+#include "MeshCache.h"
+#include "Model.h"
+#include <engine/util/MappedFile.h>
+#include <engine/util/file.h>
+#include <engine/util/Logger.h>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+const uint32_t MeshCache::VERSION;
+
+namespace
+{
+    const char MAGIC[8] = { 'V', 'C', 'T', 'M', 'E', 'S', 'H', '\0' };
+    const uint32_t ALIGNMENT = 16;
+    const uint32_t NO_PARENT = 0xFFFFFFFF;
+
+    enum TextureType : uint32_t
+    {
+        DIFFUSE_TEXTURE = 0,
+        NORMAL_TEXTURE,
+        SPECULAR_TEXTURE,
+        EMISSION_TEXTURE,
+        OPACITY_TEXTURE,
+        TEXTURE_TYPE_COUNT
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t nodeCount;
+        uint64_t fileSize;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint32_t subMeshCount;
+        uint32_t textureCount;
+        uint64_t nodeTableOffset;
+        uint64_t subMeshTableOffset;
+        uint64_t textureTableOffset;
+        uint64_t stringTableOffset;
+        uint64_t stringTableSize;
+    };
+
+    struct NodeEntry
+    {
+        uint32_t parent;
+        uint32_t nameOffset;
+        uint32_t firstSubMesh;
+        uint32_t subMeshCount;
+        float position[3];
+        float scale[3];
+        float rotation[4]; // w, x, y, z
+        float center[3];
+    };
+
+    // The vertices are interleaved with the VERTEX_* attributes - offsets are 0 if there are no vertices or indices
+    struct SubMeshEntry
+    {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint32_t attributes;
+
+        uint32_t firstTexture;
+        uint32_t textureCount;
+        float diffuseColor[3];
+        float specularColor[3];
+        float emissiveColor[3];
+        float opacity;
+        float shininess;
+    };
+
+    struct TextureEntry
+    {
+        uint32_t type;
+        uint32_t pathOffset;
+    };
+
+    static_assert(sizeof(Header) % 8 == 0, "Unexpected header padding.");
+    static_assert(sizeof(NodeEntry) == 68, "Unexpected node entry padding.");
+    static_assert(sizeof(SubMeshEntry) % 8 == 0, "Unexpected sub mesh entry padding.");
+
+    uint64_t align(uint64_t offset) { return (offset + ALIGNMENT - 1) & ~uint64_t(ALIGNMENT - 1); }
+
+    const uint32_t CACHED_ATTRIBUTES = VERTEX_POS | VERTEX_NORMAL | VERTEX_TANGENT | VERTEX_BITANGENT | VERTEX_UV | VERTEX_COLOR;
+
+    void copyTo(float* dst, const glm::vec3& v) { std::memcpy(dst, &v[0], sizeof(glm::vec3)); }
+
+    /**
+    * Tangents, bitangents and uvs are written in any case (zero if missing).
+    * Normals and colors only if the sub mesh has them.
+    */
+    uint32_t interleave(const Mesh::SubMesh& subMesh, float* dst)
+    {
+        std::size_t vertexCount = subMesh.vertices.size();
+        bool hasNormals = subMesh.normals.size() == vertexCount;
+        bool hasColors = subMesh.colors.size() == vertexCount;
+        bool hasTangents = subMesh.tangents.size() == vertexCount;
+        bool hasBitangents = subMesh.bitangents.size() == vertexCount;
+        bool hasUVs = subMesh.uvs.size() == vertexCount;
+
+        auto put = [&dst](const float* src, std::size_t count)
+        {
+            if (src)
+                std::memcpy(dst, src, count * sizeof(float));
+
+            // The writer buffer is zero initialized
+            dst += count;
+        };
+
+        for (std::size_t i = 0; i < vertexCount; ++i)
+        {
+            put(&subMesh.vertices[i][0], 3);
+
+            if (hasNormals)
+                put(&subMesh.normals[i][0], 3);
+
+            put(hasTangents ? &subMesh.tangents[i][0] : nullptr, 3);
+            put(hasBitangents ? &subMesh.bitangents[i][0] : nullptr, 3);
+            put(hasUVs ? &subMesh.uvs[i][0] : nullptr, 2);
+
+            if (hasColors)
+                put(&subMesh.colors[i][0], 3);
+        }
+
+        return VERTEX_POS | VERTEX_TANGENT | VERTEX_BITANGENT | VERTEX_UV | (hasNormals ? VERTEX_NORMAL : 0) | (hasColors ? VERTEX_COLOR : 0);
+    }
+
+    glm::vec3 toVec3(const float* src) { return glm::vec3(src[0], src[1], src[2]); }
+
+    /**
+    * Collects the nodes in depth-first order.
+    */
+    void flatten(const Model* model, uint32_t parent, std::vector<std::pair<const Model*, uint32_t>>& nodes)
+    {
+        uint32_t idx = uint32_t(nodes.size());
+        nodes.push_back({ model, parent });
+
+        for (auto& child : model->children)
+            flatten(child.get(), idx, nodes);
+    }
+
+    class Writer
+    {
+    public:
+        uint64_t reserve(uint64_t size)
+        {
+            uint64_t offset = align(m_data.size());
+            m_data.resize(offset + size, 0);
+            return offset;
+        }
+
+        template <class T>
+        uint64_t writeArray(const std::vector<T>& v)
+        {
+            if (v.empty())
+                return 0;
+
+            uint64_t offset = reserve(v.size() * sizeof(T));
+            std::memcpy(&m_data[offset], v.data(), v.size() * sizeof(T));
+            return offset;
+        }
+
+        /**
+        * Drops the data after size - used to reserve the maximum size before the actual size is known.
+        */
+        void shrink(uint64_t size) { m_data.resize(size); }
+
+        template <class T>
+        T* at(uint64_t offset) { return reinterpret_cast<T*>(&m_data[offset]); }
+
+        const std::vector<uint8_t>& data() const { return m_data; }
+
+    private:
+        std::vector<uint8_t> m_data;
+    };
+
+    class StringTable
+    {
+    public:
+        uint32_t add(const std::string& str)
+        {
+            uint32_t offset = uint32_t(m_data.size());
+            m_data.insert(m_data.end(), str.begin(), str.end());
+            m_data.push_back('\0');
+            return offset;
+        }
+
+        const std::vector<char>& data() const { return m_data; }
+
+    private:
+        std::vector<char> m_data;
+    };
+
+    bool isInFile(const MappedFile& file, uint64_t offset, uint64_t size)
+    {
+        return offset % ALIGNMENT == 0 && offset <= file.size() && size <= file.size() - offset;
+    }
+}
+
+std::shared_ptr<Model> MeshCache::read(const std::string& cachePath, const std::string& sourcePath)
+{
+    // Owned by the sub meshes which reference the vertices and indices in the mapping
+    auto mappedFile = std::make_shared<MappedFile>();
+    const MappedFile& file = *mappedFile;
+    if (!mappedFile->open(cachePath) || file.size() < sizeof(Header))
+        return nullptr;
+
+    const Header& header = *reinterpret_cast<const Header*>(file.data());
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.fileSize != file.size())
+        return nullptr;
+
+    if (file::exists(sourcePath) &&
+        (header.sourceSize != file::getSize(sourcePath) || header.sourceWriteTime != file::getLastWriteTime(sourcePath)))
+        return nullptr;
+
+    if (header.nodeCount == 0 ||
+        header.nodeTableOffset + header.nodeCount * sizeof(NodeEntry) > file.size() ||
+        header.subMeshTableOffset + header.subMeshCount * sizeof(SubMeshEntry) > file.size() ||
+        header.textureTableOffset + header.textureCount * sizeof(TextureEntry) > file.size() ||
+        header.stringTableOffset + header.stringTableSize > file.size() ||
+        header.stringTableSize == 0 || file.data()[header.stringTableOffset + header.stringTableSize - 1] != '\0')
+    {
+        LOG_ERROR("Invalid mesh cache " << cachePath);
+        return nullptr;
+    }
+
+    auto nodes = reinterpret_cast<const NodeEntry*>(file.data() + header.nodeTableOffset);
+    auto subMeshes = reinterpret_cast<const SubMeshEntry*>(file.data() + header.subMeshTableOffset);
+    auto textures = reinterpret_cast<const TextureEntry*>(file.data() + header.textureTableOffset);
+    auto strings = reinterpret_cast<const char*>(file.data() + header.stringTableOffset);
+
+    auto getString = [&](uint32_t offset) { return offset < header.stringTableSize ? std::string(strings + offset) : std::string(); };
+
+    std::vector<std::shared_ptr<Model>> models(header.nodeCount);
+
+    for (uint32_t i = 0; i < header.nodeCount; ++i)
+    {
+        const NodeEntry& node = nodes[i];
+        auto model = std::make_shared<Model>();
+        models[i] = model;
+
+        model->name = getString(node.nameOffset);
+        model->position = toVec3(node.position);
+        model->scale = toVec3(node.scale);
+        model->rotation = glm::quat(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]);
+        model->center = toVec3(node.center);
+
+        // Parents come before their children
+        if (node.parent != NO_PARENT)
+        {
+            if (node.parent >= i)
+                return nullptr;
+
+            models[node.parent]->addChild(model);
+        }
+        else
+        {
+            model->parent = nullptr;
+        }
+
+        if (uint64_t(node.firstSubMesh) + node.subMeshCount > header.subMeshCount)
+            return nullptr;
+
+        model->subMeshes.resize(node.subMeshCount);
+        model->materials.resize(node.subMeshCount);
+
+        for (uint32_t j = 0; j < node.subMeshCount; ++j)
+        {
+            const SubMeshEntry& entry = subMeshes[node.firstSubMesh + j];
+            Mesh::SubMesh& subMesh = model->subMeshes[j];
+            MaterialDescription& material = model->materials[j];
+
+            uint64_t vertexSize = uint64_t(entry.vertexCount) * Mesh::getFloatsPerVertex(entry.attributes) * sizeof(float);
+            if ((entry.attributes & ~CACHED_ATTRIBUTES) != 0 ||
+                (entry.vertexCount > 0 && !isInFile(file, entry.vertexOffset, vertexSize)) ||
+                (entry.indexCount > 0 && !isInFile(file, entry.indexOffset, uint64_t(entry.indexCount) * sizeof(IndexType))))
+            {
+                LOG_ERROR("Invalid mesh cache " << cachePath);
+                return nullptr;
+            }
+
+            InterleavedSubMeshData& data = subMesh.interleaved;
+            data.owner = mappedFile;
+            data.vertices = reinterpret_cast<const float*>(file.data() + entry.vertexOffset);
+            data.indices = entry.indexCount > 0 ? reinterpret_cast<const IndexType*>(file.data() + entry.indexOffset) : nullptr;
+            data.vertexCount = entry.vertexCount;
+            data.indexCount = entry.indexCount;
+            data.attributes = entry.attributes;
+
+            if (uint64_t(entry.firstTexture) + entry.textureCount > header.textureCount)
+                return nullptr;
+
+            std::vector<std::string>* textureLists[TEXTURE_TYPE_COUNT] = { &material.diffuseTextures, &material.normalTextures,
+                &material.specularTextures, &material.emissionTextures, &material.opacityTextures };
+
+            for (uint32_t k = entry.firstTexture; k < entry.firstTexture + entry.textureCount; ++k)
+            {
+                if (textures[k].type < TEXTURE_TYPE_COUNT)
+                    textureLists[textures[k].type]->push_back(getString(textures[k].pathOffset));
+            }
+
+            material.diffuseColor = toVec3(entry.diffuseColor);
+            material.specularColor = toVec3(entry.specularColor);
+            material.emissiveColor = toVec3(entry.emissiveColor);
+            material.opacity = entry.opacity;
+            material.shininess = entry.shininess;
+        }
+    }
+
+    return models[0];
+}
+
+bool MeshCache::write(const std::string& cachePath, const std::string& sourcePath, const Model& model)
+{
+    std::vector<std::pair<const Model*, uint32_t>> nodes;
+    flatten(&model, NO_PARENT, nodes);
+
+    uint32_t subMeshCount = 0;
+    uint32_t textureCount = 0;
+    for (auto& n : nodes)
+    {
+        subMeshCount += uint32_t(n.first->subMeshes.size());
+
+        for (auto& m : n.first->materials)
+            textureCount += uint32_t(m.diffuseTextures.size() + m.normalTextures.size() + m.specularTextures.size() +
+                                     m.emissionTextures.size() + m.opacityTextures.size());
+    }
+
+    Writer writer;
+    StringTable strings;
+
+    // Offsets stay valid while the buffer grows - pointers are fetched again after every write
+    uint64_t headerOffset = writer.reserve(sizeof(Header));
+    uint64_t nodeTableOffset = writer.reserve(nodes.size() * sizeof(NodeEntry));
+    uint64_t subMeshTableOffset = writer.reserve(subMeshCount * sizeof(SubMeshEntry));
+    uint64_t textureTableOffset = writer.reserve(textureCount * sizeof(TextureEntry));
+
+    uint32_t subMeshIdx = 0;
+    uint32_t textureIdx = 0;
+
+    for (uint32_t i = 0; i < nodes.size(); ++i)
+    {
+        const Model* m = nodes[i].first;
+
+        NodeEntry node;
+        node.parent = nodes[i].second;
+        node.nameOffset = strings.add(m->name);
+        node.firstSubMesh = subMeshIdx;
+        node.subMeshCount = uint32_t(m->subMeshes.size());
+        copyTo(node.position, m->position);
+        copyTo(node.scale, m->scale);
+        node.rotation[0] = m->rotation.w;
+        node.rotation[1] = m->rotation.x;
+        node.rotation[2] = m->rotation.y;
+        node.rotation[3] = m->rotation.z;
+        copyTo(node.center, m->center);
+        *writer.at<NodeEntry>(nodeTableOffset + i * sizeof(NodeEntry)) = node;
+
+        for (std::size_t j = 0; j < m->subMeshes.size(); ++j)
+        {
+            const Mesh::SubMesh& subMesh = m->subMeshes[j];
+            MaterialDescription material = j < m->materials.size() ? m->materials[j] : MaterialDescription();
+
+            SubMeshEntry entry;
+            std::memset(&entry, 0, sizeof(SubMeshEntry));
+            entry.vertexCount = uint32_t(subMesh.vertices.size());
+            entry.indexCount = uint32_t(subMesh.indices.size());
+            entry.attributes = VERTEX_POS;
+
+            // Attributes which don't match the vertex count are dropped
+            if (entry.vertexCount > 0)
+            {
+                entry.vertexOffset = writer.reserve(entry.vertexCount * Mesh::getFloatsPerVertex(CACHED_ATTRIBUTES) * sizeof(float));
+                entry.attributes = interleave(subMesh, writer.at<float>(entry.vertexOffset));
+                writer.shrink(entry.vertexOffset + entry.vertexCount * Mesh::getFloatsPerVertex(entry.attributes) * sizeof(float));
+            }
+
+            entry.indexOffset = writer.writeArray(subMesh.indices);
+
+            entry.firstTexture = textureIdx;
+            const std::vector<std::string>* textureLists[TEXTURE_TYPE_COUNT] = { &material.diffuseTextures, &material.normalTextures,
+                &material.specularTextures, &material.emissionTextures, &material.opacityTextures };
+
+            for (uint32_t type = 0; type < TEXTURE_TYPE_COUNT; ++type)
+            {
+                for (auto& path : *textureLists[type])
+                {
+                    TextureEntry texture;
+                    texture.type = type;
+                    texture.pathOffset = strings.add(path);
+                    *writer.at<TextureEntry>(textureTableOffset + textureIdx * sizeof(TextureEntry)) = texture;
+                    ++textureIdx;
+                }
+            }
+
+            entry.textureCount = textureIdx - entry.firstTexture;
+            copyTo(entry.diffuseColor, material.diffuseColor);
+            copyTo(entry.specularColor, material.specularColor);
+            copyTo(entry.emissiveColor, material.emissiveColor);
+            entry.opacity = material.opacity;
+            entry.shininess = material.shininess;
+
+            *writer.at<SubMeshEntry>(subMeshTableOffset + subMeshIdx * sizeof(SubMeshEntry)) = entry;
+            ++subMeshIdx;
+        }
+    }
+
+    uint64_t stringTableOffset = writer.writeArray(strings.data());
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.nodeCount = uint32_t(nodes.size());
+    header.fileSize = writer.data().size();
+    header.sourceSize = file::getSize(sourcePath);
+    header.sourceWriteTime = file::getLastWriteTime(sourcePath);
+    header.subMeshCount = subMeshCount;
+    header.textureCount = textureCount;
+    header.nodeTableOffset = nodeTableOffset;
+    header.subMeshTableOffset = subMeshTableOffset;
+    header.textureTableOffset = textureTableOffset;
+    header.stringTableOffset = stringTableOffset;
+    header.stringTableSize = strings.data().size();
+    *writer.at<Header>(headerOffset) = header;
+
+    std::ofstream os(cachePath, std::ios::binary | std::ios::trunc);
+    if (!os.is_open())
+    {
+        LOG_ERROR("Could not write mesh cache " << cachePath);
+        return false;
+    }
+
+    os.write(reinterpret_cast<const char*>(writer.data().data()), std::streamsize(writer.data().size()));
+    return bool(os);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <cstdint>
+
+struct Model;
+
+/**
+* Binary cache of imported models (".vctmesh") that replaces the Assimp import on later starts.
+*
+* Layout (all sections 16 byte aligned, offsets relative to the start of the file):
+*   Header
+*   Node table      - model tree in depth-first order, each node references its parent and its sub meshes
+*   Sub mesh table  - counts, attribute flags, data offsets and the material description of each sub mesh
+*   Texture table   - texture paths of all materials
+*   String table    - null-terminated node names and texture paths
+*   Data            - interleaved vertices (see InterleavedSubMeshData) and indices of all sub meshes
+*
+* The vertices are stored relative to the node centers (see Model::recenter()) and tangents, bitangents and uvs are always
+* stored (zero if the source has none) - the layout loadMeshEntities() needs, so the data is never modified after loading.
+* The file stays memory mapped while sub meshes reference it and Mesh::finalize() uploads straight from the mapping.
+* The cache is invalidated if the version, size or modification time of the source file changed.
+*/
+class MeshCache
+{
+public:
+    static const uint32_t VERSION = 2;
+
+    static std::string getCachePath(const std::string& sourcePath) { return sourcePath + ".vctmesh"; }
+
+    /**
+    * Returns nullptr if the cache doesn't exist, is invalid or is stale relative to the source file.
+    * If the source file doesn't exist the cache is used as is.
+    * The sub meshes of the returned model reference the mapped file instead of holding vectors.
+    */
+    static std::shared_ptr<Model> read(const std::string& cachePath, const std::string& sourcePath);
+
+    /**
+    * Returns false if the file can't be written. Only the vertex vectors of the model are stored.
+    */
+    static bool write(const std::string& cachePath, const std::string& sourcePath, const Model& model);
+};
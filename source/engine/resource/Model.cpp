@@ -40,10 +40,33 @@ std::size_t Model::getTriangleCount() const
     std::size_t triangleCount = 0;
 
     for (auto& sm : subMeshes)
-        triangleCount += sm.indices.size() / 3;
+        triangleCount += sm.getIndexCount() / 3;
 
     for (auto& c : children)
         triangleCount += c->getTriangleCount();
 
     return triangleCount;
 }
+
+void Model::recenter()
+{
+    std::size_t count = 0;
+    glm::vec3 sum;
+    for (auto& sm : subMeshes)
+    {
+        for (auto& v : sm.vertices)
+            sum += v;
+
+        count += sm.vertices.size();
+    }
+
+    glm::vec3 offset = count > 0 ? sum / float(count) : glm::vec3(0.0f);
+    for (auto& sm : subMeshes)
+        for (auto& v : sm.vertices)
+            v -= offset;
+
+    center += offset;
+
+    for (auto& c : children)
+        c->recenter();
+}
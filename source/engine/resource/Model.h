@@ -23,16 +23,28 @@ struct MaterialDescription
 struct Model
 {
     void addChild(std::shared_ptr<Model> model);
+
+    /**
+    * The vertices stay in the space of their node - node transformations and centers are not applied.
+    */
     std::vector<Mesh::SubMesh> getAllSubMeshes() const;
     std::vector<MaterialDescription> getAllMaterials() const;
     std::size_t getTriangleCount() const;
 
+    /**
+    * Moves the vertices of every node relative to its center (the average vertex position) and stores it in center.
+    */
+    void recenter();
+
     // Members
     std::string name;
     glm::vec3 position;
     glm::vec3 scale{1.0f,1.0f,1.0f};
     glm::quat rotation;
 
+    // The vertices of the sub meshes are relative to this point of the node space (see recenter())
+    glm::vec3 center;
+
     // Index of sub mesh corresponds to the index of the material
     std::vector<Mesh::SubMesh> subMeshes;
     std::vector<MaterialDescription> materials;
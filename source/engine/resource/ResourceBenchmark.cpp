@@ -0,0 +1,149 @@
+#include "ResourceBenchmark.h"
+#include "AssetImporter.h"
+#include "MeshCache.h"
+#include "Model.h"
+#include <engine/util/Timer.h>
+#include <engine/util/Logger.h>
+#include <engine/util/file.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <cstdio>
+
+namespace resource_benchmark
+{
+    const int CACHE_READ_ITERATIONS = 10;
+
+    bool equalVertex(const Mesh::SubMesh& imported, const Mesh::SubMesh& cached, std::size_t vertexIdx)
+    {
+        const InterleavedSubMeshData& data = cached.interleaved;
+        const float* v = data.vertices + vertexIdx * Mesh::getFloatsPerVertex(data.attributes);
+
+        if (imported.vertices[vertexIdx] != cached.getPosition(vertexIdx))
+            return false;
+
+        if (imported.normals.size() > 0 && ((data.attributes & VERTEX_NORMAL) == 0 ||
+            glm::vec3(imported.normals[vertexIdx]) != glm::make_vec3(v + Mesh::getAttributeOffset(data.attributes, VERTEX_NORMAL))))
+            return false;
+
+        return imported.uvs.empty() || imported.uvs[vertexIdx] == glm::make_vec2(v + Mesh::getAttributeOffset(data.attributes, VERTEX_UV));
+    }
+
+    bool equal(const Model& imported, const Model& cached)
+    {
+        if (imported.name != cached.name || imported.center != cached.center || imported.subMeshes.size() != cached.subMeshes.size() || imported.children.size() != cached.children.size())
+            return false;
+
+        for (std::size_t i = 0; i < imported.subMeshes.size(); ++i)
+        {
+            auto& sm0 = imported.subMeshes[i];
+            auto& sm1 = cached.subMeshes[i];
+
+            Indices indices;
+            if (sm0.vertices.size() != sm1.getVertexCount() || sm0.indices != sm1.getIndices(indices))
+                return false;
+
+            for (std::size_t j = 0; j < sm0.vertices.size(); ++j)
+                if (!equalVertex(sm0, sm1, j))
+                    return false;
+
+            if (imported.materials[i].diffuseTextures != cached.materials[i].diffuseTextures)
+                return false;
+        }
+
+        for (std::size_t i = 0; i < imported.children.size(); ++i)
+            if (!equal(*imported.children[i], *cached.children[i]))
+                return false;
+
+        return true;
+    }
+
+    /**
+    * Uploads the sub meshes of all nodes like ECSUtil::loadMeshEntities().
+    */
+    void upload(Model& model, std::vector<std::shared_ptr<Mesh>>& meshes)
+    {
+        if (model.subMeshes.size() > 0)
+        {
+            for (auto& subMesh : model.subMeshes)
+            {
+                subMesh.tangents.resize(subMesh.vertices.size());
+                subMesh.bitangents.resize(subMesh.vertices.size());
+                subMesh.uvs.resize(subMesh.vertices.size());
+            }
+
+            auto mesh = std::make_shared<Mesh>();
+            mesh->setSubMeshes(model.subMeshes);
+            mesh->finalize();
+            meshes.push_back(mesh);
+        }
+
+        for (auto& child : model.children)
+            upload(*child, meshes);
+    }
+
+    /**
+    * Returns the time in milliseconds until the GPU consumed the uploads.
+    */
+    double timeUpload(Model& model)
+    {
+        std::vector<std::shared_ptr<Mesh>> meshes;
+        Timer timer;
+        timer.start();
+        upload(model, meshes);
+        glFinish();
+        timer.tick();
+
+        return timer.deltaTimeInMicroseconds() / 1000.0;
+    }
+}
+using namespace resource_benchmark;
+
+void ResourceBenchmark::benchmarkModelLoad(const std::string& path)
+{
+    std::string sourcePath = ASSET_ROOT_FOLDER + path;
+    std::string cachePath = MeshCache::getCachePath(sourcePath) + ".benchmark";
+    Timer timer;
+
+    timer.start();
+    auto importedModel = AssetImporter::import(sourcePath);
+    timer.tick();
+
+    if (!importedModel)
+        return;
+
+    double importTime = timer.deltaTimeInMicroseconds() / 1000.0;
+    LOG("Resource Benchmark: Loading " << path << " with " << importedModel->getTriangleCount() << " triangles");
+    LOG("Assimp import: " << importTime << " ms");
+
+    timer.start();
+    bool written = MeshCache::write(cachePath, sourcePath, *importedModel);
+    timer.tick();
+
+    if (!written)
+        return;
+
+    LOG("Mesh cache write: " << timer.deltaTimeInMilliseconds() << " ms, " << file::getSize(cachePath) / (1024 * 1024) << " MB");
+
+    std::shared_ptr<Model> cachedModel;
+    timer.start();
+    for (int i = 0; i < CACHE_READ_ITERATIONS; ++i)
+        cachedModel = MeshCache::read(cachePath, sourcePath);
+    timer.tick();
+
+    double readTime = timer.deltaTimeInMicroseconds() / 1000.0 / CACHE_READ_ITERATIONS;
+    LOG("Mesh cache read: " << readTime << " ms");
+
+    if (!cachedModel || !equal(*importedModel, *cachedModel))
+    {
+        LOG_ERROR("The cached model doesn't match the imported model.");
+        std::remove(cachePath.c_str());
+        return;
+    }
+
+    // The imported model is interleaved per vertex on upload, the cached one is uploaded from the mapping
+    double importedUploadTime = timeUpload(*importedModel);
+    double cachedUploadTime = timeUpload(*cachedModel);
+    LOG("Upload of the imported model: " << importedUploadTime << " ms, of the cached model: " << cachedUploadTime << " ms");
+    LOG("Assimp import and upload: " << importTime + importedUploadTime << " ms, mesh cache read and upload: " << readTime + cachedUploadTime << " ms");
+
+    std::remove(cachePath.c_str());
+}
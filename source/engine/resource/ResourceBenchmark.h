@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+// Runs the resource benchmarks on startup of the demo and logs the results
+//#define RUN_RESOURCE_BENCHMARKS
+
+class ResourceBenchmark
+{
+public:
+    /**
+    * Compares the load time of the Assimp import with the load time of the mesh cache and the upload times of both models.
+    * Requires a GL context. path is relative to the asset root folder.
+    */
+    static void benchmarkModelLoad(const std::string& path);
+};
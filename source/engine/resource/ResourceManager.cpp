@@ -1,8 +1,12 @@
 #include "ResourceManager.h"
 #include "AssetImporter.h"
+#include "MeshCache.h"
 #include <engine/rendering/Material.h>
 #include <engine/rendering/renderer/MeshRenderer.h>
 #include "engine/util/file.h"
+#include <engine/util/ThreadPool.h>
+#include <engine/util/QueryManager.h>
+#include <engine/util/Profiler.h>
 #include <cstddef>
 
 std::unordered_map<Texture2DKey, std::shared_ptr<Texture2D>> ResourceManager::m_textures2D;
@@ -10,6 +14,14 @@ std::unordered_map<std::string, std::shared_ptr<MeshRenderer>> ResourceManager::
 std::unordered_map<std::string, std::shared_ptr<Model>> ResourceManager::m_models;
 std::unordered_map<ShaderKey, std::shared_ptr<Shader>> ResourceManager::m_shaders;
 std::unordered_map<std::string, std::string> ResourceManager::m_shaderIncludes;
+ThreadPool* ResourceManager::m_threadPool = nullptr;
+std::mutex ResourceManager::m_decodedTexturesMutex;
+std::deque<std::shared_ptr<ResourceManager::PendingTexture2D>> ResourceManager::m_decodedTextures;
+std::size_t ResourceManager::m_pendingTextureCount = 0;
+std::atomic<uint64_t> ResourceManager::m_decodeTimeInMicroseconds{0};
+uint64_t ResourceManager::m_uploadTimeInMicroseconds = 0;
+float ResourceManager::m_uploadBudgetInMilliseconds = 4.0f;
+Timer ResourceManager::m_loadTimer;
 
 std::shared_ptr<Texture2D> ResourceManager::getTexture(const std::string& path, Texture2DSettings settings)
 {
@@ -24,6 +36,101 @@ std::shared_ptr<Texture2D> ResourceManager::getTexture(const std::string& path,
     return texture;
 }
 
+std::shared_ptr<Texture2D> ResourceManager::getTextureAsync(const std::string& path, Texture2DSettings settings, const glm::u8vec4& placeholderColor)
+{
+    auto key = Texture2DKey(path, settings);
+    auto it = m_textures2D.find(key);
+    if (it != m_textures2D.end())
+        return it->second;
+
+    auto texture = std::make_shared<Texture2D>();
+    texture->create(1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, Texture2DSettings::S_T_REPEAT_MIN_MAG_NEAREST, &placeholderColor[0]);
+    m_textures2D[key] = texture;
+
+    if (m_pendingTextureCount == 0)
+    {
+        m_loadTimer.start();
+        m_decodeTimeInMicroseconds = 0;
+        m_uploadTimeInMicroseconds = 0;
+    }
+
+    ++m_pendingTextureCount;
+
+    // The job owns the request - the texture stays alive even if the caller drops its reference
+    auto request = std::make_shared<PendingTexture2D>();
+    request->texture = texture;
+    request->path = ASSET_ROOT_FOLDER + path;
+    request->settings = settings;
+
+    auto decodeJob = [request]()
+    {
+        Timer timer;
+        request->image = Texture2D::decode(request->path);
+        timer.tick();
+        m_decodeTimeInMicroseconds += timer.deltaTimeInMicroseconds();
+
+        std::lock_guard<std::mutex> lock(m_decodedTexturesMutex);
+        m_decodedTextures.push_back(request);
+    };
+
+    if (m_threadPool)
+        m_threadPool->submit(decodeJob);
+    else
+        decodeJob();
+
+    return texture;
+}
+
+void ResourceManager::update()
+{
+    PROFILE_ZONE("Texture Upload");
+
+    Timer timer;
+    bool uploaded = false;
+
+    while (m_pendingTextureCount > 0)
+    {
+        timer.tick();
+        if (uploaded && timer.totalTime() * 1000.0f >= m_uploadBudgetInMilliseconds)
+            break;
+
+        std::shared_ptr<PendingTexture2D> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_decodedTexturesMutex);
+
+            if (m_decodedTextures.empty())
+                break;
+
+            pending = std::move(m_decodedTextures.front());
+            m_decodedTextures.pop_front();
+        }
+
+        if (pending->image.isValid())
+            pending->texture->upload(pending->image, pending->settings);
+        else
+            LOG("Failed to load: " + pending->path);
+
+        --m_pendingTextureCount;
+        uploaded = true;
+    }
+
+    timer.tick();
+    m_uploadTimeInMicroseconds += timer.totalTimeInMicroseconds();
+
+    if (uploaded)
+    {
+        QueryManager::setCounter("Asset Loading: Textures Pending", m_pendingTextureCount);
+        QueryManager::setCounter("Asset Loading: Decode Time (ms, all workers)", m_decodeTimeInMicroseconds / 1000);
+        QueryManager::setCounter("Asset Loading: Upload Time (ms)", m_uploadTimeInMicroseconds / 1000);
+
+        if (m_pendingTextureCount == 0)
+        {
+            m_loadTimer.tick();
+            QueryManager::setCounter("Asset Loading: Wall Time (ms)", m_loadTimer.totalTimeInMilliseconds());
+        }
+    }
+}
+
 void ResourceManager::setTextures(const std::string& textureName, const std::string& baseTexturePath,
     const std::vector<std::string>& texturePaths, Material* material, Texture2DSettings settings)
 {
@@ -85,7 +192,28 @@ std::shared_ptr<Model> ResourceManager::getModel(const std::string& path)
     if (it != m_models.end())
         return it->second;
 
-    auto model = AssetImporter::import(ASSET_ROOT_FOLDER + path);
+    Timer timer;
+    std::string sourcePath = ASSET_ROOT_FOLDER + path;
+    std::string cachePath = MeshCache::getCachePath(sourcePath);
+    auto model = MeshCache::read(cachePath, sourcePath);
+
+    // Import with Assimp if the cache is missing or stale
+    if (!model)
+    {
+        model = AssetImporter::import(sourcePath, m_threadPool);
+
+        // The sub meshes of the cached model are uploaded from the mapping like on later starts - the imported model is the fallback
+        if (model && MeshCache::write(cachePath, sourcePath, *model))
+        {
+            auto cachedModel = MeshCache::read(cachePath, sourcePath);
+            if (cachedModel)
+                model = cachedModel;
+        }
+    }
+
+    timer.tick();
+    QueryManager::setCounter("Asset Loading: Mesh Import Time (ms)", timer.deltaTimeInMilliseconds());
+
     m_models[path] = model;
 
     return model;
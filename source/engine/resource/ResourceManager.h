@@ -2,11 +2,17 @@
 #include <engine/rendering/Texture2D.h>
 #include <memory>
 #include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <atomic>
 #include "Model.h"
 #include <engine/rendering/shader/Shader.h>
 #include <engine/rendering/renderer/MeshRenderer.h>
+#include <engine/util/Timer.h>
+#include <glm/gtc/type_precision.hpp>
 
 class Material;
+class ThreadPool;
 
 struct Texture2DKey
 {
@@ -67,6 +73,28 @@ class ResourceManager
 public:
     static std::shared_ptr<Texture2D> getTexture(const std::string& path, Texture2DSettings settings = Texture2DSettings::S_T_REPEAT_MIN_MAG_LINEAR);
 
+    /**
+    * Returns a valid 1x1 placeholder texture with the given color immediately. The image is decoded on a worker
+    * thread and uploaded into the same texture in a later update(). The texture stays the placeholder if loading fails.
+    */
+    static std::shared_ptr<Texture2D> getTextureAsync(const std::string& path, Texture2DSettings settings = Texture2DSettings::S_T_REPEAT_MIN_MAG_LINEAR,
+                                                      const glm::u8vec4& placeholderColor = glm::u8vec4(255));
+
+    /**
+    * Uploads decoded textures on the render thread. Stops when the upload budget of the frame is used up
+    * but uploads at least one texture per call.
+    */
+    static void update();
+
+    static void setUploadBudget(float milliseconds) { m_uploadBudgetInMilliseconds = milliseconds; }
+
+    static bool isLoading() { return m_pendingTextureCount > 0; }
+
+    /**
+    * The pool is used to decode textures and to import meshes. Everything is loaded on the calling thread if no pool is set.
+    */
+    static void setThreadPool(ThreadPool* threadPool) { m_threadPool = threadPool; }
+
     // Just a convenience function for ease of development
     static std::shared_ptr<MeshRenderer> getMeshRenderer(const std::string& path, std::shared_ptr<Shader> shader, const std::string& baseTexturePath);
 
@@ -79,6 +107,14 @@ public:
     static void setShaderIncludePath(const std::string& path);
     static const std::string& getIncludeSource(const std::string& includePath);
 private:
+    struct PendingTexture2D
+    {
+        std::shared_ptr<Texture2D> texture;
+        std::string path;
+        Texture2DSettings settings;
+        Texture2DImage image;
+    };
+
     static void setTextures(const std::string& textureName, const std::string& baseTexturePath,
         const std::vector<std::string>& texturePaths, Material* material, Texture2DSettings settings);
 
@@ -88,6 +124,16 @@ private:
     static std::unordered_map<std::string, std::shared_ptr<Model>> m_models;
     static std::unordered_map<ShaderKey, std::shared_ptr<Shader>> m_shaders;
 
+    static ThreadPool* m_threadPool;
+
+    // Async loading: Workers push decoded textures, update() uploads them
+    static std::mutex m_decodedTexturesMutex;
+    static std::deque<std::shared_ptr<PendingTexture2D>> m_decodedTextures;
+    static std::size_t m_pendingTextureCount;
+    static std::atomic<uint64_t> m_decodeTimeInMicroseconds;
+    static uint64_t m_uploadTimeInMicroseconds;
+    static float m_uploadBudgetInMilliseconds;
+    static Timer m_loadTimer;
 
     static std::unordered_map<std::string, std::string> m_shaderIncludes;
 };
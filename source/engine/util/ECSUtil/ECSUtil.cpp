@@ -8,14 +8,18 @@
 #include "engine/rendering/lights/DirectionalLight.h"
 #include "engine/rendering/voxelConeTracing/Globals.h"
 #include "engine/rendering/util/GLUtil.h"
+#include <engine/memory/FrameArena.h>
 #include <cstddef>
 
+/**
+* The textures are loaded asynchronously - the material uses the placeholder color until they are uploaded.
+*/
 void setTextures(const std::string& textureName, const std::string& baseTexturePath,
-                 const std::vector<std::string>& texturePaths, Material* material, Texture2DSettings settings)
+                 const std::vector<std::string>& texturePaths, Material* material, Texture2DSettings settings, const glm::u8vec4& placeholderColor)
 {
     for (std::size_t i = 0; i < texturePaths.size(); ++i)
     {
-        auto texture = ResourceManager::getTexture(baseTexturePath + texturePaths[i], settings);
+        auto texture = ResourceManager::getTextureAsync(baseTexturePath + texturePaths[i], settings, placeholderColor);
 
         if (texture->isValid())
             material->setTexture2D(textureName + std::to_string(i), *texture);
@@ -31,9 +35,17 @@ ComponentPtr<Transform> ECSUtil::loadMeshEntities(Model* model, std::shared_ptr<
     Entity entity = ECS::createEntity(model->name);
     entity.addComponent<Transform>();
     auto transform = entity.getComponent<Transform>();
-    transform->setLocalPosition(model->position);
     transform->setLocalRotation(model->rotation);
-    transform->setLocalScale(model->scale);
+
+    // The vertices are left as loaded - the scale is applied to the root and inherited by the children
+    transform->setLocalScale(model->scale * scale);
+
+    // The vertices are relative to the center of the model (see Model::recenter()). When a whole scene is loaded objects in the scene
+    // can have an inconvenient transform - deriving the position places the pivot at the center to fix this problem
+    if (useDerivedPos)
+        transform->setLocalPosition(scale * model->center);
+    else
+        transform->setLocalPosition(model->position + model->rotation * (model->scale * scale * model->center));
 
     if (parent)
         transform->setParent(parent);
@@ -44,7 +56,7 @@ ComponentPtr<Transform> ECSUtil::loadMeshEntities(Model* model, std::shared_ptr<
 
         auto mesh = std::make_shared<Mesh>();
 
-        // Fill sub meshes to make them compatible with all shaders
+        // Fill sub meshes to make them compatible with all shaders - cached sub meshes already store these attributes
         for (auto& subMesh : model->subMeshes)
         {
             subMesh.tangents.resize(subMesh.vertices.size());
@@ -53,16 +65,6 @@ ComponentPtr<Transform> ECSUtil::loadMeshEntities(Model* model, std::shared_ptr<
         }
 
         mesh->setSubMeshes(model->subMeshes);
-        mesh->scale(scale);
-
-        // When a whole scene is loaded objects in the scene can have an inconvenient transform - deriving the position attempts to fix this problem
-        if (useDerivedPos)
-        {
-            auto center = mesh->computeCenter();
-            mesh->translate(-center);
-            transform->setLocalPosition(center);
-        }
-
         mesh->finalize();
 
         transform->setBBox(util::computeBBox(*mesh.get()));
@@ -83,11 +85,11 @@ ComponentPtr<Transform> ECSUtil::loadMeshEntities(Model* model, std::shared_ptr<
             material->setColor("u_emissionColor", glm::vec3(0.0f));
             material->setColor("u_specularColor", materialDesc.specularColor);
 
-            setTextures("u_diffuseTexture", baseTexturePath, materialDesc.diffuseTextures, material.get(), Texture2DSettings::S_T_REPEAT_ANISOTROPIC);
-            setTextures("u_normalMap", baseTexturePath, materialDesc.normalTextures, material.get(), Texture2DSettings::S_T_REPEAT_ANISOTROPIC);
-            setTextures("u_specularMap", baseTexturePath, materialDesc.specularTextures, material.get(), Texture2DSettings::S_T_REPEAT_MIN_MIPMAP_LINEAR_MAG_LINEAR);
-            setTextures("u_emissionMap", baseTexturePath, materialDesc.emissionTextures, material.get(), Texture2DSettings::S_T_REPEAT_ANISOTROPIC);
-            setTextures("u_opacityMap", baseTexturePath, materialDesc.opacityTextures, material.get(), Texture2DSettings::S_T_REPEAT_MIN_MAG_NEAREST);
+            setTextures("u_diffuseTexture", baseTexturePath, materialDesc.diffuseTextures, material.get(), Texture2DSettings::S_T_REPEAT_ANISOTROPIC, glm::u8vec4(255));
+            setTextures("u_normalMap", baseTexturePath, materialDesc.normalTextures, material.get(), Texture2DSettings::S_T_REPEAT_ANISOTROPIC, glm::u8vec4(128, 128, 255, 255));
+            setTextures("u_specularMap", baseTexturePath, materialDesc.specularTextures, material.get(), Texture2DSettings::S_T_REPEAT_MIN_MIPMAP_LINEAR_MAG_LINEAR, glm::u8vec4(0, 0, 0, 255));
+            setTextures("u_emissionMap", baseTexturePath, materialDesc.emissionTextures, material.get(), Texture2DSettings::S_T_REPEAT_ANISOTROPIC, glm::u8vec4(0, 0, 0, 255));
+            setTextures("u_opacityMap", baseTexturePath, materialDesc.opacityTextures, material.get(), Texture2DSettings::S_T_REPEAT_MIN_MAG_NEAREST, glm::u8vec4(255));
 
             meshRenderer->addMaterial(material);
         }
@@ -95,7 +97,7 @@ ComponentPtr<Transform> ECSUtil::loadMeshEntities(Model* model, std::shared_ptr<
 
     for (auto& child : model->children)
     {
-        loadMeshEntities(child.get(), shader, baseTexturePath, scale, useDerivedPos, transform);
+        loadMeshEntities(child.get(), shader, baseTexturePath, glm::vec3(1.0f), useDerivedPos, transform);
     }
 
     return transform;
@@ -125,17 +127,23 @@ void ECSUtil::renderEntities(const std::vector<Entity>& entities, Shader* shader
 
 void ECSUtil::renderEntity(Entity entity, Shader* shader)
 {
-    auto transform = entity.getComponent<Transform>();
     auto renderer = entity.getComponent<MeshRenderer>();
-    assert(transform && renderer);
+    assert(renderer);
+
+    setEntityUniforms(entity, shader);
+    renderer->render(shader);
+}
+
+void ECSUtil::setEntityUniforms(Entity entity, Shader* shader)
+{
+    auto transform = entity.getComponent<Transform>();
+    assert(transform);
 
     shader->setMatrix("u_model", transform->getLocalToWorldMatrix());
     shader->setMatrix("u_modelIT", glm::transpose(glm::inverse(transform->getLocalToWorldMatrix())));
 
     shader->setUnsignedInt("u_entityID", entity.getID());
     shader->setUnsignedInt("u_entityVersion", entity.getVersion());
-
-    renderer->render(shader);
 }
 
 void ECSUtil::renderEntitiesInAABB(const BBox& bbox, Shader* shader)
@@ -152,6 +160,15 @@ void ECSUtil::renderEntitiesInAABB(const BBox& bbox, Shader* shader)
 void ECSUtil::setDirectionalLightUniforms(Shader* shader, GLint shadowMapStartTextureUnit, float pcfRadius)
 {
     assert(GL::isShaderBound(shader->getProgram()));
+    static_assert(MAX_DIR_LIGHT_COUNT <= 10, "The light index has to be a single digit.");
+
+    // The uniform names are built in the frame arena - this is called by several passes every frame
+    auto location = [shader](const FrameString& structName, const char* member)
+    {
+        FrameString uniformName(structName);
+        uniformName += member;
+        return shader->getLocation(uniformName.c_str());
+    };
 
     int lightCount = 0;
     for (auto dirLight : ECS::getEntitiesWithComponents<DirectionalLight, Transform>())
@@ -161,27 +178,34 @@ void ECSUtil::setDirectionalLightUniforms(Shader* shader, GLint shadowMapStartTe
 
         auto dirLightComponent = dirLight.getComponent<DirectionalLight>();
         auto lightTransform = dirLight.getComponent<Transform>();
-        std::string arrayIdxStr = "[" + std::to_string(lightCount) + "]";
-        std::string dirLightUniformName = "u_directionalLights" + arrayIdxStr;
-        std::string shadowUniformName = "u_directionalLightShadowDescs" + arrayIdxStr;
+        FrameString arrayIdxStr("[");
+        arrayIdxStr += char('0' + lightCount);
+        arrayIdxStr += "]";
+        FrameString dirLightUniformName = "u_directionalLights" + arrayIdxStr;
+        FrameString shadowUniformName = "u_directionalLightShadowDescs" + arrayIdxStr;
 
-        shader->setVector(dirLightUniformName + ".direction", lightTransform->getForward());
-        shader->setVector(dirLightUniformName + ".color", dirLightComponent->color);
-        shader->setFloat(dirLightUniformName + ".intensity", dirLightComponent->intensity);
+        glm::vec3 direction = lightTransform->getForward();
+        glUniform3fv(location(dirLightUniformName, ".direction"), 1, &direction[0]);
+        glUniform3fv(location(dirLightUniformName, ".color"), 1, &dirLightComponent->color[0]);
+        glUniform1f(location(dirLightUniformName, ".intensity"), dirLightComponent->intensity);
 
-        shader->setInt(shadowUniformName + ".enabled", dirLightComponent->shadowsEnabled ? 1 : 0);
+        glUniform1i(location(shadowUniformName, ".enabled"), dirLightComponent->shadowsEnabled ? 1 : 0);
 
         if (dirLightComponent->shadowsEnabled)
         {
-            shader->setMatrix(shadowUniformName + ".view", dirLightComponent->view);
-            shader->setMatrix(shadowUniformName + ".proj", dirLightComponent->proj);
-            shader->setFloat(shadowUniformName + ".zNear", dirLightComponent->zNear);
-            shader->setFloat(shadowUniformName + ".zFar", dirLightComponent->zFar);
+            glUniformMatrix4fv(location(shadowUniformName, ".view"), 1, GL_FALSE, &dirLightComponent->view[0][0]);
+            glUniformMatrix4fv(location(shadowUniformName, ".proj"), 1, GL_FALSE, &dirLightComponent->proj[0][0]);
+            glUniform1f(location(shadowUniformName, ".zNear"), dirLightComponent->zNear);
+            glUniform1f(location(shadowUniformName, ".zFar"), dirLightComponent->zFar);
             if (pcfRadius < 0.0f)
                 pcfRadius = dirLightComponent->pcfRadius;
 
-            shader->setFloat(shadowUniformName + ".pcfRadius", pcfRadius);
-            shader->bindTexture2D(dirLightComponent->shadowMap, "u_shadowMaps" + arrayIdxStr, shadowMapStartTextureUnit + lightCount);
+            glUniform1f(location(shadowUniformName, ".pcfRadius"), pcfRadius);
+
+            GLint textureUnit = shadowMapStartTextureUnit + lightCount;
+            glActiveTexture(GL_TEXTURE0 + textureUnit);
+            glBindTexture(GL_TEXTURE_2D, dirLightComponent->shadowMap);
+            glUniform1i(location("u_shadowMaps", arrayIdxStr.c_str()), textureUnit);
         }
 
         ++lightCount;
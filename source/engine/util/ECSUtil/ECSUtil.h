@@ -19,6 +19,11 @@ public:
 
     static void renderEntity(Entity entity, Shader* shader);
 
+    /**
+    * Sets the model matrices and the entity id uniforms.
+    */
+    static void setEntityUniforms(Entity entity, Shader* shader);
+
     static void renderEntitiesInAABB(const BBox& bbox, Shader* shader);
 
     template<class... Components>
@@ -1,25 +1,21 @@
 #pragma once
-#include <memory>
-#include <engine/rendering/Framebuffer.h>
-#include <engine/rendering/shader/Shader.h>
-#include "engine/input/Input.h"
 
 class Entity;
+class SceneBVH;
 
-class EntityPicker : public InputHandler
+/**
+* Picks the entity under a screen point by casting a ray from the main camera into the SceneBVH.
+*/
+class EntityPicker
 {
 public:
-    EntityPicker();
+    explicit EntityPicker(SceneBVH& sceneBVH);
 
-    void update() const;
+    /**
+    * Screen coordinates have (0, 0) in the lower left corner. Returns an invalid entity if no mesh was hit.
+    */
     Entity pick(int screenX, int screenY) const;
 
-protected:
-    void onWindowEvent(const SDL_WindowEvent& windowEvent) override;
-
 private:
-    std::unique_ptr<Framebuffer> m_framebuffer;
-    std::shared_ptr<Shader> m_shader;
-
-    std::shared_ptr<Texture2D> m_texture;
+    SceneBVH* m_sceneBVH;
 };
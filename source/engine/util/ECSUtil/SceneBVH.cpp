@@ -0,0 +1,224 @@
+#include "SceneBVH.h"
+#include <engine/ecs/ECS.h>
+#include <engine/camera/CameraComponent.h>
+#include <engine/rendering/renderer/MeshRenderer.h>
+#include <engine/rendering/voxelConeTracing/VoxelRegion.h>
+
+namespace
+{
+    // The BVH is rebuilt if refitting grew the surface area of the root by this factor
+    const float REBUILD_AREA_FACTOR = 2.0f;
+}
+
+void SceneBVH::update()
+{
+    bool entitiesChanged = false;
+    std::size_t entityCount = 0;
+    bool transformChanged = false;
+
+    for (Entity e : ECS::getEntitiesWithComponents<Transform, MeshRenderer>())
+    {
+        if (entityCount >= m_entities.size() || !(m_entities[entityCount] == e))
+            entitiesChanged = true;
+
+        ++entityCount;
+    }
+
+    entitiesChanged = entitiesChanged || entityCount != m_entities.size();
+
+    if (entitiesChanged)
+    {
+        m_entities.clear();
+        m_entities.reserve(entityCount);
+        for (Entity e : ECS::getEntitiesWithComponents<Transform, MeshRenderer>())
+        {
+            m_entities.push_back(e);
+            refitChangedMesh(e);
+        }
+
+        rebuild();
+        return;
+    }
+
+    for (std::size_t i = 0; i < m_entities.size(); ++i)
+    {
+        auto transform = m_entities[i].getComponent<Transform>();
+
+        if (transform->hasChangedSinceLastFrame())
+        {
+            m_bboxes[i] = transform->getBBox();
+            refitChangedMesh(m_entities[i]);
+            transformChanged = true;
+        }
+    }
+
+    if (!transformChanged)
+        return;
+
+    m_bvh.refit(m_bboxes);
+
+    if (m_bvh.getBBox().surfaceArea() > REBUILD_AREA_FACTOR * m_builtRootArea)
+        rebuild();
+}
+
+bool SceneBVH::raycast(const Ray& ray, RaycastHit& hit, float tMax)
+{
+    SubMeshIndex closestSubMeshIdx = 0;
+    uint32_t closestTriangleIdx = 0;
+
+    auto intersectEntity = [this, &ray, &closestSubMeshIdx, &closestTriangleIdx](uint32_t idx, float maxT, float& tHit)
+    {
+        auto transform = m_entities[idx].getComponent<Transform>();
+        auto mesh = m_entities[idx].getComponent<MeshRenderer>()->getMesh();
+
+        if (!mesh)
+            return false;
+
+        // The direction is not normalized to keep the ray parameter of the world ray
+        const glm::mat4& worldToLocal = transform->getWorldToLocalMatrix();
+        Ray localRay(glm::vec3(worldToLocal * glm::vec4(ray.origin, 1.0f)), glm::mat3(worldToLocal) * ray.direction);
+
+        MeshBVHs& meshBVHs = getMeshBVHs(mesh);
+        bool hitEntity = false;
+        tHit = maxT;
+
+        for (std::size_t i = 0; i < meshBVHs.subMeshBVHs.size(); ++i)
+        {
+            uint32_t triangleIdx;
+            float t;
+            glm::vec2 uv;
+
+            if (meshBVHs.subMeshBVHs[i].raycast(localRay, tHit, triangleIdx, t, uv))
+            {
+                tHit = t;
+                closestSubMeshIdx = SubMeshIndex(i);
+                closestTriangleIdx = triangleIdx;
+                hitEntity = true;
+            }
+        }
+
+        return hitEntity;
+    };
+
+    uint32_t entityIdx;
+    float t;
+    if (!m_bvh.raycast(ray, tMax, intersectEntity, entityIdx, t))
+        return false;
+
+    // The normal is transformed with the inverse transpose of the local to world matrix
+    auto transform = m_entities[entityIdx].getComponent<Transform>();
+    auto& meshBVHs = getMeshBVHs(m_entities[entityIdx].getComponent<MeshRenderer>()->getMesh());
+    glm::vec3 localNormal = meshBVHs.subMeshBVHs[closestSubMeshIdx].computeNormal(closestTriangleIdx);
+
+    hit.entity = m_entities[entityIdx];
+    hit.subMeshIdx = closestSubMeshIdx;
+    hit.triangleIdx = closestTriangleIdx;
+    hit.t = t;
+    hit.point = ray.origin + t * ray.direction;
+    hit.normal = glm::normalize(glm::transpose(glm::mat3(transform->getWorldToLocalMatrix())) * localNormal);
+
+    return true;
+}
+
+std::vector<Entity> SceneBVH::getEntitiesInAABB(const BBox& bbox) const
+{
+    std::vector<Entity> entities;
+    m_bvh.query(bbox, [this, &entities](uint32_t idx) { entities.push_back(m_entities[idx]); });
+    return entities;
+}
+
+std::vector<Entity> SceneBVH::getEntitiesInFrustum(const Frustum& frustum) const
+{
+    glm::vec4 planes[6];
+    frustum.getPlanes(planes);
+
+    std::vector<Entity> entities;
+    m_bvh.query(planes, 6, [this, &entities](uint32_t idx) { entities.push_back(m_entities[idx]); });
+    return entities;
+}
+
+std::vector<Entity> SceneBVH::getEntitiesInRegion(const VoxelRegion& region) const
+{
+    return getEntitiesInAABB(BBox(region.getMinPosWorld(), region.getMaxPosWorld()));
+}
+
+void SceneBVH::refitMesh(const std::shared_ptr<Mesh>& mesh)
+{
+    auto it = m_meshBVHs.find(mesh.get());
+    if (it == m_meshBVHs.end())
+        return;
+
+    auto& subMeshes = mesh->getSubMeshes();
+    auto& subMeshBVHs = it->second.subMeshBVHs;
+    it->second.meshVersion = mesh->getVersion();
+
+    // Topology changes require a rebuild
+    if (subMeshes.size() != subMeshBVHs.size())
+    {
+        m_meshBVHs.erase(it);
+        return;
+    }
+
+    Vertices positions;
+    Indices indices;
+    for (std::size_t i = 0; i < subMeshes.size(); ++i)
+    {
+        if (subMeshes[i].getIndexCount() / 3 == subMeshBVHs[i].getTriangleCount())
+            subMeshBVHs[i].refit(subMeshes[i].getPositions(positions), subMeshes[i].getIndices(indices));
+        else
+            subMeshBVHs[i].build(subMeshes[i].getPositions(positions), subMeshes[i].getIndices(indices));
+    }
+}
+
+void SceneBVH::refitChangedMesh(Entity entity)
+{
+    auto mesh = entity.getComponent<MeshRenderer>()->getMesh();
+    if (!mesh)
+        return;
+
+    // Triangle BVHs that weren't built yet are built from the current version on demand
+    auto it = m_meshBVHs.find(mesh.get());
+    if (it != m_meshBVHs.end() && !it->second.mesh.expired() && it->second.meshVersion != mesh->getVersion())
+        refitMesh(mesh);
+}
+
+void SceneBVH::rebuild()
+{
+    m_bboxes.resize(m_entities.size());
+    for (std::size_t i = 0; i < m_entities.size(); ++i)
+        m_bboxes[i] = m_entities[i].getComponent<Transform>()->getBBox();
+
+    m_bvh.build(m_bboxes, 1);
+    m_builtRootArea = m_bvh.empty() ? 0.0f : m_bvh.getBBox().surfaceArea();
+
+    // Remove the triangle BVHs of destroyed meshes
+    for (auto it = m_meshBVHs.begin(); it != m_meshBVHs.end();)
+    {
+        if (it->second.mesh.expired())
+            it = m_meshBVHs.erase(it);
+        else
+            ++it;
+    }
+}
+
+SceneBVH::MeshBVHs& SceneBVH::getMeshBVHs(const std::shared_ptr<Mesh>& mesh)
+{
+    auto it = m_meshBVHs.find(mesh.get());
+
+    // A new mesh can have the address of a destroyed one
+    if (it != m_meshBVHs.end() && !it->second.mesh.expired())
+        return it->second;
+
+    MeshBVHs& meshBVHs = m_meshBVHs[mesh.get()];
+    meshBVHs.mesh = mesh;
+    meshBVHs.meshVersion = mesh->getVersion();
+    meshBVHs.subMeshBVHs.clear();
+
+    // Interleaved sub meshes (e.g. from the mesh cache) are copied into temporary vectors
+    Vertices positions;
+    Indices indices;
+    for (auto& subMesh : mesh->getSubMeshes())
+        meshBVHs.subMeshBVHs.emplace_back(subMesh.getPositions(positions), subMesh.getIndices(indices));
+
+    return meshBVHs;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cfloat>
+#include <engine/ecs/EntityManager.h>
+#include <engine/geometry/BVH.h>
+#include <engine/geometry/TriangleBVH.h>
+#include <engine/rendering/geometry/Mesh.h>
+
+struct Frustum;
+struct VoxelRegion;
+
+struct RaycastHit
+{
+    Entity entity;
+    SubMeshIndex subMeshIdx{0};
+    uint32_t triangleIdx{0};
+    float t{0.0f}; // Ray parameter of the hit: point = origin + t * direction
+    glm::vec3 point;
+    glm::vec3 normal;
+};
+
+/**
+* BVH over the world bounding boxes of all entities with a Transform and a MeshRenderer.
+* Ray casts are refined with triangle BVHs which are built on demand in object space and
+* shared by all entities that use the same mesh. Moving an entity thus only refits the entity BVH.
+* The triangle BVHs of a moved entity are refitted as well if its mesh was finalized again (see Mesh::getVersion()).
+*/
+class SceneBVH
+{
+public:
+    /**
+    * Rebuilds the BVH if entities were added or removed - otherwise refits it if a transform changed.
+    * The triangle BVHs of the changed entities are refitted if the vertices of their meshes changed.
+    * Has to be called before ECS::lateUpdate() because changes are detected with Transform::hasChangedSinceLastFrame().
+    */
+    void update();
+
+    /**
+    * Finds the closest mesh triangle hit by the ray in [0, tMax].
+    */
+    bool raycast(const Ray& ray, RaycastHit& hit, float tMax = FLT_MAX);
+
+    std::vector<Entity> getEntitiesInAABB(const BBox& bbox) const;
+
+    std::vector<Entity> getEntitiesInFrustum(const Frustum& frustum) const;
+
+    std::vector<Entity> getEntitiesInRegion(const VoxelRegion& region) const;
+
+    /**
+    * Batched query of the entities that overlap the bboxes and pass filter(Entity). The filter is called once per entity.
+    * See BVH::BatchQueryResult for the layout of the result - the primitives are converted with getEntity().
+    */
+    template <class TFilter>
+    void getEntitiesInAABBs(const std::vector<BBox>& bboxes, TFilter filter, BVH::BatchQueryResult& result) const;
+
+    /**
+    * Returns the entity of a primitive of the BVH.
+    */
+    Entity getEntity(uint32_t primitiveIdx) const { return m_entities[primitiveIdx]; }
+
+    /**
+    * Refits the triangle BVHs of the mesh. Call this after the vertices of the mesh changed.
+    */
+    void refitMesh(const std::shared_ptr<Mesh>& mesh);
+
+    const BVH& getBVH() const { return m_bvh; }
+
+private:
+    struct MeshBVHs
+    {
+        std::weak_ptr<Mesh> mesh;
+        uint32_t meshVersion{0};
+        std::vector<TriangleBVH> subMeshBVHs;
+    };
+
+    void rebuild();
+
+    /**
+    * Refits the triangle BVHs of the mesh of the entity if they were built from an older version of the mesh.
+    */
+    void refitChangedMesh(Entity entity);
+
+    MeshBVHs& getMeshBVHs(const std::shared_ptr<Mesh>& mesh);
+
+private:
+    BVH m_bvh;
+    std::vector<Entity> m_entities;
+    std::vector<BBox> m_bboxes;
+
+    // Refitting increases the surface area of the nodes - the BVH is rebuilt if the root area grows too much
+    float m_builtRootArea{0.0f};
+
+    std::unordered_map<const Mesh*, MeshBVHs> m_meshBVHs;
+};
+
+template <class TFilter>
+void SceneBVH::getEntitiesInAABBs(const std::vector<BBox>& bboxes, TFilter filter, BVH::BatchQueryResult& result) const
+{
+    m_bvh.query(bboxes, [this, &filter](uint32_t idx) { return filter(m_entities[idx]); }, result);
+}
@@ -0,0 +1,27 @@
+#include "GLProfilerGPUBackend.h"
+#include <cassert>
+
+void GLProfilerGPUBackend::recordTimestamp(uint32_t bufferIdx, uint32_t timestampIdx)
+{
+    auto& queryObjects = m_queryObjects[bufferIdx];
+    while (timestampIdx >= queryObjects.size())
+        queryObjects.push_back(std::make_unique<GLQueryObject>());
+
+    queryObjects[timestampIdx]->queryCounter(GL_TIMESTAMP);
+}
+
+uint64_t GLProfilerGPUBackend::getTimestampInNanoseconds(uint32_t bufferIdx, uint32_t timestampIdx)
+{
+    assert(timestampIdx < m_queryObjects[bufferIdx].size());
+
+    // Blocks if the GPU hasn't reached the timestamp yet
+    return uint64_t(m_queryObjects[bufferIdx][timestampIdx]->getUInt64(GL_QUERY_RESULT));
+}
+
+uint64_t GLProfilerGPUBackend::getCurrentTimeInNanoseconds()
+{
+    GLint64 timestamp = 0;
+    glGetInteger64v(GL_TIMESTAMP, &timestamp);
+
+    return uint64_t(timestamp);
+}
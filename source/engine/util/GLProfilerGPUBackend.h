@@ -0,0 +1,19 @@
+#pragma once
+#include "Profiler.h"
+#include "GLQueryObject.h"
+#include <vector>
+#include <memory>
+
+/**
+* Records the timestamps of the GPU zones with GL_TIMESTAMP query objects. Unlike GL_TIME_ELAPSED queries they can be nested.
+*/
+class GLProfilerGPUBackend : public ProfilerGPUBackend
+{
+public:
+    void recordTimestamp(uint32_t bufferIdx, uint32_t timestampIdx) override;
+    uint64_t getTimestampInNanoseconds(uint32_t bufferIdx, uint32_t timestampIdx) override;
+    uint64_t getCurrentTimeInNanoseconds() override;
+
+private:
+    std::vector<std::unique_ptr<GLQueryObject>> m_queryObjects[PROFILER_GPU_LATENCY];
+};
@@ -21,6 +21,12 @@ void GLQueryObject::end() const
     glEndQuery(m_curTarget);
 }
 
+void GLQueryObject::queryCounter(GLenum target)
+{
+    m_curTarget = target;
+    glQueryCounter(m_id, target);
+}
+
 GLint64 GLQueryObject::getInt64(GLenum pname) const
 {
     GLint64 result = 0;
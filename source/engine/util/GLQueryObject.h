@@ -13,6 +13,11 @@ public:
     void begin(GLenum target);
     void end() const;
 
+    /**
+     * Records the GPU time once all previous commands are done - target has to be GL_TIMESTAMP
+     */
+    void queryCounter(GLenum target = GL_TIMESTAMP);
+
     GLint64 getInt64(GLenum pname = GL_QUERY_RESULT) const;
     GLuint64 getUInt64(GLenum pname = GL_QUERY_RESULT) const;
 
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cassert>
+
+/**
+* Bounded lock-free queue for multiple producers and a single consumer.
+* Every slot carries a sequence number that tells whether it's free for the producer of a position or
+* filled for the consumer (Dmitry Vyukov's bounded queue). Producers only contend on the tail position.
+*/
+template <class T>
+class MPSCQueue
+{
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+public:
+    /**
+    * The capacity has to be a power of 2.
+    */
+    explicit MPSCQueue(std::size_t capacity);
+    ~MPSCQueue();
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    /**
+    * Thread-safe. Returns false without constructing the element if the queue is full.
+    */
+    template <class... Args>
+    bool tryPush(Args&&... args);
+
+    /**
+    * Calls func with the oldest element and removes it. Only the consumer thread may call this.
+    * Returns false if the queue is empty.
+    */
+    template <class Func>
+    bool tryConsume(Func&& func);
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+private:
+    std::unique_ptr<Slot[]> m_slots;
+    const std::size_t m_mask;
+
+    // Producers and the consumer write different cache lines
+    char m_padding0[64];
+    std::atomic<std::size_t> m_tail{0};
+    char m_padding1[64];
+    std::size_t m_head{0};
+};
+
+template <class T>
+MPSCQueue<T>::MPSCQueue(std::size_t capacity)
+    : m_slots(new Slot[capacity]), m_mask(capacity - 1)
+{
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+    for (std::size_t i = 0; i < capacity; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <class T>
+MPSCQueue<T>::~MPSCQueue()
+{
+    while (tryConsume([](T&) { })) { }
+}
+
+template <class T>
+template <class... Args>
+bool MPSCQueue<T>::tryPush(Args&&... args)
+{
+    std::size_t pos = m_tail.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;)
+    {
+        slot = &m_slots[pos & m_mask];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+        if (diff == 0)
+        {
+            // The slot is free - claim the position
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // The consumer hasn't freed the slot of the last round yet
+            return false;
+        }
+        else
+        {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    new(&slot->storage) T(std::forward<Args>(args)...);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <class T>
+template <class Func>
+bool MPSCQueue<T>::tryConsume(Func&& func)
+{
+    Slot& slot = m_slots[m_head & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_head + 1)
+        return false;
+
+    T* element = reinterpret_cast<T*>(&slot.storage);
+    func(*element);
+    element->~T();
+
+    // Free the slot for the producer of the next round
+    slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+    ++m_head;
+
+    return true;
+}
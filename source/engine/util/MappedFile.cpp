@@ -0,0 +1,96 @@
+#include "MappedFile.h"
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32)
+#include <Windows.h>
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The mapping keeps the file open
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (!mapping)
+        return false;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = std::size_t(fileSize.QuadPart);
+    m_mapping = mapping;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+}
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat buffer;
+    if (fstat(fd, &buffer) != 0 || buffer.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after closing the descriptor
+    void* data = mmap(nullptr, std::size_t(buffer.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = std::size_t(buffer.st_size);
+    m_mapping = data;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+        munmap(m_mapping, m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+* Read-only memory mapping of a whole file. The mapping is released when the object is destroyed.
+*/
+class MappedFile
+{
+public:
+    MappedFile() { }
+
+    explicit MappedFile(const std::string& path) { open(path); }
+
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+    * Returns false if the file can't be opened or is empty.
+    */
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    const uint8_t* data() const { return m_data; }
+
+    std::size_t size() const { return m_size; }
+
+private:
+    const uint8_t* m_data{nullptr};
+    std::size_t m_size{0};
+
+    // Platform handle of the mapping
+    void* m_mapping{nullptr};
+};
@@ -0,0 +1,498 @@
+#include "Profiler.h"
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <cassert>
+
+static_assert((PROFILER_THREAD_BUFFER_SIZE & (PROFILER_THREAD_BUFFER_SIZE - 1)) == 0, "The thread buffer size must be a power of 2.");
+static_assert(PROFILER_FRAME_HISTORY > PROFILER_GPU_LATENCY, "The GPU zones are added to frames that are still recorded.");
+
+thread_local ProfileThreadBuffer* Profiler::m_threadBuffer = nullptr;
+
+namespace
+{
+    const uint64_t NO_FRAME = std::numeric_limits<uint64_t>::max();
+
+    struct GPUTimestamp
+    {
+        ProfileZoneId zone;
+        uint32_t begin;
+    };
+
+    struct GPUFrame
+    {
+        uint64_t frame{NO_FRAME};
+
+        // The same point in time on the CPU and the GPU clock
+        uint64_t cpuTimeInNanoseconds{0};
+        uint64_t gpuTimeInNanoseconds{0};
+
+        std::vector<GPUTimestamp> timestamps;
+    };
+
+    struct TrackEvent
+    {
+        uint64_t timeInNanoseconds; // Since the start of the profiler
+        ProfileZoneId zone;
+        uint32_t begin;
+        uint32_t track;
+    };
+
+    struct OpenZone
+    {
+        ProfileZoneId zone;
+        uint64_t beginInNanoseconds;
+    };
+
+    struct FrameRecord
+    {
+        uint64_t frame{NO_FRAME};
+        uint64_t beginInNanoseconds{0};
+        std::vector<TrackEvent> events;
+    };
+
+    struct ProfilerState
+    {
+        ProfilerState()
+            : startInNanoseconds(Profiler::nowInNanoseconds()), startInTicks(Profiler::nowInTicks())
+        {
+            frames[0].frame = 0;
+            frames[0].beginInNanoseconds = startInNanoseconds;
+            gpuFrames[0].frame = 0;
+
+            // A first estimate of the tick rate - refined with every update
+            while (Profiler::nowInNanoseconds() - startInNanoseconds < 1000000) { }
+            calibrate();
+        }
+
+        void calibrate()
+        {
+            uint64_t elapsedTicks = Profiler::nowInTicks() - startInTicks;
+            uint64_t elapsedNanoseconds = Profiler::nowInNanoseconds() - startInNanoseconds;
+
+            if (elapsedTicks > 0)
+                nanosecondsPerTick = double(elapsedNanoseconds) / double(elapsedTicks);
+        }
+
+        uint64_t toNanoseconds(uint64_t ticks) const
+        {
+            return ticks > startInTicks ? uint64_t(double(ticks - startInTicks) * nanosecondsPerTick) : 0;
+        }
+
+        // Guards the zone names and the thread buffers
+        std::mutex mutex;
+        std::deque<std::string> zoneNames;
+        std::unordered_map<std::string, ProfileZoneId> zoneIds;
+        std::vector<std::unique_ptr<ProfileThreadBuffer>> threadBuffers;
+        uint32_t nextTrack{1}; // Track 0 is the GPU track
+        uint64_t releasedDroppedZoneCount{0};
+
+        // Only used on the main thread
+        std::vector<ProfileZoneTime> cpuZoneTimes; // Indexed by ProfileZoneId
+        std::vector<ProfileZoneTime> gpuZoneTimes;
+        std::vector<std::vector<OpenZone>> cpuOpenZones; // Indexed by track - zones of other threads can span frames
+        std::vector<OpenZone> gpuOpenZones;
+        std::unique_ptr<ProfilerGPUBackend> gpuBackend;
+        GPUFrame gpuFrames[PROFILER_GPU_LATENCY];
+        FrameRecord frames[PROFILER_FRAME_HISTORY];
+        uint64_t frame{0};
+        uint64_t startInNanoseconds;
+        uint64_t startInTicks;
+        double nanosecondsPerTick{1.0};
+    };
+
+    /**
+    * Marks the buffer of the thread as released when the thread exits.
+    */
+    struct ThreadBufferRelease
+    {
+        ~ThreadBufferRelease()
+        {
+            if (buffer)
+                buffer->released.store(true, std::memory_order_release);
+        }
+
+        ProfileThreadBuffer* buffer{nullptr};
+    };
+
+    thread_local ThreadBufferRelease threadBufferRelease;
+
+    ProfilerState& getState()
+    {
+        // Never destroyed because other threads might still record zones during the static destruction
+        static ProfilerState* state = new ProfilerState();
+        return *state;
+    }
+
+    /**
+    * Adds the time of the zone that is ended by the event. Events of zones that began before the last clearHistory() are skipped.
+    */
+    void addZoneTime(std::vector<OpenZone>& openZones, std::vector<ProfileZoneTime>& zoneTimes, ProfileZoneId zone, uint32_t begin,
+                     uint64_t timeInNanoseconds)
+    {
+        if (begin)
+        {
+            openZones.push_back({zone, timeInNanoseconds});
+        }
+        else if (!openZones.empty() && openZones.back().zone == zone)
+        {
+            zoneTimes[zone].timeInNanoseconds += timeInNanoseconds - openZones.back().beginInNanoseconds;
+            ++zoneTimes[zone].callCount;
+            openZones.pop_back();
+        }
+    }
+
+    void resolveGPUFrame(ProfilerState& state, GPUFrame& gpuFrame, uint32_t bufferIdx)
+    {
+        FrameRecord& record = state.frames[gpuFrame.frame % PROFILER_FRAME_HISTORY];
+        if (record.frame != gpuFrame.frame)
+            return;
+
+        for (std::size_t i = 0; i < gpuFrame.timestamps.size(); ++i)
+        {
+            uint64_t gpuTime = state.gpuBackend->getTimestampInNanoseconds(bufferIdx, uint32_t(i));
+            int64_t cpuTime = int64_t(gpuFrame.cpuTimeInNanoseconds) + (int64_t(gpuTime) - int64_t(gpuFrame.gpuTimeInNanoseconds));
+
+            uint64_t time = uint64_t(std::max(cpuTime - int64_t(state.startInNanoseconds), int64_t(0)));
+            record.events.push_back({time, gpuFrame.timestamps[i].zone, gpuFrame.timestamps[i].begin, Profiler::GPU_TRACK});
+            addZoneTime(state.gpuOpenZones, state.gpuZoneTimes, gpuFrame.timestamps[i].zone, gpuFrame.timestamps[i].begin, time);
+        }
+    }
+
+    void writeEscaped(std::ostream& os, const std::string& str)
+    {
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                os << '\\' << c;
+            else if (static_cast<unsigned char>(c) >= 0x20)
+                os << c;
+        }
+    }
+
+    double toMicroseconds(uint64_t nanoseconds)
+    {
+        return double(nanoseconds) / 1000.0;
+    }
+}
+
+ProfileZoneId Profiler::registerZone(const char* name)
+{
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    auto it = state.zoneIds.find(name);
+    if (it != state.zoneIds.end())
+        return it->second;
+
+    ProfileZoneId zone = ProfileZoneId(state.zoneNames.size());
+    state.zoneNames.emplace_back(name);
+    state.zoneIds.emplace(name, zone);
+
+    return zone;
+}
+
+const std::string& Profiler::getZoneName(ProfileZoneId zone)
+{
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    assert(zone < state.zoneNames.size());
+    return state.zoneNames[zone];
+}
+
+std::size_t Profiler::getZoneCount()
+{
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    return state.zoneNames.size();
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+    ProfileThreadBuffer* buffer = m_threadBuffer;
+    if (!buffer)
+        buffer = registerThread();
+
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    buffer->name = name;
+}
+
+bool Profiler::beginGPUZone(ProfileZoneId zone)
+{
+    auto& state = getState();
+    if (!state.gpuBackend)
+        return false;
+
+    uint32_t bufferIdx = uint32_t(state.frame % PROFILER_GPU_LATENCY);
+    auto& timestamps = state.gpuFrames[bufferIdx].timestamps;
+
+    timestamps.push_back({zone, 1});
+    state.gpuBackend->recordTimestamp(bufferIdx, uint32_t(timestamps.size() - 1));
+
+    return true;
+}
+
+void Profiler::endGPUZone(ProfileZoneId zone)
+{
+    auto& state = getState();
+    uint32_t bufferIdx = uint32_t(state.frame % PROFILER_GPU_LATENCY);
+    auto& timestamps = state.gpuFrames[bufferIdx].timestamps;
+
+    timestamps.push_back({zone, 0});
+    state.gpuBackend->recordTimestamp(bufferIdx, uint32_t(timestamps.size() - 1));
+}
+
+void Profiler::setGPUBackend(std::unique_ptr<ProfilerGPUBackend> backend)
+{
+    auto& state = getState();
+    state.gpuBackend = std::move(backend);
+
+    // The timestamps of the frames in flight were recorded with the previous backend
+    for (auto& gpuFrame : state.gpuFrames)
+        gpuFrame.timestamps.clear();
+
+    if (state.gpuBackend)
+    {
+        auto& gpuFrame = state.gpuFrames[state.frame % PROFILER_GPU_LATENCY];
+        gpuFrame.frame = state.frame;
+        gpuFrame.cpuTimeInNanoseconds = nowInNanoseconds();
+        gpuFrame.gpuTimeInNanoseconds = state.gpuBackend->getCurrentTimeInNanoseconds();
+    }
+}
+
+void Profiler::update()
+{
+    auto& state = getState();
+    state.calibrate();
+
+    std::size_t zoneCount = 0;
+    {
+        FrameRecord& record = state.frames[state.frame % PROFILER_FRAME_HISTORY];
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        // The zones are registered before their events are recorded
+        zoneCount = state.zoneNames.size();
+        state.cpuZoneTimes.assign(zoneCount, ProfileZoneTime());
+
+        for (auto& buffer : state.threadBuffers)
+        {
+            if (buffer->track >= state.cpuOpenZones.size())
+                state.cpuOpenZones.resize(buffer->track + 1);
+
+            auto& openZones = state.cpuOpenZones[buffer->track];
+
+            // Checked before the write index - all events of a released buffer are collected
+            bool released = buffer->released.load(std::memory_order_acquire);
+            uint64_t readIdx = buffer->readIdx.load(std::memory_order_relaxed);
+            uint64_t writeIdx = buffer->writeIdx.load(std::memory_order_acquire);
+
+            for (uint64_t i = readIdx; i < writeIdx; ++i)
+            {
+                const ProfileEvent& event = buffer->events[i & (PROFILER_THREAD_BUFFER_SIZE - 1)];
+                uint64_t time = state.toNanoseconds(event.timestampInTicks);
+                record.events.push_back({time, event.zone, event.begin, buffer->track});
+                addZoneTime(openZones, state.cpuZoneTimes, event.zone, event.begin, time);
+            }
+
+            buffer->readIdx.store(writeIdx, std::memory_order_release);
+
+            if (released)
+            {
+                state.releasedDroppedZoneCount += buffer->droppedZoneCount.load(std::memory_order_relaxed);
+                openZones.clear();
+                buffer.reset();
+            }
+        }
+
+        state.threadBuffers.erase(std::remove(state.threadBuffers.begin(), state.threadBuffers.end(), nullptr), state.threadBuffers.end());
+    }
+
+    ++state.frame;
+
+    // The GPU buffer of the new frame still holds the timestamps of the frame PROFILER_GPU_LATENCY frames ago
+    uint32_t bufferIdx = uint32_t(state.frame % PROFILER_GPU_LATENCY);
+    GPUFrame& gpuFrame = state.gpuFrames[bufferIdx];
+    state.gpuZoneTimes.assign(zoneCount, ProfileZoneTime());
+    state.gpuOpenZones.clear();
+    if (state.gpuBackend && !gpuFrame.timestamps.empty())
+        resolveGPUFrame(state, gpuFrame, bufferIdx);
+
+    gpuFrame.timestamps.clear();
+    gpuFrame.frame = state.frame;
+    if (state.gpuBackend)
+    {
+        gpuFrame.cpuTimeInNanoseconds = nowInNanoseconds();
+        gpuFrame.gpuTimeInNanoseconds = state.gpuBackend->getCurrentTimeInNanoseconds();
+    }
+
+    // The oldest frame is replaced - the capacity of its event list is reused
+    FrameRecord& record = state.frames[state.frame % PROFILER_FRAME_HISTORY];
+    record.frame = state.frame;
+    record.beginInNanoseconds = nowInNanoseconds();
+    record.events.clear();
+}
+
+std::vector<ProfileZone> Profiler::getRecordedZones()
+{
+    auto& state = getState();
+
+    std::vector<std::vector<OpenZone>> openZones;
+    std::vector<ProfileZone> zones;
+
+    // Oldest frame first
+    for (uint64_t i = 1; i <= PROFILER_FRAME_HISTORY; ++i)
+    {
+        const FrameRecord& record = state.frames[(state.frame + i) % PROFILER_FRAME_HISTORY];
+        if (record.frame == NO_FRAME)
+            continue;
+
+        for (auto& trackEvent : record.events)
+        {
+            if (trackEvent.track >= openZones.size())
+                openZones.resize(trackEvent.track + 1);
+
+            auto& stack = openZones[trackEvent.track];
+            if (trackEvent.begin)
+            {
+                stack.push_back({trackEvent.zone, trackEvent.timeInNanoseconds});
+            }
+            else if (!stack.empty())
+            {
+                assert(stack.back().zone == trackEvent.zone);
+                zones.push_back({trackEvent.zone, trackEvent.track, uint32_t(stack.size() - 1), stack.back().beginInNanoseconds, trackEvent.timeInNanoseconds});
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::sort(zones.begin(), zones.end(), [](const ProfileZone& z0, const ProfileZone& z1)
+    {
+        if (z0.track != z1.track)
+            return z0.track < z1.track;
+
+        // Parents before their children
+        if (z0.beginInNanoseconds != z1.beginInNanoseconds)
+            return z0.beginInNanoseconds < z1.beginInNanoseconds;
+
+        return z0.depth < z1.depth;
+    });
+
+    return zones;
+}
+
+ProfileZoneTime Profiler::getCPUZoneTime(ProfileZoneId zone)
+{
+    auto& state = getState();
+    return zone < state.cpuZoneTimes.size() ? state.cpuZoneTimes[zone] : ProfileZoneTime();
+}
+
+ProfileZoneTime Profiler::getGPUZoneTime(ProfileZoneId zone)
+{
+    auto& state = getState();
+    return zone < state.gpuZoneTimes.size() ? state.gpuZoneTimes[zone] : ProfileZoneTime();
+}
+
+bool Profiler::exportChromeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+
+    auto& state = getState();
+    std::vector<ProfileZone> zones = getRecordedZones();
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Engine\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << GPU_TRACK << ",\"args\":{\"name\":\"GPU\"}}";
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (auto& buffer : state.threadBuffers)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->track << ",\"args\":{\"name\":\"";
+            writeEscaped(file, buffer->name);
+            file << "\"}}";
+        }
+    }
+
+    for (uint64_t i = 1; i <= PROFILER_FRAME_HISTORY; ++i)
+    {
+        const FrameRecord& record = state.frames[(state.frame + i) % PROFILER_FRAME_HISTORY];
+        if (record.frame == NO_FRAME)
+            continue;
+
+        file << ",\n{\"name\":\"Frame " << record.frame << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":"
+             << toMicroseconds(record.beginInNanoseconds - state.startInNanoseconds) << "}";
+    }
+
+    for (auto& zone : zones)
+    {
+        file << ",\n{\"name\":\"";
+        writeEscaped(file, getZoneName(zone.zone));
+        file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << zone.track << ",\"ts\":" << toMicroseconds(zone.beginInNanoseconds)
+             << ",\"dur\":" << toMicroseconds(zone.endInNanoseconds - zone.beginInNanoseconds) << "}";
+    }
+
+    file << "\n]}\n";
+
+    return bool(file);
+}
+
+uint64_t Profiler::getDroppedZoneCount()
+{
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    uint64_t droppedZoneCount = state.releasedDroppedZoneCount;
+    for (auto& buffer : state.threadBuffers)
+        droppedZoneCount += buffer->droppedZoneCount.load(std::memory_order_relaxed);
+
+    return droppedZoneCount;
+}
+
+void Profiler::clearHistory()
+{
+    auto& state = getState();
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (auto& buffer : state.threadBuffers)
+            buffer->readIdx.store(buffer->writeIdx.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    for (auto& gpuFrame : state.gpuFrames)
+        if (gpuFrame.frame != state.frame)
+            gpuFrame.timestamps.clear();
+
+    for (auto& openZones : state.cpuOpenZones)
+        openZones.clear();
+
+    for (auto& record : state.frames)
+    {
+        if (record.frame != state.frame)
+            record.frame = NO_FRAME;
+
+        record.events.clear();
+    }
+}
+
+ProfileThreadBuffer* Profiler::registerThread()
+{
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    uint32_t track = state.nextTrack++;
+    state.threadBuffers.push_back(std::make_unique<ProfileThreadBuffer>(track, "Thread " + std::to_string(track)));
+    m_threadBuffer = state.threadBuffers.back().get();
+    threadBufferRelease.buffer = m_threadBuffer;
+
+    return m_threadBuffer;
+}
@@ -0,0 +1,321 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PROFILER_USE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_TSC
+#endif
+
+// Without this define the PROFILE_* macros compile to nothing
+#define ENABLE_PROFILER
+
+// Number of zone events a thread can record between two Profiler::update() calls. Further zones are dropped.
+// A zone costs about 60 ns on a single thread of the test VM (ProfilerBenchmark) - the 50 ns target is not met because the two
+// reads of the time stamp counter that every begin/end pair needs already take about 53 ns there. The bookkeeping adds about 7 ns.
+#define PROFILER_THREAD_BUFFER_SIZE 16384
+
+// Number of frames that are kept for getRecordedZones() and the trace export
+#define PROFILER_FRAME_HISTORY 16
+
+// GPU timestamps of a frame are read this many frames later to avoid stalls
+#define PROFILER_GPU_LATENCY 3
+
+using ProfileZoneId = uint32_t;
+
+/**
+* Records GPU timestamps for the GPU zones. There is a set of timestamps for each of the PROFILER_GPU_LATENCY frames in flight.
+*/
+class ProfilerGPUBackend
+{
+public:
+    virtual ~ProfilerGPUBackend() { }
+
+    /**
+    * Records the GPU time at which all previously submitted commands are done.
+    */
+    virtual void recordTimestamp(uint32_t bufferIdx, uint32_t timestampIdx) = 0;
+
+    /**
+    * Returns a timestamp that was recorded PROFILER_GPU_LATENCY frames ago.
+    */
+    virtual uint64_t getTimestampInNanoseconds(uint32_t bufferIdx, uint32_t timestampIdx) = 0;
+
+    /**
+    * The current GPU time - used to map GPU timestamps to the CPU timeline.
+    */
+    virtual uint64_t getCurrentTimeInNanoseconds() = 0;
+};
+
+struct ProfileEvent
+{
+    uint64_t timestampInTicks;
+    ProfileZoneId zone;
+    uint32_t begin;
+};
+
+/**
+* Buffer of the zone events of a single thread. The thread writes the events and Profiler::update() reads them - no locks are needed.
+*/
+struct ProfileThreadBuffer
+{
+    ProfileThreadBuffer(uint32_t track, const std::string& name)
+        : events(new ProfileEvent[PROFILER_THREAD_BUFFER_SIZE]), track(track), name(name) { }
+
+    std::unique_ptr<ProfileEvent[]> events;
+
+    // Written by the recording thread
+    std::atomic<uint64_t> writeIdx{0};
+    uint64_t cachedReadIdx{0};
+    uint32_t openZoneCount{0};
+    std::atomic<uint64_t> droppedZoneCount{0};
+    char padding[64];
+
+    // Written by Profiler::update()
+    std::atomic<uint64_t> readIdx{0};
+
+    // Set when the thread exits - the buffer is removed by the next Profiler::update()
+    std::atomic<bool> released{false};
+
+    uint32_t track;
+    std::string name;
+};
+
+/**
+* A zone of the recorded frames. Times are relative to the start of the profiler.
+*/
+struct ProfileZone
+{
+    ProfileZoneId zone;
+    uint32_t track;
+    uint32_t depth;
+    uint64_t beginInNanoseconds;
+    uint64_t endInNanoseconds;
+};
+
+/**
+* Time spent in a zone during one frame summed over all of its calls.
+*/
+struct ProfileZoneTime
+{
+    uint64_t timeInNanoseconds{0};
+    uint32_t callCount{0};
+};
+
+/**
+* Hierarchical CPU/GPU profiler. Zones are identified by handles that are created once per call site with the PROFILE_* macros.
+* Every thread records its zones into its own buffer. Profiler::update() collects the zones of all threads once per frame
+* and keeps the last PROFILER_FRAME_HISTORY frames which can be exported as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+* GPU zones can only be recorded on the thread with the OpenGL context and are shown on a separate GPU track.
+*/
+class Profiler
+{
+public:
+    static const uint32_t GPU_TRACK = 0;
+
+    /**
+    * Returns the handle of the zone with the given name. Zones with the same name share the handle.
+    */
+    static ProfileZoneId registerZone(const char* name);
+
+    static const std::string& getZoneName(ProfileZoneId zone);
+
+    /**
+    * Zone handles are in [0, getZoneCount()).
+    */
+    static std::size_t getZoneCount();
+
+    /**
+    * Names the track of the calling thread in the trace. The track is removed after the thread exited.
+    */
+    static void setThreadName(const std::string& name);
+
+    /**
+    * Thread-safe.
+    * @return false if the zone was dropped because the buffer of the thread is full - endZone() must not be called in that case.
+    */
+    static bool beginZone(ProfileZoneId zone);
+    static void endZone(ProfileZoneId zone);
+
+    /**
+    * Only allowed on the thread with the OpenGL context. Returns false without a GPU backend - endGPUZone() must not be called in that case.
+    */
+    static bool beginGPUZone(ProfileZoneId zone);
+    static void endGPUZone(ProfileZoneId zone);
+
+    static void setGPUBackend(std::unique_ptr<ProfilerGPUBackend> backend);
+
+    /**
+    * Collects the zones of the last frame from all threads and starts a new frame. Called once per frame on the main thread.
+    */
+    static void update();
+
+    /**
+    * Returns the zones of the recorded frames ordered by track and begin time. Zones that began or ended outside of the
+    * recorded frames are skipped.
+    */
+    static std::vector<ProfileZone> getRecordedZones();
+
+    /**
+    * Time of the zone on all CPU tracks in the frame that was collected by the last update(). Only allowed on the main thread.
+    */
+    static ProfileZoneTime getCPUZoneTime(ProfileZoneId zone);
+
+    /**
+    * Time of the zone on the GPU track in the frame whose GPU timestamps were read by the last update() - that frame ended
+    * PROFILER_GPU_LATENCY frames earlier than the one of getCPUZoneTime(). Only allowed on the main thread.
+    */
+    static ProfileZoneTime getGPUZoneTime(ProfileZoneId zone);
+
+    /**
+    * Writes the recorded frames in the Chrome trace event format. Doesn't log - the caller reports the result.
+    * @return false if the file couldn't be written.
+    */
+    static bool exportChromeTrace(const std::string& path);
+
+    static uint64_t getDroppedZoneCount();
+
+    /**
+    * Removes the recorded frames.
+    */
+    static void clearHistory();
+
+    static uint64_t nowInNanoseconds()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+    * The time stamp counter is read in a fraction of the time of the steady_clock. The ticks are converted to nanoseconds when the
+    * zones are collected. Assumes an invariant TSC like on all recent x86 CPUs.
+    */
+    static uint64_t nowInTicks()
+    {
+#ifdef PROFILER_USE_TSC
+        return uint64_t(__rdtsc());
+#else
+        return nowInNanoseconds();
+#endif
+    }
+
+private:
+    static ProfileThreadBuffer* registerThread();
+
+    static void push(ProfileThreadBuffer* buffer, uint64_t writeIdx, ProfileZoneId zone, uint32_t begin)
+    {
+        ProfileEvent& event = buffer->events[writeIdx & (PROFILER_THREAD_BUFFER_SIZE - 1)];
+        event.timestampInTicks = nowInTicks();
+        event.zone = zone;
+        event.begin = begin;
+        buffer->writeIdx.store(writeIdx + 1, std::memory_order_release);
+    }
+
+private:
+    static thread_local ProfileThreadBuffer* m_threadBuffer;
+};
+
+inline bool Profiler::beginZone(ProfileZoneId zone)
+{
+    ProfileThreadBuffer* buffer = m_threadBuffer;
+    if (!buffer)
+        buffer = registerThread();
+
+    // The buffer needs space for this zone and the end events of all open zones to keep the events balanced
+    uint64_t writeIdx = buffer->writeIdx.load(std::memory_order_relaxed);
+    uint64_t requiredIdx = writeIdx + buffer->openZoneCount + 1;
+    if (requiredIdx - buffer->cachedReadIdx > PROFILER_THREAD_BUFFER_SIZE)
+    {
+        buffer->cachedReadIdx = buffer->readIdx.load(std::memory_order_acquire);
+        if (requiredIdx - buffer->cachedReadIdx > PROFILER_THREAD_BUFFER_SIZE)
+        {
+            buffer->droppedZoneCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    ++buffer->openZoneCount;
+    push(buffer, writeIdx, zone, 1);
+    return true;
+}
+
+inline void Profiler::endZone(ProfileZoneId zone)
+{
+    ProfileThreadBuffer* buffer = m_threadBuffer;
+    --buffer->openZoneCount;
+    push(buffer, buffer->writeIdx.load(std::memory_order_relaxed), zone, 0);
+}
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(ProfileZoneId zone)
+        : m_zone(zone), m_recorded(Profiler::beginZone(zone)) { }
+
+    ~ProfileScope()
+    {
+        if (m_recorded)
+            Profiler::endZone(m_zone);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileZoneId m_zone;
+    bool m_recorded;
+};
+
+/**
+* Records the zone on the CPU and the GPU.
+*/
+class GPUProfileScope
+{
+public:
+    explicit GPUProfileScope(ProfileZoneId zone)
+        : m_cpuScope(zone), m_zone(zone), m_recorded(Profiler::beginGPUZone(zone)) { }
+
+    ~GPUProfileScope()
+    {
+        if (m_recorded)
+            Profiler::endGPUZone(m_zone);
+    }
+
+    GPUProfileScope(const GPUProfileScope&) = delete;
+    GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+
+private:
+    ProfileScope m_cpuScope;
+    ProfileZoneId m_zone;
+    bool m_recorded;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef ENABLE_PROFILER
+// The zone handle is created on the first execution of the call site
+#define PROFILE_ZONE(name) \
+    static const ProfileZoneId PROFILE_CONCAT(profileZone, __LINE__) = Profiler::registerZone(name); \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZone, __LINE__))
+
+#define PROFILE_GPU_ZONE(name) \
+    static const ProfileZoneId PROFILE_CONCAT(profileZone, __LINE__) = Profiler::registerZone(name); \
+    GPUProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZone, __LINE__))
+
+// For zones with names that are only known at runtime - the handle is created with Profiler::registerZone()
+#define PROFILE_ZONE_ID(zone) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
+#define PROFILE_GPU_ZONE_ID(zone) GPUProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_GPU_ZONE(name)
+#define PROFILE_ZONE_ID(zone)
+#define PROFILE_GPU_ZONE_ID(zone)
+#endif
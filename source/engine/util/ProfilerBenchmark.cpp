@@ -0,0 +1,96 @@
+#include "ProfilerBenchmark.h"
+#include "Profiler.h"
+#include <engine/util/Timer.h>
+#include <engine/util/Logger.h>
+#include <thread>
+#include <vector>
+
+namespace profiler_benchmark
+{
+    // The zones of a batch fit into the thread buffer - the buffer is collected between the batches
+    const int ZONES_PER_BATCH = PROFILER_THREAD_BUFFER_SIZE / 2 - 1;
+    const int BATCH_COUNT = 64;
+
+    uint64_t recordZones()
+    {
+        uint64_t startInNanoseconds = Profiler::nowInNanoseconds();
+        for (int i = 0; i < ZONES_PER_BATCH; ++i)
+        {
+            PROFILE_ZONE("ProfilerBenchmark Zone");
+        }
+
+        return Profiler::nowInNanoseconds() - startInNanoseconds;
+    }
+
+    uint64_t readClock()
+    {
+        volatile uint64_t sum = 0;
+        uint64_t startInNanoseconds = Profiler::nowInNanoseconds();
+        for (int i = 0; i < ZONES_PER_BATCH; ++i)
+        {
+            sum = sum + Profiler::nowInTicks();
+            sum = sum + Profiler::nowInTicks();
+        }
+
+        return Profiler::nowInNanoseconds() - startInNanoseconds;
+    }
+
+#ifdef RUN_PROFILER_BENCHMARKS
+    struct ProfilerBenchmarkRunner
+    {
+        ProfilerBenchmarkRunner()
+        {
+            ProfilerBenchmark::runBenchmarks();
+        }
+    };
+
+    ProfilerBenchmarkRunner profilerBenchmarkRunner;
+#endif
+}
+
+using namespace profiler_benchmark;
+
+void ProfilerBenchmark::runBenchmarks()
+{
+    for (int threadCount : {1, 4})
+        benchmarkZoneOverhead(threadCount);
+
+    Profiler::clearHistory();
+}
+
+void ProfilerBenchmark::benchmarkZoneOverhead(int threadCount)
+{
+    std::vector<uint64_t> zoneTimes(threadCount, 0);
+    std::vector<uint64_t> clockTimes(threadCount, 0);
+
+    for (int batch = 0; batch < BATCH_COUNT; ++batch)
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&zoneTimes, &clockTimes, t]()
+            {
+                zoneTimes[t] += recordZones();
+                clockTimes[t] += readClock();
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        Profiler::update();
+    }
+
+    uint64_t zoneTime = 0;
+    uint64_t clockTime = 0;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        zoneTime += zoneTimes[t];
+        clockTime += clockTimes[t];
+    }
+
+    uint64_t zoneCount = uint64_t(threadCount) * ZONES_PER_BATCH * BATCH_COUNT;
+    LOG("Profiler Benchmark: " << threadCount << " threads, " << zoneCount << " zones: " << double(zoneTime) / zoneCount
+        << " ns per zone (reading the clock twice: " << double(clockTime) / zoneCount << " ns), "
+        << Profiler::getDroppedZoneCount() << " dropped zones");
+}
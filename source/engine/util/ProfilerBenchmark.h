@@ -0,0 +1,16 @@
+#pragma once
+
+// Runs the profiler benchmarks on startup and logs the results
+//#define RUN_PROFILER_BENCHMARKS
+
+class ProfilerBenchmark
+{
+public:
+    static void runBenchmarks();
+
+private:
+    /**
+    * Overhead of an empty PROFILE_ZONE on threadCount threads compared to reading the profiler clock twice.
+    */
+    static void benchmarkZoneOverhead(int threadCount);
+};
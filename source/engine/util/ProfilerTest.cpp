@@ -0,0 +1,321 @@
+#include "ProfilerTest.h"
+#include "Profiler.h"
+#include <thread>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+namespace profiler_test
+{
+    /**
+    * The GPU clock is ahead of the CPU clock by a constant offset.
+    */
+    class TestGPUBackend : public ProfilerGPUBackend
+    {
+    public:
+        static const uint64_t GPU_CLOCK_OFFSET = 1000000000000ull;
+
+        void recordTimestamp(uint32_t bufferIdx, uint32_t timestampIdx) override
+        {
+            if (timestampIdx >= timestamps[bufferIdx].size())
+                timestamps[bufferIdx].resize(timestampIdx + 1);
+
+            timestamps[bufferIdx][timestampIdx] = getCurrentTimeInNanoseconds();
+        }
+
+        uint64_t getTimestampInNanoseconds(uint32_t bufferIdx, uint32_t timestampIdx) override
+        {
+            return timestamps[bufferIdx][timestampIdx];
+        }
+
+        uint64_t getCurrentTimeInNanoseconds() override { return Profiler::nowInNanoseconds() + GPU_CLOCK_OFFSET; }
+
+        std::vector<uint64_t> timestamps[PROFILER_GPU_LATENCY];
+    };
+
+    std::vector<ProfileZone> getZones(ProfileZoneId zone)
+    {
+        std::vector<ProfileZone> zones;
+        for (auto& z : Profiler::getRecordedZones())
+            if (z.zone == zone)
+                zones.push_back(z);
+
+        return zones;
+    }
+
+    ProfileZoneId getZone(const char* name)
+    {
+        return Profiler::registerZone(name);
+    }
+
+    std::string getTempPath(const std::string& fileName)
+    {
+#ifdef _WIN32
+        const char* tempFolder = std::getenv("TEMP");
+#else
+        const char* tempFolder = std::getenv("TMPDIR");
+        if (!tempFolder)
+            tempFolder = "/tmp";
+#endif
+        return tempFolder ? std::string(tempFolder) + "/" + fileName : fileName;
+    }
+
+    void recordZone()
+    {
+        PROFILE_ZONE("ProfilerTest Call Site");
+    }
+
+#ifdef RUN_PROFILER_TESTS
+    struct ProfilerTestRunner
+    {
+        ProfilerTestRunner()
+        {
+            ProfilerTest::runTests();
+        }
+    };
+
+    ProfilerTestRunner profilerTestRunner;
+#endif
+}
+
+using namespace profiler_test;
+
+void ProfilerTest::runTests()
+{
+    testZoneHandles();
+    testNestedZones();
+    testThreads();
+    testDroppedZones();
+    testGPUZones();
+    testZoneTimes();
+    testChromeTraceExport();
+
+    Profiler::clearHistory();
+}
+
+void ProfilerTest::testZoneHandles()
+{
+    ProfileZoneId zone0 = Profiler::registerZone("ProfilerTest Zone");
+    ProfileZoneId zone1 = Profiler::registerZone("ProfilerTest Other Zone");
+
+    assert(zone0 != zone1);
+    assert(Profiler::registerZone("ProfilerTest Zone") == zone0);
+    assert(Profiler::getZoneName(zone1) == "ProfilerTest Other Zone");
+}
+
+void ProfilerTest::testNestedZones()
+{
+    Profiler::clearHistory();
+
+    {
+        PROFILE_ZONE("ProfilerTest Outer");
+        for (int i = 0; i < 3; ++i)
+        {
+            PROFILE_ZONE("ProfilerTest Inner");
+        }
+    }
+
+    Profiler::update();
+
+    auto outer = getZones(getZone("ProfilerTest Outer"));
+    auto inner = getZones(getZone("ProfilerTest Inner"));
+    assert(outer.size() == 1);
+    assert(inner.size() == 3);
+    assert(outer[0].depth == 0);
+
+    for (auto& zone : inner)
+    {
+        assert(zone.depth == 1);
+        assert(zone.track == outer[0].track);
+        assert(zone.beginInNanoseconds >= outer[0].beginInNanoseconds);
+        assert(zone.endInNanoseconds <= outer[0].endInNanoseconds);
+    }
+
+    assert(inner[0].endInNanoseconds <= inner[1].beginInNanoseconds);
+}
+
+void ProfilerTest::testThreads()
+{
+    const int threadCount = 4;
+    const int zoneCount = 1000;
+    Profiler::clearHistory();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([]()
+        {
+            Profiler::setThreadName("ProfilerTest Worker");
+            for (int i = 0; i < zoneCount; ++i)
+            {
+                PROFILE_ZONE("ProfilerTest Thread Outer");
+                PROFILE_ZONE("ProfilerTest Thread Inner");
+            }
+        });
+    }
+
+    // Collecting while the threads are recording
+    for (int i = 0; i < 5; ++i)
+        Profiler::update();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    Profiler::update();
+
+    auto outer = getZones(getZone("ProfilerTest Thread Outer"));
+    auto inner = getZones(getZone("ProfilerTest Thread Inner"));
+    assert(outer.size() == threadCount * zoneCount);
+    assert(inner.size() == threadCount * zoneCount);
+
+    std::set<uint32_t> tracks;
+    for (auto& zone : outer)
+    {
+        assert(zone.depth == 0);
+        assert(zone.track != Profiler::GPU_TRACK);
+        tracks.insert(zone.track);
+    }
+
+    assert(tracks.size() == threadCount);
+}
+
+void ProfilerTest::testDroppedZones()
+{
+    Profiler::clearHistory();
+    uint64_t droppedZoneCount = Profiler::getDroppedZoneCount();
+
+    // More zones than fit into the buffer of the thread
+    {
+        PROFILE_ZONE("ProfilerTest Dropped Outer");
+        for (int i = 0; i < PROFILER_THREAD_BUFFER_SIZE; ++i)
+        {
+            PROFILE_ZONE("ProfilerTest Dropped Inner");
+        }
+    }
+
+    Profiler::update();
+
+    auto outer = getZones(getZone("ProfilerTest Dropped Outer"));
+    auto inner = getZones(getZone("ProfilerTest Dropped Inner"));
+    assert(outer.size() == 1);
+    assert(inner.size() == PROFILER_THREAD_BUFFER_SIZE / 2 - 1);
+    assert(Profiler::getDroppedZoneCount() - droppedZoneCount == PROFILER_THREAD_BUFFER_SIZE - inner.size());
+
+    // The buffer has space again after the update
+    recordZone();
+    recordZone();
+    Profiler::update();
+    assert(getZones(getZone("ProfilerTest Call Site")).size() == 2);
+}
+
+void ProfilerTest::testGPUZones()
+{
+    Profiler::clearHistory();
+    Profiler::setGPUBackend(std::make_unique<TestGPUBackend>());
+
+    {
+        PROFILE_GPU_ZONE("ProfilerTest GPU Outer");
+        PROFILE_GPU_ZONE("ProfilerTest GPU Inner");
+    }
+
+    // The GPU zones are added PROFILER_GPU_LATENCY frames later
+    for (int i = 0; i < PROFILER_GPU_LATENCY - 1; ++i)
+        Profiler::update();
+
+    auto zones = getZones(getZone("ProfilerTest GPU Outer"));
+    assert(zones.size() == 1);
+    assert(zones[0].track != Profiler::GPU_TRACK);
+
+    Profiler::update();
+
+    auto outer = getZones(getZone("ProfilerTest GPU Outer"));
+    auto inner = getZones(getZone("ProfilerTest GPU Inner"));
+    assert(outer.size() == 2);
+    assert(inner.size() == 2);
+
+    const ProfileZone& cpuZone = outer[0].track == Profiler::GPU_TRACK ? outer[1] : outer[0];
+    const ProfileZone& gpuZone = outer[0].track == Profiler::GPU_TRACK ? outer[0] : outer[1];
+    const ProfileZone& gpuInnerZone = inner[0].track == Profiler::GPU_TRACK ? inner[0] : inner[1];
+    assert(gpuZone.track == Profiler::GPU_TRACK);
+    assert(gpuInnerZone.track == Profiler::GPU_TRACK && gpuInnerZone.depth == 1);
+
+    // The GPU times are mapped to the CPU timeline
+    const uint64_t toleranceInNanoseconds = 1000000;
+    assert(gpuZone.beginInNanoseconds + toleranceInNanoseconds >= cpuZone.beginInNanoseconds);
+    assert(gpuZone.beginInNanoseconds <= cpuZone.endInNanoseconds + toleranceInNanoseconds);
+    assert(gpuInnerZone.beginInNanoseconds >= gpuZone.beginInNanoseconds);
+    assert(gpuInnerZone.endInNanoseconds <= gpuZone.endInNanoseconds);
+
+    Profiler::setGPUBackend(nullptr);
+}
+
+void ProfilerTest::testZoneTimes()
+{
+    Profiler::clearHistory();
+    Profiler::setGPUBackend(std::make_unique<TestGPUBackend>());
+
+    {
+        PROFILE_GPU_ZONE("ProfilerTest Times Outer");
+        for (int i = 0; i < 3; ++i)
+        {
+            PROFILE_ZONE("ProfilerTest Times Inner");
+        }
+    }
+
+    Profiler::update();
+
+    ProfileZoneTime outer = Profiler::getCPUZoneTime(getZone("ProfilerTest Times Outer"));
+    ProfileZoneTime inner = Profiler::getCPUZoneTime(getZone("ProfilerTest Times Inner"));
+    assert(outer.callCount == 1);
+    assert(inner.callCount == 3);
+    assert(inner.timeInNanoseconds <= outer.timeInNanoseconds);
+    assert(Profiler::getGPUZoneTime(getZone("ProfilerTest Times Outer")).callCount == 0);
+    assert(Profiler::getZoneCount() > getZone("ProfilerTest Times Inner"));
+
+    // The GPU times arrive PROFILER_GPU_LATENCY frames later - the CPU times only cover the last frame
+    for (int i = 0; i < PROFILER_GPU_LATENCY - 1; ++i)
+        Profiler::update();
+
+    assert(Profiler::getCPUZoneTime(getZone("ProfilerTest Times Outer")).callCount == 0);
+    assert(Profiler::getGPUZoneTime(getZone("ProfilerTest Times Outer")).callCount == 1);
+    assert(Profiler::getGPUZoneTime(getZone("ProfilerTest Times Inner")).callCount == 0);
+
+    Profiler::update();
+    assert(Profiler::getGPUZoneTime(getZone("ProfilerTest Times Outer")).callCount == 0);
+
+    Profiler::setGPUBackend(nullptr);
+}
+
+void ProfilerTest::testChromeTraceExport()
+{
+    Profiler::clearHistory();
+    Profiler::setThreadName("ProfilerTest \"Main\" Thread");
+
+    {
+        PROFILE_ZONE("ProfilerTest Export");
+    }
+
+    Profiler::update();
+
+    std::string path = getTempPath("ProfilerTest.json");
+    bool exported = Profiler::exportChromeTrace(path);
+    assert(exported);
+
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string trace = ss.str();
+    file.close();
+    std::remove(path.c_str());
+
+    assert(trace.find("\"traceEvents\"") != std::string::npos);
+    assert(trace.find("{\"name\":\"ProfilerTest Export\",\"ph\":\"X\"") != std::string::npos);
+    assert(trace.find("ProfilerTest \\\"Main\\\" Thread") != std::string::npos);
+    assert(trace.find("ProfilerTest Worker") == std::string::npos);
+    assert(trace.find("\"ph\":\"i\"") != std::string::npos);
+    assert(trace.rfind("]}") != std::string::npos);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#if defined(DEBUG) || defined(_DEBUG)
+#define RUN_PROFILER_TESTS
+#endif
+
+class ProfilerTest
+{
+public:
+    static void runTests();
+
+private:
+    static void testZoneHandles();
+    static void testNestedZones();
+    static void testThreads();
+    static void testDroppedZones();
+    static void testGPUZones();
+    static void testZoneTimes();
+    static void testChromeTraceExport();
+};
@@ -10,6 +10,7 @@ Timer QueryManager::m_timer;
 uint32_t QueryManager::m_writeQueryBufferIdx = 0;
 uint32_t QueryManager::m_readQueryBufferIdx = 0;
 InternalElapsedTimeInfo* QueryManager::m_currentTimeInfo[2]{nullptr, nullptr};
+std::map<std::string, uint64_t, std::less<>> QueryManager::m_counters;
 
 struct InternalElapsedTimeInfo
 {
@@ -323,18 +324,39 @@ void QueryManager::endElapsedTime(QueryTarget target, const std::string& name)
         LOG_ERROR("Could not find query: " << name);
 }
 
-std::vector<ElapsedTimeInfoBag> QueryManager::getElapsedTimeInfo(QueryTarget target)
+FrameVector<const ElapsedTimeInfoBag*> QueryManager::getElapsedTimeInfo(QueryTarget target)
 {
     ElapsedTimeMap* entryMap = getElapsedTimeMap(target);
 
-    std::vector<ElapsedTimeInfoBag> info;
+    FrameVector<const ElapsedTimeInfoBag*> info;
+    info.reserve(entryMap->size());
 
     for (auto& p : *entryMap)
-        info.push_back(p.second->info);
+        info.push_back(&p.second->info);
 
     return info;
 }
 
+const ElapsedTimeInfo* QueryManager::getElapsedTimeInfo(QueryTarget target, const std::string& name, ElapsedTimeInfoType type)
+{
+    ElapsedTimeMap* entryMap = getElapsedTimeMap(target);
+    auto it = entryMap->find(name);
+
+    if (it == entryMap->end())
+        return nullptr;
+
+    return &it->second->info[type];
+}
+
+void QueryManager::setCounter(const char* name, uint64_t value)
+{
+    auto it = m_counters.find(name);
+    if (it != m_counters.end())
+        it->second = value;
+    else
+        m_counters.emplace(name, value);
+}
+
 QueryManager::ElapsedTimeMap* QueryManager::getElapsedTimeMap(QueryTarget target)
 {
     switch (target)
@@ -2,10 +2,13 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <functional>
 #include "GLQueryObject.h"
 #include "Timer.h"
 #include <memory>
 #include "Logger.h"
+#include <engine/memory/FrameArena.h>
 #include <cstddef>
 
 // Multiple buffers are used because querying can stall
@@ -97,7 +100,30 @@ public:
     static void beginElapsedTime(QueryTarget target, const std::string& name);
     static void endElapsedTime(QueryTarget target, const std::string& name);
 
-    static std::vector<ElapsedTimeInfoBag> getElapsedTimeInfo(QueryTarget target);
+    /**
+    * The returned list is allocated in the FrameArena and only valid during the current frame.
+    */
+    static FrameVector<const ElapsedTimeInfoBag*> getElapsedTimeInfo(QueryTarget target);
+
+    /**
+    * Returns the info of the query or nullptr if it doesn't exist.
+    * GPU timings of a frame are added MAX_QUERY_OBJECT_BUFFERS - 1 frames later.
+    */
+    static const ElapsedTimeInfo* getElapsedTimeInfo(QueryTarget target, const std::string& name,
+                                                     ElapsedTimeInfoType type = ElapsedTimeInfoType::PER_FRAME);
+
+    /**
+    * Counters are plain per frame values like the number of culled draw calls.
+    * A counter keeps its value until it is set again.
+    */
+    static void setCounter(const std::string& name, uint64_t value) { setCounter(name.c_str(), value); }
+
+    /**
+    * Doesn't allocate once the counter exists.
+    */
+    static void setCounter(const char* name, uint64_t value);
+
+    static const std::map<std::string, uint64_t, std::less<>>& getCounters() { return m_counters; }
 
 private:
     static ElapsedTimeMap* getElapsedTimeMap(QueryTarget target);
@@ -112,4 +138,5 @@ private:
     static uint32_t m_writeQueryBufferIdx;
     static uint32_t m_readQueryBufferIdx;
     static InternalElapsedTimeInfo* m_currentTimeInfo[2];
+    static std::map<std::string, uint64_t, std::less<>> m_counters; // Transparent comparison to look up names without a std::string
 };
@@ -0,0 +1,200 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <string>
+#include <cassert>
+
+namespace
+{
+    // Identifies the pool and the queue of a worker thread
+    thread_local const ThreadPool* t_pool = nullptr;
+    thread_local std::size_t t_queueIdx = 0;
+}
+
+ThreadPool::ThreadPool(std::size_t workerCount)
+{
+    for (std::size_t i = 0; i < workerCount + 1; ++i)
+        m_queues.push_back(std::make_unique<JobQueue>());
+
+    for (std::size_t i = 0; i < workerCount; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running = false;
+    }
+
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+std::size_t ThreadPool::defaultWorkerCount()
+{
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t chunkSize, const std::function<void(std::size_t begin, std::size_t end)>& func)
+{
+    assert(chunkSize > 0);
+    std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    if (chunkCount == 0)
+        return;
+
+    if (chunkCount == 1 || m_workers.empty())
+    {
+        func(0, count);
+        return;
+    }
+
+    std::atomic<std::size_t> remainingChunks{chunkCount};
+    std::size_t callerQueueIdx = getQueueIdx();
+
+    // Distribute the chunks over all queues - idle workers will steal the rest
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        std::size_t begin = i * chunkSize;
+        std::size_t end = std::min(begin + chunkSize, count);
+
+        push((callerQueueIdx + i) % m_queues.size(), [&func, &remainingChunks, begin, end]()
+        {
+            func(begin, end);
+            --remainingChunks;
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wakeCondition.notify_all();
+
+    // Help until all chunks are done
+    while (remainingChunks > 0)
+    {
+        if (!tryRunJob(callerQueueIdx))
+            std::this_thread::yield();
+    }
+}
+
+void ThreadPool::submit(Job job)
+{
+    if (m_workers.empty())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_backgroundMutex);
+        m_backgroundJobs.push_back(std::move(job));
+        ++m_queuedJobCount;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wakeCondition.notify_one();
+}
+
+void ThreadPool::push(std::size_t queueIdx, Job job)
+{
+    auto& queue = *m_queues[queueIdx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+    ++m_queuedJobCount;
+}
+
+bool ThreadPool::tryRunJob(std::size_t queueIdx)
+{
+    Job job;
+
+    if (tryPop(queueIdx, job) || trySteal(queueIdx, job))
+    {
+        PROFILE_ZONE("Job");
+        job();
+        return true;
+    }
+
+    return false;
+}
+
+bool ThreadPool::tryPop(std::size_t queueIdx, Job& job)
+{
+    auto& queue = *m_queues[queueIdx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.jobs.empty())
+        return false;
+
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    --m_queuedJobCount;
+    return true;
+}
+
+bool ThreadPool::trySteal(std::size_t thiefIdx, Job& job)
+{
+    for (std::size_t i = 1; i < m_queues.size(); ++i)
+    {
+        auto& queue = *m_queues[(thiefIdx + i) % m_queues.size()];
+        std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+
+        if (!lock.owns_lock() || queue.jobs.empty())
+            continue;
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        --m_queuedJobCount;
+        return true;
+    }
+
+    return false;
+}
+
+bool ThreadPool::tryRunBackgroundJob()
+{
+    Job job;
+
+    {
+        std::lock_guard<std::mutex> lock(m_backgroundMutex);
+
+        if (m_backgroundJobs.empty())
+            return false;
+
+        job = std::move(m_backgroundJobs.front());
+        m_backgroundJobs.pop_front();
+        --m_queuedJobCount;
+    }
+
+    PROFILE_ZONE("Background Job");
+    job();
+    return true;
+}
+
+void ThreadPool::workerLoop(std::size_t queueIdx)
+{
+    t_pool = this;
+    t_queueIdx = queueIdx;
+    Profiler::setThreadName("Worker " + std::to_string(queueIdx));
+
+    while (m_running)
+    {
+        if (tryRunJob(queueIdx) || tryRunBackgroundJob())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait(lock, [this]() { return !m_running || m_queuedJobCount > 0; });
+    }
+}
+
+std::size_t ThreadPool::getQueueIdx() const
+{
+    // Threads outside of the pool share the last queue
+    return t_pool == this ? t_queueIdx : m_queues.size() - 1;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+/**
+* Work-stealing thread pool. Every worker thread owns a job queue. Workers take jobs from the back of their own queue
+* and steal from the front of other queues if their own queue is empty.
+* The thread that calls parallelFor() has its own queue and helps to process the jobs until all of them are done.
+* Background jobs (submit()) are only run by the workers when they have nothing else to do.
+*/
+class ThreadPool
+{
+public:
+    using Job = std::function<void()>;
+
+private:
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+public:
+    /**
+    * Creates a pool with the given number of worker threads. The thread calling parallelFor()
+    * is not included, thus workerCount = hardware threads - 1 uses all cores.
+    */
+    explicit ThreadPool(std::size_t workerCount = defaultWorkerCount());
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+    * Splits [0, count) into chunks of at most chunkSize elements and calls func(begin, end) for each chunk.
+    * Blocks until all chunks are processed.
+    */
+    void parallelFor(std::size_t count, std::size_t chunkSize, const std::function<void(std::size_t begin, std::size_t end)>& func);
+
+    /**
+    * Queues a job that runs asynchronously on a worker thread. Workers prefer parallelFor() jobs, and the thread
+    * calling parallelFor() never runs background jobs - long jobs (e.g. file loading) don't delay parallelFor().
+    * If the pool has no workers the job is run immediately on the calling thread.
+    */
+    void submit(Job job);
+
+    std::size_t getWorkerCount() const { return m_workers.size(); }
+
+    static std::size_t defaultWorkerCount();
+
+private:
+    void push(std::size_t queueIdx, Job job);
+
+    /**
+    * Runs a job of the given queue or steals one from another queue.
+    * @return false if no job was found.
+    */
+    bool tryRunJob(std::size_t queueIdx);
+
+    bool tryPop(std::size_t queueIdx, Job& job);
+    bool trySteal(std::size_t thiefIdx, Job& job);
+    bool tryRunBackgroundJob();
+
+    void workerLoop(std::size_t queueIdx);
+
+    /**
+    * Returns the queue index of the calling thread.
+    */
+    std::size_t getQueueIdx() const;
+
+private:
+    // One queue per worker and one for the threads outside of the pool
+    std::vector<std::unique_ptr<JobQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_backgroundMutex;
+    std::deque<Job> m_backgroundJobs;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<std::size_t> m_queuedJobCount{0};
+    std::atomic<bool> m_running{true};
+};
@@ -225,3 +225,9 @@ std::size_t file::getSize(const std::string& filename)
     struct stat buffer;
     return stat(filename.c_str(), &buffer) == 0 ? buffer.st_size : 0;
 }
+
+int64_t file::getLastWriteTime(const std::string& filename)
+{
+    struct stat buffer;
+    return stat(filename.c_str(), &buffer) == 0 ? int64_t(buffer.st_mtime) : 0;
+}
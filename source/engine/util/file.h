@@ -3,6 +3,7 @@
 #include <vector>
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 
 namespace file
 {
@@ -104,6 +105,11 @@ namespace file
 
     bool exists(const std::string& filename) noexcept;
     std::size_t getSize(const std::string& filename);
+
+    /**
+    * Returns the time of the last modification in seconds since epoch or 0 if the file doesn't exist.
+    */
+    int64_t getLastWriteTime(const std::string& filename);
 }
 
 namespace file
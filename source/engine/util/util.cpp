@@ -8,8 +8,8 @@ BBox util::computeBBox(const Mesh& mesh)
     BBox box;
 
     for (auto& subMesh : mesh.getSubMeshes())
-        for (auto& v : subMesh.vertices)
-            box.unite(v);
+        for (std::size_t i = 0; i < subMesh.getVertexCount(); ++i)
+            box.unite(subMesh.getPosition(i));
 
     return box;
 }
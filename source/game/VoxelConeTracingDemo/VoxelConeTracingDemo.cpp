@@ -8,12 +8,15 @@
 #include <engine/util/util.h>
 #include <engine/resource/ResourceManager.h>
 #include <fstream>
+#include <functional>
 #include <engine/rendering/architecture/RenderPipeline.h>
+#include <engine/rendering/architecture/RPKeys.h>
 #include <engine/ecs/ECS.h>
 #include <engine/rendering/lights/DirectionalLight.h>
 #include "engine/rendering/voxelConeTracing/VoxelizationPass.h"
 #include "engine/rendering/debug/DebugRenderer.h"
 #include "engine/util/ECSUtil/ECSUtil.h"
+#include "engine/rendering/renderPasses/CullingPass.h"
 #include "engine/rendering/renderPasses/SceneGeometryPass.h"
 #include "engine/rendering/renderPasses/ShadowMapPass.h"
 #include "engine/rendering/voxelConeTracing/RadianceInjectionPass.h"
@@ -23,8 +26,11 @@
 #include "engine/rendering/voxelConeTracing/settings/VoxelConeTracingSettings.h"
 #include "engine/util/commands/RotationCommand.h"
 #include "engine/util/commands/CommandChain.h"
-#include "engine/util/QueryManager.h"
+#include "engine/util/Profiler.h"
 #include "engine/rendering/renderer/MeshRenderers.h"
+#include "engine/geometry/GeometryBenchmark.h"
+#include "engine/resource/ResourceBenchmark.h"
+#include "engine/rendering/voxelConeTracing/VoxelConeTracingBenchmark.h"
 #include <cstddef>
 
 VoxelConeTracingDemo::VoxelConeTracingDemo()
@@ -47,17 +53,24 @@ void VoxelConeTracingDemo::initUpdate()
     m_renderPipeline = std::make_unique<RenderPipeline>(MainCamera);
     m_gui = std::make_unique<VoxelConeTracingGUI>(m_renderPipeline.get());
     m_clipmapUpdatePolicy = std::make_unique<ClipmapUpdatePolicy>(ClipmapUpdatePolicy::Type::ONE_PER_FRAME_PRIORITY, CLIP_REGION_COUNT);
+    m_clipmapUpdatePolicy->setTimingLatency(PROFILER_GPU_LATENCY - 1);
 
     // Set render pipeline input
-    m_renderPipeline->putPtr("VoxelOpacity", &m_voxelOpacity);
-    m_renderPipeline->putPtr("VoxelRadiance", &m_voxelRadiance);
-    m_renderPipeline->putPtr("ClipRegionBBoxes", &m_clipRegionBBoxes);
-    m_renderPipeline->putPtr("ClipmapUpdatePolicy", m_clipmapUpdatePolicy.get());
+    m_renderPipeline->putPtr(rp_keys::VOXEL_OPACITY, &m_voxelOpacity);
+    m_renderPipeline->putPtr(rp_keys::VOXEL_RADIANCE, &m_voxelRadiance);
+    m_renderPipeline->putPtr(rp_keys::CLIP_REGION_BBOXES, &m_clipRegionBBoxes);
+    m_renderPipeline->putPtr(rp_keys::CLIPMAP_UPDATE_POLICY, m_clipmapUpdatePolicy.get());
+
+    m_renderPipeline->importResource(rp_keys::VOXEL_OPACITY);
+    m_renderPipeline->importResource(rp_keys::VOXEL_RADIANCE);
+    m_renderPipeline->importResource(rp_keys::CLIP_REGION_BBOXES);
+    m_renderPipeline->importResource(rp_keys::CLIPMAP_UPDATE_POLICY);
 
     updateCameraClipRegions();
 
     // Add render passes to the pipeline
     m_renderPipeline->addRenderPasses(
+        std::make_shared<CullingPass>(),
         std::make_shared<SceneGeometryPass>(),
         std::make_shared<VoxelizationPass>(),
         std::make_shared<ShadowMapPass>(SHADOW_SETTINGS.shadowMapResolution),
@@ -75,6 +88,8 @@ void VoxelConeTracingDemo::initUpdate()
 void VoxelConeTracingDemo::update()
 {
     m_clipmapUpdatePolicy->setType(getSelectedClipmapUpdatePolicyType());
+    m_clipmapUpdatePolicy->setBudget(GI_SETTINGS.clipmapUpdateBudget);
+    reportClipmapUpdateTimings();
     m_clipmapUpdatePolicy->update();
 
     moveCamera(Time::deltaTime());
@@ -97,7 +112,6 @@ void VoxelConeTracingDemo::update()
         m_renderPipeline->getRenderPass<GIPass>()->setEnabled(true);
         m_renderPipeline->getRenderPass<VoxelizationPass>()->setEnabled(true);
         m_renderPipeline->getRenderPass<RadianceInjectionPass>()->setEnabled(true);
-        m_renderPipeline->getRenderPass<SceneGeometryPass>()->setEnabled(true);
     }
     
     if (forwardPipeline)
@@ -106,9 +120,11 @@ void VoxelConeTracingDemo::update()
         m_renderPipeline->getRenderPass<GIPass>()->setEnabled(false);
         m_renderPipeline->getRenderPass<VoxelizationPass>()->setEnabled(true);
         m_renderPipeline->getRenderPass<RadianceInjectionPass>()->setEnabled(false);
-        m_renderPipeline->getRenderPass<SceneGeometryPass>()->setEnabled(false);
     }
 
+    bool rsmInjection = GI_SETTINGS.radianceInjectionMode.asString() == "Reflective Shadow Maps";
+    m_renderPipeline->getRenderPass<ShadowMapPass>()->setRenderReflectiveShadowMaps(giPipeline && rsmInjection);
+
     animateDirLight();
 
     GL::setViewport(MainCamera->getViewport());
@@ -181,6 +197,9 @@ void VoxelConeTracingDemo::onKeyDown(SDL_Keycode keyCode)
     case SDLK_F5:
         m_engine->requestScreenshot();
         break;
+    case SDLK_F6:
+        m_engine->exportTrace();
+        break;
     default: break;
     }
 }
@@ -253,11 +272,51 @@ void VoxelConeTracingDemo::createDemoScene()
     m_engine->registerCamera(camComponent);
 
     auto shader = ResourceManager::getShader("shaders/forwardShadingPass.vert", "shaders/forwardShadingPass.frag", { "in_pos", "in_normal", "in_tangent", "in_bitangent", "in_uv" });
+#ifdef RUN_RESOURCE_BENCHMARKS
+    ResourceBenchmark::benchmarkModelLoad("meshes/sponza_obj/sponza.obj");
+#endif
+
     auto sceneRootEntity = ECSUtil::loadMeshEntities("meshes/sponza_obj/sponza.obj", shader, "textures/sponza_textures/", glm::vec3(0.01f), true);
 
     if (sceneRootEntity)
         sceneRootEntity->setPosition(glm::vec3(m_scenePosition));
 
+#if defined(RUN_GEOMETRY_BENCHMARKS) || defined(RUN_VOXEL_CONE_TRACING_BENCHMARKS)
+    if (auto sponza = ResourceManager::getModel("meshes/sponza_obj/sponza.obj"))
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<uint32_t> indices;
+
+        // The vertices of each node are relative to its center - the node transformations are identities
+        std::function<void(const Model&)> addTriangles = [&](const Model& model)
+        {
+            Vertices positions;
+            Indices subMeshIndices;
+            for (auto& subMesh : model.subMeshes)
+            {
+                uint32_t baseVertex = uint32_t(vertices.size());
+                for (auto& v : subMesh.getPositions(positions))
+                    vertices.push_back((v + model.center) * 0.01f);
+
+                for (auto idx : subMesh.getIndices(subMeshIndices))
+                    indices.push_back(baseVertex + idx);
+            }
+
+            for (auto& child : model.children)
+                addTriangles(*child);
+        };
+
+        addTriangles(*sponza);
+
+#ifdef RUN_GEOMETRY_BENCHMARKS
+        GeometryBenchmark::benchmarkRaycast("Sponza", vertices, indices);
+#endif
+#ifdef RUN_VOXEL_CONE_TRACING_BENCHMARKS
+        VoxelConeTracingBenchmark::benchmarkCPUVoxelizer("Sponza", vertices, indices, m_clipRegionBBoxExtentL0);
+#endif
+    }
+#endif
+
     m_directionalLight = ECS::createEntity("Directional Light");
     m_directionalLight.addComponent<DirectionalLight>();
     m_directionalLight.addComponent<Transform>();
@@ -292,8 +351,27 @@ void VoxelConeTracingDemo::updateCameraClipRegions()
 
 ClipmapUpdatePolicy::Type VoxelConeTracingDemo::getSelectedClipmapUpdatePolicyType() const
 {
-    if (GI_SETTINGS.updateOneClipLevelPerFrame)
+    switch (GI_SETTINGS.clipmapUpdatePolicy)
+    {
+    case 1:
         return ClipmapUpdatePolicy::Type::ONE_PER_FRAME_PRIORITY;
+    case 2:
+        return ClipmapUpdatePolicy::Type::BUDGET;
+    default:
+        return ClipmapUpdatePolicy::Type::ALL_PER_FRAME;
+    }
+}
+
+void VoxelConeTracingDemo::reportClipmapUpdateTimings()
+{
+    static const ProfileZoneId voxelizationZone = Profiler::registerZone("Radiance Voxelization");
+    static const ProfileZoneId downsamplingZone = Profiler::registerZone("Radiance Downsampling");
+
+    // The GPU times of a frame are read PROFILER_GPU_LATENCY frames later - frames without a radiance update are skipped
+    ProfileZoneTime voxelizationTime = Profiler::getGPUZoneTime(voxelizationZone);
+    ProfileZoneTime downsamplingTime = Profiler::getGPUZoneTime(downsamplingZone);
+    if (voxelizationTime.callCount == 0 || downsamplingTime.callCount == 0)
+        return;
 
-    return ClipmapUpdatePolicy::Type::ALL_PER_FRAME;
+    m_clipmapUpdatePolicy->reportTimings(voxelizationTime.timeInNanoseconds / 1000000.0, downsamplingTime.timeInNanoseconds / 1000000.0);
 }
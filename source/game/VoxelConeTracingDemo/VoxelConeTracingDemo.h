@@ -34,6 +34,7 @@ private:
     void updateCameraClipRegions();
 
     ClipmapUpdatePolicy::Type getSelectedClipmapUpdatePolicyType() const;
+    void reportClipmapUpdateTimings();
 
 private:
     std::unique_ptr<RenderPipeline> m_renderPipeline;
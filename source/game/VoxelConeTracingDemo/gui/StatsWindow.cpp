@@ -1,9 +1,8 @@
 #include "StatsWindow.h"
 #include "engine/util/QueryManager.h"
+#include <algorithm>
 #include <cstddef>
 
-uint32_t StatsWindow::ElapsedTimeGUIData::m_idCounter = 0;
-
 StatsWindow::StatsWindow()
 {
     m_window.open = false;
@@ -14,97 +13,93 @@ void StatsWindow::update()
 {
     m_window.begin();
 
-    auto elapsedTimeCPUInfo = QueryManager::getElapsedTimeInfo(QueryTarget::CPU);
-    auto elapsedTimeGPUInfo = QueryManager::getElapsedTimeInfo(QueryTarget::GPU);
+    addZoneTimes(m_cpuHistories, &Profiler::getCPUZoneTime);
+    addZoneTimes(m_gpuHistories, &Profiler::getGPUZoneTime);
 
     ImGui::Text("Max Displayed Value:"); ImGui::SameLine();
     ImGui::SliderFloat("", &m_maxDisplayedValue, 5.0f, 100.0f);
     ImGui::Text("CPU Elapsed Time:");
-    for (auto& cpuInfo : elapsedTimeCPUInfo)
-    {
-        onElapsedTimeInfoItem(cpuInfo, QueryTarget::CPU);
-    }
+    ImGui::PushID("CPU");
+    onZoneItems(m_cpuHistories);
+    ImGui::PopID();
 
     ImGui::NewLine();
     ImGui::Text("GPU Elapsed Time:");
-    for (auto& gpuInfo : elapsedTimeGPUInfo)
+    ImGui::PushID("GPU");
+    onZoneItems(m_gpuHistories);
+    ImGui::PopID();
+
+    ImGui::NewLine();
+    ImGui::Text("Counters:");
+    for (auto& counter : QueryManager::getCounters())
     {
-        onElapsedTimeInfoItem(gpuInfo, QueryTarget::GPU);
+        std::stringstream ss;
+        ss << counter.first << ": " << counter.second;
+        ImGui::TextUnformatted(ss.str().c_str());
     }
 
     m_window.end();
 }
 
-void StatsWindow::plotHistogram(const ElapsedTimeInfo& timeInfo, const ElapsedTimeGUIData& guiData) const
-{
-    int valueCount = 100;
-    int halfValueCount = valueCount / 2;
-
-    std::vector<float> historyF(valueCount, 0.0f);
-    auto history = timeInfo.getHistory(-halfValueCount - timeInfo.getAddedEntryCount() % halfValueCount - 1, -1);
-    for (std::size_t i = 0; i < history.size(); ++i)
-        historyF[i] = history[i].elapsedTimeInMicroseconds / 1000.0f;
-
-    if (historyF.size() > 0)
-        ImGui::PlotHistogram("", &historyF[0], static_cast<int>(historyF.size()), 0, "", 0.0f, m_maxDisplayedValue, ImVec2(m_window.size.x - 50, 100.0f));
-}
-
-void StatsWindow::onElapsedTimeInfoItem(const ElapsedTimeInfoBag& timeInfo, QueryTarget target)
+void StatsWindow::addZoneTimes(std::vector<ZoneHistory>& histories, ProfileZoneTime (*getZoneTime)(ProfileZoneId))
 {
-    auto name = timeInfo[ElapsedTimeInfoType::PER_FRAME].getName();
+    std::size_t zoneCount = Profiler::getZoneCount();
+    if (histories.size() < zoneCount)
+        histories.resize(zoneCount);
 
-    auto guiDataMap = getElapsedTimeGUIData(target);
-    auto& guiData = (*guiDataMap)[name];
-
-    const char* infoTypes[2] = {
-        "Max Per Interval",
-        "Average Per Interval"
-    };
-
-    ImGui::PushID(guiData.id);
-    if (ImGui::TreeNode(name.c_str()))
+    for (std::size_t zone = 0; zone < zoneCount; ++zone)
     {
-        ElapsedTimeInfoType selectedType = ElapsedTimeInfoType::MAX_PER_INTERVAL;
+        ProfileZoneTime time = getZoneTime(ProfileZoneId(zone));
+        ZoneHistory& history = histories[zone];
 
-        ImGui::Combo("Type", &guiData.selectedInfoType, infoTypes, 2);
-
-        switch(guiData.selectedInfoType)
+        // Zones are only listed once they were recorded
+        if (history.timesInMilliseconds.empty())
         {
-        case 0:
-            selectedType = ElapsedTimeInfoType::MAX_PER_INTERVAL;
-            break;
-        case 1:
-            selectedType = ElapsedTimeInfoType::AVERAGE_PER_INTERVAL;
-            break;
-        default: break;
-        }
+            if (time.callCount == 0)
+                continue;
 
-        std::stringstream ss;
-        ss << "Average in the last second: " << timeInfo[selectedType].getAverageInMicroseconds() / 1000.0 << " ms";
-        ImGui::TextUnformatted(ss.str().c_str());
-        ss.str("");
-        ss.clear();
-        ss << "Highest in the last second: " << timeInfo[selectedType].getMaxInMicroseconds() / 1000.0 << " ms";
-        ImGui::TextUnformatted(ss.str().c_str());
+            history.timesInMilliseconds.assign(HISTORY_SIZE, 0.0f);
+        }
 
-        plotHistogram(timeInfo[selectedType], guiData);
-        ImGui::TreePop();
+        history.timesInMilliseconds[history.nextIdx] = time.timeInNanoseconds / 1000000.0f;
+        history.nextIdx = (history.nextIdx + 1) % HISTORY_SIZE;
+        ++history.addedCount;
     }
-    ImGui::PopID();
 }
 
-std::unordered_map<std::string, StatsWindow::ElapsedTimeGUIData>* StatsWindow::getElapsedTimeGUIData(QueryTarget target)
+void StatsWindow::onZoneItems(const std::vector<ZoneHistory>& histories) const
 {
-    switch(target)
+    for (std::size_t zone = 0; zone < histories.size(); ++zone)
     {
-    case QueryTarget::CPU: 
-        return &m_elapsedTimeGUIDataCPU;
-    case QueryTarget::GPU: 
-        return &m_elapsedTimeGUIDataGPU;
-    default: 
-        assert(false);
-        break;
-    }
+        const ZoneHistory& history = histories[zone];
+        if (history.timesInMilliseconds.empty())
+            continue;
 
-    return nullptr;
+        ImGui::PushID(int(zone));
+        if (ImGui::TreeNode(Profiler::getZoneName(ProfileZoneId(zone)).c_str()))
+        {
+            std::size_t frameCount = std::min(history.addedCount, std::size_t(HISTORY_SIZE));
+            float sum = 0.0f;
+            float max = 0.0f;
+            for (float time : history.timesInMilliseconds)
+            {
+                sum += time;
+                max = std::max(max, time);
+            }
+
+            std::stringstream ss;
+            ss << "Average in the last " << frameCount << " frames: " << sum / frameCount << " ms";
+            ImGui::TextUnformatted(ss.str().c_str());
+            ss.str("");
+            ss.clear();
+            ss << "Highest in the last " << frameCount << " frames: " << max << " ms";
+            ImGui::TextUnformatted(ss.str().c_str());
+
+            // The oldest time is at nextIdx
+            ImGui::PlotHistogram("", history.timesInMilliseconds.data(), int(HISTORY_SIZE), int(history.nextIdx), "", 0.0f, m_maxDisplayedValue,
+                                 ImVec2(m_window.size.x - 50, 100.0f));
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+    }
 }
@@ -1,23 +1,19 @@
 #pragma once
-#include <unordered_map>
+#include <vector>
+#include <cstddef>
 #include "engine/gui/GUIElements.h"
-
-enum class QueryTarget;
-struct ElapsedTimeInfoBag;
-class ElapsedTimeInfo;
+#include "engine/util/Profiler.h"
 
 class StatsWindow
 {
-    class ElapsedTimeGUIData
+    /**
+    * Times of a profile zone in the last HISTORY_SIZE frames in which the window was open.
+    */
+    struct ZoneHistory
     {
-    public:
-        ElapsedTimeGUIData()
-            :id(m_idCounter++) {}
-
-        int selectedInfoType{ 0 };
-        uint32_t id{ 0 };
-    private:
-        static uint32_t m_idCounter;
+        std::vector<float> timesInMilliseconds; // Ring buffer - empty until the zone was recorded
+        std::size_t nextIdx{0};
+        std::size_t addedCount{0};
     };
 public:
     StatsWindow();
@@ -27,14 +23,16 @@ public:
     bool& open() { return m_window.open; }
 
 private:
-    void plotHistogram(const ElapsedTimeInfo& timeInfo, const ElapsedTimeGUIData& guiData) const;
-    void onElapsedTimeInfoItem(const ElapsedTimeInfoBag& timeInfo, QueryTarget target);
+    static const std::size_t HISTORY_SIZE = 100;
+
+    static void addZoneTimes(std::vector<ZoneHistory>& histories, ProfileZoneTime (*getZoneTime)(ProfileZoneId));
 
-    std::unordered_map<std::string, ElapsedTimeGUIData>* getElapsedTimeGUIData(QueryTarget target);
+    void onZoneItems(const std::vector<ZoneHistory>& histories) const;
 private:
     GUIWindow m_window{ "Stats" };
 
-    std::unordered_map<std::string, ElapsedTimeGUIData> m_elapsedTimeGUIDataCPU;
-    std::unordered_map<std::string, ElapsedTimeGUIData> m_elapsedTimeGUIDataGPU;
+    // Indexed by ProfileZoneId
+    std::vector<ZoneHistory> m_cpuHistories;
+    std::vector<ZoneHistory> m_gpuHistories;
     float m_maxDisplayedValue{ 50.0f };
 };
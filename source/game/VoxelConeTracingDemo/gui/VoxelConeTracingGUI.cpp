@@ -1,4 +1,5 @@
 #include "VoxelConeTracingGUI.h"
+#include <engine/rendering/architecture/RPKeys.h>
 #include <imgui/imgui.h>
 #include <engine/rendering/Screen.h>
 #include <engine/util/Timer.h>
@@ -12,6 +13,9 @@
 #include "engine/util/Random.h"
 #include "engine/rendering/voxelConeTracing/settings/VoxelConeTracingSettings.h"
 #include "engine/rendering/voxelConeTracing/VoxelRegion.h"
+#include "engine/rendering/voxelConeTracing/DynamicVoxelization.h"
+#include "engine/rendering/voxelConeTracing/VoxelConeTracing.h"
+#include "engine/rendering/voxelConeTracing/voxelization.h"
 #include "engine/gui/GUI.h"
 #include "engine/util/ECSUtil/EntityCreator.h"
 #include "engine/rendering/lights/DirectionalLight.h"
@@ -35,7 +39,7 @@ VoxelConeTracingGUI::VoxelConeTracingGUI(RenderPipeline* renderPipeline)
     m_visualizer = std::make_unique<Visualizer>();
     m_coneTool = std::make_unique<ConeTool>();
 
-    m_entityPicker = std::make_unique<EntityPicker>();
+    m_entityPicker = std::make_unique<EntityPicker>(VoxelConeTracing::voxelizer()->getSceneBVH());
     m_statsWindow = std::make_unique<StatsWindow>();
 
     Input::subscribe(this);
@@ -45,7 +49,6 @@ void VoxelConeTracingGUI::update()
 {
     if (m_entityPickRequest.requested)
     {
-        m_entityPicker->update();
         m_selectedEntity = m_entityPicker->pick(m_entityPickRequest.x, m_entityPickRequest.y);
         m_entityPickRequest.requested = false;
     }
@@ -111,21 +114,25 @@ void VoxelConeTracingGUI::update()
     {
         m_gBuffersWindow.begin();
 
-        GLuint diffuseTexture = m_renderPipeline->fetch<GLuint>("DiffuseTexture");
-        GLuint normalMap = m_renderPipeline->fetch<GLuint>("NormalMap");
-        GLuint specularMap = m_renderPipeline->fetch<GLuint>("SpecularMap");
-        GLuint emissionMap = m_renderPipeline->fetch<GLuint>("EmissionMap");
-        GLuint depthTexture = m_renderPipeline->fetch<GLuint>("DepthTexture");
+        // The G-buffer is only rendered if a pass of the current pipeline reads it
+        if (m_renderPipeline->contains(rp_keys::DIFFUSE_TEXTURE))
+        {
+            GLuint diffuseTexture = m_renderPipeline->fetch(rp_keys::DIFFUSE_TEXTURE);
+            GLuint normalMap = m_renderPipeline->fetch(rp_keys::NORMAL_MAP);
+            GLuint specularMap = m_renderPipeline->fetch(rp_keys::SPECULAR_MAP);
+            GLuint emissionMap = m_renderPipeline->fetch(rp_keys::EMISSION_MAP);
+            GLuint depthTexture = m_renderPipeline->fetch(rp_keys::DEPTH_TEXTURE);
         
-        GUI::textures[specularMap] = GUITexture("Specular Map", specularMap, GL_RED, GL_GREEN, GL_BLUE, GL_ONE);
-        GUI::textures[depthTexture] = GUITexture("Depth Texture", depthTexture, GL_RED, GL_RED, GL_RED, GL_ONE);
-
-        showTextures(m_gBuffersWindow.size, {
-                         GUITexture("Diffuse Texture", diffuseTexture),
-                         GUITexture("Normal Map", normalMap),
-                         GUITexture("Specular Map", specularMap),
-                         GUITexture("Emission Map", emissionMap),
-                         GUITexture("Depth Texture", depthTexture)});
+            GUI::textures[specularMap] = GUITexture("Specular Map", specularMap, GL_RED, GL_GREEN, GL_BLUE, GL_ONE);
+            GUI::textures[depthTexture] = GUITexture("Depth Texture", depthTexture, GL_RED, GL_RED, GL_RED, GL_ONE);
+
+            showTextures(m_gBuffersWindow.size, {
+                             GUITexture("Diffuse Texture", diffuseTexture),
+                             GUITexture("Normal Map", normalMap),
+                             GUITexture("Specular Map", specularMap),
+                             GUITexture("Emission Map", emissionMap),
+                             GUITexture("Depth Texture", depthTexture)});
+        }
 
         m_gBuffersWindow.end();
     }
@@ -183,7 +190,7 @@ void VoxelConeTracingGUI::onVoxelVisualization()
     bool hasMultipleFaces = true;
     int numColorComponents = 4;
 
-    auto clipRegions = m_renderPipeline->fetchPtr<std::vector<VoxelRegion>>("ClipRegions");
+    auto clipRegions = m_renderPipeline->fetchPtr(rp_keys::CLIP_REGIONS);
 
     VoxelRegion prevRegion;
     bool hasPrevLevel = false;
@@ -300,6 +307,10 @@ void VoxelConeTracingGUI::showEntityWindow(const Entity& entity)
     ImGui::Checkbox("Active", &active);
     entity.setActive(active);
 
+    bool dynamic = entity.hasComponent<DynamicVoxelization>();
+    if (ImGui::Checkbox("Dynamic Voxelization", &dynamic))
+        DynamicVoxelization::setDynamic(entity, dynamic);
+
     showComponents(entity);
 
     if (!m_entityWindow.open)
@@ -409,10 +420,10 @@ void VoxelConeTracingGUI::showVoxelVisualizationOptions()
     switch (curSelection)
     {
     case 0:
-        m_visualizedVoxelTex = m_renderPipeline->fetchPtr<Texture3D>("VoxelOpacity");
+        m_visualizedVoxelTex = m_renderPipeline->fetchPtr(rp_keys::VOXEL_OPACITY);
         break;
     case 1:
-        m_visualizedVoxelTex = m_renderPipeline->fetchPtr<Texture3D>("VoxelRadiance");
+        m_visualizedVoxelTex = m_renderPipeline->fetchPtr(rp_keys::VOXEL_RADIANCE);
         break;
     default:
         assert(false);